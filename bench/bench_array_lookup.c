@@ -0,0 +1,83 @@
+// bench_array_lookup.c — repeated value lookups in a large OCArray
+//
+// Searches the same array of OCNumbers and of OCStrings with
+// OCArrayGetFirstIndexOfValue, first by linear scan and then with the value
+// index turned on. Queries are fresh objects equal to values spread over the
+// array, so every lookup goes through OCTypeEqual rather than pointer
+// identity. The index time includes building it on the first lookup.
+// Pass an element count to override the default of 1M.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kLinearQueries 200
+#define kIndexedQueries 1000000
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+// Runs `count` lookups and returns the time per lookup in microseconds
+static double run(OCArrayRef array, const void **queries, int queryCount, int count, uint64_t *found) {
+    double t0 = now_seconds();
+    for (int i = 0; i < count; i++)
+        *found += OCArrayGetFirstIndexOfValue(array, queries[i % queryCount]) != kOCNotFound;
+    return (now_seconds() - t0) * 1e6 / count;
+}
+static void bench(const char *label, OCArrayRef array, const void **queries, int queryCount) {
+    uint64_t found = 0;
+    double linear = run(array, queries, queryCount, kLinearQueries, &found);
+    double t0 = now_seconds();
+    OCArraySetValueIndexEnabled(array, true);
+    OCArrayContainsValue(array, queries[0]);
+    double build = now_seconds() - t0;
+    double indexed = run(array, queries, queryCount, kIndexedQueries, &found);
+    printf("%-10s %14.1f %12.3f %14.3f %10.0fx\n", label, linear, build, indexed, linear / indexed);
+    if (found != kLinearQueries + kIndexedQueries) printf("  (%llu lookups missed)\n",
+                                                          (unsigned long long)(kLinearQueries + kIndexedQueries - found));
+}
+int main(int argc, char **argv) {
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    if (n == 0) n = 1;
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    const int queryCount = 4096;
+    const void **queries = malloc(queryCount * sizeof(const void *));
+    OCMutableArrayRef numbers = OCArrayCreateMutable(n, &kOCTypeArrayCallBacks);
+    OCMutableArrayRef strings = OCArrayCreateMutable(n, &kOCTypeArrayCallBacks);
+    for (uint64_t i = 0; i < n; i++) {
+        OCNumberRef number = OCNumberCreateWithSInt64((int64_t)i);
+        OCStringRef string = OCStringCreateWithFormat(STR("record-%llu"), (unsigned long long)i);
+        OCArrayAppendValue(numbers, number);
+        OCArrayAppendValue(strings, string);
+        OCRelease(number);
+        OCRelease(string);
+    }
+    printf("%llu elements, %d linear and %d indexed lookups\n", (unsigned long long)n, kLinearQueries,
+           kIndexedQueries);
+    printf("%-10s %14s %12s %14s %11s\n", "values", "scan (us/op)", "build (s)", "index (us/op)", "speedup");
+    for (int q = 0; q < queryCount; q++)
+        queries[q] = OCNumberCreateWithSInt64((int64_t)(xorshift64(&state) % n));
+    bench("OCNumber", numbers, queries, queryCount);
+    for (int q = 0; q < queryCount; q++) {
+        OCRelease(queries[q]);
+        queries[q] = OCStringCreateWithFormat(STR("record-%llu"), (unsigned long long)(xorshift64(&state) % n));
+    }
+    bench("OCString", strings, queries, queryCount);
+    for (int q = 0; q < queryCount; q++)
+        OCRelease(queries[q]);
+    free(queries);
+    OCRelease(numbers);
+    OCRelease(strings);
+    OCTypesShutdown();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// bench_array_sort.c — OCArray sorting of boxed numbers and strings
+//
+// Sorts the same shuffled arrays of OCNumbers and OCStrings with libc qsort
+// through a comparator thunk (how OCArraySortValues used to work),
+// with the stable merge sort behind OCArraySortValues, with its concurrent
+// variant, and with the key-extracting OCArraySortNumbers/OCArraySortStrings.
+// Pass an element count to override the default of 1M.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OCTypes.h"
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static OCComparisonResult compareNumbers(const void *a, const void *b, void *context) {
+    (void)context;
+    double x = 0, y = 0;
+    OCNumberTryGetFloat64((OCNumberRef)a, &x);
+    OCNumberTryGetFloat64((OCNumberRef)b, &y);
+    return x < y ? kOCCompareLessThan : x > y ? kOCCompareGreaterThan : kOCCompareEqualTo;
+}
+static OCComparisonResult compareStrings(const void *a, const void *b, void *context) {
+    (void)context;
+    return OCStringCompare((OCStringRef)a, (OCStringRef)b, 0);
+}
+static OCComparatorFunction qsortComparator;
+static int qsortThunk(const void *a, const void *b) {
+    return qsortComparator(*(const void *const *)a, *(const void *const *)b, NULL);
+}
+// Sorts a fresh mutable copy so every run starts from the same order
+static double timeSort(OCArrayRef source, int method, OCComparatorFunction comparator, bool numbers) {
+    OCMutableArrayRef array = OCArrayCreateMutableCopy(source);
+    OCRange all = OCRangeMake(0, (OCIndex)OCArrayGetCount(array));
+    const void **values = (const void **)malloc(OCArrayGetCount(array) * sizeof(void *));
+    double t0 = now_seconds();
+    switch (method) {
+        case 0: {
+            // The old path: libc qsort over a copy of the value pointers
+            qsortComparator = comparator;
+            for (uint64_t i = 0; i < OCArrayGetCount(array); i++)
+                values[i] = OCArrayGetValueAtIndex(array, i);
+            qsort(values, OCArrayGetCount(array), sizeof(void *), qsortThunk);
+            break;
+        }
+        case 1:
+            OCArraySortValues(array, all, comparator, NULL);
+            break;
+        case 2:
+            OCArraySortValuesWithOptions(array, all, comparator, NULL, kOCArraySortConcurrent);
+            break;
+        case 3:
+            if (numbers)
+                OCArraySortNumbers(array, all, kOCArraySortDefault);
+            else
+                OCArraySortStrings(array, all, kOCArraySortDefault);
+            break;
+        case 4:
+            if (numbers)
+                OCArraySortNumbers(array, all, kOCArraySortConcurrent);
+            else
+                OCArraySortStrings(array, all, kOCArraySortConcurrent);
+            break;
+    }
+    double elapsed = now_seconds() - t0;
+    free(values);
+    OCRelease(array);
+    return elapsed;
+}
+static void report(const char *label, OCArrayRef source, OCComparatorFunction comparator, bool numbers) {
+    static const char *methods[] = {"qsort + comparator", "OCArraySortValues", "  concurrent",
+                                    "key extraction", "  concurrent"};
+    printf("%s\n", label);
+    for (int m = 0; m < 5; m++)
+        printf("  %-24s %8.3f s\n", methods[m], timeSort(source, m, comparator, numbers));
+}
+int main(int argc, char **argv) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    if (count < 1) count = 1000000;
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    OCMutableArrayRef numbers = OCArrayCreateMutable((uint64_t)count, &kOCTypeArrayCallBacks);
+    OCMutableArrayRef strings = OCArrayCreateMutable((uint64_t)count, &kOCTypeArrayCallBacks);
+    for (long i = 0; i < count; i++) {
+        uint64_t r = xorshift64(&state);
+        OCNumberRef n = OCNumberCreateWithDouble((double)(r >> 11) / 9007199254740992.0);
+        // Shared leading text, as with generated identifiers
+        OCStringRef s = OCStringCreateWithFormat(STR("sample-%llu"), (unsigned long long)(r % 100000000));
+        OCArrayAppendValue(numbers, n);
+        OCArrayAppendValue(strings, s);
+        OCRelease(n);
+        OCRelease(s);
+    }
+    printf("%ld elements\n", count);
+    report("OCNumber (double)", numbers, compareNumbers, true);
+    report("OCString", strings, compareStrings, false);
+    OCRelease(numbers);
+    OCRelease(strings);
+    OCTypesShutdown();
+    return 0;
+}
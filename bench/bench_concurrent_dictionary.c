@@ -0,0 +1,100 @@
+// bench_concurrent_dictionary.c — shared cache throughput under threads
+//
+// Runs a 90% lookup / 10% store mix over a fixed key set from 1, 2, 4 and 8
+// threads, comparing one OCMutableDictionary behind a single mutex with the
+// lock-striped OCConcurrentDictionary. Both paths retain what they read, as
+// a cache user would. Scaling depends on the number of cores available.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, pthread_rwlock
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kKeyCount 4096
+#define kOpsPerThread 400000
+#define kMaxThreads 8
+static OCStringRef keys[kKeyCount];
+static OCNumberRef values[kKeyCount];
+static OCMutableDictionaryRef lockedDict;
+static pthread_mutex_t lockedDictMutex = PTHREAD_MUTEX_INITIALIZER;
+static OCConcurrentDictionaryRef concurrentDict;
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static void *run_locked(void *arg) {
+    uint64_t state = (uint64_t)(uintptr_t)arg * 0x9E3779B97F4A7C15ULL + 1;
+    for (int i = 0; i < kOpsPerThread; i++) {
+        uint64_t r = xorshift64(&state);
+        size_t k = (size_t)(r % kKeyCount);
+        pthread_mutex_lock(&lockedDictMutex);
+        if ((r >> 32) % 10 == 0) {
+            OCDictionarySetValue(lockedDict, keys[k], values[(k + 1) % kKeyCount]);
+            pthread_mutex_unlock(&lockedDictMutex);
+        } else {
+            const void *v = OCDictionaryGetValue(lockedDict, keys[k]);
+            if (v) OCRetain(v);
+            pthread_mutex_unlock(&lockedDictMutex);
+            OCRelease(v);
+        }
+    }
+    return NULL;
+}
+static void *run_concurrent(void *arg) {
+    uint64_t state = (uint64_t)(uintptr_t)arg * 0x9E3779B97F4A7C15ULL + 1;
+    for (int i = 0; i < kOpsPerThread; i++) {
+        uint64_t r = xorshift64(&state);
+        size_t k = (size_t)(r % kKeyCount);
+        if ((r >> 32) % 10 == 0) {
+            OCConcurrentDictionarySetValue(concurrentDict, keys[k], values[(k + 1) % kKeyCount]);
+        } else {
+            OCRelease(OCConcurrentDictionaryCopyValue(concurrentDict, keys[k]));
+        }
+    }
+    return NULL;
+}
+static double run(void *(*worker)(void *), int threadCount) {
+    pthread_t threads[kMaxThreads];
+    double t0 = now_seconds();
+    for (int t = 0; t < threadCount; t++)
+        pthread_create(&threads[t], NULL, worker, (void *)(uintptr_t)(t + 1));
+    for (int t = 0; t < threadCount; t++)
+        pthread_join(threads[t], NULL);
+    double elapsed = now_seconds() - t0;
+    return (double)threadCount * kOpsPerThread / elapsed / 1e6;
+}
+int main(void) {
+    lockedDict = OCDictionaryCreateMutable(kKeyCount);
+    concurrentDict = OCConcurrentDictionaryCreate(kKeyCount);
+    for (int i = 0; i < kKeyCount; i++) {
+        keys[i] = OCStringCreateWithFormat(STR("cache-entry-%d"), i);
+        values[i] = OCNumberCreateWithInt(i);
+        OCDictionarySetValue(lockedDict, keys[i], values[i]);
+        OCConcurrentDictionarySetValue(concurrentDict, keys[i], values[i]);
+    }
+    printf("%d keys, %d ops per thread, 90%% reads\n", kKeyCount, kOpsPerThread);
+    printf("%-8s %18s %18s\n", "threads", "mutex (Mops/s)", "striped (Mops/s)");
+    for (int threadCount = 1; threadCount <= kMaxThreads; threadCount *= 2) {
+        double locked = run(run_locked, threadCount);
+        double striped = run(run_concurrent, threadCount);
+        printf("%-8d %18.2f %18.2f\n", threadCount, locked, striped);
+    }
+    OCRelease(lockedDict);
+    OCRelease(concurrentDict);
+    for (int i = 0; i < kKeyCount; i++) {
+        OCRelease(keys[i]);
+        OCRelease(values[i]);
+    }
+    OCTypesShutdown();
+    return 0;
+}
@@ -0,0 +1,152 @@
+// bench_cow_copies.c — snapshot-heavy use of container copies
+//
+// Models an editor that takes an immutable snapshot of its working state
+// after every step and keeps the last kKeep of them for undo, while only
+// some steps actually edit the state. Each container type is run in a
+// forked child so that the peak resident size belongs to that run alone.
+// Copies that share storage pay for a copy only on the first edit after a
+// snapshot; eager copies pay on every snapshot.
+// Pass a step count to override the default of 2000.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, fork
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "OCTypes.h"
+#define kKeep 32
+#define kArrayCount 100000
+#define kDictionaryCount 20000
+#define kDataLength (1 << 20)
+#define kStringLength (1 << 18)
+typedef enum { kArray, kDictionary, kData, kString, kKindCount } Kind;
+static const char *kKindNames[kKindCount] = {"OCArray", "OCDictionary", "OCData", "OCString"};
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static long peak_kilobytes(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+static void *create_state(Kind kind) {
+    switch (kind) {
+        case kArray: {
+            OCMutableArrayRef array = OCArrayCreateMutable(kArrayCount, &kOCTypeArrayCallBacks);
+            for (int i = 0; i < kArrayCount; i++) {
+                OCNumberRef n = OCNumberCreateWithInt(i);
+                OCArrayAppendValue(array, n);
+                OCRelease(n);
+            }
+            return array;
+        }
+        case kDictionary: {
+            OCMutableDictionaryRef dict = OCDictionaryCreateMutable(kDictionaryCount);
+            for (int i = 0; i < kDictionaryCount; i++) {
+                OCStringRef key = OCStringCreateWithFormat(STR("field-%d"), i);
+                OCNumberRef n = OCNumberCreateWithInt(i);
+                OCDictionarySetValue(dict, key, n);
+                OCRelease(key);
+                OCRelease(n);
+            }
+            return dict;
+        }
+        case kData: {
+            OCMutableDataRef data = OCDataCreateMutable(kDataLength);
+            OCDataSetLength(data, kDataLength);
+            return data;
+        }
+        default: {
+            OCMutableStringRef string = OCStringCreateMutable(kStringLength);
+            for (int i = 0; i < kStringLength / 64; i++)
+                OCStringAppendCString(string, "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+            return string;
+        }
+    }
+}
+static void edit_state(Kind kind, void *state, uint64_t *rng) {
+    uint64_t r = xorshift64(rng);
+    switch (kind) {
+        case kArray:
+            OCArraySetValueAtIndex(state, r % kArrayCount, kOCBooleanTrue);
+            break;
+        case kDictionary: {
+            OCStringRef key = OCStringCreateWithFormat(STR("field-%d"), (int)(r % kDictionaryCount));
+            OCDictionarySetValue(state, key, kOCBooleanTrue);
+            OCRelease(key);
+            break;
+        }
+        case kData:
+            OCDataGetMutableBytes(state)[r % kDataLength] ^= 1;
+            break;
+        default:
+            OCStringReplace(state, OCRangeMake((int64_t)(r % kStringLength), 1), STR("x"));
+            break;
+    }
+}
+static const void *snapshot_state(Kind kind, void *state) {
+    switch (kind) {
+        case kArray: return OCArrayCreateCopy(state);
+        case kDictionary: return OCDictionaryCreateCopy(state);
+        case kData: return OCDataCreateCopy(state);
+        default: return OCStringCreateCopy(state);
+    }
+}
+// Runs one kind in the calling process and prints its row
+static void run(Kind kind, int steps, int editEvery) {
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    void *state = create_state(kind);
+    const void *kept[kKeep] = {NULL};
+    long before = peak_kilobytes();
+    double t0 = now_seconds();
+    for (int step = 0; step < steps; step++) {
+        if (step % editEvery == 0) edit_state(kind, state, &rng);
+        const void **slot = &kept[step % kKeep];
+        if (*slot) OCRelease(*slot);
+        *slot = snapshot_state(kind, state);
+    }
+    double elapsed = now_seconds() - t0;
+    long after = peak_kilobytes();
+    printf("%-13s %10d %16.2f %18ld\n", kKindNames[kind], editEvery, elapsed * 1e6 / steps, after - before);
+    fflush(stdout);
+    for (int i = 0; i < kKeep; i++)
+        if (kept[i]) OCRelease(kept[i]);
+    OCRelease(state);
+}
+int main(int argc, char **argv) {
+    int steps = argc > 1 ? atoi(argv[1]) : 2000;
+    if (steps <= 0) steps = 1;
+    const int editEvery[] = {1, 16};
+    printf("%d steps, one snapshot per step, last %d snapshots kept\n", steps, kKeep);
+    printf("%-13s %10s %16s %18s\n", "state", "edit every", "us per step", "peak growth (KiB)");
+    fflush(stdout);
+    for (int kind = 0; kind < kKindCount; kind++) {
+        for (size_t e = 0; e < sizeof(editEvery) / sizeof(editEvery[0]); e++) {
+            pid_t child = fork();
+            if (child == 0) {
+                run((Kind)kind, steps, editEvery[e]);
+                OCTypesShutdown();
+                _exit(0);
+            }
+            if (child < 0) {
+                run((Kind)kind, steps, editEvery[e]);
+            } else {
+                waitpid(child, NULL, 0);
+            }
+        }
+    }
+    OCTypesShutdown();
+    return 0;
+}
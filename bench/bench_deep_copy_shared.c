@@ -0,0 +1,117 @@
+// bench_deep_copy_shared.c — deep copies of a nested configuration tree
+//
+// Builds a dictionary of sections, each a dictionary of string, number and
+// small-array fields, and copies it with OCTypeDeepCopyMutable and with
+// OCTypeDeepCopyShared. The sections are either frozen (built once and never
+// changed, the usual shape of loaded configuration) or mutable. After each
+// copy a handful of sections is edited through the copy, which is where the
+// shared copy pays for the nodes it did not copy up front. The first shared
+// copy of a tree also learns which subtrees hold nothing mutable, so it is
+// timed apart from the later ones.
+// Pass a section count to override the default of 2000.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kFields 100
+#define kEdits 16
+#define kRounds 5
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static OCMutableDictionaryRef create_tree(int sections, bool frozen) {
+    OCMutableDictionaryRef root = OCDictionaryCreateMutable(sections);
+    for (int s = 0; s < sections; s++) {
+        OCMutableDictionaryRef section = OCDictionaryCreateMutable(kFields);
+        for (int f = 0; f < kFields; f++) {
+            OCStringRef key = OCStringCreateWithFormat(STR("field-%d"), f);
+            const void *value;
+            if (f % 3 == 0) {
+                value = OCStringCreateWithFormat(STR("value %d.%d"), s, f);
+            } else if (f % 3 == 1) {
+                value = OCNumberCreateWithInt(s * kFields + f);
+            } else {
+                const void *items[] = {kOCBooleanTrue, kOCBooleanFalse, kOCNull};
+                value = OCArrayCreate(items, 3, &kOCTypeArrayCallBacks);
+            }
+            OCDictionarySetValue(section, key, value);
+            OCRelease(value);
+            OCRelease(key);
+        }
+        OCStringRef name = OCStringCreateWithFormat(STR("section-%d"), s);
+        if (frozen) {
+            OCDictionaryRef fixed = OCDictionaryCreateCopy(section);
+            OCDictionarySetValue(root, name, fixed);
+            OCRelease(fixed);
+        } else {
+            OCDictionarySetValue(root, name, section);
+        }
+        OCRelease(name);
+        OCRelease(section);
+    }
+    return root;
+}
+// Replaces one field in each of kEdits random sections of the copy; frozen
+// sections are replaced by edited mutable copies
+static void edit_copy(OCMutableDictionaryRef copy, int sections, uint64_t *rng) {
+    for (int e = 0; e < kEdits; e++) {
+        OCStringRef name = OCStringCreateWithFormat(STR("section-%d"), (int)(xorshift64(rng) % sections));
+        OCDictionaryRef section = OCDictionaryGetValue(copy, name);
+        OCMutableDictionaryRef edited = OCDictionaryCreateMutableCopy(section);
+        OCDictionarySetValue(edited, STR("field-1"), kOCBooleanTrue);
+        OCDictionarySetValue(copy, name, edited);
+        OCRelease(edited);
+        OCRelease(name);
+    }
+}
+static void bench(const char *label, int sections, bool frozen) {
+    OCMutableDictionaryRef tree = create_tree(sections, frozen);
+    double firstTime[2] = {0, 0}, copyTime[2] = {0, 0}, editTime[2] = {0, 0};
+    for (int round = 0; round <= kRounds; round++) {
+        for (int mode = 0; mode < 2; mode++) {
+            uint64_t rng = 0x2545F4914F6CDD1DULL + (uint64_t)round;
+            double t0 = now_seconds();
+            OCMutableDictionaryRef copy = mode ? OCTypeDeepCopyShared(tree) : OCTypeDeepCopyMutable(tree);
+            double t1 = now_seconds();
+            edit_copy(copy, sections, &rng);
+            double t2 = now_seconds();
+            if (round == 0) {
+                firstTime[mode] = t1 - t0;
+            } else {
+                copyTime[mode] += t1 - t0;
+                editTime[mode] += t2 - t1;
+            }
+            OCRelease(copy);
+        }
+    }
+    printf("%-9s %-22s %12.2f %12.2f %12.3f\n", label, "OCTypeDeepCopyMutable", firstTime[0] * 1e3,
+           copyTime[0] * 1e3 / kRounds, editTime[0] * 1e3 / kRounds);
+    printf("%-9s %-22s %12.2f %12.2f %12.3f %8.0fx\n", label, "OCTypeDeepCopyShared", firstTime[1] * 1e3,
+           copyTime[1] * 1e3 / kRounds, editTime[1] * 1e3 / kRounds,
+           (copyTime[0] + editTime[0]) / (copyTime[1] + editTime[1]));
+    OCRelease(tree);
+}
+int main(int argc, char **argv) {
+    int sections = argc > 1 ? atoi(argv[1]) : 2000;
+    if (sections <= 0) sections = 1;
+    printf("%d sections of %d fields, %d edited sections per copy, later copies are a mean of %d\n", sections,
+           kFields, kEdits, kRounds);
+    printf("%-9s %-22s %12s %12s %12s %9s\n", "sections", "copy", "first (ms)", "later (ms)", "edits (ms)",
+           "speedup");
+    bench("frozen", sections, true);
+    bench("mutable", sections, false);
+    OCTypesShutdown();
+    return 0;
+}
@@ -0,0 +1,78 @@
+// bench_float_format.c — throughput of double → text conversion
+//
+// Compares the shortest round-trip formatter against the printf paths it
+// replaced: "%.17g", and cJSON's old "%1.15g" / sscanf / "%1.17g" retry.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kValueCount 1000000
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static int format_printf17(double d, char *buf) {
+    return snprintf(buf, 32, "%.17g", d);
+}
+static int format_retry(double d, char *buf) {
+    double test = 0.0;
+    int n = snprintf(buf, 32, "%1.15g", d);
+    if (sscanf(buf, "%lg", &test) != 1 || test != d) n = snprintf(buf, 32, "%1.17g", d);
+    return n;
+}
+static int format_shortest(double d, char *buf) {
+    return OCDoubleWriteShortestCString(d, buf, 32);
+}
+static void run(const char *label, const char *dataset, const double *values, int (*format)(double, char *)) {
+    char buf[32];
+    size_t bytes = 0;
+    double start = now_seconds();
+    for (int i = 0; i < kValueCount; i++) bytes += (size_t)format(values[i], buf);
+    double elapsed = now_seconds() - start;
+    printf("  %-10s %-22s %8.1f ns/value %8.1f MB/s\n", dataset, label,
+           elapsed * 1e9 / kValueCount, (double)bytes / elapsed / 1e6);
+}
+int main(void) {
+    double *random_bits = malloc(kValueCount * sizeof(double));
+    double *decimals = malloc(kValueCount * sizeof(double));
+    if (!random_bits || !decimals) return 1;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < kValueCount; i++) {
+        // Uniform bit patterns: mostly 16-17 significant digits
+        double d;
+        do {
+            uint64_t bits = xorshift64(&state);
+            memcpy(&d, &bits, sizeof d);
+        } while (!isfinite(d));
+        random_bits[i] = d;
+        // Short decimals such as measurements: 1-9 digits, moderate exponents
+        uint64_t r = xorshift64(&state);
+        decimals[i] = (double)(r % 1000000000u) * pow(10.0, (int)((r >> 32) % 16) - 12);
+    }
+    printf("Formatting %d doubles\n", kValueCount);
+    const struct {
+        const char *name;
+        const double *values;
+    } sets[] = {{"random", random_bits}, {"decimal", decimals}};
+    for (size_t s = 0; s < sizeof sets / sizeof *sets; s++) {
+        run("%.17g", sets[s].name, sets[s].values, format_printf17);
+        run("%.15g+sscanf+%.17g", sets[s].name, sets[s].values, format_retry);
+        run("shortest", sets[s].name, sets[s].values, format_shortest);
+    }
+    free(random_bits);
+    free(decimals);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// bench_sorted_dictionary.c — ordered maps: B+ tree against sorted arrays
+//
+// Keeps number keys in order two ways: an OCSortedDictionary, and the
+// pattern it replaces, parallel key and value OCMutableArrays kept sorted by
+// binary-searching each insert position and inserting there with
+// OCArrayInsertValueAtIndex, which shifts the tail of both arrays. Times random
+// inserts, random lookups, range scans of kScanLength entries from random
+// starting keys, removal of half the keys, and building the same map from
+// sorted input with OCSortedDictionaryCreate.
+// Pass a key count to override the default of 200000.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kLookups 200000
+#define kScans 2000
+#define kScanLength 100
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+static OCComparisonResult compare_numbers(const void *a, const void *b, void *context) {
+    (void)context;
+    int64_t x = 0, y = 0;
+    OCNumberTryGetSInt64((OCNumberRef)a, &x);
+    OCNumberTryGetSInt64((OCNumberRef)b, &y);
+    return x < y ? kOCCompareLessThan : x > y ? kOCCompareGreaterThan : kOCCompareEqualTo;
+}
+// Position of the first key not less than key. OCArrayBSearchValues only
+// reports exact matches, so the insert position needs its own search.
+static uint64_t lower_bound(OCArrayRef keys, OCNumberRef key) {
+    uint64_t low = 0, high = OCArrayGetCount(keys);
+    while (low < high) {
+        uint64_t mid = (low + high) / 2;
+        if (compare_numbers(OCArrayGetValueAtIndex(keys, mid), key, NULL) == kOCCompareLessThan)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+static void array_set(OCMutableArrayRef keys, OCMutableArrayRef values, OCNumberRef key, const void *value) {
+    uint64_t at = lower_bound(keys, key);
+    if (at < OCArrayGetCount(keys) && compare_numbers(OCArrayGetValueAtIndex(keys, at), key, NULL) == kOCCompareEqualTo) {
+        OCArraySetValueAtIndex(values, at, value);
+        return;
+    }
+    OCArrayInsertValueAtIndex(keys, at, key);
+    OCArrayInsertValueAtIndex(values, at, value);
+}
+static const void *array_get(OCArrayRef keys, OCArrayRef values, OCNumberRef key) {
+    uint64_t at = lower_bound(keys, key);
+    if (at == OCArrayGetCount(keys) || compare_numbers(OCArrayGetValueAtIndex(keys, at), key, NULL) != kOCCompareEqualTo)
+        return NULL;
+    return OCArrayGetValueAtIndex(values, at);
+}
+static void array_remove(OCMutableArrayRef keys, OCMutableArrayRef values, OCNumberRef key) {
+    uint64_t at = lower_bound(keys, key);
+    if (at == OCArrayGetCount(keys) || compare_numbers(OCArrayGetValueAtIndex(keys, at), key, NULL) != kOCCompareEqualTo)
+        return;
+    OCArrayRemoveValueAtIndex(keys, at);
+    OCArrayRemoveValueAtIndex(values, at);
+}
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    if (count <= 0) count = 1;
+    int64_t keyRange = (int64_t)count * 4;
+    OCNumberRef *keys = malloc((size_t)count * sizeof(OCNumberRef));
+    OCNumberRef *probes = malloc(kLookups * sizeof(OCNumberRef));
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < count; i++) keys[i] = OCNumberCreateWithSInt64((int64_t)(xorshift64(&rng) % keyRange));
+    for (int i = 0; i < kLookups; i++) probes[i] = OCNumberCreateWithSInt64((int64_t)(xorshift64(&rng) % keyRange));
+    double times[2][5] = {{0}};
+    uint64_t hits[2] = {0, 0}, scanned[2] = {0, 0};
+    // Sorted parallel arrays
+    {
+        OCMutableArrayRef keyArray = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+        OCMutableArrayRef valueArray = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+        double t0 = now_seconds();
+        for (int i = 0; i < count; i++) array_set(keyArray, valueArray, keys[i], keys[i]);
+        double t1 = now_seconds();
+        for (int i = 0; i < kLookups; i++) hits[0] += array_get(keyArray, valueArray, probes[i]) != NULL;
+        double t2 = now_seconds();
+        for (int s = 0; s < kScans; s++) {
+            uint64_t at = lower_bound(keyArray, probes[s]);
+            uint64_t size = OCArrayGetCount(keyArray);
+            for (int n = 0; n < kScanLength && at < size; n++, at++)
+                scanned[0] += OCArrayGetValueAtIndex(valueArray, at) != NULL;
+        }
+        double t3 = now_seconds();
+        for (int i = 0; i < count; i += 2) array_remove(keyArray, valueArray, keys[i]);
+        double t4 = now_seconds();
+        times[0][0] = t1 - t0;
+        times[0][1] = t2 - t1;
+        times[0][2] = t3 - t2;
+        times[0][3] = t4 - t3;
+        OCRelease(keyArray);
+        OCRelease(valueArray);
+    }
+    // B+ tree
+    {
+        OCMutableSortedDictionaryRef dict = OCSortedDictionaryCreateMutable(compare_numbers, NULL);
+        double t0 = now_seconds();
+        for (int i = 0; i < count; i++) OCSortedDictionarySetValue(dict, keys[i], keys[i]);
+        double t1 = now_seconds();
+        for (int i = 0; i < kLookups; i++) hits[1] += OCSortedDictionaryGetValue(dict, probes[i]) != NULL;
+        double t2 = now_seconds();
+        for (int s = 0; s < kScans; s++) {
+            OCSortedDictionaryCursor cursor;
+            const void *value;
+            OCSortedDictionaryCursorInit(&cursor, dict, probes[s], NULL);
+            for (int n = 0; n < kScanLength && OCSortedDictionaryCursorNext(&cursor, NULL, &value); n++)
+                scanned[1] += value != NULL;
+        }
+        double t3 = now_seconds();
+        // Bulk load the same entries from their sorted order
+        uint64_t size = OCSortedDictionaryGetCount(dict);
+        const void **sortedKeys = malloc(size * sizeof(void *));
+        const void **sortedValues = malloc(size * sizeof(void *));
+        OCSortedDictionaryCursor cursor;
+        uint64_t n = 0;
+        OCSortedDictionaryCursorInit(&cursor, dict, NULL, NULL);
+        while (OCSortedDictionaryCursorNext(&cursor, &sortedKeys[n], &sortedValues[n])) n++;
+        double t4 = now_seconds();
+        OCSortedDictionaryRef loaded = OCSortedDictionaryCreate(sortedKeys, sortedValues, n, compare_numbers, NULL);
+        double t5 = now_seconds();
+        OCRelease(loaded);
+        free(sortedKeys);
+        free(sortedValues);
+        double t6 = now_seconds();
+        for (int i = 0; i < count; i += 2) OCSortedDictionaryRemoveValue(dict, keys[i]);
+        double t7 = now_seconds();
+        times[1][0] = t1 - t0;
+        times[1][1] = t2 - t1;
+        times[1][2] = t3 - t2;
+        times[1][3] = t7 - t6;
+        times[1][4] = t5 - t4;
+        OCRelease(dict);
+    }
+    if (hits[0] != hits[1] || scanned[0] != scanned[1]) printf("results differ!\n");
+    printf("%d random inserts, %d lookups, %d scans of %d, removal of every other inserted key\n", count, kLookups,
+           kScans, kScanLength);
+    printf("%-20s %12s %12s %12s %12s %14s\n", "map", "insert (ms)", "lookup (ms)", "scan (ms)", "remove (ms)",
+           "bulk load (ms)");
+    printf("%-20s %12.1f %12.1f %12.2f %12.1f %14s\n", "sorted OCArrays", times[0][0] * 1e3, times[0][1] * 1e3,
+           times[0][2] * 1e3, times[0][3] * 1e3, "-");
+    printf("%-20s %12.1f %12.1f %12.2f %12.1f %14.1f\n", "OCSortedDictionary", times[1][0] * 1e3, times[1][1] * 1e3,
+           times[1][2] * 1e3, times[1][3] * 1e3, times[1][4] * 1e3);
+    for (int i = 0; i < count; i++) OCRelease(keys[i]);
+    for (int i = 0; i < kLookups; i++) OCRelease(probes[i]);
+    free(keys);
+    free(probes);
+    OCTypesShutdown();
+    return 0;
+}
@@ -0,0 +1,55 @@
+// bench_string_rope.c — building a large report with a flat vs. rope mutable string
+//
+// Appends many formatted rows, then inserts and deletes lines near the front,
+// which moves the whole tail of a flat buffer but only one path of the rope.
+// Build and run with `make bench`.
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "OCTypes.h"
+#define kRowCount 100000
+#define kEditCount 5000
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+static void run(const char *label, OCMutableStringRef s) {
+    double t0 = now_seconds();
+    for (int i = 0; i < kRowCount; i++) {
+        OCStringAppendFormat(s, STR("row %d: value=%g status=%s\n"), i, i * 0.5, (i & 1) ? "odd" : "even");
+    }
+    double t1 = now_seconds();
+    OCStringRef line = STR("inserted line of text\n");
+    uint64_t lineLength = OCStringGetLength(line);
+    for (int i = 0; i < kEditCount; i++) {
+        int64_t at = (int64_t)((uint64_t)i * 37 % 1000);
+        OCStringInsert(s, at, line);
+        OCStringDelete(s, OCRangeMake(at + lineLength, 10));
+    }
+    double t2 = now_seconds();
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink) {
+        OCStringWriteToStream(s, sink);
+        fclose(sink);
+    }
+    double t3 = now_seconds();
+    size_t bytes = strlen(OCStringGetCString(s));
+    double t4 = now_seconds();
+    printf("%-6s append %7.1f ms   edit %8.1f ms   stream %6.1f ms   flatten %6.1f ms   (%zu bytes)\n",
+           label, (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3, (t4 - t3) * 1e3, bytes);
+}
+int main(void) {
+    OCMutableStringRef flat = OCStringCreateMutable(0);
+    OCMutableStringRef rope = OCStringCreateMutableRope();
+    run("flat", flat);
+    run("rope", rope);
+    bool same = OCStringEqual(flat, rope);
+    OCRelease(flat);
+    OCRelease(rope);
+    OCTypesShutdown();
+    return same ? 0 : 1;
+}
@@ -4,30 +4,27 @@
 //
 //  Created by philip on 4/2/17.
 //
-#if (defined(__GNUC__) && (defined(_WIN32) || defined(__CYGWIN__))) || \
-    (defined(_MSC_VER) && defined(_WIN32))
-// For qsort_s (C11 Annex K)
-#ifndef __STDC_WANT_LIB_EXT1__
-#define __STDC_WANT_LIB_EXT1__ 1
-#endif
-#endif
 #if defined(__linux__) || (defined(__GNUC__) && (defined(_WIN32) || defined(__CYGWIN__)))
-// For GNU-specific extensions (like GNU qsort_r if available)
+// For GNU-specific extensions (like sysconf(_SC_NPROCESSORS_ONLN))
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
 #endif
 #include "OCArray.h"  // Own header first
+#include <math.h>     // For NAN
 #include <stdbool.h>  // For bool
 #include <stdint.h>   // For uint64_t, etc.
 #include <stdio.h>
-#include <stdlib.h>        // For qsort, qsort_r, qsort_s, malloc, etc.
+#include <stdlib.h>        // For malloc, etc.
 #include <string.h>        // For memcpy
 #include "OCString.h"      // For OCString functions
 #include "OCBoolean.h"     // For OCBoolean functions
 #include "OCNumber.h"      // For OCNumber functions
 #include "OCNull.h"        // For OCNull functions
 #include "OCDictionary.h"  // For OCDictionary functions
+#include "OCIndexSet.h"    // For OCArrayRemoveValuesAtIndexes
+#include "OCAutoreleasePool.h"  // For per-batch pools in OCArrayApplyFunction
+#include "OCThreadPool.h"       // For concurrent sort, apply, map and filter
 #if defined(__APPLE__)
 #include <malloc/malloc.h>  // For malloc_zone_t
 #else
@@ -40,15 +37,44 @@
 static OCTypeID kOCArrayID = kOCNotATypeID;
 const OCArrayCallBacks kOCTypeArrayCallBacks = {0, OCRetain, OCRelease, OCTypeCopyFormattingDesc, OCTypeEqual};
 static const OCArrayCallBacks __kOCNullArrayCallBacks = {0, NULL, NULL, NULL, NULL};
+// Lookup index from values to the first index holding an equal value. Slots
+// are open-addressed and store the position plus one, so zero marks empty.
+typedef struct {
+    uint64_t hash;
+    uint64_t position;
+} impl_OCArrayValueIndexSlot;
+typedef struct {
+    uint64_t (*hash)(const void *);
+    uint64_t mask;
+    uint64_t count;
+    impl_OCArrayValueIndexSlot slots[];
+} impl_OCArrayValueIndex;
 // OCArray Opaque Type
 struct impl_OCArray {
     OCBase base;
     // OCArray Type attributes  - order of declaration is essential
     const OCArrayCallBacks *callBacks;
     uint64_t count;     // Changed from u_int64_t
-    uint64_t capacity;  // Changed from u_int64_t
-    const void **data;
+    uint64_t capacity;  // slots from data to the end of the buffer
+    const void **data;  // first value; the buffer starts headroom slots earlier
+    OCArrayGrowthPolicy growthPolicy;
+    OCArrayStorageMode storageMode;
+    uint64_t headroom;  // free slots before data
+    bool valueIndexEnabled;
+    impl_OCArrayValueIndex *valueIndex;  // built by the first lookup after a change
+    // Persistent arrays keep their values in a 32-way trie whose nodes are
+    // shared between versions; data is then only a flat view built on demand
+    bool persistent;
+    unsigned trieShift;
+    struct impl_OCArrayTrieNode *trieRoot;
+    struct impl_OCArrayTrieNode *trieTail;
+    // Copies share storage until one of them changes. A copy, and a mutable
+    // array that has been copied, point data into the buffer of the immutable
+    // array 'parent' and hold no references of their own to the values.
+    bool isMutable;
+    OCArrayRef parent;
 };
+static const void **impl_OCArrayGetValues(OCArrayRef theArray);
 static bool impl_OCArrayEqual(const void *theType1, const void *theType2) {
     OCArrayRef a1 = (OCArrayRef)theType1;
     OCArrayRef a2 = (OCArrayRef)theType2;
@@ -63,9 +89,12 @@ static bool impl_OCArrayEqual(const void *theType1, const void *theType2) {
     } else if (a1->callBacks && a1->callBacks->equal) {
         equalFn = a1->callBacks->equal;
     }
+    const void **values1 = impl_OCArrayGetValues(a1);
+    const void **values2 = impl_OCArrayGetValues(a2);
+    if (a1->count && (!values1 || !values2)) return false;
     for (uint64_t i = 0; i < a1->count; ++i) {
-        const void *v1 = a1->data[i];
-        const void *v2 = a2->data[i];
+        const void *v1 = values1[i];
+        const void *v2 = values2[i];
         if (equalFn) {
             if (!equalFn(v1, v2)) return false;
         } else {
@@ -75,7 +104,8 @@ static bool impl_OCArrayEqual(const void *theType1, const void *theType2) {
     return true;
 }
 static void impl_OCArrayReleaseValues(OCArrayRef theArray) {
-    if (theArray && theArray->callBacks && theArray->callBacks->release) {
+    // A persistent array's values belong to its trie nodes
+    if (theArray && !theArray->persistent && theArray->callBacks && theArray->callBacks->release) {
         for (uint64_t index = 0; index < theArray->count; index++) {
             if (theArray->data[index]) {  // Add a NULL check for safety before dereferencing
                 theArray->callBacks->release(theArray->data[index]);
@@ -92,13 +122,447 @@ static void impl_OCArrayRetainValues(OCArrayRef theArray) {
         }
     }
 }
+// Retains or releases a run of values with the callback looked up once
+static void impl_OCArrayRetainRange(const OCArrayCallBacks *cb, const void **values, uint64_t count) {
+    OCArrayRetainCallBack retain = cb ? cb->retain : NULL;
+    if (!retain) return;
+    for (uint64_t i = 0; i < count; i++) {
+        if (values[i]) retain(values[i]);
+    }
+}
+static void impl_OCArrayReleaseRange(const OCArrayCallBacks *cb, const void **values, uint64_t count) {
+    OCArrayReleaseCallBack release = cb ? cb->release : NULL;
+    if (!release) return;
+    for (uint64_t i = 0; i < count; i++) {
+        if (values[i]) release(values[i]);
+    }
+}
+static const void **impl_OCArrayBuffer(OCArrayRef theArray) {
+    return theArray->data ? theArray->data - theArray->headroom : NULL;
+}
+// Lays the values out again with at least `front` free slots before them and
+// room for `needed` values from the first. The current buffer is reused when
+// that leaves spare room worth at least half the values moved; otherwise it
+// grows as the growth policy asks, unless `exact` is set. Deque storage splits
+// the spare room between both ends, linear storage keeps it all at the back.
+static bool impl_OCArrayResize(struct impl_OCArray *theArray, uint64_t front, uint64_t needed, bool exact,
+                               const char *caller) {
+    const void **buffer = impl_OCArrayBuffer(theArray);
+    uint64_t total = theArray->headroom + theArray->capacity;
+    uint64_t count = theArray->count;
+    uint64_t minimum = front + needed;
+    uint64_t newTotal = minimum;
+    if (minimum <= total && (exact || total - minimum >= count / 2)) {
+        newTotal = total;
+    } else if (!exact) {
+        switch (theArray->growthPolicy) {
+            case kOCArrayGrowthDouble:
+                if (total * 2 > newTotal) newTotal = total * 2;
+                break;
+            case kOCArrayGrowthOneAndHalf:
+                if (total + total / 2 > newTotal) newTotal = total + total / 2;
+                break;
+            case kOCArrayGrowthExact:
+                break;
+        }
+    }
+    uint64_t newHead = front + (theArray->storageMode == kOCArrayStorageDeque ? (newTotal - minimum) / 2 : 0);
+    const void **newBuffer;
+    if (newTotal == total) {
+        newBuffer = buffer;
+        memmove(newBuffer + newHead, theArray->data, count * sizeof(const void *));
+    } else if (newHead == 0) {
+        // Pack the values at the start so realloc carries them over
+        if (theArray->headroom) {
+            memmove(buffer, theArray->data, count * sizeof(const void *));
+            theArray->data = buffer;
+            theArray->capacity = total;
+            theArray->headroom = 0;
+        }
+        newBuffer = (const void **)realloc(buffer, newTotal * sizeof(const void *));
+        if (newBuffer == NULL) {
+            fprintf(stderr, "%s: Memory reallocation failed.\n", caller);
+            return false;
+        }
+    } else {
+        newBuffer = (const void **)malloc(newTotal * sizeof(const void *));
+        if (newBuffer == NULL) {
+            fprintf(stderr, "%s: Memory allocation failed.\n", caller);
+            return false;
+        }
+        if (count) memcpy(newBuffer + newHead, theArray->data, count * sizeof(const void *));
+        free((void *)buffer);
+    }
+    theArray->data = newBuffer + newHead;
+    theArray->headroom = newHead;
+    theArray->capacity = newTotal - newHead;
+    return true;
+}
+// Makes room for at least `needed` values from the first one
+static bool impl_OCArrayEnsureCapacity(struct impl_OCArray *theArray, uint64_t needed, bool exact, const char *caller) {
+    if (needed <= theArray->capacity) return true;
+    return impl_OCArrayResize(theArray, 0, needed, exact, caller);
+}
+// Makes at least `front` slots free before the first value
+static bool impl_OCArrayEnsureHeadroom(struct impl_OCArray *theArray, uint64_t front, const char *caller) {
+    if (front <= theArray->headroom) return true;
+    return impl_OCArrayResize(theArray, front, theArray->count, false, caller);
+}
+// Persistent arrays are 32-way tries with a separate tail leaf, as in
+// Clojure's PersistentVector. The first count - tailCount values fill whole
+// leaves under trieRoot, trieShift bits above the leaf level; the rest sit in
+// trieTail. Nodes are immutable once shared and reference counted, so an
+// append or a set copies only the path it changes. Each leaf retains its
+// values once, and releases them when the last version using it goes away.
+#define kOCArrayTrieBits 5
+#define kOCArrayTrieWidth (1u << kOCArrayTrieBits)
+#define kOCArrayTrieMask (kOCArrayTrieWidth - 1)
+typedef struct impl_OCArrayTrieNode {
+    uint64_t refCount;
+    const void *slots[kOCArrayTrieWidth];  // values in leaves, child nodes above; unused slots are NULL
+} impl_OCArrayTrieNode;
+static impl_OCArrayTrieNode *impl_OCArrayTrieNodeCreate(void) {
+    impl_OCArrayTrieNode *node = (impl_OCArrayTrieNode *)calloc(1, sizeof(impl_OCArrayTrieNode));
+    if (node) node->refCount = 1;
+    return node;
+}
+static impl_OCArrayTrieNode *impl_OCArrayTrieNodeRetain(impl_OCArrayTrieNode *node) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (node) __atomic_add_fetch(&node->refCount, 1, __ATOMIC_RELAXED);
+#else
+    if (node) node->refCount++;
+#endif
+    return node;
+}
+// Releases a node `level` bits above the leaves
+static void impl_OCArrayTrieNodeRelease(impl_OCArrayTrieNode *node, unsigned level, const OCArrayCallBacks *cb) {
+    if (node == NULL) return;
+#if defined(__GNUC__) || defined(__clang__)
+    if (__atomic_sub_fetch(&node->refCount, 1, __ATOMIC_ACQ_REL) != 0) return;
+#else
+    if (--node->refCount != 0) return;
+#endif
+    for (unsigned i = 0; i < kOCArrayTrieWidth && node->slots[i]; i++) {
+        if (level > 0)
+            impl_OCArrayTrieNodeRelease((impl_OCArrayTrieNode *)node->slots[i], level - kOCArrayTrieBits, cb);
+        else if (cb && cb->release)
+            cb->release(node->slots[i]);
+    }
+    free(node);
+}
+// Unshared copy of a node, retaining what its slots refer to
+static impl_OCArrayTrieNode *impl_OCArrayTrieNodeCopy(const impl_OCArrayTrieNode *node, unsigned level,
+                                                      const OCArrayCallBacks *cb) {
+    impl_OCArrayTrieNode *copy = impl_OCArrayTrieNodeCreate();
+    if (copy == NULL || node == NULL) return copy;
+    memcpy(copy->slots, node->slots, sizeof(copy->slots));
+    for (unsigned i = 0; i < kOCArrayTrieWidth && copy->slots[i]; i++) {
+        if (level > 0)
+            impl_OCArrayTrieNodeRetain((impl_OCArrayTrieNode *)copy->slots[i]);
+        else if (cb && cb->retain)
+            cb->retain(copy->slots[i]);
+    }
+    return copy;
+}
+static uint64_t impl_OCArrayTrieTailOffset(uint64_t count) {
+    return count == 0 ? 0 : ((count - 1) >> kOCArrayTrieBits) << kOCArrayTrieBits;
+}
+static const void *impl_OCArrayTrieGet(OCArrayRef theArray, uint64_t index) {
+    uint64_t tailOffset = impl_OCArrayTrieTailOffset(theArray->count);
+    if (index >= tailOffset) return theArray->trieTail->slots[index - tailOffset];
+    const impl_OCArrayTrieNode *node = theArray->trieRoot;
+    for (unsigned level = theArray->trieShift; level > 0; level -= kOCArrayTrieBits)
+        node = (const impl_OCArrayTrieNode *)node->slots[(index >> level) & kOCArrayTrieMask];
+    return node->slots[index & kOCArrayTrieMask];
+}
+// Chain of single-child nodes leading down `level` bits to a leaf
+static impl_OCArrayTrieNode *impl_OCArrayTrieNewPath(unsigned level, impl_OCArrayTrieNode *leaf) {
+    impl_OCArrayTrieNode *node = leaf;
+    for (; level > 0; level -= kOCArrayTrieBits) {
+        impl_OCArrayTrieNode *parent = impl_OCArrayTrieNodeCreate();
+        if (parent == NULL) {
+            // Free the chain built so far, leaving the caller's leaf alone
+            while (node != leaf) {
+                impl_OCArrayTrieNode *child = (impl_OCArrayTrieNode *)node->slots[0];
+                free(node);
+                node = child;
+            }
+            return NULL;
+        }
+        parent->slots[0] = node;
+        node = parent;
+    }
+    return node;
+}
+// Copy of `parent` with a full leaf added as value number `count`'s block
+static impl_OCArrayTrieNode *impl_OCArrayTriePushLeaf(const impl_OCArrayTrieNode *parent, unsigned level,
+                                                      uint64_t count, impl_OCArrayTrieNode *leaf) {
+    impl_OCArrayTrieNode *copy = impl_OCArrayTrieNodeCopy(parent, level, NULL);
+    if (copy == NULL) return NULL;
+    unsigned slot = (unsigned)((count - 1) >> level) & kOCArrayTrieMask;
+    impl_OCArrayTrieNode *child;
+    if (level == kOCArrayTrieBits) {
+        child = leaf;
+    } else if (copy->slots[slot]) {
+        child = impl_OCArrayTriePushLeaf((const impl_OCArrayTrieNode *)copy->slots[slot], level - kOCArrayTrieBits,
+                                         count, leaf);
+        if (child) impl_OCArrayTrieNodeRelease((impl_OCArrayTrieNode *)copy->slots[slot], level - kOCArrayTrieBits, NULL);
+    } else {
+        child = impl_OCArrayTrieNewPath(level - kOCArrayTrieBits, leaf);
+    }
+    if (child == NULL) {
+        impl_OCArrayTrieNodeRelease(copy, level, NULL);
+        return NULL;
+    }
+    copy->slots[slot] = child;
+    return copy;
+}
+// Copy of the path to `index` with its value replaced
+static impl_OCArrayTrieNode *impl_OCArrayTrieSet(const impl_OCArrayTrieNode *node, unsigned level, uint64_t index,
+                                                 const void *value, const OCArrayCallBacks *cb) {
+    impl_OCArrayTrieNode *copy = impl_OCArrayTrieNodeCopy(node, level, cb);
+    if (copy == NULL) return NULL;
+    unsigned slot = (unsigned)(index >> level) & kOCArrayTrieMask;
+    if (level == 0) {
+        if (cb && cb->retain) cb->retain(value);
+        if (cb && cb->release) cb->release(copy->slots[slot]);
+        copy->slots[slot] = value;
+        return copy;
+    }
+    impl_OCArrayTrieNode *old = (impl_OCArrayTrieNode *)copy->slots[slot];
+    impl_OCArrayTrieNode *child = impl_OCArrayTrieSet(old, level - kOCArrayTrieBits, index, value, cb);
+    if (child == NULL) {
+        impl_OCArrayTrieNodeRelease(copy, level, cb);
+        return NULL;
+    }
+    impl_OCArrayTrieNodeRelease(old, level - kOCArrayTrieBits, cb);
+    copy->slots[slot] = child;
+    return copy;
+}
+// Replaces the value at index in the trie held through root and tail with a
+// copy of the path to it
+static bool impl_OCArrayTrieReplace(impl_OCArrayTrieNode **root, unsigned shift, impl_OCArrayTrieNode **tail,
+                                    uint64_t count, uint64_t index, const void *value, const OCArrayCallBacks *cb) {
+    uint64_t tailOffset = impl_OCArrayTrieTailOffset(count);
+    bool inTail = index >= tailOffset;
+    impl_OCArrayTrieNode **node = inTail ? tail : root;
+    unsigned level = inTail ? 0 : shift;
+    impl_OCArrayTrieNode *copy = impl_OCArrayTrieSet(*node, level, inTail ? index - tailOffset : index, value, cb);
+    if (copy == NULL) return false;
+    impl_OCArrayTrieNodeRelease(*node, level, cb);
+    *node = copy;
+    return true;
+}
+// Builds a trie over a flat run of values, retaining each once
+static bool impl_OCArrayTrieBuild(const void **values, uint64_t count, const OCArrayCallBacks *cb,
+                                  impl_OCArrayTrieNode **outRoot, impl_OCArrayTrieNode **outTail,
+                                  unsigned *outShift) {
+    uint64_t tailOffset = impl_OCArrayTrieTailOffset(count);
+    uint64_t nodeCount = tailOffset >> kOCArrayTrieBits;
+    impl_OCArrayTrieNode *tail = impl_OCArrayTrieNodeCreate();
+    impl_OCArrayTrieNode **nodes = (impl_OCArrayTrieNode **)malloc((nodeCount ? nodeCount : 1) * sizeof(void *));
+    if (tail == NULL || nodes == NULL) {
+        free(tail);
+        free(nodes);
+        return false;
+    }
+    if (count) memcpy(tail->slots, values + tailOffset, (count - tailOffset) * sizeof(const void *));
+    impl_OCArrayRetainRange(cb, tail->slots, count - tailOffset);
+    // Full leaves first, then each level of parents in place over its
+    // children; parent p only overwrites entries its predecessors consumed
+    unsigned shift = 0;
+    uint64_t made = 0;
+    for (; made < nodeCount; made++) {
+        nodes[made] = impl_OCArrayTrieNodeCreate();
+        if (nodes[made] == NULL) goto fail;
+        memcpy(nodes[made]->slots, values + (made << kOCArrayTrieBits), sizeof(nodes[made]->slots));
+        impl_OCArrayRetainRange(cb, nodes[made]->slots, kOCArrayTrieWidth);
+    }
+    while (nodeCount > 0 && (shift == 0 || nodeCount > 1)) {
+        uint64_t parentCount = (nodeCount + kOCArrayTrieMask) >> kOCArrayTrieBits;
+        for (made = 0; made < parentCount; made++) {
+            impl_OCArrayTrieNode *parent = impl_OCArrayTrieNodeCreate();
+            if (parent == NULL) goto fail_level;
+            uint64_t first = made << kOCArrayTrieBits;
+            for (uint64_t c = first; c < nodeCount && c < first + kOCArrayTrieWidth; c++)
+                parent->slots[c - first] = nodes[c];
+            nodes[made] = parent;
+        }
+        nodeCount = parentCount;
+        shift += kOCArrayTrieBits;
+    }
+    *outRoot = nodeCount ? nodes[0] : NULL;
+    *outTail = tail;
+    *outShift = nodeCount ? shift : kOCArrayTrieBits;
+    free(nodes);
+    return true;
+fail_level:
+    // Parents [0, made) are complete; children from made's block on are not yet adopted
+    for (uint64_t c = made << kOCArrayTrieBits; c < nodeCount; c++)
+        impl_OCArrayTrieNodeRelease(nodes[c], shift, cb);
+    shift += kOCArrayTrieBits;
+fail:
+    for (uint64_t i = 0; i < made; i++)
+        impl_OCArrayTrieNodeRelease(nodes[i], shift, cb);
+    free(nodes);
+    impl_OCArrayTrieNodeRelease(tail, 0, cb);
+    return false;
+}
+// Returns the array's values as one contiguous run. Persistent arrays build
+// the flat view on first use; lookups on a shared array may race to build it,
+// and whichever view lands first is kept.
+static const void **impl_OCArrayGetValues(OCArrayRef theArray) {
+    if (!theArray->persistent) return theArray->data;
+    struct impl_OCArray *a = (struct impl_OCArray *)theArray;
+#if defined(__GNUC__) || defined(__clang__)
+    const void **view = __atomic_load_n(&a->data, __ATOMIC_ACQUIRE);
+#else
+    const void **view = a->data;
+#endif
+    if (view || theArray->count == 0) return view;
+    const void **built = (const void **)malloc(theArray->count * sizeof(const void *));
+    if (built == NULL) {
+        fprintf(stderr, "OCArray: Memory allocation failed for a flat view of a persistent array.\n");
+        return NULL;
+    }
+    uint64_t tailOffset = impl_OCArrayTrieTailOffset(theArray->count);
+    for (uint64_t i = 0; i < tailOffset; i += kOCArrayTrieWidth) {
+        const impl_OCArrayTrieNode *node = theArray->trieRoot;
+        for (unsigned level = theArray->trieShift; level > 0; level -= kOCArrayTrieBits)
+            node = (const impl_OCArrayTrieNode *)node->slots[(i >> level) & kOCArrayTrieMask];
+        memcpy(built + i, node->slots, sizeof(node->slots));
+    }
+    memcpy(built + tailOffset, theArray->trieTail->slots, (theArray->count - tailOffset) * sizeof(const void *));
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__atomic_compare_exchange_n(&a->data, &view, built, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free((void *)built);
+        return view;
+    }
+#else
+    a->data = built;
+#endif
+    return built;
+}
+// Value index. Lookups build it on demand; appends extend it in place and
+// every other mutation drops it. Types without a registered hash function
+// all hash alike, so a build that meets a long probe run gives up and leaves
+// a marker that keeps lookups linear until the next mutation.
+#define kOCArrayValueIndexMaxProbe 128
+static impl_OCArrayValueIndex impl_OCArrayValueIndexUnusable;
+static uint64_t impl_OCArrayHashPointer(const void *value) {
+    return (uint64_t)(uintptr_t)value;
+}
+static OCArrayEqualCallBack impl_OCArrayGetEqual(OCArrayRef theArray) {
+    if (theArray->callBacks == &kOCTypeArrayCallBacks) return OCTypeEqual;
+    return theArray->callBacks ? theArray->callBacks->equal : NULL;
+}
+// Hash consistent with the array's equality, or NULL if there is none
+static uint64_t (*impl_OCArrayGetHash(OCArrayRef theArray))(const void *) {
+    OCArrayEqualCallBack equal = impl_OCArrayGetEqual(theArray);
+    if (equal == NULL) return impl_OCArrayHashPointer;
+    if (equal == OCTypeEqual) return OCTypeHash;
+    return NULL;
+}
+static uint64_t impl_OCArrayMixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+// Adds data[position] unless an equal value is already indexed. Returns false
+// when the probe run grows too long to be worth indexing.
+static bool impl_OCArrayValueIndexAdd(impl_OCArrayValueIndex *index, OCArrayRef theArray, uint64_t position) {
+    const void *value = theArray->data[position];
+    OCArrayEqualCallBack equal = impl_OCArrayGetEqual(theArray);
+    uint64_t hash = impl_OCArrayMixHash(index->hash(value));
+    uint64_t slot = hash & index->mask;
+    for (uint64_t probe = 0; probe < kOCArrayValueIndexMaxProbe; probe++) {
+        impl_OCArrayValueIndexSlot *s = &index->slots[slot];
+        if (s->position == 0) {
+            s->hash = hash;
+            s->position = position + 1;
+            index->count++;
+            return true;
+        }
+        if (s->hash == hash) {
+            const void *indexed = theArray->data[s->position - 1];
+            if (equal ? equal(indexed, value) : indexed == value) return true;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    return false;
+}
+static void impl_OCArrayValueIndexFree(impl_OCArrayValueIndex *index) {
+    if (index != &impl_OCArrayValueIndexUnusable) free(index);
+}
+static impl_OCArrayValueIndex *impl_OCArrayValueIndexBuild(OCArrayRef theArray) {
+    uint64_t capacity = 16;
+    while (capacity < theArray->count * 2) capacity *= 2;
+    impl_OCArrayValueIndex *index = (impl_OCArrayValueIndex *)calloc(
+        1, sizeof(impl_OCArrayValueIndex) + capacity * sizeof(impl_OCArrayValueIndexSlot));
+    if (index == NULL) return NULL;
+    index->hash = impl_OCArrayGetHash(theArray);
+    index->mask = capacity - 1;
+    for (uint64_t i = 0; i < theArray->count; i++) {
+        if (!impl_OCArrayValueIndexAdd(index, theArray, i)) {
+            free(index);
+            return &impl_OCArrayValueIndexUnusable;
+        }
+    }
+    return index;
+}
+// Returns the array's index, building it first if needed, or NULL if the
+// array is not indexed. Lookups on a shared immutable array may race to
+// build it; whichever build lands first is kept.
+static impl_OCArrayValueIndex *impl_OCArrayGetValueIndex(OCArrayRef theArray) {
+    if (!theArray->valueIndexEnabled) return NULL;
+    struct impl_OCArray *a = (struct impl_OCArray *)theArray;
+#if defined(__GNUC__) || defined(__clang__)
+    impl_OCArrayValueIndex *index = __atomic_load_n(&a->valueIndex, __ATOMIC_ACQUIRE);
+#else
+    impl_OCArrayValueIndex *index = a->valueIndex;
+#endif
+    if (index == NULL) {
+        impl_OCArrayValueIndex *built = impl_OCArrayValueIndexBuild(theArray);
+        if (built == NULL) return NULL;
+#if defined(__GNUC__) || defined(__clang__)
+        if (!__atomic_compare_exchange_n(&a->valueIndex, &index, built, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            impl_OCArrayValueIndexFree(built);
+        } else {
+            index = built;
+        }
+#else
+        a->valueIndex = index = built;
+#endif
+    }
+    return index == &impl_OCArrayValueIndexUnusable ? NULL : index;
+}
+static void impl_OCArrayInvalidateValueIndex(struct impl_OCArray *theArray) {
+    if (theArray->valueIndex == NULL) return;
+    impl_OCArrayValueIndexFree(theArray->valueIndex);
+    theArray->valueIndex = NULL;
+}
+// Keeps a built index current after values were appended at [first, count)
+static void impl_OCArrayValueIndexAppended(struct impl_OCArray *theArray, uint64_t first) {
+    impl_OCArrayValueIndex *index = theArray->valueIndex;
+    if (index == NULL || index == &impl_OCArrayValueIndexUnusable) return;
+    for (uint64_t i = first; i < theArray->count; i++) {
+        // Past three quarters full, leave the resize to the next lookup's rebuild
+        if ((index->count + 1) * 4 > (index->mask + 1) * 3 || !impl_OCArrayValueIndexAdd(index, theArray, i)) {
+            impl_OCArrayInvalidateValueIndex(theArray);
+            return;
+        }
+    }
+}
 static void *impl_OCArrayDeepCopy(const void *obj) {
     const OCArrayRef src = (const OCArrayRef)obj;
     if (!src) return NULL;
     OCMutableArrayRef copy = OCArrayCreateMutable(src->count, src->callBacks);
     if (!copy) return NULL;
     for (uint64_t i = 0; i < src->count; ++i) {
-        const void *value = src->data[i];
+        const void *value = OCArrayGetValueAtIndex(src, i);
         const void *copied = NULL;
         if (src->callBacks == &kOCTypeArrayCallBacks) {
             copied = OCTypeDeepCopy(value);
@@ -199,25 +663,47 @@ static cJSON *impl_OCArrayCopyJSON(const void *obj, bool typed, OCStringRef *out
 static void impl_OCArrayFinalize(const void *theType) {
     if (NULL == theType) return;
     struct impl_OCArray *theArray = (struct impl_OCArray *)theType;
+    impl_OCArrayInvalidateValueIndex(theArray);
+    if (theArray->parent) {
+        // Borrowed values and buffer belong to the parent
+        OCRelease(theArray->parent);
+        theArray->parent = NULL;
+        theArray->data = NULL;
+        return;
+    }
     impl_OCArrayReleaseValues(theArray);
-    // Only free non-NULL data
-    if (theArray->data) {
+    if (theArray->persistent) {
+        impl_OCArrayTrieNodeRelease(theArray->trieRoot, theArray->trieShift, theArray->callBacks);
+        impl_OCArrayTrieNodeRelease(theArray->trieTail, 0, theArray->callBacks);
+        theArray->trieRoot = theArray->trieTail = NULL;
+    }
+    // Only free non-NULL data; a persistent array's flat view holds no references
+    const void **buffer = impl_OCArrayBuffer(theArray);
+    if (buffer) {
 #if defined(__APPLE__)
-        malloc_zone_t *zone = malloc_zone_from_ptr(theArray->data);
+        malloc_zone_t *zone = malloc_zone_from_ptr(buffer);
         if (zone) {
-            free((void *)theArray->data);
+            free((void *)buffer);
         } else {
-            fprintf(stderr, "OCArrayFinalize: invalid free of %p\n", theArray->data);
+            fprintf(stderr, "OCArrayFinalize: invalid free of %p\n", (void *)buffer);
         }
 #else
-        free((void *)theArray->data);
+        free((void *)buffer);
 #endif
         theArray->data = NULL;
+        theArray->headroom = 0;
     }
 }
+static bool impl_OCArrayIsMutable(const void *obj);
+static bool impl_OCArrayAnyChild(const void *obj, bool (*visit)(const void *, void *), void *info);
+static void *impl_OCArrayCreateShared(const void *obj);
+static bool impl_OCArrayReplaceChildren(void *obj, const void *(*map)(const void *, void *), void *info);
+static const OCTypeSharedCopyCallBacks kOCArraySharedCopyCallBacks = {
+    impl_OCArrayIsMutable, impl_OCArrayAnyChild, impl_OCArrayCreateShared, impl_OCArrayReplaceChildren};
 OCTypeID OCArrayGetTypeID(void) {
     if (kOCArrayID == kOCNotATypeID) {
         kOCArrayID = OCRegisterType("OCArray", (OCTypeRef (*)(cJSON *, OCStringRef *))OCArrayCreateFromJSONTyped);
+        OCTypeSetSharedCopyCallBacks(kOCArrayID, &kOCArraySharedCopyCallBacks);
     }
     return kOCArrayID;
 }
@@ -236,8 +722,119 @@ static struct impl_OCArray *OCArrayAllocate() {
     obj->count = 0;
     obj->capacity = 0;
     obj->data = NULL;
+    obj->growthPolicy = kOCArrayGrowthDouble;
+    obj->storageMode = kOCArrayStorageLinear;
+    obj->headroom = 0;
+    obj->valueIndexEnabled = false;
+    obj->valueIndex = NULL;
+    obj->persistent = false;
+    obj->trieShift = 0;
+    obj->trieRoot = NULL;
+    obj->trieTail = NULL;
+    obj->isMutable = false;
+    obj->parent = NULL;
     return obj;
 }
+// Returns the immutable array whose buffer holds theArray's values. A mutable
+// array that owns its buffer hands it over to a new immutable array, reachable
+// only through the arrays borrowing from it, and borrows it back; copies made
+// at the same time on other threads agree on one owner.
+static OCArrayRef impl_OCArrayShareStorage(OCArrayRef theArray) {
+    struct impl_OCArray *a = (struct impl_OCArray *)theArray;
+#if defined(__GNUC__) || defined(__clang__)
+    OCArrayRef parent = __atomic_load_n(&a->parent, __ATOMIC_ACQUIRE);
+#else
+    OCArrayRef parent = a->parent;
+#endif
+    if (parent) return parent;
+    if (!theArray->isMutable) return theArray;
+    struct impl_OCArray *owner = OCArrayAllocate();
+    if (owner == NULL) return NULL;
+    owner->callBacks = theArray->callBacks;
+    owner->count = theArray->count;
+    owner->capacity = theArray->capacity;
+    owner->data = theArray->data;
+    owner->headroom = theArray->headroom;
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__atomic_compare_exchange_n(&a->parent, &parent, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        owner->data = NULL;
+        owner->count = 0;
+        OCRelease(owner);
+        return parent;
+    }
+#else
+    a->parent = owner;
+#endif
+    return owner;
+}
+// Gives a borrowing array a buffer of its own before it changes. When the
+// other copies are gone the buffer is simply taken back.
+static bool impl_OCArrayUnshare(struct impl_OCArray *theArray, const char *caller) {
+    if (theArray->parent == NULL) return true;
+    struct impl_OCArray *owner = (struct impl_OCArray *)theArray->parent;
+    if (OCTypeGetRetainCount(owner) == 1) {
+        owner->data = NULL;
+        owner->count = 0;
+    } else if (theArray->data) {
+        uint64_t total = theArray->headroom + theArray->capacity;
+        const void **buffer = (const void **)malloc(total * sizeof(const void *));
+        if (buffer == NULL) {
+            fprintf(stderr, "%s: Memory allocation failed.\n", caller);
+            return false;
+        }
+        memcpy(buffer + theArray->headroom, theArray->data, theArray->count * sizeof(const void *));
+        theArray->data = buffer + theArray->headroom;
+        impl_OCArrayRetainRange(theArray->callBacks, theArray->data, theArray->count);
+    }
+    theArray->parent = NULL;
+    OCRelease(owner);
+    return true;
+}
+static struct impl_OCArray *impl_OCArrayCreateBorrowing(OCArrayRef owner, bool isMutable) {
+    struct impl_OCArray *copy = OCArrayAllocate();
+    if (copy == NULL) return NULL;
+    copy->callBacks = owner->callBacks;
+    copy->count = owner->count;
+    copy->capacity = owner->capacity;
+    copy->data = owner->data;
+    copy->headroom = owner->headroom;
+    copy->isMutable = isMutable;
+    copy->parent = (OCArrayRef)OCRetain(owner);
+    return copy;
+}
+// Wraps a trie in a new persistent array, taking over the references to
+// root and tail; on failure they are released
+static OCArrayRef impl_OCArrayCreatePersistent(const OCArrayCallBacks *callBacks, uint64_t count,
+                                               impl_OCArrayTrieNode *root, unsigned shift, impl_OCArrayTrieNode *tail) {
+    struct impl_OCArray *newArray = OCArrayAllocate();
+    if (NULL == newArray) {
+        impl_OCArrayTrieNodeRelease(root, shift, callBacks);
+        impl_OCArrayTrieNodeRelease(tail, 0, callBacks);
+        return NULL;
+    }
+    newArray->callBacks = callBacks;
+    newArray->count = count;
+    newArray->persistent = true;
+    newArray->trieRoot = root;
+    newArray->trieShift = shift;
+    newArray->trieTail = tail;
+    return newArray;
+}
+// Returns references to the array's trie, building one if it is flat
+static bool impl_OCArrayGetTrie(OCArrayRef theArray, impl_OCArrayTrieNode **root, unsigned *shift,
+                                impl_OCArrayTrieNode **tail, const char *caller) {
+    if (theArray->persistent) {
+        *root = impl_OCArrayTrieNodeRetain(theArray->trieRoot);
+        *shift = theArray->trieShift;
+        *tail = impl_OCArrayTrieNodeRetain(theArray->trieTail);
+        return true;
+    }
+    if (!impl_OCArrayTrieBuild(theArray->data, theArray->count, theArray->callBacks, root, tail, shift)) {
+        fprintf(stderr, "%s: Memory allocation failed.\n", caller);
+        return false;
+    }
+    return true;
+}
 OCArrayRef OCArrayCreate(const void **values, uint64_t numValues, const OCArrayCallBacks *callBacks) {
     // Allow creation of an empty array even if values is NULL, as long as numValues is 0.
     if (numValues > 0 && NULL == values) return NULL;
@@ -262,8 +859,11 @@ OCArrayRef OCArrayCreate(const void **values, uint64_t numValues, const OCArrayC
 }
 OCArrayRef OCArrayCreateCopy(OCArrayRef theArray) {
     if (NULL == theArray) return NULL;  // Handle NULL input
-    // For immutable copies, capacity can be same as count
-    return (OCArrayRef)OCArrayCreate((const void **)theArray->data, theArray->count, theArray->callBacks);
+    // An immutable array is its own copy; a mutable one shares its buffer
+    // with the copy until it next changes
+    if (!theArray->isMutable) return (OCArrayRef)OCRetain(theArray);
+    OCArrayRef owner = impl_OCArrayShareStorage(theArray);
+    return owner ? impl_OCArrayCreateBorrowing(owner, false) : NULL;
 }
 OCMutableArrayRef OCArrayCreateMutable(uint64_t capacity, const OCArrayCallBacks *callBacks) {
     struct impl_OCArray *newArray = OCArrayAllocate();
@@ -281,21 +881,144 @@ OCMutableArrayRef OCArrayCreateMutable(uint64_t capacity, const OCArrayCallBacks
     newArray->count = 0;
     newArray->capacity = capacity;
     newArray->callBacks = callBacks ? callBacks : &__kOCNullArrayCallBacks;
+    newArray->isMutable = true;
     return newArray;
 }
 OCMutableArrayRef OCArrayCreateMutableCopy(OCArrayRef theArray) {
     if (NULL == theArray) return NULL;
+    if (!theArray->persistent) {
+        // Borrow the values until the copy first changes
+        OCArrayRef owner = impl_OCArrayShareStorage(theArray);
+        return owner ? impl_OCArrayCreateBorrowing(owner, true) : NULL;
+    }
     // Create a mutable copy with initial capacity at least the count of the original array.
     OCMutableArrayRef newMutableArray = OCArrayCreateMutable(theArray->count > 0 ? theArray->count : 1,
                                                              theArray->callBacks);
     if (NULL == newMutableArray) return NULL;
     if (theArray->count > 0) {
-        memcpy(newMutableArray->data, theArray->data, theArray->count * sizeof(const void *));
+        const void **values = impl_OCArrayGetValues(theArray);
+        if (values == NULL) {
+            OCRelease(newMutableArray);
+            return NULL;
+        }
+        memcpy(newMutableArray->data, values, theArray->count * sizeof(const void *));
         newMutableArray->count = theArray->count;
         impl_OCArrayRetainValues(newMutableArray);  // Retain values copied into the new mutable array
     }
     return newMutableArray;
 }
+OCArrayRef OCArrayCreateByAppendingValue(OCArrayRef theArray, const void *value) {
+    if (theArray == NULL || value == NULL) return NULL;
+    impl_OCArrayTrieNode *root, *tail;
+    unsigned shift;
+    if (!impl_OCArrayGetTrie(theArray, &root, &shift, &tail, "OCArrayCreateByAppendingValue")) return NULL;
+    const OCArrayCallBacks *cb = theArray->callBacks;
+    uint64_t count = theArray->count;
+    uint64_t tailCount = count - impl_OCArrayTrieTailOffset(count);
+    impl_OCArrayTrieNode *newTail = NULL;
+    if (tailCount < kOCArrayTrieWidth) {
+        // Room left in the tail: only the tail is copied
+        newTail = impl_OCArrayTrieNodeCopy(tail, 0, cb);
+        if (newTail == NULL) goto fail;
+        newTail->slots[tailCount] = cb->retain ? cb->retain(value) : value;
+        impl_OCArrayTrieNodeRelease(tail, 0, cb);
+        return impl_OCArrayCreatePersistent(cb, count + 1, root, shift, newTail);
+    }
+    // Full tail: it moves into the trie and the value starts a new tail
+    newTail = impl_OCArrayTrieNodeCreate();
+    if (newTail == NULL) goto fail;
+    impl_OCArrayTrieNode *newRoot;
+    if (root == NULL) {
+        newRoot = impl_OCArrayTrieNewPath(shift, tail);
+    } else if ((count >> kOCArrayTrieBits) > ((uint64_t)1 << shift)) {
+        // The trie is full at this height; grow a new root above it
+        newRoot = impl_OCArrayTrieNodeCreate();
+        impl_OCArrayTrieNode *path = newRoot ? impl_OCArrayTrieNewPath(shift, tail) : NULL;
+        if (path == NULL) {
+            free(newRoot);
+            newRoot = NULL;
+        } else {
+            newRoot->slots[0] = root;
+            newRoot->slots[1] = path;
+            root = NULL;  // now owned by newRoot
+            shift += kOCArrayTrieBits;
+        }
+    } else {
+        newRoot = impl_OCArrayTriePushLeaf(root, shift, count, tail);
+    }
+    if (newRoot == NULL) goto fail;
+    // The tail now belongs to newRoot
+    if (root) impl_OCArrayTrieNodeRelease(root, shift, cb);
+    newTail->slots[0] = cb->retain ? cb->retain(value) : value;
+    return impl_OCArrayCreatePersistent(cb, count + 1, newRoot, shift, newTail);
+fail:
+    fprintf(stderr, "OCArrayCreateByAppendingValue: Memory allocation failed.\n");
+    impl_OCArrayTrieNodeRelease(newTail, 0, cb);
+    impl_OCArrayTrieNodeRelease(root, shift, cb);
+    impl_OCArrayTrieNodeRelease(tail, 0, cb);
+    return NULL;
+}
+OCArrayRef OCArrayCreateBySettingValueAtIndex(OCArrayRef theArray, uint64_t index, const void *value) {
+    if (theArray == NULL || value == NULL || index >= theArray->count) return NULL;
+    impl_OCArrayTrieNode *root, *tail;
+    unsigned shift;
+    if (!impl_OCArrayGetTrie(theArray, &root, &shift, &tail, "OCArrayCreateBySettingValueAtIndex")) return NULL;
+    const OCArrayCallBacks *cb = theArray->callBacks;
+    if (!impl_OCArrayTrieReplace(&root, shift, &tail, theArray->count, index, value, cb)) {
+        fprintf(stderr, "OCArrayCreateBySettingValueAtIndex: Memory allocation failed.\n");
+        impl_OCArrayTrieNodeRelease(root, shift, cb);
+        impl_OCArrayTrieNodeRelease(tail, 0, cb);
+        return NULL;
+    }
+    return impl_OCArrayCreatePersistent(cb, theArray->count, root, shift, tail);
+}
+bool OCArrayIsPersistent(OCArrayRef theArray) {
+    return theArray != NULL && theArray->persistent;
+}
+// ——— OCTypeDeepCopyShared support ———
+// Only arrays with kOCTypeArrayCallBacks hold OCTypes, so other arrays are
+// copied without looking at their values.
+static bool impl_OCArrayIsMutable(const void *obj) {
+    return ((OCArrayRef)obj)->isMutable;
+}
+static bool impl_OCArrayAnyChild(const void *obj, bool (*visit)(const void *, void *), void *info) {
+    OCArrayRef theArray = (OCArrayRef)obj;
+    if (theArray->callBacks != &kOCTypeArrayCallBacks) return false;
+    for (uint64_t i = 0; i < theArray->count; i++)
+        if (visit(OCArrayGetValueAtIndex(theArray, i), info)) return true;
+    return false;
+}
+static void *impl_OCArrayCreateShared(const void *obj) {
+    OCArrayRef theArray = (OCArrayRef)obj;
+    if (theArray->isMutable) return OCArrayCreateMutableCopy(theArray);
+    if (theArray->persistent) {
+        impl_OCArrayTrieNode *root, *tail;
+        unsigned shift;
+        if (!impl_OCArrayGetTrie(theArray, &root, &shift, &tail, "OCTypeDeepCopyShared")) return NULL;
+        return (void *)impl_OCArrayCreatePersistent(theArray->callBacks, theArray->count, root, shift, tail);
+    }
+    OCArrayRef owner = impl_OCArrayShareStorage(theArray);
+    return owner ? impl_OCArrayCreateBorrowing(owner, false) : NULL;
+}
+static bool impl_OCArrayReplaceChildren(void *obj, const void *(*map)(const void *, void *), void *info) {
+    struct impl_OCArray *copy = (struct impl_OCArray *)obj;
+    if (copy->callBacks != &kOCTypeArrayCallBacks) return true;
+    for (uint64_t i = 0; i < copy->count; i++) {
+        const void *value = OCArrayGetValueAtIndex(copy, i);
+        const void *replacement = map(value, info);
+        if (replacement == value) continue;
+        if (copy->persistent) {
+            if (!impl_OCArrayTrieReplace(&copy->trieRoot, copy->trieShift, &copy->trieTail, copy->count, i,
+                                         replacement, copy->callBacks)) {
+                fprintf(stderr, "OCTypeDeepCopyShared: Memory allocation failed.\n");
+                return false;
+            }
+        } else if (!OCArraySetValueAtIndex(copy, (OCIndex)i, replacement)) {
+            return false;
+        }
+    }
+    return true;
+}
 // Helper function to create OCNumber with specific type from double value
 static OCNumberRef impl_OCNumberCreateWithTypeFromDouble(double value, OCNumberType type) {
     switch (type) {
@@ -525,11 +1248,19 @@ OCArrayRef OCArrayCreateFromJSONTyped(cJSON *json, OCStringRef *outError) {
         if (outError) *outError = STR("Failed to create mutable array");
         return NULL;
     }
+    OCDictionaryRef lastRecord = NULL;
     for (int i = 0; i < arraySize; i++) {
         cJSON *elem = cJSON_GetArrayItem(json, i);
-        // Use the global typed factory function to deserialize each element
         OCStringRef elemError = NULL;
-        OCTypeRef obj = OCTypeCreateFromJSONTyped(elem, &elemError);
+        OCTypeRef obj;
+        if (cJSON_IsObject(elem) && !cJSON_IsString(cJSON_GetObjectItem(elem, "type"))) {
+            // Plain objects are dictionaries; records of one shape share their keys
+            obj = (OCTypeRef)OCDictionaryCreateFromJSONWithSharedKeys(elem, true, lastRecord, &elemError);
+            lastRecord = (OCDictionaryRef)obj;
+        } else {
+            // Use the global typed factory function to deserialize each element
+            obj = OCTypeCreateFromJSONTyped(elem, &elemError);
+        }
         if (obj) {
             OCArrayAppendValue(result, obj);
             OCRelease(obj);  // OCArrayAppendValue retains
@@ -578,6 +1309,7 @@ OCArrayRef OCArrayCreateFromJSON(cJSON *json, OCStringRef *outError) {
         return NULL;
     }
     // Process each element according to its JSON type
+    OCDictionaryRef lastRecord = NULL;
     for (int i = 0; i < arraySize; i++) {
         cJSON *elem = cJSON_GetArrayItem(json, i);
         if (!elem) {
@@ -609,8 +1341,9 @@ OCArrayRef OCArrayCreateFromJSON(cJSON *json, OCStringRef *outError) {
                 *outError = elemError ? elemError : STR("Failed to create OCArray from JSON array element");
             }
         } else if (cJSON_IsObject(elem)) {
-            // JSON object → OCDictionary
-            ocValue = (OCTypeRef)OCDictionaryCreateFromJSON(elem, &elemError);
+            // JSON object → OCDictionary; records of one shape share their keys
+            ocValue = (OCTypeRef)OCDictionaryCreateFromJSONWithSharedKeys(elem, false, lastRecord, &elemError);
+            lastRecord = (OCDictionaryRef)ocValue;
             if (!ocValue && outError && !*outError) {
                 *outError = elemError ? elemError : STR("Failed to create OCDictionary from JSON object element");
             }
@@ -728,6 +1461,7 @@ OCArrayRef OCArrayOfNumbersCreateFromJSON(cJSON *json, OCNumberType numericType,
 const void *OCArrayGetValueAtIndex(OCArrayRef theArray, uint64_t index) {
     if (NULL == theArray) return NULL;
     if (index >= theArray->count) return NULL;
+    if (theArray->persistent) return impl_OCArrayTrieGet(theArray, index);
     return theArray->data[index];
 }
 bool OCArraySetValueAtIndex(OCMutableArrayRef theArray, OCIndex index, const void *value) {
@@ -739,6 +1473,7 @@ bool OCArraySetValueAtIndex(OCMutableArrayRef theArray, OCIndex index, const voi
         // No change needed
         return true;
     }
+    if (!impl_OCArrayUnshare(theArray, "OCArraySetValueAtIndex")) return false;
     const OCArrayCallBacks *cb = OCArrayGetCallBacks(theArray);
     // Release existing value if necessary
     if (cb && cb->release && oldValue) {
@@ -750,68 +1485,46 @@ bool OCArraySetValueAtIndex(OCMutableArrayRef theArray, OCIndex index, const voi
         retained = cb->retain(value);
     }
     theArray->data[index] = retained;
+    impl_OCArrayInvalidateValueIndex(theArray);
     return true;
 }
 bool OCArrayRemoveValueAtIndex(OCMutableArrayRef theArray, uint64_t index) {
     if (theArray == NULL || index >= theArray->count) {
         return false;
     }
-    const void *value = theArray->data[index];
-    const OCArrayCallBacks *cb = theArray->callBacks;
-    if (cb && cb->release && value) {
-        cb->release(value);
-    } else if (cb == &kOCTypeArrayCallBacks && value) {
-        OCRelease(value);
-    }
-    // Shift elements down
-    for (uint64_t i = index; i < theArray->count - 1; i++) {
-        theArray->data[i] = theArray->data[i + 1];
-    }
-    theArray->count--;
-    return true;
+    return OCArrayReplaceValuesInRange(theArray, OCRangeMake((OCIndex)index, 1), NULL, 0);
 }
 OCIndex OCArrayGetFirstIndexOfValue(OCArrayRef theArray, const void *value) {
-    if (NULL == theArray || NULL == value) return kOCNotFound;  // Use kOCNotFound
-    OCArrayEqualCallBack equalCB = NULL;
-    if (theArray->callBacks) {
-        equalCB = theArray->callBacks->equal;
-    }
-    if (theArray->callBacks == &kOCTypeArrayCallBacks) {  // Ensure OCTypeEqual is used for kOCTypeArrayCallBacks
-        equalCB = OCTypeEqual;
-    }
-    for (uint64_t index = 0; index < theArray->count; index++) {  // Changed to uint64_t for index
-        if (equalCB) {
-            if (equalCB(theArray->data[index], value)) return (long)index;
-        } else {  // Fallback to direct pointer comparison if no equal callback
-            if (theArray->data[index] == value) return (long)index;
+    if (NULL == theArray || NULL == value) return kOCNotFound;
+    const void **values = impl_OCArrayGetValues(theArray);
+    if (values == NULL) return kOCNotFound;
+    OCArrayEqualCallBack equal = impl_OCArrayGetEqual(theArray);
+    impl_OCArrayValueIndex *index = impl_OCArrayGetValueIndex(theArray);
+    if (index) {
+        uint64_t hash = impl_OCArrayMixHash(index->hash(value));
+        for (uint64_t slot = hash & index->mask; index->slots[slot].position; slot = (slot + 1) & index->mask) {
+            if (index->slots[slot].hash != hash) continue;
+            uint64_t position = index->slots[slot].position - 1;
+            const void *indexed = values[position];
+            if (equal ? equal(indexed, value) : indexed == value) return (OCIndex)position;
         }
+        return kOCNotFound;
+    }
+    for (uint64_t i = 0; i < theArray->count; i++) {
+        if (equal ? equal(values[i], value) : values[i] == value) return (OCIndex)i;
     }
-    return kOCNotFound;  // Use kOCNotFound
+    return kOCNotFound;
 }
 bool OCArrayAppendValue(OCMutableArrayRef theArray, const void *value) {
     if (theArray == NULL || value == NULL) {
         return false;
     }
-    OCTypeRef type = (OCTypeRef)value;  // Assuming value is an OCTypeRef
-    // Reallocate if needed
-    if (theArray->count == theArray->capacity) {
-        uint64_t newCapacity = (theArray->capacity == 0) ? 1 : theArray->capacity * 2;
-        const void **newData = (const void **)realloc(theArray->data, newCapacity * sizeof(const void *));
-        if (newData == NULL) {
-            fprintf(stderr, "OCArrayAppendValue: Memory reallocation failed.\n");
-            return false;
-        }
-        theArray->data = newData;
-        theArray->capacity = newCapacity;
-    }
+    if (!impl_OCArrayUnshare(theArray, "OCArrayAppendValue") ||
+        !impl_OCArrayEnsureCapacity(theArray, theArray->count + 1, false, "OCArrayAppendValue")) return false;
     theArray->data[theArray->count] = value;
-    // Retain if needed
-    if (theArray->callBacks && theArray->callBacks->retain) {
-        theArray->callBacks->retain(type);
-    } else if (theArray->callBacks == &kOCTypeArrayCallBacks) {
-        OCRetain(type);
-    }
+    impl_OCArrayRetainRange(theArray->callBacks, &theArray->data[theArray->count], 1);
     theArray->count++;
+    impl_OCArrayValueIndexAppended(theArray, theArray->count - 1);
     return true;
 }
 bool OCArrayAppendArray(OCMutableArrayRef theArray, OCArrayRef otherArray, OCRange range) {
@@ -823,138 +1536,847 @@ bool OCArrayAppendArray(OCMutableArrayRef theArray, OCArrayRef otherArray, OCRan
         (uint64_t)range.location + (uint64_t)range.length > count) {
         return false;
     }
-    for (uint64_t index = (uint64_t)range.location; index < (uint64_t)range.location + (uint64_t)range.length; index++) {
-        OCTypeRef theType = (OCTypeRef)OCArrayGetValueAtIndex(otherArray, index);
-        OCArrayAppendValue(theArray, theType);  // Assume this always succeeds
-    }
-    return true;
+    if (range.length == 0) return true;
+    const void **values = impl_OCArrayGetValues(otherArray);
+    if (values == NULL) return false;
+    return OCArrayInsertValuesAtIndex(theArray, theArray->count, &values[range.location], (uint64_t)range.length);
 }
 bool OCArrayInsertValueAtIndex(OCMutableArrayRef theArray, uint64_t index, const void *value) {
     if (theArray == NULL || value == NULL || index > theArray->count) {
         return false;
     }
-    OCTypeRef type = (OCTypeRef)value;
-    if (theArray->count == theArray->capacity) {
-        uint64_t newCapacity = (theArray->capacity == 0) ? 1 : theArray->capacity * 2;
-        const void **newData = (const void **)realloc(theArray->data, newCapacity * sizeof(const void *));
-        if (newData == NULL) {
-            fprintf(stderr, "OCArrayInsertValueAtIndex: Memory reallocation failed.\n");
+    return OCArrayReplaceValuesInRange(theArray, OCRangeMake((OCIndex)index, 0), &value, 1);
+}
+bool OCArrayReplaceValuesInRange(OCMutableArrayRef theArray, OCRange range, const void **newValues, uint64_t newCount) {
+    if (theArray == NULL || (newCount > 0 && newValues == NULL)) {
+        return false;
+    }
+    if (range.location < 0 || range.length < 0 ||
+        (uint64_t)range.location + (uint64_t)range.length > theArray->count) {
+        return false;
+    }
+    for (uint64_t i = 0; i < newCount; i++) {
+        if (newValues[i] == NULL) return false;
+    }
+    if (!impl_OCArrayUnshare(theArray, "OCArrayReplaceValuesInRange")) return false;
+    uint64_t location = (uint64_t)range.location;
+    uint64_t oldCount = (uint64_t)range.length;
+    uint64_t tailCount = theArray->count - location - oldCount;
+    // The source may be this array's own buffer, which the reallocation and
+    // the shift below would move out from under it
+    const void **source = newValues;
+    const void **scratch = NULL;
+    const void **buffer = impl_OCArrayBuffer(theArray);
+    if (newCount > 0 && buffer && newValues < theArray->data + theArray->capacity && newValues + newCount > buffer) {
+        scratch = (const void **)malloc(newCount * sizeof(const void *));
+        if (scratch == NULL) {
+            fprintf(stderr, "OCArrayReplaceValuesInRange: Memory allocation failed.\n");
             return false;
         }
-        theArray->data = newData;
-        theArray->capacity = newCapacity;
+        memcpy(scratch, newValues, newCount * sizeof(const void *));
+        source = scratch;
     }
-    for (uint64_t i = theArray->count; i > index; i--) {
-        theArray->data[i] = theArray->data[i - 1];
+    // Shift whichever side of the range holds fewer values: the values before
+    // it move into or out of the headroom, those after it into or out of the
+    // spare capacity. Removing from the front is then O(1), and so is
+    // inserting there while headroom lasts, which deque storage keeps up.
+    bool moveFront = location < tailCount;
+    if (newCount > oldCount) {
+        uint64_t grow = newCount - oldCount;
+        if (moveFront && theArray->storageMode == kOCArrayStorageDeque &&
+            !impl_OCArrayEnsureHeadroom(theArray, grow, "OCArrayReplaceValuesInRange")) {
+            free(scratch);
+            return false;
+        }
+        moveFront = moveFront && theArray->headroom >= grow;
+        if (!moveFront && !impl_OCArrayEnsureCapacity(theArray, theArray->count + grow, false,
+                                                       "OCArrayReplaceValuesInRange")) {
+            free(scratch);
+            return false;
+        }
     }
-    theArray->data[index] = value;
-    if (theArray->callBacks && theArray->callBacks->retain) {
-        theArray->callBacks->retain(type);
-    } else if (theArray->callBacks == &kOCTypeArrayCallBacks) {
-        OCRetain(type);
+    // Retain the incoming values before releasing the outgoing ones, in case
+    // a value is in both and this array holds its last reference
+    impl_OCArrayRetainRange(theArray->callBacks, source, newCount);
+    impl_OCArrayReleaseRange(theArray->callBacks, &theArray->data[location], oldCount);
+    if (newCount != oldCount && moveFront) {
+        int64_t shift = (int64_t)oldCount - (int64_t)newCount;
+        if (location > 0) memmove(theArray->data + shift, theArray->data, location * sizeof(const void *));
+        theArray->data += shift;
+        theArray->headroom = (uint64_t)((int64_t)theArray->headroom + shift);
+        theArray->capacity = (uint64_t)((int64_t)theArray->capacity - shift);
+    } else if (newCount != oldCount && tailCount > 0) {
+        memmove(&theArray->data[location + newCount], &theArray->data[location + oldCount],
+                tailCount * sizeof(const void *));
     }
-    theArray->count++;
+    if (newCount > 0) memcpy(&theArray->data[location], source, newCount * sizeof(const void *));
+    theArray->count = theArray->count - oldCount + newCount;
+    free(scratch);
+    if (theArray->count == 0 && theArray->data) {
+        // Start over from the middle (deque) or the start (linear) of the buffer
+        uint64_t total = theArray->headroom + theArray->capacity;
+        uint64_t head = theArray->storageMode == kOCArrayStorageDeque ? total / 2 : 0;
+        theArray->data = theArray->data - theArray->headroom + head;
+        theArray->headroom = head;
+        theArray->capacity = total - head;
+    }
+    if (oldCount == 0 && tailCount == 0)
+        impl_OCArrayValueIndexAppended(theArray, location);
+    else
+        impl_OCArrayInvalidateValueIndex(theArray);
+    return true;
+}
+bool OCArrayInsertValuesAtIndex(OCMutableArrayRef theArray, uint64_t index, const void **values, uint64_t count) {
+    if (theArray == NULL || index > theArray->count) {
+        return false;
+    }
+    return OCArrayReplaceValuesInRange(theArray, OCRangeMake((OCIndex)index, 0), values, count);
+}
+bool OCArrayRemoveValuesInRange(OCMutableArrayRef theArray, OCRange range) {
+    return OCArrayReplaceValuesInRange(theArray, range, NULL, 0);
+}
+bool OCArrayRemoveValuesAtIndexes(OCMutableArrayRef theArray, OCIndexSetRef indexSet) {
+    if (theArray == NULL || indexSet == NULL) {
+        return false;
+    }
+    OCIndex indexCount = OCIndexSetGetCount(indexSet);
+    if (indexCount == 0) return true;
+    // Index sets are kept sorted, so bounds come from the ends
+    const OCIndex *indexes = OCIndexSetGetBytesPtr(indexSet);
+    if (indexes[0] < 0 || (uint64_t)indexes[indexCount - 1] >= theArray->count) {
+        return false;
+    }
+    if (!impl_OCArrayUnshare(theArray, "OCArrayRemoveValuesAtIndexes")) return false;
+    // Compact the survivors in one pass, releasing the removed values
+    const OCArrayCallBacks *cb = theArray->callBacks;
+    uint64_t write = (uint64_t)indexes[0];
+    uint64_t read = write;
+    for (OCIndex i = 0; i < indexCount; i++) {
+        uint64_t removed = (uint64_t)indexes[i];
+        if (removed > read) {
+            memmove(&theArray->data[write], &theArray->data[read], (removed - read) * sizeof(const void *));
+            write += removed - read;
+        }
+        impl_OCArrayReleaseRange(cb, &theArray->data[removed], 1);
+        read = removed + 1;
+    }
+    memmove(&theArray->data[write], &theArray->data[read], (theArray->count - read) * sizeof(const void *));
+    theArray->count = write + (theArray->count - read);
+    impl_OCArrayInvalidateValueIndex(theArray);
     return true;
 }
+bool OCArrayReserveCapacity(OCMutableArrayRef theArray, uint64_t capacity) {
+    if (theArray == NULL || !impl_OCArrayUnshare(theArray, "OCArrayReserveCapacity")) return false;
+    // A reservation is an exact request, whatever the growth policy
+    return impl_OCArrayEnsureCapacity(theArray, capacity, true, "OCArrayReserveCapacity");
+}
+void OCArraySetGrowthPolicy(OCMutableArrayRef theArray, OCArrayGrowthPolicy policy) {
+    if (theArray == NULL) return;
+    theArray->growthPolicy = policy;
+}
+void OCArraySetStorageMode(OCMutableArrayRef theArray, OCArrayStorageMode mode) {
+    if (theArray == NULL) return;
+    theArray->storageMode = mode;
+}
+OCArrayStorageMode OCArrayGetStorageMode(OCArrayRef theArray) {
+    return theArray ? theArray->storageMode : kOCArrayStorageLinear;
+}
 struct _acompareContext {
     OCComparatorFunction func;
     void *context;
 };
 #define INVOKE_CALLBACK3(P, A, B, C) (P)(A, B, C)
 bool OCArrayContainsValue(OCArrayRef theArray, const void *value) {
-    if (NULL == theArray) return false;
-    if (NULL == value) return false;
-    if (theArray->callBacks == &kOCTypeArrayCallBacks) {
-        for (uint64_t index = 0; index < theArray->count; index++) {
-            if (OCTypeEqual(theArray->data[index], value)) return true;
-        }
-    } else if (theArray->callBacks) {
-        for (uint64_t index = 0; index < theArray->count; index++) {
-            if (theArray->callBacks->equal(theArray->data[index], value)) return true;
-        }
-    } else {
-        for (uint64_t index = 0; index < theArray->count; index++) {
-            if (theArray->data[index] == value) return true;
-        }
+    return OCArrayGetFirstIndexOfValue(theArray, value) != kOCNotFound;
+}
+bool OCArraySetValueIndexEnabled(OCArrayRef theArray, bool enabled) {
+    if (theArray == NULL) return false;
+    struct impl_OCArray *a = (struct impl_OCArray *)theArray;
+    if (enabled && impl_OCArrayGetHash(theArray) == NULL) {
+        fprintf(stderr, "OCArraySetValueIndexEnabled: The array's equal callback has no matching hash.\n");
+        return false;
     }
-    return false;
+    a->valueIndexEnabled = enabled;
+    if (!enabled) impl_OCArrayInvalidateValueIndex(a);
+    return true;
+}
+bool OCArrayIsValueIndexEnabled(OCArrayRef theArray) {
+    return theArray && theArray->valueIndexEnabled;
+}
+// Concurrent operations cut their range into slices, at most one per pool
+// thread and kOCArrayMaxWorkers in all, with none shorter than minSlice. The
+// count is kept a power of two so slices can be merged pairwise.
+#define kOCArrayMaxWorkers 16
+static unsigned impl_OCArrayWorkerCount(uint64_t count, uint64_t minSlice) {
+    uint64_t threads = OCThreadPoolGetThreadCount();
+    unsigned workers = 1;
+    while (workers * 2 <= kOCArrayMaxWorkers && workers * 2 <= threads && count / (workers * 2) >= minSlice)
+        workers *= 2;
+    return workers;
 }
-struct qsortContext {
+// Runs the tasks as one group on the shared thread pool, the first on the
+// caller's thread, which then helps with the rest until all have finished
+static void impl_OCArrayRunTasks(OCTaskFunction run, void *tasks, size_t taskSize, unsigned taskCount) {
+    char *task = (char *)tasks;
+    if (taskCount < 2) {
+        run(task);
+        return;
+    }
+    OCTaskGroupRef group = OCTaskGroupCreate();
+    for (unsigned t = 1; t < taskCount; t++) {
+        if (group == NULL || !OCTaskGroupSubmit(group, run, task + t * taskSize)) run(task + t * taskSize);
+    }
+    run(task);
+    OCTaskGroupRelease(group);
+}
+// Sorting is a stable merge sort: insertion-sorted runs of at most
+// kOCArraySortRunLength elements merged through a scratch buffer.
+// The same driver sorts either raw value pointers through the caller's
+// comparator or (key, value) records whose keys compare inline, which is how
+// OCArraySortNumbers and OCArraySortStrings avoid a callback per comparison.
+#define kOCArraySortRunLength 32
+#define kOCArraySortMinChunkLength ((uint64_t)1 << 14)
+typedef struct impl_OCArraySorter impl_OCArraySorter;
+struct impl_OCArraySorter {
+    size_t elementSize;
+    void (*insertionSort)(const impl_OCArraySorter *sorter, void *elements, uint64_t count);
+    void (*merge)(const impl_OCArraySorter *sorter, const void *left, uint64_t leftCount,
+                  const void *right, uint64_t rightCount, void *out);
     OCComparatorFunction comparator;
     void *context;
+    bool descending;
+    bool stringTies;  // records with equal keys need a full string compare
+    bool numberTies;  // equal double keys may hide distinct 64-bit integers
 };
-// Comparator wrapper for qsort_r (BSD, macOS) and qsort_s (MSVC)
-// Signature: int (*compar)(void *thunk, const void *a, const void *b)
-#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || (defined(_MSC_VER) && defined(_WIN32))
-static int thunk_first_qsort_compare_wrapper(void *thunk, const void *val1_ptr, const void *val2_ptr) {
-    struct qsortContext *myContext = (struct qsortContext *)thunk;
-    const void *obj1 = *((const void **)val1_ptr);
-    const void *obj2 = *((const void **)val2_ptr);
-    return myContext->comparator(obj1, obj2, myContext->context);
+// A real number read at its own precision
+typedef enum { kOCArraySortFloat, kOCArraySortSigned, kOCArraySortUnsigned } impl_OCArraySortNumberKind;
+typedef struct {
+    impl_OCArraySortNumberKind kind;
+    union {
+        double d;
+        int64_t s;
+        uint64_t u;
+    } v;
+} impl_OCArraySortNumber;
+typedef struct {
+    uint64_t key;
+    const void *value;
+    // What the key cannot hold, for comparing past it
+    union {
+        const char *bytes;              // strings
+        impl_OCArraySortNumber number;  // numbers
+    } tie;
+} impl_OCArraySortRecord;
+// Exact order of two numbers whose double keys are equal; such a float is
+// integral whenever the other number is an integer
+static int impl_OCArraySortNumberCompare(const impl_OCArraySortNumber *a, const impl_OCArraySortNumber *b) {
+    if (a->kind == kOCArraySortFloat && b->kind == kOCArraySortFloat) return 0;
+    if (a->kind == kOCArraySortFloat) return -impl_OCArraySortNumberCompare(b, a);
+    if (b->kind == kOCArraySortFloat) {
+        double d = b->v.d;
+        if (a->kind == kOCArraySortSigned) {
+            if (d >= 0x1p63) return -1;
+            if (d < -0x1p63) return 1;
+            int64_t t = (int64_t)d;
+            return (a->v.s > t) - (a->v.s < t);
+        }
+        if (d >= 0x1p64) return -1;
+        if (d < 0) return 1;
+        uint64_t t = (uint64_t)d;
+        return (a->v.u > t) - (a->v.u < t);
+    }
+    if (a->kind == kOCArraySortSigned && b->kind == kOCArraySortSigned) return (a->v.s > b->v.s) - (a->v.s < b->v.s);
+    if (a->kind == kOCArraySortSigned) {
+        if (a->v.s < 0) return -1;
+        return ((uint64_t)a->v.s > b->v.u) - ((uint64_t)a->v.s < b->v.u);
+    }
+    if (b->kind == kOCArraySortSigned) return -impl_OCArraySortNumberCompare(b, a);
+    return (a->v.u > b->v.u) - (a->v.u < b->v.u);
 }
-#endif
-// Comparator wrapper for qsort_r (GNU/Linux, MinGW, Cygwin GCC)
-// Signature: int (*compar)(const void *a, const void *b, void *thunk)
-#if defined(__linux__) || (defined(__GNUC__) && (defined(_WIN32) || defined(__CYGWIN__)))
-static int thunk_last_qsort_compare_wrapper(const void *val1_ptr, const void *val2_ptr, void *thunk) {
-    struct qsortContext *myContext = (struct qsortContext *)thunk;
-    const void *obj1 = *((const void **)val1_ptr);
-    const void *obj2 = *((const void **)val2_ptr);
-    return myContext->comparator(obj1, obj2, myContext->context);
+// True when a must be placed strictly before b
+static inline bool impl_OCArraySortPointerPrecedes(const impl_OCArraySorter *sorter, const void *a, const void *b) {
+    OCComparisonResult r = sorter->comparator(a, b, sorter->context);
+    return sorter->descending ? r == kOCCompareGreaterThan : r == kOCCompareLessThan;
 }
-#endif
-void OCArraySortValues(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator, void *context) {
-    if (theArray == NULL || theArray->count == 0 || comparator == NULL || range.length == 0) {
+static inline bool impl_OCArraySortRecordPrecedes(const impl_OCArraySorter *sorter,
+                                                  const impl_OCArraySortRecord *a, const impl_OCArraySortRecord *b) {
+    if (a->key != b->key) return a->key < b->key;
+    int r;
+    if (sorter->stringTies)
+        r = strcmp(a->tie.bytes, b->tie.bytes);
+    else if (sorter->numberTies)
+        r = impl_OCArraySortNumberCompare(&a->tie.number, &b->tie.number);
+    else
+        return false;
+    return sorter->descending ? r > 0 : r < 0;
+}
+// Binary insertion keeps comparator calls near log2(run length) per value;
+// searching past equal values keeps the insertion stable
+static void impl_OCArrayInsertionSortPointers(const impl_OCArraySorter *sorter, void *elements, uint64_t count) {
+    const void **v = (const void **)elements;
+    for (uint64_t i = 1; i < count; i++) {
+        const void *x = v[i];
+        uint64_t lo = 0, hi = i;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (impl_OCArraySortPointerPrecedes(sorter, x, v[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(&v[lo + 1], &v[lo], (i - lo) * sizeof(const void *));
+        v[lo] = x;
+    }
+}
+static void impl_OCArrayInsertionSortRecords(const impl_OCArraySorter *sorter, void *elements, uint64_t count) {
+    impl_OCArraySortRecord *v = (impl_OCArraySortRecord *)elements;
+    for (uint64_t i = 1; i < count; i++) {
+        impl_OCArraySortRecord x = v[i];
+        uint64_t lo = 0, hi = i;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (impl_OCArraySortRecordPrecedes(sorter, &x, &v[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(&v[lo + 1], &v[lo], (i - lo) * sizeof(impl_OCArraySortRecord));
+        v[lo] = x;
+    }
+}
+// Merges take from the right run only when it strictly precedes the left,
+// which keeps equal elements in their original order
+static void impl_OCArrayMergePointers(const impl_OCArraySorter *sorter, const void *left, uint64_t leftCount,
+                                      const void *right, uint64_t rightCount, void *out) {
+    const void *const *l = (const void *const *)left;
+    const void *const *r = (const void *const *)right;
+    const void **o = (const void **)out;
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < leftCount && j < rightCount) {
+        if (impl_OCArraySortPointerPrecedes(sorter, r[j], l[i]))
+            o[k++] = r[j++];
+        else
+            o[k++] = l[i++];
+    }
+    memcpy(&o[k], &l[i], (leftCount - i) * sizeof(const void *));
+    memcpy(&o[k + leftCount - i], &r[j], (rightCount - j) * sizeof(const void *));
+}
+static void impl_OCArrayMergeRecords(const impl_OCArraySorter *sorter, const void *left, uint64_t leftCount,
+                                     const void *right, uint64_t rightCount, void *out) {
+    const impl_OCArraySortRecord *l = (const impl_OCArraySortRecord *)left;
+    const impl_OCArraySortRecord *r = (const impl_OCArraySortRecord *)right;
+    impl_OCArraySortRecord *o = (impl_OCArraySortRecord *)out;
+    uint64_t i = 0, j = 0, k = 0;
+    while (i < leftCount && j < rightCount) {
+        if (impl_OCArraySortRecordPrecedes(sorter, &r[j], &l[i]))
+            o[k++] = r[j++];
+        else
+            o[k++] = l[i++];
+    }
+    memcpy(&o[k], &l[i], (leftCount - i) * sizeof(impl_OCArraySortRecord));
+    memcpy(&o[k + leftCount - i], &r[j], (rightCount - j) * sizeof(impl_OCArraySortRecord));
+}
+// Top-down so each half is finished while it is still in cache; comparisons
+// dereference the values, which makes full passes over a large array costly.
+// The halves are sorted into whichever buffer the merge reads from, so no
+// level copies its output back.
+static void impl_OCArraySortInto(const impl_OCArraySorter *sorter, char *data, char *scratch, uint64_t count,
+                                 bool intoScratch) {
+    size_t size = sorter->elementSize;
+    if (count <= kOCArraySortRunLength) {
+        sorter->insertionSort(sorter, data, count);
+        if (intoScratch) memcpy(scratch, data, count * size);
         return;
     }
-    // Ensure range is valid
-    if (range.location < 0 || range.length < 0 ||
-        (uint64_t)range.location >= theArray->count ||
-        ((uint64_t)range.location + (uint64_t)range.length) > theArray->count) {
+    uint64_t half = count / 2;
+    impl_OCArraySortInto(sorter, data, scratch, half, !intoScratch);
+    impl_OCArraySortInto(sorter, data + half * size, scratch + half * size, count - half, !intoScratch);
+    const char *src = intoScratch ? data : scratch;
+    char *dst = intoScratch ? scratch : data;
+    sorter->merge(sorter, src, half, src + half * size, count - half, dst);
+}
+static void impl_OCArraySortSequential(const impl_OCArraySorter *sorter, char *data, char *scratch, uint64_t count) {
+    impl_OCArraySortInto(sorter, data, scratch, count, false);
+}
+// One unit of work for the concurrent sort: sort a chunk, or merge two
+// adjacent sorted chunks
+typedef struct {
+    const impl_OCArraySorter *sorter;
+    char *data;
+    char *scratch;
+    uint64_t count;
+    uint64_t leftCount;  // nonzero for a merge of data[0..leftCount) and the rest into scratch
+} impl_OCArraySortTask;
+static void impl_OCArraySortTaskRun(void *arg) {
+    impl_OCArraySortTask *task = (impl_OCArraySortTask *)arg;
+    const impl_OCArraySorter *sorter = task->sorter;
+    if (task->leftCount == 0) {
+        impl_OCArraySortSequential(sorter, task->data, task->scratch, task->count);
+    } else {
+        sorter->merge(sorter, task->data, task->leftCount, task->data + task->leftCount * sorter->elementSize,
+                      task->count - task->leftCount, task->scratch);
+    }
+}
+// Sorts equal slices on the thread pool, then merges neighbouring slices
+// pairwise, each level's merges also running side by side
+static void impl_OCArraySort(const impl_OCArraySorter *sorter, char *data, char *scratch, uint64_t count, bool concurrent) {
+    unsigned chunks = concurrent ? impl_OCArrayWorkerCount(count, kOCArraySortMinChunkLength) : 1;
+    if (chunks < 2) {
+        impl_OCArraySortSequential(sorter, data, scratch, count);
         return;
     }
-    struct qsortContext myContext = {comparator, context};
-    void **base_ptr = (void **)(theArray->data + range.location);
-    size_t nmemb = range.length;
-    size_t element_size = sizeof(void *);
-#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-    // BSD qsort_r: compar(thunk, a, b)
-    qsort_r(base_ptr, nmemb, element_size, &myContext, thunk_first_qsort_compare_wrapper);
-#elif defined(__linux__) && defined(_GNU_SOURCE)
-    // GNU/Linux qsort_r: compar(a, b, thunk)
-    qsort_r(base_ptr, nmemb, element_size, thunk_last_qsort_compare_wrapper, &myContext);
-#elif (defined(__GNUC__) && (defined(_WIN32) || defined(__CYGWIN__)))  // MinGW or Cygwin with GCC
-    {
-        void **arr = base_ptr;
-        for (size_t i = 1; i < nmemb; i++) {
-            void *tmp = arr[i];
-            size_t j = i;
-            while (j > 0) {
-                void *prev = arr[j - 1];
-                if (myContext.comparator(prev, tmp, myContext.context) > 0) {
-                    arr[j] = arr[j - 1];
-                    j--;
-                } else {
+    size_t size = sorter->elementSize;
+    uint64_t bounds[kOCArrayMaxWorkers + 1];
+    for (unsigned c = 0; c <= chunks; c++)
+        bounds[c] = count * c / chunks;
+    impl_OCArraySortTask tasks[kOCArrayMaxWorkers];
+    for (unsigned c = 0; c < chunks; c++) {
+        tasks[c] = (impl_OCArraySortTask){sorter, data + bounds[c] * size, scratch + bounds[c] * size,
+                                          bounds[c + 1] - bounds[c], 0};
+    }
+    impl_OCArrayRunTasks(impl_OCArraySortTaskRun, tasks, sizeof(impl_OCArraySortTask), chunks);
+    char *src = data;
+    char *dst = scratch;
+    for (unsigned width = 1; width < chunks; width *= 2) {
+        unsigned taskCount = 0;
+        for (unsigned c = 0; c < chunks; c += 2 * width) {
+            uint64_t start = bounds[c], mid = bounds[c + width], end = bounds[c + 2 * width];
+            tasks[taskCount++] = (impl_OCArraySortTask){sorter, src + start * size, dst + start * size,
+                                                        end - start, mid - start};
+        }
+        impl_OCArrayRunTasks(impl_OCArraySortTaskRun, tasks, sizeof(impl_OCArraySortTask), taskCount);
+        char *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != data) memcpy(data, src, count * size);
+}
+static bool impl_OCArraySortRangeIsValid(OCArrayRef theArray, OCRange range) {
+    return range.location >= 0 && range.length >= 0 &&
+           (uint64_t)range.location + (uint64_t)range.length <= theArray->count;
+}
+static bool impl_OCArraySortPointers(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator,
+                                     void *context, OCArraySortOptions options) {
+    if (theArray == NULL || comparator == NULL || !impl_OCArraySortRangeIsValid(theArray, range)) {
+        return false;
+    }
+    if (range.length < 2) return true;
+    if (!impl_OCArrayUnshare(theArray, "OCArraySortValues")) return false;
+    impl_OCArrayInvalidateValueIndex(theArray);
+    uint64_t count = (uint64_t)range.length;
+    char *scratch = (char *)malloc(count * sizeof(const void *));
+    if (scratch == NULL) {
+        fprintf(stderr, "OCArraySortValues: Memory allocation failed.\n");
+        return false;
+    }
+    impl_OCArraySorter sorter = {sizeof(const void *), impl_OCArrayInsertionSortPointers, impl_OCArrayMergePointers,
+                                 comparator, context, (options & kOCArraySortDescending) != 0, false, false};
+    impl_OCArraySort(&sorter, (char *)(theArray->data + range.location), scratch, count,
+                     (options & kOCArraySortConcurrent) != 0);
+    free(scratch);
+    return true;
+}
+void OCArraySortValues(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator, void *context) {
+    impl_OCArraySortPointers(theArray, range, comparator, context, kOCArraySortDefault);
+}
+bool OCArraySortValuesWithOptions(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator,
+                                  void *context, OCArraySortOptions options) {
+    return impl_OCArraySortPointers(theArray, range, comparator, context, options);
+}
+// Maps a double onto an unsigned key with the same order. Zeros and NaNs
+// are canonicalised first, so -0 ties with +0 and every NaN sorts last.
+static uint64_t impl_OCArraySortKeyForDouble(double d) {
+    if (d == 0.0) d = 0.0;
+    if (d != d) d = NAN;
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof bits);
+    return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+}
+// Reads a real OCNumber of any width, keeping 64-bit integers exact; complex
+// numbers have no natural order and are refused
+static bool impl_OCArraySortNumberValue(OCNumberRef number, impl_OCArraySortNumber *out) {
+    switch (OCNumberGetType(number)) {
+        case kOCNumberSInt8Type: {
+            int8_t v;
+            if (!OCNumberTryGetSInt8(number, &v)) return false;
+            out->kind = kOCArraySortSigned;
+            out->v.s = v;
+            return true;
+        }
+        case kOCNumberSInt16Type: {
+            int16_t v;
+            if (!OCNumberTryGetSInt16(number, &v)) return false;
+            out->kind = kOCArraySortSigned;
+            out->v.s = v;
+            return true;
+        }
+        case kOCNumberSInt32Type: {
+            int32_t v;
+            if (!OCNumberTryGetSInt32(number, &v)) return false;
+            out->kind = kOCArraySortSigned;
+            out->v.s = v;
+            return true;
+        }
+        case kOCNumberSInt64Type: {
+            int64_t v;
+            if (!OCNumberTryGetSInt64(number, &v)) return false;
+            out->kind = kOCArraySortSigned;
+            out->v.s = v;
+            return true;
+        }
+        case kOCNumberUInt8Type: {
+            uint8_t v;
+            if (!OCNumberTryGetUInt8(number, &v)) return false;
+            out->kind = kOCArraySortUnsigned;
+            out->v.u = v;
+            return true;
+        }
+        case kOCNumberUInt16Type: {
+            uint16_t v;
+            if (!OCNumberTryGetUInt16(number, &v)) return false;
+            out->kind = kOCArraySortUnsigned;
+            out->v.u = v;
+            return true;
+        }
+        case kOCNumberUInt32Type: {
+            uint32_t v;
+            if (!OCNumberTryGetUInt32(number, &v)) return false;
+            out->kind = kOCArraySortUnsigned;
+            out->v.u = v;
+            return true;
+        }
+        case kOCNumberUInt64Type: {
+            uint64_t v;
+            if (!OCNumberTryGetUInt64(number, &v)) return false;
+            out->kind = kOCArraySortUnsigned;
+            out->v.u = v;
+            return true;
+        }
+        case kOCNumberFloat32Type: {
+            float v;
+            if (!OCNumberTryGetFloat32(number, &v)) return false;
+            out->kind = kOCArraySortFloat;
+            out->v.d = v;
+            return true;
+        }
+        case kOCNumberFloat64Type:
+            out->kind = kOCArraySortFloat;
+            return OCNumberTryGetFloat64(number, &out->v.d);
+        default:
+            return false;
+    }
+}
+// The first eight bytes, big-endian, so keys order as strcmp would
+static uint64_t impl_OCArraySortKeyForBytes(const char *bytes) {
+    const unsigned char *p = (const unsigned char *)bytes;
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && p[i]; i++)
+        key = (key << 8) | p[i];
+    return i == 0 ? 0 : key << (8 * (8 - i));
+}
+static bool impl_OCArraySortByKey(OCMutableArrayRef theArray, OCRange range, OCArraySortOptions options,
+                                  bool strings, const char *caller) {
+    if (theArray == NULL || !impl_OCArraySortRangeIsValid(theArray, range)) {
+        return false;
+    }
+    if (range.length < 2) return true;
+    if (!impl_OCArrayUnshare(theArray, caller)) return false;
+    impl_OCArrayInvalidateValueIndex(theArray);
+    uint64_t count = (uint64_t)range.length;
+    const void **values = theArray->data + range.location;
+    OCTypeID expected = strings ? OCStringGetTypeID() : OCNumberGetTypeID();
+    impl_OCArraySortRecord *records = (impl_OCArraySortRecord *)malloc(2 * count * sizeof(impl_OCArraySortRecord));
+    if (records == NULL) {
+        fprintf(stderr, "%s: Memory allocation failed.\n", caller);
+        return false;
+    }
+    bool descending = (options & kOCArraySortDescending) != 0;
+    bool floats = false, negatives = false, beyondSigned = false;
+    for (uint64_t i = 0; i < count; i++) {
+        if (values[i] == NULL || OCGetTypeID(values[i]) != expected) {
+            free(records);
+            return false;
+        }
+        records[i].value = values[i];
+        if (strings) {
+            const char *bytes = OCStringGetCString((OCStringRef)values[i]);
+            if (bytes == NULL) {
+                free(records);
+                return false;
+            }
+            records[i].key = impl_OCArraySortKeyForBytes(bytes);
+            records[i].tie.bytes = bytes;
+        } else {
+            impl_OCArraySortNumber *n = &records[i].tie.number;
+            if (!impl_OCArraySortNumberValue((OCNumberRef)values[i], n)) {
+                free(records);
+                return false;
+            }
+            floats |= n->kind == kOCArraySortFloat;
+            negatives |= n->kind == kOCArraySortSigned && n->v.s < 0;
+            beyondSigned |= n->kind == kOCArraySortUnsigned && n->v.u > INT64_MAX;
+        }
+    }
+    // Integers key exactly when one 64-bit type holds them all: unsigned
+    // when none is negative, offset two's complement when none exceeds
+    // INT64_MAX. Anything else keys as a double and settles ties exactly.
+    bool exact = !strings && !floats && !(negatives && beyondSigned);
+    for (uint64_t i = 0; !strings && i < count; i++) {
+        const impl_OCArraySortNumber *n = &records[i].tie.number;
+        uint64_t bits = n->kind == kOCArraySortSigned ? (uint64_t)n->v.s : n->v.u;
+        if (!exact)
+            records[i].key = impl_OCArraySortKeyForDouble(n->kind == kOCArraySortFloat    ? n->v.d
+                                                          : n->kind == kOCArraySortSigned ? (double)n->v.s
+                                                                                          : (double)n->v.u);
+        else
+            records[i].key = negatives ? bits ^ 0x8000000000000000ULL : bits;
+    }
+    if (descending) {
+        for (uint64_t i = 0; i < count; i++)
+            records[i].key = ~records[i].key;
+    }
+    impl_OCArraySorter sorter = {sizeof(impl_OCArraySortRecord), impl_OCArrayInsertionSortRecords, impl_OCArrayMergeRecords,
+                                 NULL, NULL, descending, strings, !strings && !exact};
+    impl_OCArraySort(&sorter, (char *)records, (char *)(records + count), count, (options & kOCArraySortConcurrent) != 0);
+    for (uint64_t i = 0; i < count; i++)
+        values[i] = records[i].value;
+    free(records);
+    return true;
+}
+bool OCArraySortNumbers(OCMutableArrayRef theArray, OCRange range, OCArraySortOptions options) {
+    return impl_OCArraySortByKey(theArray, range, options, false, "OCArraySortNumbers");
+}
+bool OCArraySortStrings(OCMutableArrayRef theArray, OCRange range, OCArraySortOptions options) {
+    return impl_OCArraySortByKey(theArray, range, options, true, "OCArraySortStrings");
+}
+// Restores the max-heap property below v[i], where "max" is the value that
+// sorts last
+static void impl_OCArraySiftDown(const void **v, uint64_t count, uint64_t i,
+                                 OCComparatorFunction comparator, void *context) {
+    for (;;) {
+        uint64_t largest = i;
+        uint64_t l = 2 * i + 1, r = l + 1;
+        if (l < count && comparator(v[l], v[largest], context) == kOCCompareGreaterThan) largest = l;
+        if (r < count && comparator(v[r], v[largest], context) == kOCCompareGreaterThan) largest = r;
+        if (largest == i) return;
+        const void *t = v[i];
+        v[i] = v[largest];
+        v[largest] = t;
+        i = largest;
+    }
+}
+// Moves the k values that sort first to the front of v, in sorted order
+static bool impl_OCArraySelectFirst(const void **v, uint64_t count, uint64_t k,
+                                    OCComparatorFunction comparator, void *context) {
+    if (k > count) k = count;
+    if (k == 0) return true;
+    // Keep the k best seen so far in a max-heap whose root is the one to evict
+    for (uint64_t i = k / 2; i-- > 0;)
+        impl_OCArraySiftDown(v, k, i, comparator, context);
+    for (uint64_t i = k; i < count; i++) {
+        if (comparator(v[i], v[0], context) == kOCCompareLessThan) {
+            const void *t = v[0];
+            v[0] = v[i];
+            v[i] = t;
+            impl_OCArraySiftDown(v, k, 0, comparator, context);
+        }
+    }
+    if (k < 2) return true;
+    char *scratch = (char *)malloc(k * sizeof(const void *));
+    if (scratch == NULL) return false;
+    impl_OCArraySorter sorter = {sizeof(const void *), impl_OCArrayInsertionSortPointers, impl_OCArrayMergePointers,
+                                 comparator, context, false, false, false};
+    impl_OCArraySortSequential(&sorter, (char *)v, scratch, k);
+    free(scratch);
+    return true;
+}
+bool OCArrayPartialSortValues(OCMutableArrayRef theArray, OCRange range, uint64_t k,
+                              OCComparatorFunction comparator, void *context) {
+    if (theArray == NULL || comparator == NULL || !impl_OCArraySortRangeIsValid(theArray, range)) {
+        return false;
+    }
+    if (!impl_OCArrayUnshare(theArray, "OCArrayPartialSortValues")) return false;
+    impl_OCArrayInvalidateValueIndex(theArray);
+    if (!impl_OCArraySelectFirst(theArray->data + range.location, (uint64_t)range.length, k, comparator, context)) {
+        fprintf(stderr, "OCArrayPartialSortValues: Memory allocation failed.\n");
+        return false;
+    }
+    return true;
+}
+OCArrayRef OCArrayCreateWithFirstSortedValues(OCArrayRef theArray, uint64_t k,
+                                              OCComparatorFunction comparator, void *context) {
+    if (theArray == NULL || comparator == NULL) return NULL;
+    uint64_t count = theArray->count;
+    const void **v = (const void **)malloc((count ? count : 1) * sizeof(const void *));
+    if (v == NULL) {
+        fprintf(stderr, "OCArrayCreateWithFirstSortedValues: Memory allocation failed.\n");
+        return NULL;
+    }
+    const void **values = impl_OCArrayGetValues(theArray);
+    if (count && values == NULL) {
+        free(v);
+        return NULL;
+    }
+    if (count) memcpy(v, values, count * sizeof(const void *));
+    if (!impl_OCArraySelectFirst(v, count, k, comparator, context)) {
+        fprintf(stderr, "OCArrayCreateWithFirstSortedValues: Memory allocation failed.\n");
+        free(v);
+        return NULL;
+    }
+    OCArrayRef result = OCArrayCreate(v, k < count ? k : count, theArray->callBacks);
+    free(v);
+    return result;
+}
+// Apply, map and filter split their range into one slice per worker. Each
+// slice is walked in batches of kOCArrayApplyBatchLength values inside an
+// autorelease pool that is drained after every batch, so callbacks can
+// autorelease temporaries on any thread without them piling up.
+#define kOCArrayApplyBatchLength 1024
+#define kOCArrayApplyMinSliceLength ((uint64_t)1 << 12)
+typedef enum {
+    kOCArrayApplyKindApply,
+    kOCArrayApplyKindMap,
+    kOCArrayApplyKindFilter
+} impl_OCArrayApplyKind;
+typedef struct {
+    impl_OCArrayApplyKind kind;
+    const void **values;
+    uint64_t start;
+    uint64_t end;
+    union {
+        OCArrayApplierFunction apply;
+        OCArrayMapFunction map;
+        OCArrayFilterFunction filter;
+    } function;
+    void *context;
+    const OCArrayCallBacks *callBacks;  // map: retains results
+    const void **results;               // map: one retained value per input
+    bool *keep;                         // filter: one flag per input
+    bool failed;
+} impl_OCArrayApplyTask;
+static void impl_OCArrayApplyTaskRun(void *arg) {
+    impl_OCArrayApplyTask *task = (impl_OCArrayApplyTask *)arg;
+    OCArrayRetainCallBack retain = task->callBacks ? task->callBacks->retain : NULL;
+    for (uint64_t batch = task->start; batch < task->end && !task->failed; batch += kOCArrayApplyBatchLength) {
+        uint64_t batchEnd = task->end - batch < kOCArrayApplyBatchLength ? task->end : batch + kOCArrayApplyBatchLength;
+        OCAutoreleasePoolRef pool = OCAutoreleasePoolCreate();
+        for (uint64_t i = batch; i < batchEnd && !task->failed; i++) {
+            switch (task->kind) {
+                case kOCArrayApplyKindApply:
+                    task->function.apply(task->values[i], task->context);
+                    break;
+                case kOCArrayApplyKindMap: {
+                    // Retain before the pool drains, in case the mapper autoreleased it
+                    const void *mapped = task->function.map(task->values[i], task->context);
+                    if (mapped == NULL)
+                        task->failed = true;
+                    else
+                        task->results[i] = retain ? retain(mapped) : mapped;
                     break;
                 }
+                case kOCArrayApplyKindFilter:
+                    task->keep[i] = task->function.filter(task->values[i], task->context);
+                    break;
             }
-            arr[j] = tmp;
         }
+        OCAutoreleasePoolRelease(pool);
     }
-#elif defined(_MSC_VER) && defined(_WIN32)
-#if defined(__STDC_LIB_EXT1__) && __STDC_LIB_EXT1__ >= 201112L
-    qsort_s(base_ptr, nmemb, element_size, thunk_first_qsort_compare_wrapper, &myContext);
-#else
-#error "MSVC: qsort_s not available (check __STDC_WANT_LIB_EXT1__ definition and compiler/library version)."
-#endif
-#else
-#warning "Platform not explicitly supported for qsort_r or qsort_s. Contextual sort may fail."
-    if (context != NULL) {
-#error "Contextual sort (qsort_r/qsort_s) not implemented for this platform and context is required."
-    } else {
-#error "Fallback to standard qsort for NULL context not robustly implemented. Please provide a qsort_r/qsort_s equivalent for your platform or ensure the comparator can work with standard qsort."
+}
+// Runs one task per slice of values[0..count) and reports whether all succeeded
+static bool impl_OCArrayApply(impl_OCArrayApplyTask prototype, uint64_t count, OCArrayApplyOptions options) {
+    unsigned workers = (options & kOCArrayApplyConcurrent) ? impl_OCArrayWorkerCount(count, kOCArrayApplyMinSliceLength) : 1;
+    impl_OCArrayApplyTask tasks[kOCArrayMaxWorkers];
+    for (unsigned w = 0; w < workers; w++) {
+        tasks[w] = prototype;
+        tasks[w].start = count * w / workers;
+        tasks[w].end = count * (w + 1) / workers;
     }
-#endif
+    impl_OCArrayRunTasks(impl_OCArrayApplyTaskRun, tasks, sizeof(impl_OCArrayApplyTask), workers);
+    for (unsigned w = 0; w < workers; w++)
+        if (tasks[w].failed) return false;
+    return true;
+}
+void OCArrayApplyFunction(OCArrayRef theArray, OCRange range, OCArrayApplierFunction applier, void *context,
+                          OCArrayApplyOptions options) {
+    if (theArray == NULL || applier == NULL || !impl_OCArraySortRangeIsValid(theArray, range) || range.length == 0) {
+        return;
+    }
+    const void **values = impl_OCArrayGetValues(theArray);
+    if (values == NULL) return;
+    impl_OCArrayApplyTask prototype = {.kind = kOCArrayApplyKindApply,
+                                       .values = values + range.location,
+                                       .function.apply = applier,
+                                       .context = context};
+    impl_OCArrayApply(prototype, (uint64_t)range.length, options);
+}
+OCArrayRef OCArrayCreateByMapping(OCArrayRef theArray, OCArrayMapFunction mapper, void *context,
+                                  const OCArrayCallBacks *callBacks, OCArrayApplyOptions options) {
+    if (theArray == NULL || mapper == NULL) return NULL;
+    uint64_t count = theArray->count;
+    const OCArrayCallBacks *resultCallBacks = callBacks ? callBacks : &__kOCNullArrayCallBacks;
+    struct impl_OCArray *result = OCArrayAllocate();
+    if (result == NULL) return NULL;
+    result->callBacks = resultCallBacks;
+    if (count == 0) return result;
+    const void **values = impl_OCArrayGetValues(theArray);
+    const void **results = values ? (const void **)calloc(count, sizeof(const void *)) : NULL;
+    if (results == NULL) {
+        fprintf(stderr, "OCArrayCreateByMapping: Memory allocation for results failed.\n");
+        OCRelease(result);
+        return NULL;
+    }
+    impl_OCArrayApplyTask prototype = {.kind = kOCArrayApplyKindMap,
+                                       .values = values,
+                                       .function.map = mapper,
+                                       .context = context,
+                                       .callBacks = resultCallBacks,
+                                       .results = results};
+    if (!impl_OCArrayApply(prototype, count, options)) {
+        // Slices that finished hold retained results; the rest are NULL
+        impl_OCArrayReleaseRange(resultCallBacks, results, count);
+        free((void *)results);
+        OCRelease(result);
+        return NULL;
+    }
+    result->data = results;
+    result->count = count;
+    result->capacity = count;
+    return result;
+}
+OCArrayRef OCArrayCreateByFiltering(OCArrayRef theArray, OCArrayFilterFunction predicate, void *context,
+                                    OCArrayApplyOptions options) {
+    if (theArray == NULL || predicate == NULL) return NULL;
+    uint64_t count = theArray->count;
+    const void **source = impl_OCArrayGetValues(theArray);
+    bool *keep = (bool *)calloc(count ? count : 1, sizeof(bool));
+    if (keep == NULL || (count && source == NULL)) {
+        free(keep);
+        fprintf(stderr, "OCArrayCreateByFiltering: Memory allocation failed.\n");
+        return NULL;
+    }
+    impl_OCArrayApplyTask prototype = {.kind = kOCArrayApplyKindFilter,
+                                       .values = source,
+                                       .function.filter = predicate,
+                                       .context = context,
+                                       .keep = keep};
+    if (count) impl_OCArrayApply(prototype, count, options);
+    // Concatenate the survivors in their original order
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < count; i++)
+        kept += keep[i];
+    const void **values = (const void **)malloc((kept ? kept : 1) * sizeof(const void *));
+    if (values == NULL) {
+        fprintf(stderr, "OCArrayCreateByFiltering: Memory allocation failed.\n");
+        free(keep);
+        return NULL;
+    }
+    for (uint64_t i = 0, k = 0; i < count; i++)
+        if (keep[i]) values[k++] = source[i];
+    free(keep);
+    OCArrayRef result = OCArrayCreate(values, kept, theArray->callBacks);
+    free((void *)values);
+    return result;
 }
 #define INVOKE_CALLBACK3(P, A, B, C) (P)(A, B, C)
 int64_t OCBSearch(void *_Nullable element,
@@ -981,7 +2403,9 @@ int64_t OCArrayBSearchValues(OCArrayRef array, OCRange range, const void *value,
         ((uint64_t)range.location + (uint64_t)range.length) > array->count) {  // Validate range
         return kOCNotFound;
     }
-    const void **base = (const void **)(array->data + range.location);
+    const void **values = impl_OCArrayGetValues(array);
+    if (values == NULL) return kOCNotFound;
+    const void **base = values + range.location;
     size_t num = range.length;
     int64_t low = 0;
     int64_t high = num - 1;
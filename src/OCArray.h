@@ -92,6 +92,10 @@ OCArrayRef OCArrayCreate(const void **values, uint64_t numValues, const OCArrayC
 /**
  * @brief Creates an immutable array copy.
  *
+ * Copying an immutable array retains it. A mutable array shares its buffer
+ * with the copy, so the call is O(1); the values are duplicated only when the
+ * mutable array next changes.
+ *
  * @param theArray Array to copy.
  * @return New OCArrayRef or NULL.
  * @ingroup OCArray
@@ -109,11 +113,62 @@ OCMutableArrayRef OCArrayCreateMutable(uint64_t capacity, const OCArrayCallBacks
 /**
  * @brief Creates a mutable copy of an array.
  *
+ * The copy reads the source's buffer until either of them first changes, at
+ * which point the one that changes takes a buffer of its own.
+ *
  * @param theArray The array to copy.
  * @return New OCMutableArrayRef or NULL.
  * @ingroup OCArray
  */
 OCMutableArrayRef OCArrayCreateMutableCopy(OCArrayRef theArray);
+/**
+ * @brief Creates a new immutable array with a value added at the end.
+ *
+ * The result is a persistent array: it keeps its values in a 32-way trie
+ * whose nodes it shares with @p theArray and with every other version made
+ * from it, so the call copies only the O(log n) nodes on the path it changes
+ * and leaves @p theArray untouched. Copies of a persistent array with
+ * OCArrayCreateCopy() are O(1). A flat array is converted on its first
+ * persistent append or set, which costs O(n) once; persistent arrays build a
+ * flat view on demand for bulk operations such as sorting copies, searching
+ * and OCArrayApplyFunction(), and OCArrayCreateMutableCopy() turns them back
+ * into ordinary mutable arrays.
+ *
+ * @param theArray Array to extend.
+ * @param value Value to append; retained through the array's callbacks.
+ * @return New OCArrayRef, or NULL on error or if @p value is NULL.
+ * @ingroup OCArray
+ *
+ * @code
+ * OCArrayRef v1 = OCArrayCreateByAppendingValue(v0, STR("a"));
+ * OCArrayRef v2 = OCArrayCreateBySettingValueAtIndex(v1, 0, STR("b"));
+ * // v1 still holds "a"; v2 holds "b"; both share the rest of v0
+ * @endcode
+ */
+OCArrayRef OCArrayCreateByAppendingValue(OCArrayRef theArray, const void *value);
+/**
+ * @brief Creates a new immutable array with one value replaced.
+ *
+ * Like OCArrayCreateByAppendingValue(), the result is a persistent array
+ * sharing all but O(log n) nodes with @p theArray, which is left untouched.
+ *
+ * @param theArray Source array.
+ * @param index Index of the value to replace.
+ * @param value New value; retained through the array's callbacks.
+ * @return New OCArrayRef, or NULL on error, if @p index is out of bounds or
+ *         if @p value is NULL.
+ * @ingroup OCArray
+ */
+OCArrayRef OCArrayCreateBySettingValueAtIndex(OCArrayRef theArray, uint64_t index, const void *value);
+/**
+ * @brief Reports whether an array is stored as a persistent trie.
+ *
+ * @param theArray The array.
+ * @return true for arrays made by OCArrayCreateByAppendingValue(),
+ *         OCArrayCreateBySettingValueAtIndex() and copies of them.
+ * @ingroup OCArray
+ */
+bool OCArrayIsPersistent(OCArrayRef theArray);
 /**
  * @brief Gets a value at a given index.
  *
@@ -151,6 +206,8 @@ bool OCArrayAppendValue(OCMutableArrayRef theArray, const void *value);
  *
  * Uses the array's equality callback to determine equivalence. If no callback is set,
  * compares pointers directly. For `kOCTypeArrayCallBacks`, uses `OCTypeEqual`.
+ * Linear in the array's length unless its value index is enabled; see
+ * OCArraySetValueIndexEnabled().
  *
  * @param theArray The array to check.
  * @param value The value to look for.
@@ -175,6 +232,8 @@ bool OCArrayAppendArray(OCMutableArrayRef theArray, OCArrayRef otherArray, OCRan
  *
  * Uses the array's equality callback to determine equivalence. If no callback is set,
  * compares pointers directly. For `kOCTypeArrayCallBacks`, uses `OCTypeEqual`.
+ * Linear in the array's length unless its value index is enabled; see
+ * OCArraySetValueIndexEnabled().
  *
  * @param theArray The array to search.
  * @param value The value to search for.
@@ -185,7 +244,8 @@ OCIndex OCArrayGetFirstIndexOfValue(OCArrayRef theArray, const void *value);
 /**
  * @brief Removes a value at a specific index from a mutable array.
  *
- * The value is released using the array's release callback. The remaining elements are shifted to fill the gap.
+ * The value is released using the array's release callback. The remaining elements are shifted to fill the gap,
+ * from whichever side has fewer, so removing the first value is O(1).
  *
  * @param theArray The mutable array.
  * @param index The index of the value to remove.
@@ -205,9 +265,171 @@ bool OCArrayRemoveValueAtIndex(OCMutableArrayRef theArray, uint64_t index);
  * @ingroup OCArray
  */
 bool OCArrayInsertValueAtIndex(OCMutableArrayRef theArray, uint64_t index, const void *value);
+/**
+ * @brief Replaces a range of values with a run of new values.
+ *
+ * The range and the new run may differ in length; the elements after the
+ * range move once, with a single memmove, and the buffer grows at most once.
+ * New values are retained and the replaced values released through the
+ * array's callbacks. @p newValues may point into the array itself.
+ *
+ * @param theArray The mutable array.
+ * @param range Range of existing values to replace (length 0 to insert).
+ * @param newValues Values to store, or NULL if @p newCount is 0.
+ * @param newCount Number of values in @p newValues.
+ * @return true on success; false if the range is out of bounds, a new value
+ *         is NULL, or allocation fails. The array is unchanged on failure.
+ * @ingroup OCArray
+ *
+ * @code
+ * // Replace elements 2..4 with a single value
+ * const void *one[] = { value };
+ * OCArrayReplaceValuesInRange(array, OCRangeMake(2, 3), one, 1);
+ * @endcode
+ */
+bool OCArrayReplaceValuesInRange(OCMutableArrayRef theArray, OCRange range, const void **newValues, uint64_t newCount);
+/**
+ * @brief Inserts a run of values at the specified index.
+ *
+ * @param theArray The mutable array.
+ * @param index The index at which to insert (must be ≤ count).
+ * @param values Values to insert; none may be NULL.
+ * @param count Number of values.
+ * @return true on success; false on invalid input or allocation failure.
+ * @ingroup OCArray
+ */
+bool OCArrayInsertValuesAtIndex(OCMutableArrayRef theArray, uint64_t index, const void **values, uint64_t count);
+/**
+ * @brief Removes a contiguous range of values.
+ *
+ * @param theArray The mutable array.
+ * @param range Range of values to remove.
+ * @return true on success; false if the range is out of bounds.
+ * @ingroup OCArray
+ */
+bool OCArrayRemoveValuesInRange(OCMutableArrayRef theArray, OCRange range);
+/**
+ * @brief Removes the values at every index in an index set.
+ *
+ * The survivors are compacted in a single pass.
+ *
+ * @param theArray The mutable array.
+ * @param indexSet Indexes to remove.
+ * @return true on success; false if any index is out of bounds, in which
+ *         case nothing is removed.
+ * @ingroup OCArray
+ */
+bool OCArrayRemoveValuesAtIndexes(OCMutableArrayRef theArray, OCIndexSetRef indexSet);
+/**
+ * @brief How a mutable array over-allocates when it runs out of room.
+ * @ingroup OCArray
+ */
+typedef enum {
+    kOCArrayGrowthDouble = 0, /**< Double the capacity (default). */
+    kOCArrayGrowthOneAndHalf, /**< Grow by half the capacity; less slack, more reallocations. */
+    kOCArrayGrowthExact       /**< Grow only to the size needed; pair with OCArrayReserveCapacity(). */
+} OCArrayGrowthPolicy;
+/**
+ * @brief Sets the growth policy used when the array must reallocate.
+ *
+ * @param theArray The mutable array.
+ * @param policy The new policy.
+ * @ingroup OCArray
+ */
+void OCArraySetGrowthPolicy(OCMutableArrayRef theArray, OCArrayGrowthPolicy policy);
+/**
+ * @brief How a mutable array places its spare room.
+ *
+ * Values are always contiguous, so OCArrayGetValueAtIndex() stays O(1) in
+ * both modes, and removing the first value is O(1) in both: the values
+ * before a removed range move into the free room in front of them when they
+ * are fewer than those after it.
+ * @ingroup OCArray
+ */
+typedef enum {
+    kOCArrayStorageLinear = 0, /**< Spare room at the back only (default). */
+    kOCArrayStorageDeque       /**< Spare room at both ends; inserting at the front is amortized O(1). */
+} OCArrayStorageMode;
+/**
+ * @brief Sets how the array places its spare room when it reallocates.
+ *
+ * Use kOCArrayStorageDeque for queues and work lists that insert or remove
+ * at both ends. The layout changes at the next reallocation.
+ *
+ * @param theArray The mutable array.
+ * @param mode The new storage mode.
+ * @ingroup OCArray
+ *
+ * @code
+ * OCMutableArrayRef queue = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+ * OCArraySetStorageMode(queue, kOCArrayStorageDeque);
+ * OCArrayInsertValueAtIndex(queue, 0, urgentJob);  // push front
+ * OCArrayAppendValue(queue, job);                  // push back
+ * OCArrayRemoveValueAtIndex(queue, 0);             // pop front
+ * @endcode
+ */
+void OCArraySetStorageMode(OCMutableArrayRef theArray, OCArrayStorageMode mode);
+/**
+ * @brief Returns the array's storage mode.
+ * @param theArray The array.
+ * @return The storage mode; kOCArrayStorageLinear for NULL.
+ * @ingroup OCArray
+ */
+OCArrayStorageMode OCArrayGetStorageMode(OCArrayRef theArray);
+/**
+ * @brief Ensures room for at least @p capacity values without reallocating.
+ *
+ * Allocates exactly the requested capacity regardless of growth policy.
+ *
+ * @param theArray The mutable array.
+ * @param capacity Minimum capacity.
+ * @return true on success; false on allocation failure.
+ * @ingroup OCArray
+ */
+bool OCArrayReserveCapacity(OCMutableArrayRef theArray, uint64_t capacity);
+/**
+ * @brief Turns the value index of an array on or off.
+ *
+ * With the index on, OCArrayContainsValue() and OCArrayGetFirstIndexOfValue()
+ * hash the value instead of comparing it with every element. The index is
+ * built by the first lookup, extended in place by appends, and rebuilt by
+ * the next lookup after any other mutation, so it pays off for arrays that
+ * are searched many times between changes. It costs 32 to 64 bytes per
+ * element.
+ *
+ * Indexing needs a hash consistent with the array's equality: arrays using
+ * kOCTypeArrayCallBacks or OCTypeEqual() hash with OCTypeHash(), and arrays
+ * without an equal callback hash the pointers. Values whose type has no
+ * registered hash function fall back to linear scans.
+ *
+ * Immutable arrays may be indexed too; concurrent lookups on a shared array
+ * remain safe.
+ *
+ * @param theArray The array.
+ * @param enabled Whether lookups should use an index.
+ * @return true on success; false if the array's equal callback has no
+ *         matching hash.
+ * @ingroup OCArray
+ *
+ * @code
+ * OCArraySetValueIndexEnabled(names, true);
+ * for (uint64_t i = 0; i < queryCount; i++)
+ *     found += OCArrayContainsValue(names, queries[i]);
+ * @endcode
+ */
+bool OCArraySetValueIndexEnabled(OCArrayRef theArray, bool enabled);
+/**
+ * @brief Reports whether lookups in an array use a value index.
+ * @param theArray The array.
+ * @return true if OCArraySetValueIndexEnabled() turned the index on.
+ * @ingroup OCArray
+ */
+bool OCArrayIsValueIndexEnabled(OCArrayRef theArray);
 /**
  * @brief Sorts values in an array.
  *
+ * The sort is stable: values that compare equal keep their relative order.
+ *
  * @param theArray The array to sort.
  * @param range Range of values to sort.
  * @param comparator Comparison function.
@@ -215,6 +437,102 @@ bool OCArrayInsertValueAtIndex(OCMutableArrayRef theArray, uint64_t index, const
  * @ingroup OCArray
  */
 void OCArraySortValues(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator, void *context);
+/**
+ * @brief Options for the OCArraySort functions.
+ * @ingroup OCArray
+ */
+typedef enum {
+    kOCArraySortDefault = 0,         /**< Ascending, on the calling thread. */
+    kOCArraySortDescending = 1 << 0, /**< Reverse the order; equal values still keep their relative order. */
+    kOCArraySortConcurrent = 1 << 1  /**< Split large ranges across threads. The comparator must be thread-safe. */
+} OCArraySortOptions;
+/**
+ * @brief Sorts values in an array with options.
+ *
+ * Stable like OCArraySortValues(). With kOCArraySortConcurrent, ranges large
+ * enough to benefit are cut into slices sorted on the OCThreadPool workers
+ * and then merged; the comparator is then called from several threads at once.
+ *
+ * @param theArray The array to sort.
+ * @param range Range of values to sort.
+ * @param comparator Comparison function.
+ * @param context User-defined data.
+ * @param options Combination of OCArraySortOptions flags.
+ * @return true on success; false on invalid input or allocation failure.
+ * @ingroup OCArray
+ */
+bool OCArraySortValuesWithOptions(OCMutableArrayRef theArray, OCRange range, OCComparatorFunction comparator,
+                                  void *context, OCArraySortOptions options);
+/**
+ * @brief Sorts a range of OCNumbers by value.
+ *
+ * Each number is read once into a 64-bit key and the sort compares those
+ * keys directly, without calling a comparator. A range of integers keys
+ * exactly; once floats are mixed in, keys are doubles and integers that
+ * round to the same double are told apart by their exact values. -0 equals
+ * +0 and NaN sorts after every other value. The sort is stable.
+ *
+ * @param theArray The array to sort.
+ * @param range Range of values to sort.
+ * @param options Combination of OCArraySortOptions flags.
+ * @return true on success; false if a value in the range is not a real
+ *         (non-complex) OCNumber, or on allocation failure. The array is
+ *         unchanged on failure.
+ * @ingroup OCArray
+ */
+bool OCArraySortNumbers(OCMutableArrayRef theArray, OCRange range, OCArraySortOptions options);
+/**
+ * @brief Sorts a range of OCStrings in byte order.
+ *
+ * Gives the same order as OCStringCompare() with no flags, for strings
+ * without embedded NUL bytes. Each string's leading eight bytes are packed
+ * into an integer key, so only values sharing that prefix compare their
+ * remaining bytes. The sort is stable.
+ *
+ * @param theArray The array to sort.
+ * @param range Range of values to sort.
+ * @param options Combination of OCArraySortOptions flags.
+ * @return true on success; false if a value in the range is not an OCString
+ *         or on allocation failure. The array is unchanged on failure.
+ * @ingroup OCArray
+ */
+bool OCArraySortStrings(OCMutableArrayRef theArray, OCRange range, OCArraySortOptions options);
+/**
+ * @brief Moves the k values that sort first to the front of a range, in order.
+ *
+ * Runs in O(n log k). The remaining values of the range follow in
+ * unspecified order. Unlike the full sorts, equal values may be reordered.
+ *
+ * @param theArray The array to reorder.
+ * @param range Range of values to consider.
+ * @param k Number of leading values to sort (clamped to the range length).
+ * @param comparator Comparison function.
+ * @param context User-defined data.
+ * @return true on success; false on invalid input or allocation failure.
+ * @ingroup OCArray
+ */
+bool OCArrayPartialSortValues(OCMutableArrayRef theArray, OCRange range, uint64_t k,
+                              OCComparatorFunction comparator, void *context);
+/**
+ * @brief Creates an array of the k values that sort first (top-k).
+ *
+ * The source array is not modified.
+ *
+ * @param theArray Source array.
+ * @param k Number of values to return (clamped to the array's count).
+ * @param comparator Comparison function; the values it orders first are kept.
+ * @param context User-defined data.
+ * @return A new immutable array with the same callbacks, in sorted order, or
+ *         NULL on failure.
+ * @ingroup OCArray
+ *
+ * @code
+ * // Ten largest readings: order descending so the largest sort first
+ * OCArrayRef top = OCArrayCreateWithFirstSortedValues(readings, 10, CompareDescending, NULL);
+ * @endcode
+ */
+OCArrayRef OCArrayCreateWithFirstSortedValues(OCArrayRef theArray, uint64_t k,
+                                              OCComparatorFunction comparator, void *context);
 /**
  * @brief Performs a binary search on a sorted array.
  *
@@ -336,6 +654,105 @@ OCArrayRef OCArrayCreateFromJSON(cJSON *json, OCStringRef *outError);
  * @ingroup OCArray
  */
 OCArrayRef OCArrayOfNumbersCreateFromJSON(cJSON *json, OCNumberType numberType, OCStringRef *outError);
+/**
+ * @brief Options for OCArrayApplyFunction(), OCArrayCreateByMapping() and
+ *        OCArrayCreateByFiltering().
+ * @ingroup OCArray
+ */
+typedef enum {
+    kOCArrayApplyDefault = 0,         /**< Visit values in order on the calling thread. */
+    kOCArrayApplyConcurrent = 1 << 0  /**< Split large arrays across threads; callbacks must be thread-safe. */
+} OCArrayApplyOptions;
+/**
+ * @brief Callback invoked by OCArrayApplyFunction() for each value.
+ *
+ * @param value The value (borrowed; not retained).
+ * @param context The context pointer passed to OCArrayApplyFunction().
+ * @ingroup OCArray
+ */
+typedef void (*OCArrayApplierFunction)(const void *value, void *context);
+/**
+ * @brief Callback that produces one value of OCArrayCreateByMapping()'s result.
+ *
+ * The returned value is retained by the result array before the current
+ * autorelease pool drains, so a mapper may return an autoreleased object.
+ *
+ * @param value The source value (borrowed).
+ * @param context The context pointer passed to OCArrayCreateByMapping().
+ * @return The mapped value, or NULL to abandon the whole mapping.
+ * @ingroup OCArray
+ */
+typedef const void *(*OCArrayMapFunction)(const void *value, void *context);
+/**
+ * @brief Predicate called by OCArrayCreateByFiltering().
+ *
+ * @param value The value to test (borrowed).
+ * @param context The context pointer passed to OCArrayCreateByFiltering().
+ * @return true to keep the value.
+ * @ingroup OCArray
+ */
+typedef bool (*OCArrayFilterFunction)(const void *value, void *context);
+/**
+ * @brief Calls a function once for each value in a range.
+ *
+ * Callbacks run inside an autorelease pool that is drained every 1024
+ * values, on whichever thread runs them, so they may autorelease
+ * temporaries. With kOCArrayApplyConcurrent, large ranges are split into
+ * slices visited at the same time on the OCThreadPool workers; the call returns
+ * once every slice is done. The array must not be mutated meanwhile.
+ *
+ * @param theArray Array to walk.
+ * @param range Range of values to visit.
+ * @param applier Function called for each value.
+ * @param context Opaque pointer passed through to @p applier.
+ * @param options Combination of OCArrayApplyOptions flags.
+ * @ingroup OCArray
+ *
+ * @code
+ * static void addToTotal(const void *value, void *context) {
+ *     double v = 0;
+ *     OCNumberTryGetFloat64((OCNumberRef)value, &v);
+ *     *(double *)context += v;
+ * }
+ * double total = 0;
+ * OCArrayApplyFunction(samples, OCRangeMake(0, OCArrayGetCount(samples)), addToTotal, &total, kOCArrayApplyDefault);
+ * @endcode
+ */
+void OCArrayApplyFunction(OCArrayRef theArray, OCRange range, OCArrayApplierFunction applier, void *context,
+                          OCArrayApplyOptions options);
+/**
+ * @brief Creates an array holding mapper(value) for every value, in order.
+ *
+ * Autorelease handling and threading are as for OCArrayApplyFunction().
+ * Results land at their source index, so a concurrent mapping has the
+ * same order as a sequential one.
+ *
+ * @param theArray Source array.
+ * @param mapper Function producing each result value.
+ * @param context Opaque pointer passed through to @p mapper.
+ * @param callBacks Callbacks for the result array (e.g. &kOCTypeArrayCallBacks).
+ * @param options Combination of OCArrayApplyOptions flags.
+ * @return A new immutable array, or NULL if @p mapper returned NULL or on
+ *         allocation failure.
+ * @ingroup OCArray
+ */
+OCArrayRef OCArrayCreateByMapping(OCArrayRef theArray, OCArrayMapFunction mapper, void *context,
+                                  const OCArrayCallBacks *callBacks, OCArrayApplyOptions options);
+/**
+ * @brief Creates an array of the values for which a predicate holds.
+ *
+ * Autorelease handling and threading are as for OCArrayApplyFunction().
+ * Kept values stay in their original order and use the source's callbacks.
+ *
+ * @param theArray Source array.
+ * @param predicate Function deciding which values to keep.
+ * @param context Opaque pointer passed through to @p predicate.
+ * @param options Combination of OCArrayApplyOptions flags.
+ * @return A new immutable array, or NULL on failure.
+ * @ingroup OCArray
+ */
+OCArrayRef OCArrayCreateByFiltering(OCArrayRef theArray, OCArrayFilterFunction predicate, void *context,
+                                    OCArrayApplyOptions options);
 /**
  * @brief Returns the callback structure associated with the array.
  *
@@ -36,8 +36,14 @@ struct impl_OCAutoreleasePoolsManager {
     int number_of_pools;
 };
 typedef struct impl_OCAutoreleasePoolsManager *OCAutoreleasePoolsManagerRef;
-// OCAutoreleasePoolsManager is a Singleton
-static OCAutoreleasePoolsManagerRef autorelease_pool_manager = NULL;
+#if defined(_MSC_VER)
+#define OC_THREAD_LOCAL __declspec(thread)
+#else
+#define OC_THREAD_LOCAL __thread
+#endif
+// Each thread has its own OCAutoreleasePoolsManager, so pools nest per thread
+// and objects autoreleased on a worker thread go to that thread's pool
+static OC_THREAD_LOCAL OCAutoreleasePoolsManagerRef autorelease_pool_manager = NULL;
 /**************************************************************************
  OCAutoreleasePoolObject methods
  *************************************************************************/
@@ -267,7 +273,13 @@ static bool OCAutoreleasePoolDeallocate(OCAutoreleasePoolRef thePool) {
 }
 bool OCAutoreleasePoolRelease(OCAutoreleasePoolRef thePool) {
     IF_NO_OBJECT_EXISTS_RETURN(thePool, false);
-    return OCAutoreleasePoolsManagerRemovePool(thePool);
+    bool removed = OCAutoreleasePoolsManagerRemovePool(thePool);
+    // Free the manager with its last pool so short-lived threads leave nothing behind
+    if (autorelease_pool_manager && autorelease_pool_manager->number_of_pools == 0) {
+        OCAutoreleasePoolsManagerDeallocate(autorelease_pool_manager);
+        autorelease_pool_manager = NULL;
+    }
+    return removed;
 }
 // Drains the pool without deallocating it: releases all queued objects
 void OCAutoreleasePoolDrain(OCAutoreleasePoolRef thePool) {
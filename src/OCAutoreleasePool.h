@@ -24,6 +24,11 @@
  *
  * Nesting Pools:
  *   Pools can be nested. Releasing a nested pool only drains that pool.
+ *
+ * Threads:
+ *   Every thread has its own stack of pools. OCAutorelease() adds to the
+ *   topmost pool of the calling thread, and a pool must be released on the
+ *   thread that created it.
  */
 #ifndef OCAutoreleasePool_h
 #define OCAutoreleasePool_h
@@ -0,0 +1,314 @@
+// OCConcurrentDictionary.c – Lock-striped dictionary for sharing between threads
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "OCTypes.h"
+static OCTypeID kOCConcurrentDictionaryID = kOCNotATypeID;
+// Keys are spread over a fixed number of stripes by the top bits of their
+// hash; each stripe is an ordinary mutable OCDictionary behind its own
+// reader-writer lock. The low hash bits pick the slot inside the stripe's
+// dictionary, so using the high bits here keeps the two choices independent.
+// Stripes are padded to a cache line so that locks taken by different threads
+// do not share one.
+#define kOCConcurrentDictionaryStripeBits 6
+#define kOCConcurrentDictionaryStripeCount (1u << kOCConcurrentDictionaryStripeBits)
+#define kOCConcurrentDictionaryCacheLine 64
+typedef struct impl_OCConcurrentDictionaryStripe {
+    pthread_rwlock_t lock;
+    OCMutableDictionaryRef dict;
+} impl_OCConcurrentDictionaryStripe;
+typedef union impl_OCConcurrentDictionaryPaddedStripe {
+    impl_OCConcurrentDictionaryStripe stripe;
+    char pad[((sizeof(impl_OCConcurrentDictionaryStripe) + kOCConcurrentDictionaryCacheLine - 1) /
+              kOCConcurrentDictionaryCacheLine) *
+             kOCConcurrentDictionaryCacheLine];
+} impl_OCConcurrentDictionaryPaddedStripe;
+struct impl_OCConcurrentDictionary {
+    OCBase base;
+    impl_OCConcurrentDictionaryPaddedStripe *stripes;
+};
+static inline impl_OCConcurrentDictionaryStripe *
+impl_OCConcurrentDictionaryStripeFor(OCConcurrentDictionaryRef dict, OCStringRef key) {
+    uint64_t hash = OCStringHash(key);
+    return &dict->stripes[hash >> (64 - kOCConcurrentDictionaryStripeBits)].stripe;
+}
+// Looks key up in a locked stripe and retains the value for the caller
+static inline OCTypeRef impl_OCConcurrentDictionaryStripeCopyValue(impl_OCConcurrentDictionaryStripe *stripe, OCStringRef key) {
+    OCTypeRef value = OCDictionaryGetValue(stripe->dict, key);
+    return value ? OCRetain(value) : NULL;
+}
+OCTypeID OCConcurrentDictionaryGetTypeID(void) {
+    if (kOCConcurrentDictionaryID == kOCNotATypeID)
+        kOCConcurrentDictionaryID = OCRegisterType("OCConcurrentDictionary", NULL);
+    return kOCConcurrentDictionaryID;
+}
+static void impl_OCConcurrentDictionaryFinalize(const void *theType) {
+    if (NULL == theType) {
+        fprintf(stderr, "Finalize called with NULL pointer\n");
+        return;
+    }
+    OCConcurrentDictionaryRef dict = (OCConcurrentDictionaryRef)theType;
+    if (!dict->stripes)
+        return;
+    for (uint32_t i = 0; i < kOCConcurrentDictionaryStripeCount; i++) {
+        impl_OCConcurrentDictionaryStripe *stripe = &dict->stripes[i].stripe;
+        OCRelease(stripe->dict);
+        pthread_rwlock_destroy(&stripe->lock);
+    }
+    free(dict->stripes);
+}
+static bool impl_OCConcurrentDictionaryEqual(const void *theType1, const void *theType2) {
+    OCConcurrentDictionaryRef d1 = (OCConcurrentDictionaryRef)theType1;
+    OCConcurrentDictionaryRef d2 = (OCConcurrentDictionaryRef)theType2;
+    if (d1 == d2)
+        return true;
+    if (!d1 || !d2 || d1->base.typeID != d2->base.typeID)
+        return false;
+    OCDictionaryRef s1 = OCConcurrentDictionaryCreateSnapshot(d1);
+    OCDictionaryRef s2 = OCConcurrentDictionaryCreateSnapshot(d2);
+    bool equal = s1 && s2 && OCDictionaryGetCount(s1) == OCDictionaryGetCount(s2);
+    if (equal) {
+        // Snapshots group entries by stripe, so compare by key rather than order
+        OCDictionaryCursor cursor;
+        OCStringRef key;
+        const void *value;
+        OCDictionaryCursorInit(&cursor, s1);
+        while (equal && OCDictionaryCursorNext(&cursor, &key, &value))
+            equal = OCTypeEqual(value, OCDictionaryGetValue(s2, key));
+    }
+    OCRelease(s1);
+    OCRelease(s2);
+    return equal;
+}
+static OCStringRef impl_OCConcurrentDictionaryCopyFormattingDesc(OCTypeRef cf) {
+    if (!cf)
+        return OCStringCreateWithCString("<OCConcurrentDictionary: NULL>");
+    uint64_t count = OCConcurrentDictionaryGetCount((OCConcurrentDictionaryRef)cf);
+    return OCStringCreateWithFormat(STR("<OCConcurrentDictionary: %llu pair%s>"),
+                                    (unsigned long long)count, count == 1 ? "" : "s");
+}
+static cJSON *impl_OCConcurrentDictionaryCopyJSON(const void *obj, bool typed, OCStringRef *outError) {
+    OCDictionaryRef snapshot = OCConcurrentDictionaryCreateSnapshot((OCConcurrentDictionaryRef)obj);
+    if (!snapshot) {
+        if (outError)
+            *outError = STR("Failed to snapshot OCConcurrentDictionary");
+        return NULL;
+    }
+    cJSON *json = OCDictionaryCopyAsJSON(snapshot, typed, outError);
+    OCRelease(snapshot);
+    return json;
+}
+static void *impl_OCConcurrentDictionaryDeepCopy(const void *obj) {
+    OCConcurrentDictionaryRef src = (OCConcurrentDictionaryRef)obj;
+    if (!src)
+        return NULL;
+    OCDictionaryRef snapshot = OCConcurrentDictionaryCreateSnapshot(src);
+    if (!snapshot)
+        return NULL;
+    OCConcurrentDictionaryRef copy = OCConcurrentDictionaryCreate(OCDictionaryGetCount(snapshot));
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    OCDictionaryCursorInit(&cursor, snapshot);
+    while (copy && OCDictionaryCursorNext(&cursor, &key, &value)) {
+        OCStringRef keyCopy = (OCStringRef)OCTypeDeepCopy(key);
+        void *valCopy = OCTypeDeepCopy(value);
+        bool ok = keyCopy && valCopy && OCConcurrentDictionarySetValue(copy, keyCopy, valCopy);
+        OCRelease(keyCopy);
+        OCRelease(valCopy);
+        if (!ok) {
+            OCRelease(copy);
+            copy = NULL;
+        }
+    }
+    OCRelease(snapshot);
+    return (void *)copy;
+}
+OCConcurrentDictionaryRef OCConcurrentDictionaryCreate(uint64_t capacity) {
+    struct impl_OCConcurrentDictionary *dict = OCTypeAlloc(
+        struct impl_OCConcurrentDictionary,
+        OCConcurrentDictionaryGetTypeID(),
+        impl_OCConcurrentDictionaryFinalize,
+        impl_OCConcurrentDictionaryEqual,
+        impl_OCConcurrentDictionaryCopyFormattingDesc,
+        impl_OCConcurrentDictionaryCopyJSON,
+        impl_OCConcurrentDictionaryDeepCopy,
+        impl_OCConcurrentDictionaryDeepCopy);
+    if (!dict) {
+        fprintf(stderr, "OCConcurrentDictionaryCreate: Memory allocation for dictionary failed.\n");
+        return NULL;
+    }
+    dict->stripes = calloc(kOCConcurrentDictionaryStripeCount, sizeof(impl_OCConcurrentDictionaryPaddedStripe));
+    if (!dict->stripes) {
+        fprintf(stderr, "OCConcurrentDictionaryCreate: Memory allocation for stripes failed.\n");
+        OCRelease(dict);
+        return NULL;
+    }
+    uint64_t perStripe = capacity / kOCConcurrentDictionaryStripeCount + 1;
+    for (uint32_t i = 0; i < kOCConcurrentDictionaryStripeCount; i++) {
+        impl_OCConcurrentDictionaryStripe *stripe = &dict->stripes[i].stripe;
+        stripe->dict = OCDictionaryCreateMutable(perStripe);
+        if (!stripe->dict || pthread_rwlock_init(&stripe->lock, NULL) != 0) {
+            fprintf(stderr, "OCConcurrentDictionaryCreate: Stripe initialization failed.\n");
+            OCRelease(stripe->dict);
+            for (uint32_t j = 0; j < i; j++) {
+                OCRelease(dict->stripes[j].stripe.dict);
+                pthread_rwlock_destroy(&dict->stripes[j].stripe.lock);
+            }
+            free(dict->stripes);
+            dict->stripes = NULL;
+            OCRelease(dict);
+            return NULL;
+        }
+    }
+    return dict;
+}
+uint64_t OCConcurrentDictionaryGetCount(OCConcurrentDictionaryRef theDictionary) {
+    if (NULL == theDictionary)
+        return 0;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < kOCConcurrentDictionaryStripeCount; i++) {
+        impl_OCConcurrentDictionaryStripe *stripe = &theDictionary->stripes[i].stripe;
+        pthread_rwlock_rdlock(&stripe->lock);
+        count += OCDictionaryGetCount(stripe->dict);
+        pthread_rwlock_unlock(&stripe->lock);
+    }
+    return count;
+}
+OCTypeRef OCConcurrentDictionaryCopyValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key) {
+    if (!theDictionary || !key)
+        return NULL;
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    pthread_rwlock_rdlock(&stripe->lock);
+    // Retained before unlocking so a concurrent removal cannot free it
+    OCTypeRef value = impl_OCConcurrentDictionaryStripeCopyValue(stripe, key);
+    pthread_rwlock_unlock(&stripe->lock);
+    return value;
+}
+bool OCConcurrentDictionaryContainsKey(OCConcurrentDictionaryRef theDictionary, OCStringRef key) {
+    if (!theDictionary || !key)
+        return false;
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    pthread_rwlock_rdlock(&stripe->lock);
+    bool found = OCDictionaryContainsKey(stripe->dict, key);
+    pthread_rwlock_unlock(&stripe->lock);
+    return found;
+}
+bool OCConcurrentDictionarySetValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key, const void *value) {
+    if (!theDictionary || !key || !value) {
+        fprintf(stderr, "OCConcurrentDictionarySetValue: NULL dictionary, key or value.\n");
+        return false;
+    }
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    pthread_rwlock_wrlock(&stripe->lock);
+    bool ok = OCDictionarySetValue(stripe->dict, key, value);
+    pthread_rwlock_unlock(&stripe->lock);
+    return ok;
+}
+bool OCConcurrentDictionaryRemoveValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key) {
+    if (!theDictionary || !key)
+        return false;
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    pthread_rwlock_wrlock(&stripe->lock);
+    bool removed = OCDictionaryContainsKey(stripe->dict, key) && OCDictionaryRemoveValue(stripe->dict, key);
+    pthread_rwlock_unlock(&stripe->lock);
+    return removed;
+}
+OCTypeRef OCConcurrentDictionaryCopyOrAddValue(OCConcurrentDictionaryRef theDictionary,
+                                               OCStringRef key,
+                                               const void *value,
+                                               bool *outAdded) {
+    if (outAdded)
+        *outAdded = false;
+    if (!theDictionary || !key || !value) {
+        fprintf(stderr, "OCConcurrentDictionaryCopyOrAddValue: NULL dictionary, key or value.\n");
+        return NULL;
+    }
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    // Hits only need the shared lock
+    pthread_rwlock_rdlock(&stripe->lock);
+    OCTypeRef existing = impl_OCConcurrentDictionaryStripeCopyValue(stripe, key);
+    pthread_rwlock_unlock(&stripe->lock);
+    if (existing)
+        return existing;
+    // Another thread may have added the key since, so look again
+    pthread_rwlock_wrlock(&stripe->lock);
+    existing = impl_OCConcurrentDictionaryStripeCopyValue(stripe, key);
+    if (!existing && OCDictionaryAddValue(stripe->dict, key, value)) {
+        existing = OCRetain(value);
+        if (outAdded)
+            *outAdded = true;
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+    return existing;
+}
+bool OCConcurrentDictionaryCompareAndSwapValue(OCConcurrentDictionaryRef theDictionary,
+                                               OCStringRef key,
+                                               const void *expected,
+                                               const void *newValue) {
+    if (!theDictionary || !key)
+        return false;
+    impl_OCConcurrentDictionaryStripe *stripe = impl_OCConcurrentDictionaryStripeFor(theDictionary, key);
+    pthread_rwlock_wrlock(&stripe->lock);
+    bool swapped = OCDictionaryGetValue(stripe->dict, key) == expected;
+    if (swapped && expected != newValue) {
+        if (newValue)
+            swapped = OCDictionarySetValue(stripe->dict, key, newValue);
+        else
+            swapped = OCDictionaryRemoveValue(stripe->dict, key);
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+    return swapped;
+}
+OCDictionaryRef OCConcurrentDictionaryCreateSnapshot(OCConcurrentDictionaryRef theDictionary) {
+    if (!theDictionary)
+        return NULL;
+    // Gather every stripe's entries, retained so that writers may remove them
+    // once the stripe is unlocked, then freeze them together: snapshots are
+    // read often, so they get OCDictionaryCreate's perfect-hash lookups.
+    // Stripes partition the keys, so no key is gathered twice.
+    uint64_t count = 0, capacity = 0;
+    const void **keys = NULL, **values = NULL;
+    bool ok = true;
+    for (uint32_t i = 0; i < kOCConcurrentDictionaryStripeCount && ok; i++) {
+        impl_OCConcurrentDictionaryStripe *stripe = &theDictionary->stripes[i].stripe;
+        OCDictionaryCursor cursor;
+        OCStringRef key;
+        const void *value;
+        pthread_rwlock_rdlock(&stripe->lock);
+        uint64_t needed = count + OCDictionaryGetCount(stripe->dict);
+        if (needed > capacity) {
+            uint64_t grown = needed > capacity * 2 ? needed : capacity * 2;
+            const void **k = realloc(keys, grown * sizeof(const void *));
+            if (k)
+                keys = k;
+            const void **v = realloc(values, grown * sizeof(const void *));
+            if (v)
+                values = v;
+            ok = k && v;
+            if (ok)
+                capacity = grown;
+        }
+        OCDictionaryCursorInit(&cursor, stripe->dict);
+        while (ok && OCDictionaryCursorNext(&cursor, &key, &value)) {
+            keys[count] = OCRetain(key);
+            values[count] = OCRetain(value);
+            count++;
+        }
+        pthread_rwlock_unlock(&stripe->lock);
+    }
+    OCDictionaryRef snapshot = NULL;
+    const void *none[1] = {NULL};
+    if (ok)
+        snapshot = count ? OCDictionaryCreate(keys, values, count) : OCDictionaryCreate(none, none, 0);
+    else
+        fprintf(stderr, "OCConcurrentDictionaryCreateSnapshot: Memory allocation failed.\n");
+    for (uint64_t i = 0; i < count; i++) {
+        OCRelease(keys[i]);
+        OCRelease(values[i]);
+    }
+    free(keys);
+    free(values);
+    return snapshot;
+}
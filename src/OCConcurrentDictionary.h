@@ -0,0 +1,162 @@
+/**
+ * @file OCConcurrentDictionary.h
+ * @brief Thread-safe string-keyed dictionary for shared caches.
+ *
+ * OCConcurrentDictionary spreads its entries over a fixed set of stripes,
+ * each an OCMutableDictionary guarded by its own reader-writer lock, so
+ * readers of different keys rarely meet and a writer only blocks the stripe
+ * its key hashes to. Values handed out are retained for the caller, which
+ * keeps them alive even if another thread removes or replaces the entry.
+ *
+ * @note Ownership follows CoreFoundation conventions:
+ *       The caller owns any object returned by functions with "Create" or
+ *       "Copy" in the name, and must call OCRelease().
+ */
+#ifndef OCCONCURRENTDICTIONARY_H
+#define OCCONCURRENTDICTIONARY_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "OCType.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @defgroup OCConcurrentDictionary OCConcurrentDictionary
+ * @brief Concurrent dictionary type and operations.
+ * @{
+ */
+/**
+ * @brief Returns the OCTypeID for OCConcurrentDictionary objects.
+ * @return Type identifier for OCConcurrentDictionary.
+ * @ingroup OCConcurrentDictionary
+ */
+OCTypeID OCConcurrentDictionaryGetTypeID(void);
+/**
+ * @brief Creates an empty concurrent dictionary.
+ *
+ * @param capacity Expected number of entries, spread over the stripes.
+ * @return New OCConcurrentDictionaryRef or NULL on failure.
+ * @ingroup OCConcurrentDictionary
+ */
+OCConcurrentDictionaryRef OCConcurrentDictionaryCreate(uint64_t capacity);
+/**
+ * @brief Returns the number of entries.
+ *
+ * Stripes are counted one after another, so the result is exact only when no
+ * other thread is writing.
+ *
+ * @param theDictionary Dictionary to query.
+ * @return Count of entries.
+ * @ingroup OCConcurrentDictionary
+ */
+uint64_t OCConcurrentDictionaryGetCount(OCConcurrentDictionaryRef theDictionary);
+/**
+ * @brief Looks up a key and returns its value retained.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to look up.
+ * @return The value (caller must release), or NULL if the key is absent.
+ * @ingroup OCConcurrentDictionary
+ */
+OCTypeRef OCConcurrentDictionaryCopyValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key);
+/**
+ * @brief Checks whether a key is present.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to test.
+ * @return true if the key is found, false otherwise.
+ * @ingroup OCConcurrentDictionary
+ */
+bool OCConcurrentDictionaryContainsKey(OCConcurrentDictionaryRef theDictionary, OCStringRef key);
+/**
+ * @brief Sets the value for a key, inserting or replacing it.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to set.
+ * @param value Value to store (retained).
+ * @return true on success, false on failure.
+ * @ingroup OCConcurrentDictionary
+ */
+bool OCConcurrentDictionarySetValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key, const void *value);
+/**
+ * @brief Removes a key and its value.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to remove.
+ * @return true if the key was present and removed, false otherwise.
+ * @ingroup OCConcurrentDictionary
+ */
+bool OCConcurrentDictionaryRemoveValue(OCConcurrentDictionaryRef theDictionary, OCStringRef key);
+/**
+ * @brief Atomically returns the existing value for a key, or adds one.
+ *
+ * When several threads race to add the same key, exactly one value wins and
+ * every caller receives that value.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to look up or add.
+ * @param value Value to add if the key is absent.
+ * @param outAdded Optional; set to true if @p value was added.
+ * @return The value now stored under @p key, retained for the caller, or
+ *         NULL on failure.
+ * @ingroup OCConcurrentDictionary
+ *
+ * @code
+ * bool added;
+ * OCTypeRef entry = OCConcurrentDictionaryCopyOrAddValue(cache, key, fresh, &added);
+ * // use entry, whichever thread created it
+ * OCRelease(entry);
+ * @endcode
+ */
+OCTypeRef OCConcurrentDictionaryCopyOrAddValue(OCConcurrentDictionaryRef theDictionary,
+                                               OCStringRef key,
+                                               const void *value,
+                                               bool *outAdded);
+/**
+ * @brief Atomically replaces a key's value if it is still the expected one.
+ *
+ * Values are compared by identity. Passing NULL for @p expected adds the key
+ * only if it is absent; passing NULL for @p newValue removes it.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key whose value is replaced.
+ * @param expected Value the caller last saw (or NULL for "absent").
+ * @param newValue Replacement value (or NULL to remove the key).
+ * @return true if the swap happened, false if the current value differed.
+ * @ingroup OCConcurrentDictionary
+ *
+ * @code
+ * // Optimistic counter update: retry if another thread got there first
+ * for (;;) {
+ *     OCNumberRef old = (OCNumberRef)OCConcurrentDictionaryCopyValue(counts, key);
+ *     int32_t n = 0;
+ *     if (old) OCNumberTryGetSInt32(old, &n);
+ *     OCNumberRef next = OCNumberCreateWithInt(n + 1);
+ *     bool swapped = OCConcurrentDictionaryCompareAndSwapValue(counts, key, old, next);
+ *     OCRelease(old);
+ *     OCRelease(next);
+ *     if (swapped) break;
+ * }
+ * @endcode
+ */
+bool OCConcurrentDictionaryCompareAndSwapValue(OCConcurrentDictionaryRef theDictionary,
+                                               OCStringRef key,
+                                               const void *expected,
+                                               const void *newValue);
+/**
+ * @brief Creates an immutable OCDictionary with the current entries.
+ *
+ * Each stripe is copied under its read lock; entries are grouped by stripe,
+ * not by insertion order. The snapshot is frozen like one made with
+ * OCDictionaryCreate(), so its lookups use the minimal perfect hash.
+ *
+ * @param theDictionary Dictionary to copy.
+ * @return New OCDictionaryRef, or NULL on failure.
+ * @ingroup OCConcurrentDictionary
+ */
+OCDictionaryRef OCConcurrentDictionaryCreateSnapshot(OCConcurrentDictionaryRef theDictionary);
+/** @} */
+#ifdef __cplusplus
+}
+#endif
+#endif /* OCCONCURRENTDICTIONARY_H */
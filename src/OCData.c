@@ -21,10 +21,34 @@ struct impl_OCData {
     uint64_t length;
     uint64_t capacity;
     OCJSONEncoding encoding;
+    // Externally owned bytes are handed back through this callback instead of free()
+    OCDataDeallocatorCallBack deallocator;
+    void *deallocatorContext;
+    // Copies share bytes until one of them changes. A copy, and a mutable
+    // data that has been copied, point bytes into the buffer of the immutable
+    // data 'parent'.
+    bool isMutable;
+    OCDataRef parent;
+    // Set once OCDataGetMutableBytes has handed out the buffer: the caller may
+    // keep writing through that pointer, so copies no longer share it
+    bool bytesExposed;
 };
+static uint64_t impl_OCDataHash(const void *obj) {
+    return OCDataHash((OCDataRef)obj);
+}
+static bool impl_OCDataIsMutable(const void *obj) {
+    return ((OCDataRef)obj)->isMutable;
+}
+static void *impl_OCDataCreateShared(const void *obj) {
+    OCDataRef data = (OCDataRef)obj;
+    return data->isMutable ? (void *)OCDataCreateMutableCopy(0, data) : (void *)OCDataCreateCopy(data);
+}
+static const OCTypeSharedCopyCallBacks kOCDataSharedCopyCallBacks = {impl_OCDataIsMutable, NULL, impl_OCDataCreateShared, NULL};
 OCTypeID OCDataGetTypeID(void) {
     if (kOCDataID == kOCNotATypeID) {
         kOCDataID = OCRegisterType("OCData", (OCTypeRef (*)(cJSON *, OCStringRef *))OCDataCreateFromJSON);
+        OCTypeSetHashFunction(kOCDataID, impl_OCDataHash);
+        OCTypeSetSharedCopyCallBacks(kOCDataID, &kOCDataSharedCopyCallBacks);
     }
     return kOCDataID;
 }
@@ -46,28 +70,101 @@ static void *impl_OCDataDeepCopy(const void *obj) {
 static void *impl_OCDataDeepCopyMutable(const void *obj) {
     OCDataRef source = (OCDataRef)obj;
     if (!source) return NULL;
-    OCMutableDataRef copy = OCDataCreateMutableCopy(source->length, source);
-    if (copy) ((struct impl_OCData *)copy)->encoding = source->encoding;
+    OCMutableDataRef copy = OCDataCreateMutable(source->length);
+    if (copy && source->length > 0 && !OCDataAppendBytes(copy, source->bytes, source->length)) {
+        OCRelease(copy);
+        return NULL;
+    }
+    if (copy) copy->encoding = source->encoding;
     return (void *)copy;
 }
+static struct impl_OCData *OCDataAllocate(void);
+// Returns the immutable data whose buffer holds source's bytes. A mutable data
+// that owns its buffer hands it over to a new immutable data, reachable only
+// through the data borrowing from it, and borrows it back.
+static OCDataRef impl_OCDataShareStorage(OCDataRef source) {
+    struct impl_OCData *s = (struct impl_OCData *)source;
+#if defined(__GNUC__) || defined(__clang__)
+    OCDataRef parent = __atomic_load_n(&s->parent, __ATOMIC_ACQUIRE);
+#else
+    OCDataRef parent = s->parent;
+#endif
+    if (parent) return parent;
+    if (!source->isMutable) return source;
+    struct impl_OCData *owner = OCDataAllocate();
+    if (!owner) return NULL;
+    owner->encoding = source->encoding;
+    owner->bytes = source->bytes;
+    owner->length = source->length;
+    owner->capacity = source->capacity;
+    owner->deallocator = source->deallocator;
+    owner->deallocatorContext = source->deallocatorContext;
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__atomic_compare_exchange_n(&s->parent, &parent, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        owner->bytes = NULL;
+        owner->deallocator = NULL;
+        OCRelease(owner);
+        return parent;
+    }
+#else
+    s->parent = owner;
+#endif
+    return owner;
+}
+// Gives a borrowing data a buffer of its own before it changes. When the other
+// copies are gone the buffer is simply taken back.
+static bool impl_OCDataUnshare(struct impl_OCData *data, const char *caller) {
+    if (!data->parent) return true;
+    struct impl_OCData *owner = (struct impl_OCData *)data->parent;
+    if (OCTypeGetRetainCount(owner) == 1 && !owner->deallocator) {
+        data->capacity = owner->capacity;
+        owner->bytes = NULL;
+    } else if (data->length > 0) {
+        uint8_t *bytes = malloc(data->length);
+        if (!bytes) {
+            fprintf(stderr, "%s: malloc failed\n", caller);
+            return false;
+        }
+        memcpy(bytes, data->bytes, data->length);
+        data->bytes = bytes;
+        data->capacity = data->length;
+    } else {
+        data->bytes = NULL;
+        data->capacity = 0;
+    }
+    data->deallocator = NULL;
+    data->deallocatorContext = NULL;
+    data->parent = NULL;
+    OCRelease(owner);
+    return true;
+}
+static struct impl_OCData *impl_OCDataCreateBorrowing(OCDataRef owner, OCJSONEncoding encoding, bool isMutable) {
+    struct impl_OCData *copy = OCDataAllocate();
+    if (!copy) return NULL;
+    copy->encoding = encoding;
+    copy->bytes = owner->bytes;
+    copy->length = owner->length;
+    copy->capacity = owner->length;
+    copy->isMutable = isMutable;
+    copy->parent = (OCDataRef)OCRetain(owner);
+    return copy;
+}
 OCDataRef OCDataCreateCopy(OCDataRef source) {
     if (!source) return NULL;
-    OCDataRef copy = OCDataCreate(source->bytes, source->length);
-    if (copy) ((struct impl_OCData *)copy)->encoding = source->encoding;
-    return copy;
+    // Immutable data is its own copy; mutable data shares its bytes with the
+    // copy until it next changes
+    if (!source->isMutable) return (OCDataRef)OCRetain(source);
+    if (source->bytesExposed) return impl_OCDataDeepCopy(source);
+    OCDataRef owner = impl_OCDataShareStorage(source);
+    return owner ? impl_OCDataCreateBorrowing(owner, source->encoding, false) : NULL;
 }
 OCMutableDataRef OCDataCreateMutableCopy(uint64_t capacity, OCDataRef source) {
     if (!source) return NULL;
-    uint64_t actualCap = (capacity > source->length) ? capacity : source->length;
-    OCMutableDataRef result = OCDataCreateMutable(actualCap);
-    if (!result) return NULL;
-    if (source->length > 0) {
-        if (!OCDataAppendBytes(result, source->bytes, source->length)) {
-            OCRelease(result);
-            return NULL;
-        }
-    }
-    return result;
+    // The capacity is only a hint, so borrow the bytes until the copy changes
+    (void)capacity;
+    if (source->bytesExposed) return impl_OCDataDeepCopyMutable(source);
+    OCDataRef owner = impl_OCDataShareStorage(source);
+    return owner ? impl_OCDataCreateBorrowing(owner, source->encoding, true) : NULL;
 }
 OCStringRef OCDataCopyFormattingDesc(OCTypeRef cf) {
     if (!cf) return NULL;
@@ -95,17 +192,31 @@ impl_OCDataCopyJSON(const void *obj, bool typed, OCStringRef *outError) {
 }
 static void impl_OCDataFinalize(const void *obj) {
     OCDataRef data = (OCDataRef)obj;
-    if (data->bytes) free(data->bytes);
-}
-static struct impl_OCData *OCDataAllocate() {
-    return OCTypeAlloc(struct impl_OCData,
-                       OCDataGetTypeID(),
-                       impl_OCDataFinalize,
-                       impl_OCDataEqual,
-                       OCDataCopyFormattingDesc,
-                       impl_OCDataCopyJSON,
-                       impl_OCDataDeepCopy,
-                       impl_OCDataDeepCopyMutable);
+    if (data->parent) {
+        OCRelease(data->parent);
+    } else if (data->deallocator) {
+        data->deallocator(data->bytes, data->length, data->deallocatorContext);
+    } else if (data->bytes) {
+        free(data->bytes);
+    }
+}
+static struct impl_OCData *OCDataAllocate(void) {
+    struct impl_OCData *data = OCTypeAlloc(struct impl_OCData,
+                                           OCDataGetTypeID(),
+                                           impl_OCDataFinalize,
+                                           impl_OCDataEqual,
+                                           OCDataCopyFormattingDesc,
+                                           impl_OCDataCopyJSON,
+                                           impl_OCDataDeepCopy,
+                                           impl_OCDataDeepCopyMutable);
+    if (data) {
+        data->deallocator = NULL;
+        data->deallocatorContext = NULL;
+        data->isMutable = false;
+        data->parent = NULL;
+        data->bytesExposed = false;
+    }
+    return data;
 }
 OCDataRef OCDataCreate(const uint8_t *bytes, uint64_t length) {
     struct impl_OCData *data = OCDataAllocate();
@@ -135,6 +246,26 @@ OCDataRef OCDataCreateWithBytesNoCopy(const uint8_t *bytes, uint64_t length) {
     data->capacity = length;
     return data;
 }
+static void impl_OCDataKeepBytes(void *bytes, uint64_t length, void *context) {
+    (void)bytes;
+    (void)length;
+    (void)context;
+}
+OCDataRef OCDataCreateWithBytesNoCopyDeallocator(const uint8_t *bytes,
+                                                 uint64_t length,
+                                                 OCDataDeallocatorCallBack deallocator,
+                                                 void *context) {
+    if (!bytes && length > 0) return NULL;
+    struct impl_OCData *data = OCDataAllocate();
+    if (!data) return NULL;
+    data->encoding = OCJSONEncodingBase64;  // Default encoding for OCData is base64
+    data->bytes = (uint8_t *)bytes;
+    data->length = length;
+    data->capacity = length;
+    data->deallocator = deallocator ? deallocator : impl_OCDataKeepBytes;
+    data->deallocatorContext = context;
+    return data;
+}
 OCMutableDataRef OCDataCreateMutable(uint64_t capacity) {
     struct impl_OCData *data = OCDataAllocate();
     if (!data) return NULL;
@@ -147,8 +278,22 @@ OCMutableDataRef OCDataCreateMutable(uint64_t capacity) {
     }
     data->length = 0;
     data->capacity = capacity;
+    data->isMutable = true;
     return data;
 }
+uint64_t OCDataHash(OCDataRef data) {
+    if (!data) return 0;
+    // Same FNV-1a and finishing mix as OCStringHash
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint64_t i = 0; i < data->length; i++) {
+        h ^= data->bytes[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
 uint64_t OCDataGetLength(OCDataRef data) {
     return data ? data->length : 0;
 }
@@ -156,7 +301,9 @@ const uint8_t *OCDataGetBytesPtr(OCDataRef data) {
     return data ? data->bytes : NULL;
 }
 uint8_t *OCDataGetMutableBytes(OCMutableDataRef data) {
-    return data ? data->bytes : NULL;
+    if (!data || !impl_OCDataUnshare((struct impl_OCData *)data, __func__)) return NULL;
+    data->bytesExposed = true;
+    return data->bytes;
 }
 bool OCDataGetBytes(OCDataRef data, OCRange range, uint8_t *buffer) {
     if (!data || !buffer || !data->bytes) return false;
@@ -173,6 +320,7 @@ bool OCDataSetLength(OCMutableDataRef data, uint64_t newLength) {
     if (newLength == data->length) {
         return true;  // No change needed
     }
+    if (!impl_OCDataUnshare(data, __func__)) return false;
     // If expanding, reallocate if necessary
     if (newLength > data->capacity) {
         uint8_t *newBytes = realloc(data->bytes, newLength);
@@ -43,9 +43,46 @@ OCDataRef OCDataCreate(const uint8_t *bytes, uint64_t length);
  * @ingroup OCData
  */
 OCDataRef OCDataCreateWithBytesNoCopy(const uint8_t *bytes, uint64_t length);
+/**
+ * @brief Callback that releases externally owned bytes when an OCData is finalized.
+ *
+ * @param bytes The byte pointer the data object was created with.
+ * @param length The length the data object was created with.
+ * @param context The context pointer passed at creation.
+ * @ingroup OCData
+ */
+typedef void (*OCDataDeallocatorCallBack)(void *bytes, uint64_t length, void *context);
+/**
+ * @brief Creates an immutable data object over externally owned memory (no copy).
+ *
+ * Unlike OCDataCreateWithBytesNoCopy(), which takes ownership of a malloc'd
+ * buffer, the bytes are returned to @p deallocator when the object is
+ * finalized, so they may come from munmap-able mappings, pools or parser
+ * buffers. Pass NULL for @p deallocator when the caller keeps ownership and
+ * guarantees the bytes outlive the object.
+ *
+ * @param bytes Pointer to the byte buffer.
+ * @param length Length of the byte buffer.
+ * @param deallocator Called once with @p bytes, @p length and @p context on finalization, or NULL.
+ * @param context Opaque pointer passed to @p deallocator.
+ * @return New OCDataRef, or NULL on failure.
+ * @ingroup OCData
+ *
+ * @code
+ * static void unmap(void *bytes, uint64_t length, void *context) { munmap(bytes, length); }
+ * OCDataRef file = OCDataCreateWithBytesNoCopyDeallocator(map, size, unmap, NULL);
+ * @endcode
+ */
+OCDataRef OCDataCreateWithBytesNoCopyDeallocator(const uint8_t *bytes,
+                                                 uint64_t length,
+                                                 OCDataDeallocatorCallBack deallocator,
+                                                 void *context);
 /**
  * @brief Creates a new OCDataRef by copying an existing one.
  *
+ * Copying immutable data retains it. Mutable data shares its bytes with the
+ * copy until it next changes.
+ *
  * @param theData Source OCDataRef to copy.
  * @return Copy of the data, or NULL on failure.
  * @ingroup OCData
@@ -62,7 +99,10 @@ OCMutableDataRef OCDataCreateMutable(uint64_t capacity);
 /**
  * @brief Creates a mutable copy of existing data with a specified capacity.
  *
- * @param capacity Minimum capacity of the new object.
+ * The copy shares the source's bytes until either of them first changes;
+ * OCDataGetMutableBytes() and any change of length give it bytes of its own.
+ *
+ * @param capacity Capacity hint for the new object.
  * @param theData Source data to copy (can be NULL).
  * @return New OCMutableDataRef.
  * @ingroup OCData
@@ -107,6 +147,17 @@ OCDataCreateWithContentsOfFile(const char *path, OCStringRef *errorString);
  * @ingroup OCData
  */
 uint64_t OCDataGetLength(OCDataRef data);
+/**
+ * @brief Returns a hash of the data's bytes.
+ *
+ * Data objects equal under OCTypeEqual() have equal hashes. A mutable data
+ * object may hash differently after it is modified.
+ *
+ * @param data OCDataRef or OCMutableDataRef (NULL hashes to 0).
+ * @return 64-bit hash value.
+ * @ingroup OCData
+ */
+uint64_t OCDataHash(OCDataRef data);
 /**
  * @brief Returns a read-only pointer to internal bytes.
  *
@@ -118,6 +169,10 @@ const uint8_t *OCDataGetBytesPtr(OCDataRef data);
 /**
  * @brief Returns a mutable pointer to internal bytes.
  *
+ * Once the bytes have been handed out, copies of @p data are made eagerly
+ * rather than sharing its buffer, since writes through the returned pointer
+ * must not show up in them.
+ *
  * @param data Mutable data object.
  * @return Pointer to bytes, or NULL.
  * @warning Use with care. Modifications may affect internal state.
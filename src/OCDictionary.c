@@ -1,20 +1,304 @@
-// OCDictionary.c – Updated to use OCTypeAlloc and leak-safe finalization
+// OCDictionary.c – Insertion-ordered hash dictionary built on OCTypeAlloc
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "OCTypes.h"
 static OCTypeID kOCDictionaryID = kOCNotATypeID;
+// Entries are stored densely in insertion order. Removing an entry leaves a
+// tombstone (NULL key) so later entries never move, and a separate
+// open-addressed index table maps key hashes to entry positions, in the
+// manner of CPython's dict. Tombstones are squeezed out when the entries
+// array fills up or when they outnumber the live entries.
+//
+// Record-shaped dictionaries (JSON objects decoded side by side, or those
+// made with OCDictionaryCreateMutableWithSharedKeys) use a split layout
+// instead: an immutable key table shared by every dictionary of that shape,
+// and a per-dictionary array holding the values of the first count keys.
+// Anything the shared table cannot express converts the dictionary back to
+// the combined layout.
+//
+// Immutable dictionaries made by OCDictionaryCreate are frozen: dense entries
+// plus a minimal perfect hash, never modified again, so they can be read from
+// several threads without locking.
+//
+// Copies share storage until one of them changes. Copying a mutable
+// dictionary hands its storage to a hidden frozen owner; the copy, and the
+// mutable dictionary itself, then borrow that storage through 'parent' and
+// hold no references of their own to the keys and values. A borrower takes
+// the storage back, or copies it if other copies still use it, on its first
+// change.
+#define kOCDictionaryIndexEmpty (-1)
+#define kOCDictionaryIndexDummy (-2)
+#define kOCDictionaryMinIndexSize 8
+#define kOCDictionaryMinCompaction 8
+typedef struct impl_OCDictionaryEntry {
+    uint64_t hash;
+    OCTypeRef key;  // NULL for a removed entry
+    OCTypeRef value;
+} impl_OCDictionaryEntry;
+typedef struct impl_OCDictionaryKeyTable {
+    uint64_t refCount;  // dictionaries sharing the table, possibly on different threads
+    uint64_t count;
+    uint64_t indexSize;
+    impl_OCDictionaryEntry *entries;  // value fields are unused
+    int64_t *indices;
+} impl_OCDictionaryKeyTable;
 // OCDictionary Opaque Type
 struct impl_OCDictionary {
     OCBase base;
-    uint64_t count;
-    uint64_t capacity;
-    OCStringRef *keys;
-    OCTypeRef *values;
+    uint64_t count;     // live entries
+    uint64_t used;      // entries consumed, live plus tombstones
+    uint64_t capacity;  // entries allocated
+    impl_OCDictionaryEntry *entries;
+    int64_t *indices;  // entry position, empty or dummy for each slot
+    uint64_t indexSize;
+    impl_OCDictionaryKeyTable *sharedKeys;  // non-NULL in the split layout
+    OCTypeRef *sharedValues;
+    bool frozen;               // read-only; entries are dense
+    uint32_t *perfectSeeds;    // per bucket, when frozen with a perfect hash
+    uint64_t perfectBuckets;
+    uint32_t *perfectOrder;    // slot of each entry, in insertion order
+    OCDictionaryRef parent;    // owner of the storage this dictionary borrows
 };
+// ——— Hash index ———
+static uint64_t impl_OCDictionaryIndexSizeFor(uint64_t capacity) {
+    // At most two thirds of the slots are occupied once every entry is used
+    uint64_t size = kOCDictionaryMinIndexSize;
+    while (size < capacity + capacity / 2 + 1)
+        size <<= 1;
+    return size;
+}
+// Keys are any OCType; equal keys have equal OCTypeHash values
+static inline bool impl_OCDictionaryKeysEqual(OCTypeRef a, OCTypeRef b) {
+    return a == b || OCTypeEqual(a, b);
+}
+// Finds the slot holding key, or the first empty slot on its probe sequence
+static uint64_t impl_OCDictionaryProbe(const impl_OCDictionaryEntry *entries,
+                                       const int64_t *indices,
+                                       uint64_t indexSize,
+                                       OCTypeRef key,
+                                       uint64_t hash,
+                                       bool *outFound) {
+    uint64_t mask = indexSize - 1;
+    uint64_t slot = hash & mask;
+    uint64_t perturb = hash;
+    for (;;) {
+        int64_t ix = indices[slot];
+        if (ix == kOCDictionaryIndexEmpty) {
+            *outFound = false;
+            return slot;
+        }
+        if (ix >= 0) {
+            const impl_OCDictionaryEntry *entry = &entries[ix];
+            if (entry->hash == hash &&
+                impl_OCDictionaryKeysEqual(entry->key, key)) {
+                *outFound = true;
+                return slot;
+            }
+        }
+        perturb >>= 5;
+        slot = (slot * 5 + perturb + 1) & mask;
+    }
+}
+static uint64_t impl_OCDictionaryFreeSlot(const int64_t *indices, uint64_t mask, uint64_t hash) {
+    uint64_t slot = hash & mask;
+    uint64_t perturb = hash;
+    while (indices[slot] != kOCDictionaryIndexEmpty) {
+        perturb >>= 5;
+        slot = (slot * 5 + perturb + 1) & mask;
+    }
+    return slot;
+}
+// ——— Minimal perfect hash for frozen dictionaries ———
+// Hash-and-displace: a key's hash picks a bucket, and the bucket's seed
+// scatters its keys onto distinct slots among exactly count slots. Entries
+// are stored by slot, with their insertion order kept alongside for
+// iteration, so a lookup reads one seed and one entry and compares one key.
+#define kOCDictionaryPerfectFree UINT32_MAX
+#define kOCDictionaryPerfectMaxSeed (1u << 20)
+static inline uint64_t impl_OCDictionaryPerfectBucket(uint64_t hash, uint64_t buckets) {
+    return ((hash >> 32) * buckets) >> 32;
+}
+static inline uint64_t impl_OCDictionaryPerfectSlot(uint64_t hash, uint32_t seed, uint64_t count) {
+    uint64_t x = hash ^ ((uint64_t)seed * 0x9e3779b97f4a7c15ULL);
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 32;
+    return ((x & 0xffffffffULL) * count) >> 32;
+}
+// Computes seeds and slots for the count dense entries; returns false if no
+// perfect hash was found (identical 64-bit hashes, or an unlucky bucket)
+static bool impl_OCDictionaryBuildPerfectHash(const impl_OCDictionaryEntry *entries,
+                                              uint64_t count,
+                                              uint32_t **outSeeds,
+                                              uint64_t *outBuckets,
+                                              uint32_t **outSlots) {
+    if (count == 0 || count >= UINT32_MAX)
+        return false;
+    uint64_t buckets = count / 3 + 1;
+    uint32_t *seeds = calloc(buckets, sizeof(uint32_t));
+    uint32_t *slots = malloc(count * sizeof(uint32_t));
+    uint32_t *start = calloc(buckets + 1, sizeof(uint32_t));
+    uint32_t *members = malloc(count * sizeof(uint32_t));
+    uint32_t *order = malloc(buckets * sizeof(uint32_t));
+    uint32_t *trial = malloc(count * sizeof(uint32_t));
+    bool ok = seeds && slots && start && members && order && trial;
+    if (!ok) {
+        fprintf(stderr, "OCDictionary: Memory allocation for perfect hash failed.\n");
+        goto done;
+    }
+    // Group entry positions by bucket
+    for (uint64_t i = 0; i < count; i++)
+        start[impl_OCDictionaryPerfectBucket(entries[i].hash, buckets) + 1]++;
+    uint32_t largest = 0;
+    for (uint64_t b = 0; b < buckets; b++) {
+        if (start[b + 1] > largest)
+            largest = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    for (uint64_t b = 0; b < buckets; b++)
+        order[b] = start[b];  // fill cursors
+    for (uint64_t i = 0; i < count; i++)
+        members[order[impl_OCDictionaryPerfectBucket(entries[i].hash, buckets)]++] = (uint32_t)i;
+    // Place the largest buckets first, while most slots are still free
+    uint32_t *bySize = calloc((uint64_t)largest + 2, sizeof(uint32_t));
+    if (!bySize) {
+        fprintf(stderr, "OCDictionary: Memory allocation for perfect hash failed.\n");
+        ok = false;
+        goto done;
+    }
+    for (uint64_t b = 0; b < buckets; b++)
+        bySize[largest - (start[b + 1] - start[b]) + 1]++;
+    for (uint32_t k = 0; k <= largest; k++)
+        bySize[k + 1] += bySize[k];
+    for (uint64_t b = 0; b < buckets; b++)
+        order[bySize[largest - (start[b + 1] - start[b])]++] = (uint32_t)b;
+    free(bySize);
+    for (uint64_t i = 0; i < count; i++)
+        slots[i] = kOCDictionaryPerfectFree;
+    for (uint64_t o = 0; o < buckets && ok; o++) {
+        uint32_t b = order[o];
+        uint32_t first = start[b], size = start[b + 1] - start[b];
+        if (size == 0)
+            break;  // the rest are empty too
+        bool placed = false;
+        for (uint32_t seed = 0; seed < kOCDictionaryPerfectMaxSeed && !placed; seed++) {
+            placed = true;
+            for (uint32_t j = 0; j < size && placed; j++) {
+                uint64_t s = impl_OCDictionaryPerfectSlot(entries[members[first + j]].hash, seed, count);
+                if (slots[s] != kOCDictionaryPerfectFree)
+                    placed = false;
+                for (uint32_t t = 0; t < j && placed; t++)
+                    if (trial[t] == s)
+                        placed = false;
+                trial[j] = (uint32_t)s;
+            }
+            if (placed) {
+                seeds[b] = seed;
+                for (uint32_t j = 0; j < size; j++)
+                    slots[trial[j]] = members[first + j];
+            }
+        }
+        ok = placed;
+    }
+done:
+    free(start);
+    free(members);
+    free(order);
+    free(trial);
+    if (!ok) {
+        free(seeds);
+        free(slots);
+        return false;
+    }
+    *outSeeds = seeds;
+    *outBuckets = buckets;
+    *outSlots = slots;
+    return true;
+}
+// ——— Shared key tables ———
+static impl_OCDictionaryKeyTable *impl_OCDictionaryKeyTableCreate(uint64_t capacity) {
+    uint64_t indexSize = impl_OCDictionaryIndexSizeFor(capacity);
+    // Header, entries and index share one block
+    impl_OCDictionaryKeyTable *table = malloc(sizeof(impl_OCDictionaryKeyTable) +
+                                              capacity * sizeof(impl_OCDictionaryEntry) +
+                                              indexSize * sizeof(int64_t));
+    if (!table) {
+        fprintf(stderr, "OCDictionary: Memory allocation for shared key table failed.\n");
+        return NULL;
+    }
+    table->refCount = 1;
+    table->count = 0;
+    table->indexSize = indexSize;
+    table->entries = (impl_OCDictionaryEntry *)(table + 1);
+    table->indices = (int64_t *)(table->entries + capacity);
+    for (uint64_t i = 0; i < indexSize; i++)
+        table->indices[i] = kOCDictionaryIndexEmpty;
+    return table;
+}
+// Appends key, taking ownership of it; returns false (and leaves key with the
+// caller) if the table already holds an equal key. The caller guarantees room.
+static bool impl_OCDictionaryKeyTableAdd(impl_OCDictionaryKeyTable *table, OCTypeRef key) {
+    uint64_t hash = OCTypeHash(key);
+    bool found;
+    uint64_t slot = impl_OCDictionaryProbe(table->entries, table->indices, table->indexSize, key, hash, &found);
+    if (found)
+        return false;
+    impl_OCDictionaryEntry *entry = &table->entries[table->count];
+    entry->hash = hash;
+    entry->key = key;
+    entry->value = NULL;
+    table->indices[slot] = (int64_t)table->count;
+    table->count++;
+    return true;
+}
+// Dictionaries sharing a table are released independently, so the count is
+// updated atomically like an OCType retain count
+#if defined(__GNUC__) || defined(__clang__)
+#define impl_OCDictionaryKeyTableRetain(t) ((void)__atomic_add_fetch(&(t)->refCount, 1, __ATOMIC_RELAXED))
+#define impl_OCDictionaryKeyTableDecrement(t) __atomic_sub_fetch(&(t)->refCount, 1, __ATOMIC_ACQ_REL)
+#else
+#define impl_OCDictionaryKeyTableRetain(t) ((void)++(t)->refCount)
+#define impl_OCDictionaryKeyTableDecrement(t) (--(t)->refCount)
+#endif
+static void impl_OCDictionaryKeyTableRelease(impl_OCDictionaryKeyTable *table) {
+    if (!table || impl_OCDictionaryKeyTableDecrement(table) > 0)
+        return;
+    for (uint64_t i = 0; i < table->count; i++)
+        OCRelease(table->entries[i].key);
+    free(table);
+}
+// ——— Entry access for both layouts ———
+// Reads the i-th entry in insertion order (i below used); returns false for a tombstone
+static inline bool impl_OCDictionaryEntryAt(OCDictionaryRef dict, uint64_t i, OCTypeRef *outKey, OCTypeRef *outValue) {
+    if (dict->sharedKeys) {
+        *outKey = dict->sharedKeys->entries[i].key;
+        *outValue = dict->sharedValues[i];
+        return true;
+    }
+    if (dict->perfectOrder)
+        i = dict->perfectOrder[i];
+    if (!dict->entries[i].key)
+        return false;
+    *outKey = dict->entries[i].key;
+    *outValue = dict->entries[i].value;
+    return true;
+}
+// Value storage for a position returned by impl_OCDictionaryFind
+static inline OCTypeRef *impl_OCDictionaryValueSlot(struct impl_OCDictionary *dict, uint64_t i) {
+    return dict->sharedKeys ? &dict->sharedValues[i] : &dict->entries[i].value;
+}
+static bool impl_OCDictionaryIsMutable(const void *obj);
+static bool impl_OCDictionaryAnyChild(const void *obj, bool (*visit)(const void *, void *), void *info);
+static void *impl_OCDictionaryCreateShared(const void *obj);
+static bool impl_OCDictionaryReplaceChildren(void *obj, const void *(*map)(const void *, void *), void *info);
+static const OCTypeSharedCopyCallBacks kOCDictionarySharedCopyCallBacks = {
+    impl_OCDictionaryIsMutable, impl_OCDictionaryAnyChild, impl_OCDictionaryCreateShared, impl_OCDictionaryReplaceChildren};
 OCTypeID OCDictionaryGetTypeID(void) {
-    if (kOCDictionaryID == kOCNotATypeID)
+    if (kOCDictionaryID == kOCNotATypeID) {
         kOCDictionaryID = OCRegisterType("OCDictionary", (OCTypeRef (*)(cJSON *, OCStringRef *))OCDictionaryCreateFromJSONTyped);
+        OCTypeSetSharedCopyCallBacks(kOCDictionaryID, &kOCDictionarySharedCopyCallBacks);
+    }
     return kOCDictionaryID;
 }
 static bool impl_OCDictionaryEqual(const void *theType1, const void *theType2) {
@@ -26,10 +310,23 @@ static bool impl_OCDictionaryEqual(const void *theType1, const void *theType2) {
         return false;
     if (d1->count != d2->count)
         return false;
-    for (uint64_t i = 0; i < d1->count; i++) {
-        if (!OCTypeEqual(d1->keys[i], d2->keys[i]))
+    if (d1->sharedKeys && d1->sharedKeys == d2->sharedKeys) {
+        // Same key table, so only the values can differ
+        for (uint64_t i = 0; i < d1->count; i++) {
+            if (!OCTypeEqual(d1->sharedValues[i], d2->sharedValues[i]))
+                return false;
+        }
+        return true;
+    }
+    OCDictionaryCursor c1, c2;
+    OCStringRef k1, k2;
+    const void *v1, *v2;
+    OCDictionaryCursorInit(&c1, d1);
+    OCDictionaryCursorInit(&c2, d2);
+    while (OCDictionaryCursorNext(&c1, &k1, &v1) && OCDictionaryCursorNext(&c2, &k2, &v2)) {
+        if (!OCTypeEqual(k1, k2))
             return false;
-        if (!OCTypeEqual(d1->values[i], d2->values[i]))
+        if (!OCTypeEqual(v1, v2))
             return false;
     }
     return true;
@@ -44,11 +341,13 @@ OCStringRef OCDictionaryCopyFormattingDesc(OCTypeRef cf) {
     OCMutableStringRef result = OCStringCreateMutable(0);
     OCStringAppendFormat(result, STR("<OCDictionary: %zu pair%s {"),
                          count, count == 1 ? "" : "s");
-    for (size_t i = 0; i < shown; ++i) {
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    OCDictionaryCursorInit(&cursor, dict);
+    for (size_t i = 0; i < shown && OCDictionaryCursorNext(&cursor, &key, &value); ++i) {
         if (i > 0)
             OCStringAppendCString(result, ", ");
-        OCTypeRef key = (OCTypeRef)dict->keys[i];
-        OCTypeRef value = dict->values[i];
         OCStringRef keyDesc = OCTypeCopyFormattingDesc(key);
         OCStringRef valDesc = OCTypeCopyFormattingDesc(value);
         if (keyDesc) {
@@ -78,15 +377,19 @@ static void *impl_OCDictionaryDeepCopy(const void *obj) {
     OCMutableDictionaryRef copy = OCDictionaryCreateMutable(src->count);
     if (!copy)
         return NULL;
-    for (uint64_t i = 0; i < src->count; ++i) {
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    OCDictionaryCursorInit(&cursor, src);
+    while (OCDictionaryCursorNext(&cursor, &key, &value)) {
         // deep-copy the key
-        OCStringRef keyCopy = (OCStringRef)OCTypeDeepCopy(src->keys[i]);
+        OCTypeRef keyCopy = OCTypeDeepCopy(key);
         if (!keyCopy) {
             OCRelease(copy);
             return NULL;
         }
         // deep-copy the value
-        void *valCopy = OCTypeDeepCopy(src->values[i]);
+        void *valCopy = OCTypeDeepCopy(value);
         if (!valCopy) {
             OCRelease(keyCopy);
             OCRelease(copy);
@@ -108,9 +411,17 @@ static void *impl_OCDictionaryDeepCopyMutable(const void *obj) {
     return impl_OCDictionaryDeepCopy(obj);
 }
 static void impl_OCDictionaryReleaseKeysAndValues(OCDictionaryRef dict) {
-    for (uint64_t i = 0; i < dict->count; i++) {
-        OCRelease(dict->keys[i]);
-        OCRelease(dict->values[i]);
+    if (dict->sharedKeys) {
+        // Keys belong to the shared table
+        for (uint64_t i = 0; i < dict->count; i++)
+            OCRelease(dict->sharedValues[i]);
+        return;
+    }
+    for (uint64_t i = 0; i < dict->used; i++) {
+        if (!dict->entries[i].key)
+            continue;
+        OCRelease(dict->entries[i].key);
+        OCRelease(dict->entries[i].value);
     }
 }
 static void impl_OCDictionaryFinalize(const void *theType) {
@@ -119,13 +430,17 @@ static void impl_OCDictionaryFinalize(const void *theType) {
         return;
     }
     OCDictionaryRef dict = (OCDictionaryRef)theType;
-    impl_OCDictionaryReleaseKeysAndValues(dict);
-    if (dict->keys) {
-        free(dict->keys);
-    }
-    if (dict->values) {
-        free(dict->values);
+    if (dict->parent) {
+        OCRelease(dict->parent);
+        return;
     }
+    impl_OCDictionaryReleaseKeysAndValues(dict);
+    free(dict->entries);
+    free(dict->indices);
+    free(dict->sharedValues);
+    impl_OCDictionaryKeyTableRelease(dict->sharedKeys);
+    free(dict->perfectSeeds);
+    free(dict->perfectOrder);
 }
 static cJSON *
 impl_OCDictionaryCopyJSON(const void *obj, bool typed, OCStringRef *outError) {
@@ -148,238 +463,633 @@ uint64_t OCDictionaryGetCount(OCDictionaryRef theDictionary) {
         return 0;
     return theDictionary->count;
 }
+// Returns the entry position of key, or -1 if absent
+static int64_t impl_OCDictionaryFind(OCDictionaryRef dict, OCTypeRef key) {
+    if (!dict || !key || dict->count == 0)
+        return -1;
+    uint64_t hash = OCTypeHash(key);
+    bool found;
+    if (dict->perfectOrder) {
+        uint32_t seed = dict->perfectSeeds[impl_OCDictionaryPerfectBucket(hash, dict->perfectBuckets)];
+        uint64_t slot = impl_OCDictionaryPerfectSlot(hash, seed, dict->count);
+        const impl_OCDictionaryEntry *entry = &dict->entries[slot];
+        if (entry->hash == hash &&
+            impl_OCDictionaryKeysEqual(entry->key, key))
+            return (int64_t)slot;
+        return -1;
+    }
+    if (dict->sharedKeys) {
+        const impl_OCDictionaryKeyTable *table = dict->sharedKeys;
+        uint64_t slot = impl_OCDictionaryProbe(table->entries, table->indices, table->indexSize, key, hash, &found);
+        if (!found || (uint64_t)table->indices[slot] >= dict->count)
+            return -1;
+        return table->indices[slot];
+    }
+    uint64_t slot = impl_OCDictionaryProbe(dict->entries, dict->indices, dict->indexSize, key, hash, &found);
+    return found ? dict->indices[slot] : -1;
+}
+// Moves the live entries, in order, into fresh combined storage for
+// newCapacity entries and rebuilds the index; a split dictionary gives up its
+// shared key table. On failure the dictionary is unchanged.
+static bool impl_OCDictionaryRebuild(struct impl_OCDictionary *dict, uint64_t newCapacity) {
+    if (newCapacity < dict->count)
+        newCapacity = dict->count;
+    if (newCapacity == 0)
+        newCapacity = 1;
+    uint64_t indexSize = impl_OCDictionaryIndexSizeFor(newCapacity);
+    impl_OCDictionaryEntry *entries = malloc(newCapacity * sizeof(impl_OCDictionaryEntry));
+    int64_t *indices = malloc(indexSize * sizeof(int64_t));
+    if (!entries || !indices) {
+        fprintf(stderr, "OCDictionary: Memory allocation for %llu entries failed.\n", (unsigned long long)newCapacity);
+        free(entries);
+        free(indices);
+        return false;
+    }
+    for (uint64_t i = 0; i < indexSize; i++)
+        indices[i] = kOCDictionaryIndexEmpty;
+    const impl_OCDictionaryEntry *source = dict->sharedKeys ? dict->sharedKeys->entries : dict->entries;
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < dict->used; i++) {
+        if (!source[i].key)
+            continue;
+        entries[n] = source[i];
+        if (dict->sharedKeys) {
+            entries[n].key = OCRetain(source[i].key);
+            entries[n].value = dict->sharedValues[i];
+        }
+        indices[impl_OCDictionaryFreeSlot(indices, indexSize - 1, entries[n].hash)] = (int64_t)n;
+        n++;
+    }
+    if (dict->sharedKeys) {
+        impl_OCDictionaryKeyTableRelease(dict->sharedKeys);
+        free(dict->sharedValues);
+        dict->sharedKeys = NULL;
+        dict->sharedValues = NULL;
+    }
+    free(dict->entries);
+    free(dict->indices);
+    dict->entries = entries;
+    dict->indices = indices;
+    dict->indexSize = indexSize;
+    dict->capacity = newCapacity;
+    dict->used = n;
+    return true;
+}
+// Makes a dictionary read-only: entries are packed exactly and, when one can
+// be built, a minimal perfect hash replaces the index table.
+static bool impl_OCDictionaryFreeze(struct impl_OCDictionary *dict) {
+    if (dict->frozen)
+        return true;
+    if ((dict->sharedKeys || dict->used != dict->count || dict->capacity != dict->count) &&
+        !impl_OCDictionaryRebuild(dict, dict->count))
+        return false;
+    uint32_t *seeds, *slots, *order = NULL;
+    uint64_t buckets;
+    impl_OCDictionaryEntry *entries = NULL;
+    if (impl_OCDictionaryBuildPerfectHash(dict->entries, dict->count, &seeds, &buckets, &slots)) {
+        // Store entries in slot order so a hit touches a single entry, and
+        // keep the insertion order on the side for iteration
+        entries = malloc(dict->count * sizeof(impl_OCDictionaryEntry));
+        order = malloc(dict->count * sizeof(uint32_t));
+        if (entries && order) {
+            for (uint64_t slot = 0; slot < dict->count; slot++) {
+                entries[slot] = dict->entries[slots[slot]];
+                order[slots[slot]] = (uint32_t)slot;
+            }
+            free(dict->entries);
+            free(dict->indices);
+            dict->entries = entries;
+            dict->indices = NULL;
+            dict->indexSize = 0;
+            dict->perfectSeeds = seeds;
+            dict->perfectBuckets = buckets;
+            dict->perfectOrder = order;
+        } else {
+            free(entries);
+            free(order);
+            free(seeds);
+        }
+        free(slots);
+    }
+    dict->frozen = true;
+    return true;
+}
+// Returns the frozen dictionary whose storage holds dict's entries. A mutable
+// dictionary that owns its storage hands it over to a new frozen dictionary,
+// reachable only through the dictionaries borrowing from it, and borrows it
+// back.
+static OCDictionaryRef impl_OCDictionaryShareStorage(OCDictionaryRef dict) {
+    struct impl_OCDictionary *d = (struct impl_OCDictionary *)dict;
+#if defined(__GNUC__) || defined(__clang__)
+    OCDictionaryRef parent = __atomic_load_n(&d->parent, __ATOMIC_ACQUIRE);
+#else
+    OCDictionaryRef parent = d->parent;
+#endif
+    if (parent)
+        return parent;
+    if (dict->frozen)
+        return dict;
+    struct impl_OCDictionary *owner = OCDictionaryAllocate();
+    if (!owner)
+        return NULL;
+    owner->count = dict->count;
+    owner->used = dict->used;
+    owner->capacity = dict->capacity;
+    owner->entries = dict->entries;
+    owner->indices = dict->indices;
+    owner->indexSize = dict->indexSize;
+    owner->sharedKeys = dict->sharedKeys;
+    owner->sharedValues = dict->sharedValues;
+    owner->frozen = true;
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__atomic_compare_exchange_n(&d->parent, &parent, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        owner->count = owner->used = 0;
+        owner->entries = NULL;
+        owner->indices = NULL;
+        owner->sharedKeys = NULL;
+        owner->sharedValues = NULL;
+        OCRelease(owner);
+        return parent;
+    }
+#else
+    d->parent = owner;
+#endif
+    return owner;
+}
+static struct impl_OCDictionary *impl_OCDictionaryCreateBorrowing(OCDictionaryRef owner, bool frozen) {
+    struct impl_OCDictionary *copy = OCDictionaryAllocate();
+    if (!copy)
+        return NULL;
+    copy->count = owner->count;
+    copy->used = owner->used;
+    copy->capacity = owner->capacity;
+    copy->entries = owner->entries;
+    copy->indices = owner->indices;
+    copy->indexSize = owner->indexSize;
+    copy->sharedKeys = owner->sharedKeys;
+    copy->sharedValues = owner->sharedValues;
+    copy->perfectSeeds = owner->perfectSeeds;
+    copy->perfectBuckets = owner->perfectBuckets;
+    copy->perfectOrder = owner->perfectOrder;
+    copy->frozen = frozen;
+    copy->parent = (OCDictionaryRef)OCRetain(owner);
+    return copy;
+}
+// Gives a borrowing dictionary storage of its own before it changes. When the
+// other copies are gone the storage is simply taken back; a frozen layout is
+// always rebuilt, since mutation needs the hash index.
+static bool impl_OCDictionaryUnshare(struct impl_OCDictionary *dict, const char *caller) {
+    if (!dict->parent)
+        return true;
+    struct impl_OCDictionary *owner = (struct impl_OCDictionary *)dict->parent;
+    if (OCTypeGetRetainCount(owner) == 1 && !dict->perfectOrder) {
+        owner->count = owner->used = 0;
+        owner->entries = NULL;
+        owner->indices = NULL;
+        owner->sharedKeys = NULL;
+        owner->sharedValues = NULL;
+    } else if (dict->sharedKeys) {
+        OCTypeRef *values = (OCTypeRef *)calloc(dict->sharedKeys->count ? dict->sharedKeys->count : 1, sizeof(OCTypeRef));
+        if (!values) {
+            fprintf(stderr, "%s: Memory allocation for shared-key values failed.\n", caller);
+            return false;
+        }
+        for (uint64_t i = 0; i < dict->count; i++)
+            values[i] = (OCTypeRef)OCRetain(dict->sharedValues[i]);
+        impl_OCDictionaryKeyTableRetain(dict->sharedKeys);
+        dict->sharedValues = values;
+    } else {
+        uint64_t capacity = dict->capacity ? dict->capacity : 1;
+        uint64_t indexSize = impl_OCDictionaryIndexSizeFor(capacity);
+        impl_OCDictionaryEntry *entries = malloc(capacity * sizeof(impl_OCDictionaryEntry));
+        int64_t *indices = malloc(indexSize * sizeof(int64_t));
+        if (!entries || !indices) {
+            fprintf(stderr, "%s: Memory allocation for %llu entries failed.\n", caller, (unsigned long long)capacity);
+            free(entries);
+            free(indices);
+            return false;
+        }
+        for (uint64_t i = 0; i < indexSize; i++)
+            indices[i] = kOCDictionaryIndexEmpty;
+        uint64_t n = 0;
+        for (uint64_t i = 0; i < dict->used; i++) {
+            const impl_OCDictionaryEntry *entry = &dict->entries[dict->perfectOrder ? dict->perfectOrder[i] : i];
+            if (!entry->key)
+                continue;
+            entries[n].hash = entry->hash;
+            entries[n].key = OCRetain(entry->key);
+            entries[n].value = OCRetain(entry->value);
+            indices[impl_OCDictionaryFreeSlot(indices, indexSize - 1, entry->hash)] = (int64_t)n;
+            n++;
+        }
+        dict->entries = entries;
+        dict->indices = indices;
+        dict->indexSize = indexSize;
+        dict->capacity = capacity;
+        dict->used = n;
+        dict->perfectSeeds = NULL;
+        dict->perfectBuckets = 0;
+        dict->perfectOrder = NULL;
+    }
+    dict->parent = NULL;
+    OCRelease(owner);
+    return true;
+}
+static bool impl_OCDictionaryCheckMutable(OCDictionaryRef dict, const char *caller) {
+    if (dict->frozen) {
+        fprintf(stderr, "%s: Dictionary is immutable.\n", caller);
+        return false;
+    }
+    return impl_OCDictionaryUnshare((struct impl_OCDictionary *)dict, caller);
+}
+// Stored keys must not change, so keys of types with mutable variants are
+// copied; numbers and booleans are immutable and simply retained. String
+// keys are never stored as substring views. OCSortedDictionary shares it.
+OCTypeRef impl_OCDictionaryCopyKey(const void *key) {
+    OCTypeID type = OCGetTypeID(key);
+    if (type == OCStringGetTypeID())
+        return (OCTypeRef)impl_OCStringCreateKeyCopy((OCStringRef)key);
+    if (type == OCNumberGetTypeID() || type == OCBooleanGetTypeID())
+        return OCRetain(key);
+    OCTypeRef copy = OCTypeDeepCopy(key);
+    return copy ? copy : OCRetain(key);
+}
+// Appends an entry for a key known to be absent; takes ownership of keyCopy
+static void impl_OCDictionaryAppendEntry(struct impl_OCDictionary *dict, uint64_t slot, uint64_t hash, OCTypeRef keyCopy, const void *value) {
+    impl_OCDictionaryEntry *entry = &dict->entries[dict->used];
+    entry->hash = hash;
+    entry->key = keyCopy;
+    entry->value = (OCTypeRef)OCRetain(value);
+    dict->indices[slot] = (int64_t)dict->used;
+    dict->used++;
+    dict->count++;
+}
+// Creates an empty dictionary in the split layout over table
+static struct impl_OCDictionary *impl_OCDictionaryCreateSplit(impl_OCDictionaryKeyTable *table) {
+    struct impl_OCDictionary *dict = OCDictionaryAllocate();
+    if (!dict)
+        return NULL;
+    dict->sharedValues = (OCTypeRef *)calloc(table->count ? table->count : 1, sizeof(OCTypeRef));
+    if (!dict->sharedValues) {
+        fprintf(stderr, "OCDictionary: Memory allocation for shared-key values failed.\n");
+        OCRelease(dict);
+        return NULL;
+    }
+    impl_OCDictionaryKeyTableRetain(table);
+    dict->sharedKeys = table;
+    dict->capacity = table->count;
+    return dict;
+}
 OCDictionaryRef OCDictionaryCreate(const void **keys,
                                    const void **values,
                                    uint64_t numValues) {
     if (!keys || !values) return NULL;
-    // Normalize zero → at least one slot
-    uint64_t allocCap = (numValues > 0 ? numValues : 1);
-    OCMutableDictionaryRef dict = OCDictionaryCreateMutable(allocCap);
+    OCMutableDictionaryRef dict = OCDictionaryCreateMutable(numValues);
     if (!dict) return NULL;
-    // If there really are no entries, we’re done:
-    if (numValues == 0) {
-        return dict;
-    }
-    // Otherwise copy keys & values as before...
-    dict->count = numValues;  // safe because allocCap >= numValues
     for (uint64_t i = 0; i < numValues; i++) {
-        dict->keys[i] = OCStringCreateCopy((OCStringRef)keys[i]);
-        dict->values[i] = (OCTypeRef)OCRetain(values[i]);
+        if (!OCDictionaryAddValue(dict, keys[i], values[i])) {
+            OCRelease(dict);
+            return NULL;
+        }
+    }
+    if (!impl_OCDictionaryFreeze(dict)) {
+        OCRelease(dict);
+        return NULL;
     }
     return dict;
 }
 OCMutableDictionaryRef OCDictionaryCreateMutable(uint64_t capacity) {
     struct impl_OCDictionary *theDictionary = OCDictionaryAllocate();
     if (!theDictionary) return NULL;
-    // Normalize zero capacity → at least one slot
-    uint64_t allocCap = (capacity > 0 ? capacity : 1);
-    theDictionary->values = (OCTypeRef *)calloc(allocCap, sizeof(OCTypeRef));
-    if (!theDictionary->values) {
-        fprintf(stderr, "OCDictionaryCreateMutable: Memory allocation for values failed.\n");
+    if (!impl_OCDictionaryRebuild(theDictionary, capacity)) {
+        fprintf(stderr, "OCDictionaryCreateMutable: Memory allocation failed.\n");
         OCRelease(theDictionary);
         return NULL;
     }
-    theDictionary->keys = (OCStringRef *)calloc(allocCap, sizeof(OCStringRef));
-    if (!theDictionary->keys) {
-        fprintf(stderr, "OCDictionaryCreateMutable: Memory allocation for keys failed.\n");
-        free(theDictionary->values);
-        OCRelease(theDictionary);
+    return theDictionary;
+}
+OCMutableDictionaryRef OCDictionaryCreateMutableWithSharedKeys(OCDictionaryRef keySource) {
+    if (!keySource || keySource->count == 0)
+        return OCDictionaryCreateMutable(0);
+    if (keySource->sharedKeys)
+        return impl_OCDictionaryCreateSplit(keySource->sharedKeys);
+    impl_OCDictionaryKeyTable *table = impl_OCDictionaryKeyTableCreate(keySource->count);
+    if (!table)
         return NULL;
+    OCTypeRef key;
+    OCTypeRef value;
+    for (uint64_t i = 0; i < keySource->used; i++) {
+        if (impl_OCDictionaryEntryAt(keySource, i, &key, &value))
+            impl_OCDictionaryKeyTableAdd(table, OCRetain(key));
     }
-    theDictionary->count = 0;
-    theDictionary->capacity = allocCap;
-    return theDictionary;
+    struct impl_OCDictionary *dict = impl_OCDictionaryCreateSplit(table);
+    impl_OCDictionaryKeyTableRelease(table);
+    return dict;
 }
 OCDictionaryRef OCDictionaryCreateCopy(OCDictionaryRef theDictionary) {
     if (!theDictionary)
         return NULL;
-    return (OCDictionaryRef)OCDictionaryCreate((const void **)theDictionary->keys, (const void **)theDictionary->values, theDictionary->count);
+    // A frozen dictionary is its own copy; a mutable one shares its storage
+    // with the copy until it next changes
+    if (theDictionary->frozen)
+        return (OCDictionaryRef)OCRetain(theDictionary);
+    OCDictionaryRef owner = impl_OCDictionaryShareStorage(theDictionary);
+    return owner ? impl_OCDictionaryCreateBorrowing(owner, true) : NULL;
 }
 OCMutableDictionaryRef OCDictionaryCreateMutableCopy(OCDictionaryRef theDictionary) {
-    return (OCMutableDictionaryRef)OCDictionaryCreate((const void **)theDictionary->keys, (const void **)theDictionary->values, theDictionary->count);
+    if (!theDictionary)
+        return NULL;
+    OCDictionaryRef owner = impl_OCDictionaryShareStorage(theDictionary);
+    return owner ? impl_OCDictionaryCreateBorrowing(owner, false) : NULL;
 }
-const void *OCDictionaryGetValue(OCDictionaryRef theDictionary, OCStringRef key) {
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        if (OCStringCompare(theDictionary->keys[index], key, 0) == kOCCompareEqualTo)
-            return theDictionary->values[index];
-    }
-    return NULL;
+// ——— OCTypeDeepCopyShared support ———
+// Stored keys are immutable copies, so only the values are children.
+static bool impl_OCDictionaryIsMutable(const void *obj) {
+    return !((OCDictionaryRef)obj)->frozen;
 }
-bool OCDictionaryContainsKey(OCDictionaryRef theDictionary, OCStringRef key) {
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        if (OCStringCompare(theDictionary->keys[index], key, 0) == kOCCompareEqualTo)
+static bool impl_OCDictionaryAnyChild(const void *obj, bool (*visit)(const void *, void *), void *info) {
+    OCDictionaryRef dict = (OCDictionaryRef)obj;
+    OCTypeRef key, value;
+    for (uint64_t i = 0; i < dict->used; i++)
+        if (impl_OCDictionaryEntryAt(dict, i, &key, &value) && visit(value, info))
             return true;
-    }
     return false;
 }
-int64_t OCDictionaryIndexOfKey(OCDictionaryRef theDictionary, OCStringRef key) {
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        if (OCStringCompare(theDictionary->keys[index], key, 0) == kOCCompareEqualTo)
-            return (int64_t)index;
+static void *impl_OCDictionaryCreateShared(const void *obj) {
+    OCDictionaryRef dict = (OCDictionaryRef)obj;
+    OCDictionaryRef owner = impl_OCDictionaryShareStorage(dict);
+    return owner ? impl_OCDictionaryCreateBorrowing(owner, dict->frozen) : NULL;
+}
+// Unsharing compacts the entries and drops the perfect-hash order, so the
+// copy is unshared only once a value is known to change, and the values are
+// then written by position in the new layout. A frozen copy is frozen again
+// to get its perfect hash back.
+static bool impl_OCDictionaryReplaceChildren(void *obj, const void *(*map)(const void *, void *), void *info) {
+    struct impl_OCDictionary *copy = (struct impl_OCDictionary *)obj;
+    OCTypeRef key, value;
+    uint64_t i = 0;
+    for (; i < copy->used; i++)
+        if (impl_OCDictionaryEntryAt(copy, i, &key, &value) && map(value, info) != value)
+            break;
+    if (i == copy->used)
+        return true;
+    if (!impl_OCDictionaryUnshare(copy, "OCTypeDeepCopyShared"))
+        return false;
+    for (i = 0; i < copy->used; i++) {
+        if (!impl_OCDictionaryEntryAt(copy, i, &key, &value))
+            continue;
+        const void *replacement = map(value, info);
+        if (replacement == value)
+            continue;
+        OCTypeRef *slot = impl_OCDictionaryValueSlot(copy, i);
+        *slot = OCRetain(replacement);
+        OCRelease(value);
     }
-    return -1;
+    if (!copy->frozen)
+        return true;
+    copy->frozen = false;
+    return impl_OCDictionaryFreeze(copy);
+}
+const void *OCDictionaryGetValue(OCDictionaryRef theDictionary, const void *key) {
+    int64_t index = impl_OCDictionaryFind(theDictionary, key);
+    return index < 0 ? NULL : *impl_OCDictionaryValueSlot((struct impl_OCDictionary *)theDictionary, (uint64_t)index);
+}
+bool OCDictionaryContainsKey(OCDictionaryRef theDictionary, const void *key) {
+    return impl_OCDictionaryFind(theDictionary, key) >= 0;
 }
 bool OCDictionaryContainsValue(OCDictionaryRef theDictionary, const void *value) {
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        if (theDictionary->values[index] == value)
+    if (!theDictionary)
+        return false;
+    OCTypeRef k;
+    OCTypeRef v;
+    for (uint64_t index = 0; index < theDictionary->used; index++) {
+        if (impl_OCDictionaryEntryAt(theDictionary, index, &k, &v) && v == value)
             return true;
     }
     return false;
 }
-bool OCDictionaryAddValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value) {
+bool OCDictionaryAddValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value) {
     if (!theDictionary || !key || !value)
         return false;
-    // Check if the key already exists
-    int64_t existingKeyIndex = OCDictionaryIndexOfKey(theDictionary, key);
-    if (existingKeyIndex >= 0) {
+    if (!impl_OCDictionaryCheckMutable(theDictionary, __func__))
+        return false;
+    uint64_t hash = OCTypeHash(key);
+    bool found;
+    if (theDictionary->sharedKeys) {
+        const impl_OCDictionaryKeyTable *table = theDictionary->sharedKeys;
+        uint64_t slot = impl_OCDictionaryProbe(table->entries, table->indices, table->indexSize, key, hash, &found);
+        uint64_t position = found ? (uint64_t)table->indices[slot] : UINT64_MAX;
+        if (position < theDictionary->count) {
+            // Key exists, replace the value
+            OCTypeRef old = theDictionary->sharedValues[position];
+            theDictionary->sharedValues[position] = (OCTypeRef)OCRetain(value);
+            OCRelease(old);
+            return true;
+        }
+        if (position == theDictionary->count) {
+            // Next key in the shared order
+            theDictionary->sharedValues[position] = (OCTypeRef)OCRetain(value);
+            theDictionary->count++;
+            theDictionary->used++;
+            return true;
+        }
+        // A key the shared table cannot place: switch to the combined layout
+        if (!impl_OCDictionaryRebuild(theDictionary, theDictionary->count * 2)) {
+            fprintf(stderr, "OCDictionaryAddValue: Memory allocation for entries failed.\n");
+            return false;
+        }
+    }
+    uint64_t slot = impl_OCDictionaryProbe(theDictionary->entries, theDictionary->indices, theDictionary->indexSize, key, hash, &found);
+    if (found) {
         // Key exists, replace the value
-        OCRelease(theDictionary->values[existingKeyIndex]);
-        OCTypeRef type = (OCTypeRef)value;
-        theDictionary->values[existingKeyIndex] = type;
-        OCRetain(type);
+        impl_OCDictionaryEntry *entry = &theDictionary->entries[theDictionary->indices[slot]];
+        OCTypeRef old = entry->value;
+        entry->value = (OCTypeRef)OCRetain(value);
+        OCRelease(old);
         return true;
     }
-    // Expand storage if necessary
-    if (theDictionary->capacity == 0 || theDictionary->count == theDictionary->capacity) {
-        OCTypeRef *newValues = NULL;
-        OCStringRef *newKeys = NULL;
-        uint64_t newCapacity = theDictionary->capacity == 0 ? 1 : theDictionary->capacity * 2;
-        newValues = (OCTypeRef *)realloc(theDictionary->values, newCapacity * sizeof(OCTypeRef));
-        if (!newValues) {
-            fprintf(stderr, "OCDictionaryAddValue: Memory reallocation for values failed.\n");
+    if (theDictionary->used == theDictionary->capacity) {
+        // Reclaim tombstones when they are a sizeable share, otherwise grow
+        uint64_t tombstones = theDictionary->used - theDictionary->count;
+        uint64_t newCapacity = tombstones > theDictionary->capacity / 4 ? theDictionary->capacity : theDictionary->capacity * 2;
+        if (!impl_OCDictionaryRebuild(theDictionary, newCapacity)) {
+            fprintf(stderr, "OCDictionaryAddValue: Memory reallocation for entries failed.\n");
             return false;
         }
-        newKeys = (OCStringRef *)realloc(theDictionary->keys, newCapacity * sizeof(OCStringRef));
-        if (!newKeys) {
-            free(newValues);  // Free previously allocated values
-            fprintf(stderr, "OCDictionaryAddValue: Memory reallocation for keys failed.\n");
-            return false;
-        }
-        theDictionary->values = newValues;
-        theDictionary->keys = newKeys;
-        theDictionary->capacity = newCapacity;
+        slot = impl_OCDictionaryFreeSlot(theDictionary->indices, theDictionary->indexSize - 1, hash);
     }
-    OCTypeRef type = (OCTypeRef)value;
-    OCStringRef keyCopy = OCStringCreateCopy(key);
+    OCTypeRef keyCopy = impl_OCDictionaryCopyKey(key);
     if (!keyCopy) {
-        fprintf(stderr, "OCDictionaryAddValue: Failed to copy key string.\n");
+        fprintf(stderr, "OCDictionaryAddValue: Failed to copy key.\n");
         return false;
     }
-    theDictionary->values[theDictionary->count] = type;
-    OCRetain(type);
-    theDictionary->keys[theDictionary->count] = keyCopy;
-    theDictionary->count++;
+    impl_OCDictionaryAppendEntry(theDictionary, slot, hash, keyCopy, value);
     return true;
 }
 bool OCDictionaryGetKeysAndValues(OCDictionaryRef theDictionary, const void **keys, const void **values) {
     if (!theDictionary || !keys || !values)
         return false;
-    OCStringRef *outKeys = (OCStringRef *)keys;
-    OCTypeRef *outValues = (OCTypeRef *)values;
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        outKeys[index] = theDictionary->keys[index];
-        outValues[index] = theDictionary->values[index];
+    OCTypeRef k;
+    OCTypeRef v;
+    uint64_t n = 0;
+    for (uint64_t index = 0; index < theDictionary->used; index++) {
+        if (!impl_OCDictionaryEntryAt(theDictionary, index, &k, &v))
+            continue;
+        keys[n] = k;
+        values[n] = v;
+        n++;
     }
     return true;
 }
-bool OCDictionarySetValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value) {
-    if (!theDictionary || !key || !value)
-        return false;
-    int64_t index = OCDictionaryIndexOfKey(theDictionary, key);
-    if (index < 0)
-        return OCDictionaryAddValue(theDictionary, key, value);
-    OCRelease(theDictionary->values[index]);
-    theDictionary->values[index] = (OCTypeRef)OCRetain(value);
-    return true;
+bool OCDictionarySetValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value) {
+    return OCDictionaryAddValue(theDictionary, key, value);
 }
-bool OCDictionaryReplaceValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value) {
+bool OCDictionaryReplaceValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value) {
     if (!theDictionary || !key || !value)
         return false;
-    int64_t index = OCDictionaryIndexOfKey(theDictionary, key);
+    if (!impl_OCDictionaryCheckMutable(theDictionary, __func__))
+        return false;
+    int64_t index = impl_OCDictionaryFind(theDictionary, key);
     if (index < 0)
         return false;
-    OCRelease(theDictionary->values[index]);
-    theDictionary->values[index] = (OCTypeRef)OCRetain(value);
+    OCTypeRef *slot = impl_OCDictionaryValueSlot(theDictionary, (uint64_t)index);
+    OCTypeRef old = *slot;
+    *slot = (OCTypeRef)OCRetain(value);
+    OCRelease(old);
     return true;
 }
-bool OCDictionaryRemoveValue(OCMutableDictionaryRef theDictionary, OCStringRef key) {
-    if (!theDictionary || !key)
+bool OCDictionaryRemoveValue(OCMutableDictionaryRef theDictionary, const void *key) {
+    if (!theDictionary || !key || theDictionary->count == 0)
+        return false;
+    if (!impl_OCDictionaryCheckMutable(theDictionary, __func__))
         return false;
-    int64_t indexOfKey = OCDictionaryIndexOfKey(theDictionary, key);
-    if (indexOfKey < 0)
+    if (theDictionary->sharedKeys) {
+        int64_t index = impl_OCDictionaryFind(theDictionary, key);
+        if (index < 0)
+            return false;  // Key not found
+        if ((uint64_t)index == theDictionary->count - 1) {
+            // Dropping the last key keeps the shape a prefix of the table
+            OCTypeRef old = theDictionary->sharedValues[index];
+            theDictionary->sharedValues[index] = NULL;
+            theDictionary->count--;
+            theDictionary->used--;
+            OCRelease(old);
+            return true;
+        }
+        if (!impl_OCDictionaryRebuild(theDictionary, theDictionary->count)) {
+            fprintf(stderr, "OCDictionaryRemoveValue: Memory allocation for entries failed.\n");
+            return false;
+        }
+    }
+    bool found;
+    uint64_t slot = impl_OCDictionaryProbe(theDictionary->entries, theDictionary->indices, theDictionary->indexSize, key, OCTypeHash(key), &found);
+    if (!found)
         return false;  // Key not found
-    // Release the key and value being removed
-    OCRelease(theDictionary->keys[indexOfKey]);
-    OCRelease(theDictionary->values[indexOfKey]);
-    // Shift subsequent elements down.
-    for (uint64_t index = indexOfKey; index < theDictionary->count - 1; index++) {
-        theDictionary->keys[index] = theDictionary->keys[index + 1];
-        theDictionary->values[index] = theDictionary->values[index + 1];
-    }
-    // Decrement count
+    // Leave a tombstone so later entries keep their positions
+    impl_OCDictionaryEntry *entry = &theDictionary->entries[theDictionary->indices[slot]];
+    OCTypeRef oldKey = entry->key;
+    OCTypeRef oldValue = entry->value;
+    theDictionary->indices[slot] = kOCDictionaryIndexDummy;
+    entry->key = NULL;
+    entry->value = NULL;
     theDictionary->count--;
+    OCRelease(oldKey);
+    OCRelease(oldValue);
+    // Compact once tombstones outnumber live entries; the work is paid for by
+    // the removals since the last rebuild. A failed rebuild leaves the
+    // dictionary valid, just sparser.
+    uint64_t tombstones = theDictionary->used - theDictionary->count;
+    if (tombstones >= kOCDictionaryMinCompaction && tombstones > theDictionary->count)
+        impl_OCDictionaryRebuild(theDictionary, theDictionary->count * 2);
     return true;
 }
 uint64_t OCDictionaryGetCountOfValue(OCMutableDictionaryRef theDictionary, const void *value) {
+    if (!theDictionary)
+        return 0;
+    OCTypeRef k;
+    OCTypeRef v;
     uint64_t count = 0;
-    for (uint64_t index = 0; index < theDictionary->count; index++) {
-        if (OCTypeEqual(theDictionary->values[index], value))
+    for (uint64_t index = 0; index < theDictionary->used; index++) {
+        if (impl_OCDictionaryEntryAt(theDictionary, index, &k, &v) && OCTypeEqual(v, value))
             count++;
     }
     return count;
 }
-OCArrayRef OCDictionaryCreateArrayWithAllKeys(OCDictionaryRef theDictionary) {
-    if (theDictionary == NULL)
-        return NULL;
-    uint64_t count = OCDictionaryGetCount(theDictionary);
-    const void **keys = calloc(count, sizeof(const void *));
-    if (NULL == keys) {
-        fprintf(stderr, "OCDictionaryCreateArrayWithAllKeys: Memory allocation for keys failed.\n");
-        return NULL;
+void OCDictionaryApplyFunction(OCDictionaryRef theDictionary, OCDictionaryApplierFunction applier, void *context) {
+    if (!theDictionary || !applier)
+        return;
+    OCTypeRef k;
+    OCTypeRef v;
+    for (uint64_t index = 0; index < theDictionary->used; index++) {
+        if (impl_OCDictionaryEntryAt(theDictionary, index, &k, &v))
+            applier((OCStringRef)k, v, context);
     }
-    const void **values = calloc(count, sizeof(const void *));
-    if (NULL == values) {
-        fprintf(stderr, "OCDictionaryCreateArrayWithAllKeys: Memory allocation for values failed.\n");
-        free(keys);
-        return NULL;
+}
+void OCDictionaryCursorInit(OCDictionaryCursor *cursor, OCDictionaryRef theDictionary) {
+    if (!cursor)
+        return;
+    cursor->dictionary = theDictionary;
+    cursor->position = 0;
+}
+bool OCDictionaryCursorNext(OCDictionaryCursor *cursor, OCStringRef *outKey, const void **outValue) {
+    if (!cursor || !cursor->dictionary)
+        return false;
+    OCDictionaryRef dict = cursor->dictionary;
+    OCTypeRef k;
+    OCTypeRef v;
+    while (cursor->position < dict->used) {
+        if (!impl_OCDictionaryEntryAt(dict, cursor->position++, &k, &v))
+            continue;  // removed
+        if (outKey) *outKey = (OCStringRef)k;
+        if (outValue) *outValue = v;
+        return true;
     }
-    OCDictionaryGetKeysAndValues(theDictionary, (const void **)keys, (const void **)values);
-    OCArrayRef array = OCArrayCreate((const void **)keys, count, &kOCTypeArrayCallBacks);
-    free(values);
-    free(keys);
-    return array;
+    return false;
 }
-OCArrayRef OCDictionaryCreateArrayWithAllValues(OCDictionaryRef theDictionary) {
+// ——— Gather keys or values into a new immutable array ———
+static OCArrayRef impl_OCDictionaryCreateArray(OCDictionaryRef theDictionary, bool wantKeys) {
     if (theDictionary == NULL)
         return NULL;
     uint64_t count = OCDictionaryGetCount(theDictionary);
-    const void **keys = calloc(count, sizeof(void *));
-    if (NULL == keys) {
-        fprintf(stderr, "OCDictionaryCreateArrayWithAllValues: Memory allocation for keys failed.\n");
+    const void **items = calloc(count ? count : 1, sizeof(const void *));
+    if (NULL == items) {
+        fprintf(stderr, "OCDictionaryCreateArray: Memory allocation for %s failed.\n", wantKeys ? "keys" : "values");
         return NULL;
     }
-    const void **values = calloc(count, sizeof(void *));
-    if (NULL == values) {
-        fprintf(stderr, "OCDictionaryCreateArrayWithAllValues: Memory allocation for values failed.\n");
-        free(keys);
-        return NULL;
-    }
-    OCDictionaryGetKeysAndValues(theDictionary, (const void **)keys, (const void **)values);
-    OCArrayRef array = OCArrayCreate((const void **)values, count, &kOCTypeArrayCallBacks);
-    free(values);
-    free(keys);
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    uint64_t n = 0;
+    OCDictionaryCursorInit(&cursor, theDictionary);
+    while (OCDictionaryCursorNext(&cursor, &key, &value))
+        items[n++] = wantKeys ? (const void *)key : value;
+    OCArrayRef array = OCArrayCreate(items, n, &kOCTypeArrayCallBacks);
+    free(items);
     return array;
 }
+OCArrayRef OCDictionaryCreateArrayWithAllKeys(OCDictionaryRef theDictionary) {
+    return impl_OCDictionaryCreateArray(theDictionary, true);
+}
+OCArrayRef OCDictionaryCreateArrayWithAllValues(OCDictionaryRef theDictionary) {
+    return impl_OCDictionaryCreateArray(theDictionary, false);
+}
 cJSON *OCDictionaryCopyAsJSON(OCDictionaryRef dict, bool typed, OCStringRef *outError) {
     if (outError) *outError = NULL;
     if (!dict) return cJSON_CreateNull();
     cJSON *root = cJSON_CreateObject();
-    OCArrayRef keys = OCDictionaryCreateArrayWithAllKeys(dict);
-    uint64_t n = OCArrayGetCount(keys);
-    for (uint64_t i = 0; i < n; i++) {
-        OCStringRef key = OCArrayGetValueAtIndex(keys, i);
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    OCDictionaryCursorInit(&cursor, dict);
+    while (OCDictionaryCursorNext(&cursor, &key, &value)) {
+        if (OCGetTypeID(key) != OCStringGetTypeID()) {
+            // JSON object member names are strings
+            if (outError) *outError = STR("OCDictionary with non-string keys cannot be serialized to JSON");
+            cJSON_Delete(root);
+            return cJSON_CreateNull();
+        }
         const char *k = OCStringGetCString(key);
-        OCTypeRef v = (OCTypeRef)OCDictionaryGetValue(dict, key);
+        OCTypeRef v = (OCTypeRef)value;
         // Use typed or untyped serialization based on parameter
         OCStringRef valueError = NULL;
         cJSON *child = OCTypeCopyJSON(v, typed, &valueError);
@@ -393,17 +1103,52 @@ cJSON *OCDictionaryCopyAsJSON(OCDictionaryRef dict, bool typed, OCStringRef *out
             } else if (valueError) {
                 // outError already set or not provided, clean up valueError
             }
-            OCRelease(keys);
             cJSON_Delete(root);
             return cJSON_CreateNull();
         }
         cJSON_AddItemToObject(root, k, child);
     }
-    OCRelease(keys);
     // Objects are native JSON types, no wrapping needed even for typed serialization
     return root;
 }
-OCDictionaryRef OCDictionaryCreateFromJSONTyped(cJSON *json, OCStringRef *outError) {
+// Prepares an empty dictionary for the members of a JSON object. When the
+// member names run along keySource's shared key table the table is reused;
+// otherwise the object gets a fresh table that the next record can share.
+// Objects with repeated member names use the combined layout.
+static OCMutableDictionaryRef impl_OCDictionaryCreateForJSONObject(cJSON *json, OCDictionaryRef keySource) {
+    int size = cJSON_GetArraySize(json);
+    if (size <= 0)
+        return OCDictionaryCreateMutable(0);
+    cJSON *item = NULL;
+    impl_OCDictionaryKeyTable *table = keySource ? keySource->sharedKeys : NULL;
+    if (table && (uint64_t)size <= table->count) {
+        uint64_t i = 0;
+        cJSON_ArrayForEach(item, json) {
+            OCTypeRef key = table->entries[i].key;
+            if (!item->string || OCGetTypeID(key) != OCStringGetTypeID() ||
+                strcmp(item->string, OCStringGetCString((OCStringRef)key)) != 0)
+                break;
+            i++;
+        }
+        if (i == (uint64_t)size)
+            return impl_OCDictionaryCreateSplit(table);
+    }
+    table = impl_OCDictionaryKeyTableCreate((uint64_t)size);
+    if (!table)
+        return OCDictionaryCreateMutable((uint64_t)size);
+    cJSON_ArrayForEach(item, json) {
+        OCStringRef key = item->string ? OCStringCreateWithCString(item->string) : NULL;
+        if (!key || !impl_OCDictionaryKeyTableAdd(table, (OCTypeRef)key)) {
+            OCRelease(key);
+            impl_OCDictionaryKeyTableRelease(table);
+            return OCDictionaryCreateMutable((uint64_t)size);
+        }
+    }
+    struct impl_OCDictionary *dict = impl_OCDictionaryCreateSplit(table);
+    impl_OCDictionaryKeyTableRelease(table);
+    return dict;
+}
+static OCDictionaryRef impl_OCDictionaryCreateFromJSONTyped(cJSON *json, OCDictionaryRef keySource, OCStringRef *outError) {
     if (!json) {
         if (outError) *outError = STR("JSON input is NULL");
         return NULL;
@@ -414,7 +1159,7 @@ OCDictionaryRef OCDictionaryCreateFromJSONTyped(cJSON *json, OCStringRef *outErr
     }
     // For typed serialization, dictionaries are stored as native JSON objects
     // with typed serialization of their values
-    OCMutableDictionaryRef result = OCDictionaryCreateMutable(0);
+    OCMutableDictionaryRef result = impl_OCDictionaryCreateForJSONObject(json, keySource);
     if (!result) {
         if (outError) *outError = STR("Failed to create mutable dictionary");
         return NULL;
@@ -446,7 +1191,7 @@ OCDictionaryRef OCDictionaryCreateFromJSONTyped(cJSON *json, OCStringRef *outErr
     }
     return result;
 }
-OCDictionaryRef OCDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError) {
+static OCDictionaryRef impl_OCDictionaryCreateFromJSON(cJSON *json, OCDictionaryRef keySource, OCStringRef *outError) {
     if (outError) *outError = NULL;
     if (!json) {
         if (outError) *outError = STR("JSON is NULL");
@@ -462,7 +1207,7 @@ OCDictionaryRef OCDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError) {
     // - JSON booleans → OCBoolean
     // - JSON arrays → OCArray (recursive)
     // - JSON objects → OCDictionary (recursive)
-    OCMutableDictionaryRef result = OCDictionaryCreateMutable(0);
+    OCMutableDictionaryRef result = impl_OCDictionaryCreateForJSONObject(json, keySource);
     if (!result) {
         if (outError) *outError = STR("Failed to create mutable dictionary");
         return NULL;
@@ -533,3 +1278,13 @@ OCDictionaryRef OCDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError) {
     }
     return result;
 }
+OCDictionaryRef OCDictionaryCreateFromJSONTyped(cJSON *json, OCStringRef *outError) {
+    return impl_OCDictionaryCreateFromJSONTyped(json, NULL, outError);
+}
+OCDictionaryRef OCDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError) {
+    return impl_OCDictionaryCreateFromJSON(json, NULL, outError);
+}
+OCDictionaryRef OCDictionaryCreateFromJSONWithSharedKeys(cJSON *json, bool typed, OCDictionaryRef keySource, OCStringRef *outError) {
+    return typed ? impl_OCDictionaryCreateFromJSONTyped(json, keySource, outError)
+                 : impl_OCDictionaryCreateFromJSON(json, keySource, outError);
+}
@@ -4,6 +4,16 @@
  *
  * This header defines the OCDictionaryRef and OCMutableDictionaryRef types
  * and associated APIs for managing collections of uniquely keyed values.
+ * Dictionaries are hash tables that remember insertion order: iteration,
+ * descriptions and JSON output list entries in the order their keys were
+ * first added.
+ *
+ * Keys are usually OCStrings but may be any OCType that OCTypeHash() hashes
+ * by content, such as OCNumber, OCData or OCIndexSet; keys compare with
+ * OCTypeEqual(). Keys are copied or retained on insertion, so later changes
+ * to a mutable key object do not affect the dictionary. Only dictionaries
+ * with string keys can be serialized to JSON. For integer keys see also
+ * OCIndexDictionary.
  *
  * @note Ownership follows CoreFoundation conventions:
  *       The caller owns any OCDictionaryRef or OCMutableDictionaryRef returned
@@ -30,7 +40,12 @@ extern "C" {
  */
 OCTypeID OCDictionaryGetTypeID(void);
 /**
- * @brief Creates a new dictionary with initial capacity.
+ * @brief Creates an immutable dictionary from parallel key and value arrays.
+ *
+ * The result is frozen: it is packed to its exact size and looked up through
+ * a minimal perfect hash, and it is never modified afterwards, so it can be
+ * read from several threads without locking. Mutating functions reject it.
+ * If a key repeats, the last value wins.
  *
  * @param keys Array of keys.
  * @param values Array of values.
@@ -47,9 +62,37 @@ OCDictionaryRef OCDictionaryCreate(const void **keys, const void **values, uint6
  * @ingroup OCDictionary
  */
 OCMutableDictionaryRef OCDictionaryCreateMutable(uint64_t capacity);
+/**
+ * @brief Creates an empty mutable dictionary that shares another dictionary's keys.
+ *
+ * Intended for many records with the same key set. The new dictionary stores
+ * only a values array and refers to an immutable key table shared with every
+ * other dictionary created from the same source. Values added under the
+ * source's keys, in the source's order, stay in this compact layout; adding
+ * any other key, adding keys out of order, or removing a key other than the
+ * last converts the dictionary to the ordinary layout automatically.
+ *
+ * @param keySource Dictionary whose keys define the shape (NULL or empty
+ *                  gives an ordinary empty dictionary). Its own layout is
+ *                  not changed.
+ * @return New OCMutableDictionaryRef or NULL on failure.
+ * @ingroup OCDictionary
+ *
+ * @code
+ * OCMutableDictionaryRef row = OCDictionaryCreateMutableWithSharedKeys(header);
+ * OCDictionaryAddValue(row, STR("name"), name);  // same order as header
+ * OCDictionaryAddValue(row, STR("age"), age);
+ * @endcode
+ */
+OCMutableDictionaryRef OCDictionaryCreateMutableWithSharedKeys(OCDictionaryRef keySource);
 /**
  * @brief Creates an immutable copy of a dictionary.
  *
+ * Copying a frozen dictionary, or an earlier copy, simply retains it. A
+ * mutable dictionary shares its storage with the copy until it next changes;
+ * the copy is read-only and thread-safe to read but, unlike one made with
+ * OCDictionaryCreate(), uses the ordinary hash index.
+ *
  * @param theDictionary Dictionary to copy.
  * @return New OCDictionaryRef, or NULL on failure.
  * @ingroup OCDictionary
@@ -58,6 +101,8 @@ OCDictionaryRef OCDictionaryCreateCopy(OCDictionaryRef theDictionary);
 /**
  * @brief Creates a mutable copy of a dictionary.
  *
+ * The copy reads the source's storage until either of them first changes.
+ *
  * @param theDictionary Dictionary to copy.
  * @return New OCMutableDictionaryRef, or NULL on failure.
  * @ingroup OCDictionary
@@ -79,7 +124,7 @@ uint64_t OCDictionaryGetCount(OCDictionaryRef theDictionary);
  * @return Pointer to value, or NULL if not found.
  * @ingroup OCDictionary
  */
-const void *OCDictionaryGetValue(OCDictionaryRef theDictionary, OCStringRef key);
+const void *OCDictionaryGetValue(OCDictionaryRef theDictionary, const void *key);
 /**
  * @brief Checks if the dictionary contains the specified key.
  *
@@ -88,7 +133,7 @@ const void *OCDictionaryGetValue(OCDictionaryRef theDictionary, OCStringRef key)
  * @return true if key is found, false otherwise.
  * @ingroup OCDictionary
  */
-bool OCDictionaryContainsKey(OCDictionaryRef theDictionary, OCStringRef key);
+bool OCDictionaryContainsKey(OCDictionaryRef theDictionary, const void *key);
 /**
  * @brief Checks if the dictionary contains the specified value.
  *
@@ -107,7 +152,7 @@ bool OCDictionaryContainsValue(OCDictionaryRef theDictionary, const void *value)
  * @return true on success, false on failure.
  * @ingroup OCDictionary
  */
-bool OCDictionaryAddValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value);
+bool OCDictionaryAddValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value);
 /**
  * @brief Sets the value for a key.
  *
@@ -120,7 +165,7 @@ bool OCDictionaryAddValue(OCMutableDictionaryRef theDictionary, OCStringRef key,
  * @return true on success (inserted or updated), false on failure.
  * @ingroup OCDictionary
  */
-bool OCDictionarySetValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value);
+bool OCDictionarySetValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value);
 /**
  * @brief OCDictionaryReplaceValue replaces the value for an existing key.
  *
@@ -132,16 +177,18 @@ bool OCDictionarySetValue(OCMutableDictionaryRef theDictionary, OCStringRef key,
  * @return true if the key existed and was replaced, false otherwise.
  * @ingroup OCDictionary
  */
-bool OCDictionaryReplaceValue(OCMutableDictionaryRef theDictionary, OCStringRef key, const void *value);
+bool OCDictionaryReplaceValue(OCMutableDictionaryRef theDictionary, const void *key, const void *value);
 /**
  * @brief Removes a key-value pair from the dictionary.
  *
+ * Runs in amortized constant time; the remaining entries keep their order.
+ *
  * @param theDictionary Dictionary to modify.
  * @param key Key to remove.
  * @return true if the key was found and removed, false if not found.
  * @ingroup OCDictionary
  */
-bool OCDictionaryRemoveValue(OCMutableDictionaryRef theDictionary, OCStringRef key);
+bool OCDictionaryRemoveValue(OCMutableDictionaryRef theDictionary, const void *key);
 /**
  * @brief Counts how many times a value appears in the dictionary.
  *
@@ -161,6 +208,79 @@ uint64_t OCDictionaryGetCountOfValue(OCMutableDictionaryRef theDictionary, const
  * @ingroup OCDictionary
  */
 bool OCDictionaryGetKeysAndValues(OCDictionaryRef theDictionary, const void **keys, const void **values);
+/**
+ * @brief Callback invoked by OCDictionaryApplyFunction() for each entry.
+ *
+ * @param key The entry's key (borrowed; not retained). Typed as OCStringRef
+ *            for the common case; dictionaries with other key types pass
+ *            those objects here.
+ * @param value The entry's value (borrowed; not retained).
+ * @param context The context pointer passed to OCDictionaryApplyFunction().
+ * @ingroup OCDictionary
+ */
+typedef void (*OCDictionaryApplierFunction)(OCStringRef key, const void *value, void *context);
+/**
+ * @brief Calls a function once for each key-value pair, without allocating.
+ *
+ * Entries are visited in insertion order. The dictionary must
+ * not be mutated from inside @p applier.
+ *
+ * @param theDictionary Dictionary to walk.
+ * @param applier Function called for each entry.
+ * @param context Opaque pointer passed through to @p applier.
+ * @ingroup OCDictionary
+ *
+ * @code
+ * static void countLongKeys(OCStringRef key, const void *value, void *context) {
+ *     if (OCStringGetLength(key) > 8) ++*(int *)context;
+ * }
+ * int n = 0;
+ * OCDictionaryApplyFunction(dict, countLongKeys, &n);
+ * @endcode
+ */
+void OCDictionaryApplyFunction(OCDictionaryRef theDictionary, OCDictionaryApplierFunction applier, void *context);
+/**
+ * @brief Position within a dictionary walk; declare it on the stack.
+ *
+ * The fields are private. Initialize with OCDictionaryCursorInit() and advance
+ * with OCDictionaryCursorNext(). A cursor does not retain its dictionary, and
+ * the dictionary must not be mutated while a cursor is in use.
+ * @ingroup OCDictionary
+ */
+typedef struct OCDictionaryCursor {
+    OCDictionaryRef dictionary;
+    uint64_t position;
+} OCDictionaryCursor;
+/**
+ * @brief Positions a cursor before the first entry of a dictionary.
+ *
+ * @param cursor Cursor to initialize.
+ * @param theDictionary Dictionary to walk (may be NULL, yielding no entries).
+ * @ingroup OCDictionary
+ */
+void OCDictionaryCursorInit(OCDictionaryCursor *cursor, OCDictionaryRef theDictionary);
+/**
+ * @brief Advances a cursor and returns the next entry in insertion order.
+ *
+ * @param cursor Cursor initialized with OCDictionaryCursorInit().
+ * @param outKey Optional; receives the key (borrowed). As with
+ *               OCDictionaryApplierFunction, a non-string key is returned
+ *               through this OCStringRef.
+ * @param outValue Optional; receives the value (borrowed).
+ * @return true if an entry was returned, false when the walk is finished.
+ * @ingroup OCDictionary
+ *
+ * @code
+ * OCDictionaryCursor cursor;
+ * OCStringRef key;
+ * const void *value;
+ * OCDictionaryCursorInit(&cursor, dict);
+ * while (OCDictionaryCursorNext(&cursor, &key, &value)) {
+ *     // use key and value
+ * }
+ * @endcode
+ */
+bool OCDictionaryCursorNext(OCDictionaryCursor *cursor, OCStringRef *outKey, const void **outValue);
 /**
  * @brief Creates an array containing all keys in the dictionary.
  *
@@ -229,5 +349,33 @@ OCDictionaryRef OCDictionaryCreateFromJSONTyped(cJSON *json, OCStringRef *outErr
  *         The caller is responsible for releasing the returned dictionary.
  */
 OCDictionaryRef OCDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError);
+/**
+ * @brief Creates an OCDictionary from a JSON object, sharing keys with a previous record.
+ *
+ * Decodes like OCDictionaryCreateFromJSONTyped() or OCDictionaryCreateFromJSON().
+ * Decoded dictionaries keep their member names in a shared key table; when
+ * the object's member names match (a prefix of) @p keySource's, in order, the
+ * result reuses that table instead of allocating its own keys. The array
+ * readers pass the previous element, so arrays of records share one table.
+ *
+ * @param json A cJSON object containing key-value pairs.
+ * @param typed true to decode values with OCTypeCreateFromJSONTyped().
+ * @param keySource Previously decoded dictionary, or NULL.
+ * @param outError Optional pointer to receive an error string on failure.
+ * @return A new OCDictionaryRef, or NULL on failure.
+ * @ingroup OCDictionary
+ */
+OCDictionaryRef OCDictionaryCreateFromJSONWithSharedKeys(cJSON *json, bool typed, OCDictionaryRef keySource, OCStringRef *outError);
+/** \cond INTERNAL */
+/**
+ * @brief Returns the immutable copy of a key that a dictionary stores; private API.
+ *
+ * Strings are copied (never as substring views), numbers and booleans are
+ * retained, and other types are deep-copied when they support it.
+ * @param key Key to copy.
+ * @return A retained key; release when done.
+ */
+OCTypeRef impl_OCDictionaryCopyKey(const void *key);
+/** \endcond */
 /** @} */
 #endif /* OCDICTIONARY_H */
@@ -21,9 +21,14 @@ struct impl_OCIndexArray {
     OCMutableDataRef indexes;
     OCJSONEncoding encoding;
 };
+static uint64_t impl_OCIndexArrayHash(const void* obj) {
+    OCIndexArrayRef a = (OCIndexArrayRef)obj;
+    return a->indexes && OCDataGetLength(a->indexes) ? OCDataHash(a->indexes) : 0;
+}
 OCTypeID OCIndexArrayGetTypeID(void) {
     if (kOCIndexArrayID == kOCNotATypeID) {
         kOCIndexArrayID = OCRegisterType("OCIndexArray", (OCTypeRef (*)(cJSON*, OCStringRef*))OCIndexArrayCreateFromJSON);
+        OCTypeSetHashFunction(kOCIndexArrayID, impl_OCIndexArrayHash);
     }
     return kOCIndexArrayID;
 }
@@ -74,7 +79,8 @@ OCIndexArrayRef OCIndexArrayCreate(OCIndex* values, OCIndex count) {
     if (count > 0 && values == NULL) return NULL;
     OCMutableIndexArrayRef array = OCIndexArrayAllocate();
     if (!array) return NULL;
-    array->indexes = (OCMutableDataRef)OCDataCreate((const uint8_t*)values, count * sizeof(OCIndex));
+    array->indexes = OCDataCreateMutable(count * sizeof(OCIndex));
+    if (array->indexes && count > 0) OCDataAppendBytes(array->indexes, (const uint8_t*)values, count * sizeof(OCIndex));
     if (!array->indexes) {
         OCRelease(array);
         return NULL;
@@ -100,7 +106,7 @@ static OCIndexArrayRef OCIndexArrayCreateWithData(OCDataRef indexes) {
     if (!indexes) return NULL;
     OCMutableIndexArrayRef array = OCIndexArrayAllocate();
     if (!array) return NULL;
-    array->indexes = (OCMutableDataRef)OCDataCreateCopy(indexes);
+    array->indexes = OCDataCreateMutableCopy(0, indexes);
     if (!array->indexes) {
         OCRelease(array);
         return NULL;
@@ -150,48 +156,29 @@ bool OCIndexArraySetValueAtIndex(OCMutableIndexArrayRef array, OCIndex index, OC
 bool OCIndexArrayRemoveValueAtIndex(OCMutableIndexArrayRef array, OCIndex index) {
     if (!array || !array->indexes) return false;
     OCIndex count = OCIndexArrayGetCount(array);
-    if (index >= count) return false;
-    OCIndex* old = (OCIndex*)OCDataGetBytesPtr(array->indexes);
-    if (!old) return false;
-    // Allocate a new buffer of capacity (count-1)*sizeof(OCIndex)
-    OCMutableDataRef data = OCDataCreateMutable((count - 1) * sizeof(OCIndex));
-    if (!data) return false;
-    // Now explicitly set its length to match capacity:
-    if (!OCDataSetLength(data, (count - 1) * sizeof(OCIndex))) {
-        OCRelease(data);
-        return false;
-    }
-    OCIndex* copy = (OCIndex*)OCDataGetMutableBytes(data);
-    if (!copy) {
-        OCRelease(data);
-        return false;
-    }
-    // Copy everything except the “index”th element
-    for (OCIndex i = 0, j = 0; i < count; i++) {
-        if (i != index) {
-            copy[j++] = old[i];
-        }
-    }
-    OCRelease(array->indexes);
-    array->indexes = data;
-    return true;
+    if (index < 0 || index >= count) return false;
+    OCIndex* ptr = (OCIndex*)OCDataGetMutableBytes(array->indexes);
+    if (!ptr) return false;
+    memmove(&ptr[index], &ptr[index + 1], (size_t)(count - index - 1) * sizeof(OCIndex));
+    return OCDataSetLength(array->indexes, (uint64_t)(count - 1) * sizeof(OCIndex));
 }
 void OCIndexArrayRemoveValuesAtIndexes(OCMutableIndexArrayRef array, OCIndexSetRef indexesToRemove) {
-    if (!array || !indexesToRemove) return;
-    OCIndex count = OCIndexSetGetCount(indexesToRemove);
-    if (count == 0) return;
-    // Copy indices to an array and sort descending
-    OCIndex* indices = (OCIndex*)malloc(count * sizeof(OCIndex));
-    if (!indices) return;
-    OCIndex idx = OCIndexSetLastIndex(indexesToRemove);
-    for (OCIndex i = 0; i < count && idx != kOCNotFound; ++i) {
-        indices[i] = idx;
-        idx = OCIndexSetIndexLessThanIndex(indexesToRemove, idx);
-    }
-    for (OCIndex i = 0; i < count; ++i) {
-        OCIndexArrayRemoveValueAtIndex(array, indices[i]);
+    if (!array || !array->indexes || !indexesToRemove) return;
+    OCIndex removeCount = OCIndexSetGetCount(indexesToRemove);
+    if (removeCount == 0) return;
+    OCIndex count = OCIndexArrayGetCount(array);
+    OCIndex* ptr = (OCIndex*)OCDataGetMutableBytes(array->indexes);
+    if (!ptr) return;
+    // Index sets are sorted, so the survivors compact in one pass
+    const OCIndex* removed = OCIndexSetGetBytesPtr(indexesToRemove);
+    OCIndex write = 0;
+    OCIndex r = 0;
+    for (OCIndex read = 0; read < count; read++) {
+        while (r < removeCount && removed[r] < read) r++;
+        if (r < removeCount && removed[r] == read) continue;
+        ptr[write++] = ptr[read];
     }
-    free(indices);
+    OCDataSetLength(array->indexes, (uint64_t)write * sizeof(OCIndex));
 }
 bool OCIndexArrayContainsIndex(OCIndexArrayRef array, OCIndex value) {
     OCIndex count = OCIndexArrayGetCount(array);
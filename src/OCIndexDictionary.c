@@ -0,0 +1,403 @@
+// OCIndexDictionary.c – OCIndex-keyed hash map built on OCTypeAlloc
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "OCTypes.h"
+static OCTypeID kOCIndexDictionaryID = kOCNotATypeID;
+// Open addressing with linear probing over parallel key and value arrays; a
+// NULL value marks an empty slot. Removal shifts the following entries of the
+// probe run back instead of leaving tombstones, so lookups never slow down as
+// entries come and go.
+#define kOCIndexDictionaryMinCapacity 8
+struct impl_OCIndexDictionary {
+    OCBase base;
+    uint64_t count;
+    uint64_t capacity;  // slots, a power of two
+    OCIndex *keys;
+    OCTypeRef *values;
+    bool isMutable;
+};
+static inline uint64_t impl_OCIndexDictionaryHash(OCIndex key) {
+    uint64_t h = (uint64_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+// Finds the slot holding key, or the empty slot where it would go
+static inline uint64_t impl_OCIndexDictionaryProbe(OCIndexDictionaryRef dict, OCIndex key, bool *outFound) {
+    uint64_t mask = dict->capacity - 1;
+    uint64_t slot = impl_OCIndexDictionaryHash(key) & mask;
+    while (dict->values[slot]) {
+        if (dict->keys[slot] == key) {
+            *outFound = true;
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    *outFound = false;
+    return slot;
+}
+static bool impl_OCIndexDictionaryResize(struct impl_OCIndexDictionary *dict, uint64_t capacity) {
+    OCIndex *keys = malloc(capacity * sizeof(OCIndex));
+    OCTypeRef *values = calloc(capacity, sizeof(OCTypeRef));
+    if (!keys || !values) {
+        fprintf(stderr, "OCIndexDictionary: Memory allocation for %llu slots failed.\n", (unsigned long long)capacity);
+        free(keys);
+        free(values);
+        return false;
+    }
+    OCIndex *oldKeys = dict->keys;
+    OCTypeRef *oldValues = dict->values;
+    uint64_t oldCapacity = dict->capacity;
+    dict->keys = keys;
+    dict->values = values;
+    dict->capacity = capacity;
+    for (uint64_t i = 0; i < oldCapacity; i++) {
+        if (!oldValues[i])
+            continue;
+        bool found;
+        uint64_t slot = impl_OCIndexDictionaryProbe(dict, oldKeys[i], &found);
+        keys[slot] = oldKeys[i];
+        values[slot] = oldValues[i];
+    }
+    free(oldKeys);
+    free(oldValues);
+    return true;
+}
+static uint64_t impl_OCIndexDictionaryCapacityFor(uint64_t count) {
+    // Keep the table at most three quarters full
+    uint64_t capacity = kOCIndexDictionaryMinCapacity;
+    while (capacity - capacity / 4 < count)
+        capacity <<= 1;
+    return capacity;
+}
+static void impl_OCIndexDictionaryFinalize(const void *theType) {
+    if (NULL == theType) {
+        fprintf(stderr, "Finalize called with NULL pointer\n");
+        return;
+    }
+    struct impl_OCIndexDictionary *dict = (struct impl_OCIndexDictionary *)theType;
+    for (uint64_t i = 0; i < dict->capacity; i++)
+        OCRelease(dict->values[i]);
+    free(dict->keys);
+    free(dict->values);
+}
+static bool impl_OCIndexDictionaryEqual(const void *theType1, const void *theType2) {
+    OCIndexDictionaryRef d1 = (OCIndexDictionaryRef)theType1;
+    OCIndexDictionaryRef d2 = (OCIndexDictionaryRef)theType2;
+    if (d1 == d2)
+        return true;
+    if (!d1 || !d2 || d1->base.typeID != d2->base.typeID || d1->count != d2->count)
+        return false;
+    for (uint64_t i = 0; i < d1->capacity; i++) {
+        if (d1->values[i] && !OCTypeEqual(d1->values[i], OCIndexDictionaryGetValue(d2, d1->keys[i])))
+            return false;
+    }
+    return true;
+}
+static OCStringRef impl_OCIndexDictionaryCopyFormattingDesc(OCTypeRef cf) {
+    if (!cf)
+        return OCStringCreateWithCString("<OCIndexDictionary: NULL>");
+    uint64_t count = ((OCIndexDictionaryRef)cf)->count;
+    return OCStringCreateWithFormat(STR("<OCIndexDictionary: %llu pair%s>"),
+                                    (unsigned long long)count, count == 1 ? "" : "s");
+}
+static cJSON *impl_OCIndexDictionaryCopyJSON(const void *obj, bool typed, OCStringRef *outError) {
+    return OCIndexDictionaryCopyAsJSON((OCIndexDictionaryRef)obj, typed, outError);
+}
+static struct impl_OCIndexDictionary *impl_OCIndexDictionaryCreate(uint64_t capacity, bool isMutable);
+static void *impl_OCIndexDictionaryDeepCopyWithMutability(const void *obj, bool isMutable) {
+    OCIndexDictionaryRef src = (OCIndexDictionaryRef)obj;
+    if (!src)
+        return NULL;
+    struct impl_OCIndexDictionary *copy = impl_OCIndexDictionaryCreate(src->count, true);
+    if (!copy)
+        return NULL;
+    for (uint64_t i = 0; i < src->capacity; i++) {
+        if (!src->values[i])
+            continue;
+        void *valueCopy = OCTypeDeepCopy(src->values[i]);
+        bool ok = valueCopy && OCIndexDictionarySetValue(copy, src->keys[i], valueCopy);
+        OCRelease(valueCopy);
+        if (!ok) {
+            OCRelease(copy);
+            return NULL;
+        }
+    }
+    copy->isMutable = isMutable;
+    return copy;
+}
+static void *impl_OCIndexDictionaryDeepCopy(const void *obj) {
+    return impl_OCIndexDictionaryDeepCopyWithMutability(obj, false);
+}
+static void *impl_OCIndexDictionaryDeepCopyMutable(const void *obj) {
+    return impl_OCIndexDictionaryDeepCopyWithMutability(obj, true);
+}
+OCTypeID OCIndexDictionaryGetTypeID(void) {
+    if (kOCIndexDictionaryID == kOCNotATypeID) {
+        kOCIndexDictionaryID = OCRegisterType("OCIndexDictionary", (OCTypeRef (*)(cJSON *, OCStringRef *))OCIndexDictionaryCreateFromJSON);
+    }
+    return kOCIndexDictionaryID;
+}
+static struct impl_OCIndexDictionary *impl_OCIndexDictionaryCreate(uint64_t capacity, bool isMutable) {
+    struct impl_OCIndexDictionary *dict = OCTypeAlloc(
+        struct impl_OCIndexDictionary,
+        OCIndexDictionaryGetTypeID(),
+        impl_OCIndexDictionaryFinalize,
+        impl_OCIndexDictionaryEqual,
+        impl_OCIndexDictionaryCopyFormattingDesc,
+        impl_OCIndexDictionaryCopyJSON,
+        impl_OCIndexDictionaryDeepCopy,
+        impl_OCIndexDictionaryDeepCopyMutable);
+    if (!dict)
+        return NULL;
+    dict->isMutable = isMutable;
+    if (!impl_OCIndexDictionaryResize(dict, impl_OCIndexDictionaryCapacityFor(capacity))) {
+        OCRelease(dict);
+        return NULL;
+    }
+    return dict;
+}
+OCMutableIndexDictionaryRef OCIndexDictionaryCreateMutable(uint64_t capacity) {
+    return impl_OCIndexDictionaryCreate(capacity, true);
+}
+static struct impl_OCIndexDictionary *impl_OCIndexDictionaryCreateCopy(OCIndexDictionaryRef src, bool isMutable) {
+    if (!src)
+        return NULL;
+    struct impl_OCIndexDictionary *copy = impl_OCIndexDictionaryCreate(src->count, isMutable);
+    if (!copy)
+        return NULL;
+    if (copy->capacity == src->capacity) {
+        // Same table size, so every entry keeps its slot
+        memcpy(copy->keys, src->keys, src->capacity * sizeof(OCIndex));
+        for (uint64_t i = 0; i < src->capacity; i++)
+            copy->values[i] = src->values[i] ? OCRetain(src->values[i]) : NULL;
+    } else {
+        for (uint64_t i = 0; i < src->capacity; i++) {
+            if (!src->values[i])
+                continue;
+            bool found;
+            uint64_t slot = impl_OCIndexDictionaryProbe(copy, src->keys[i], &found);
+            copy->keys[slot] = src->keys[i];
+            copy->values[slot] = OCRetain(src->values[i]);
+        }
+    }
+    copy->count = src->count;
+    return copy;
+}
+OCIndexDictionaryRef OCIndexDictionaryCreateCopy(OCIndexDictionaryRef theDictionary) {
+    return impl_OCIndexDictionaryCreateCopy(theDictionary, false);
+}
+OCMutableIndexDictionaryRef OCIndexDictionaryCreateMutableCopy(OCIndexDictionaryRef theDictionary) {
+    return impl_OCIndexDictionaryCreateCopy(theDictionary, true);
+}
+uint64_t OCIndexDictionaryGetCount(OCIndexDictionaryRef theDictionary) {
+    return theDictionary ? theDictionary->count : 0;
+}
+const void *OCIndexDictionaryGetValue(OCIndexDictionaryRef theDictionary, OCIndex key) {
+    if (!theDictionary)
+        return NULL;
+    bool found;
+    uint64_t slot = impl_OCIndexDictionaryProbe(theDictionary, key, &found);
+    return found ? theDictionary->values[slot] : NULL;
+}
+bool OCIndexDictionaryContainsKey(OCIndexDictionaryRef theDictionary, OCIndex key) {
+    return OCIndexDictionaryGetValue(theDictionary, key) != NULL;
+}
+bool OCIndexDictionarySetValue(OCMutableIndexDictionaryRef theDictionary, OCIndex key, const void *value) {
+    if (!theDictionary || !value)
+        return false;
+    if (!theDictionary->isMutable) {
+        fprintf(stderr, "OCIndexDictionarySetValue: Dictionary is immutable.\n");
+        return false;
+    }
+    bool found;
+    uint64_t slot = impl_OCIndexDictionaryProbe(theDictionary, key, &found);
+    if (found) {
+        OCTypeRef old = theDictionary->values[slot];
+        theDictionary->values[slot] = OCRetain(value);
+        OCRelease(old);
+        return true;
+    }
+    if (theDictionary->count + 1 > theDictionary->capacity - theDictionary->capacity / 4) {
+        if (!impl_OCIndexDictionaryResize(theDictionary, theDictionary->capacity * 2))
+            return false;
+        slot = impl_OCIndexDictionaryProbe(theDictionary, key, &found);
+    }
+    theDictionary->keys[slot] = key;
+    theDictionary->values[slot] = OCRetain(value);
+    theDictionary->count++;
+    return true;
+}
+bool OCIndexDictionaryRemoveValue(OCMutableIndexDictionaryRef theDictionary, OCIndex key) {
+    if (!theDictionary)
+        return false;
+    if (!theDictionary->isMutable) {
+        fprintf(stderr, "OCIndexDictionaryRemoveValue: Dictionary is immutable.\n");
+        return false;
+    }
+    bool found;
+    uint64_t hole = impl_OCIndexDictionaryProbe(theDictionary, key, &found);
+    if (!found)
+        return false;
+    OCTypeRef old = theDictionary->values[hole];
+    theDictionary->values[hole] = NULL;
+    theDictionary->count--;
+    // Pull later entries of the run back into the hole when the hole lies
+    // between their home slot and where they sit
+    uint64_t mask = theDictionary->capacity - 1;
+    for (uint64_t next = (hole + 1) & mask; theDictionary->values[next]; next = (next + 1) & mask) {
+        uint64_t home = impl_OCIndexDictionaryHash(theDictionary->keys[next]) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            theDictionary->keys[hole] = theDictionary->keys[next];
+            theDictionary->values[hole] = theDictionary->values[next];
+            theDictionary->values[next] = NULL;
+            hole = next;
+        }
+    }
+    OCRelease(old);
+    return true;
+}
+void OCIndexDictionaryApplyFunction(OCIndexDictionaryRef theDictionary, OCIndexDictionaryApplierFunction applier, void *context) {
+    if (!theDictionary || !applier)
+        return;
+    for (uint64_t i = 0; i < theDictionary->capacity; i++) {
+        if (theDictionary->values[i])
+            applier(theDictionary->keys[i], theDictionary->values[i], context);
+    }
+}
+static int impl_OCIndexCompare(const void *a, const void *b) {
+    OCIndex x = *(const OCIndex *)a, y = *(const OCIndex *)b;
+    return (x > y) - (x < y);
+}
+// Keys in ascending order; the caller frees the result
+static OCIndex *impl_OCIndexDictionaryCopySortedKeys(OCIndexDictionaryRef dict) {
+    OCIndex *keys = malloc((dict->count ? dict->count : 1) * sizeof(OCIndex));
+    if (!keys) {
+        fprintf(stderr, "OCIndexDictionary: Memory allocation for keys failed.\n");
+        return NULL;
+    }
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < dict->capacity; i++) {
+        if (dict->values[i])
+            keys[n++] = dict->keys[i];
+    }
+    qsort(keys, n, sizeof(OCIndex), impl_OCIndexCompare);
+    return keys;
+}
+OCIndexArrayRef OCIndexDictionaryCreateIndexArrayWithAllKeys(OCIndexDictionaryRef theDictionary) {
+    if (!theDictionary)
+        return NULL;
+    OCIndex *keys = impl_OCIndexDictionaryCopySortedKeys(theDictionary);
+    if (!keys)
+        return NULL;
+    OCIndexArrayRef array = OCIndexArrayCreate(keys, (OCIndex)theDictionary->count);
+    free(keys);
+    return array;
+}
+cJSON *OCIndexDictionaryCopyAsJSON(OCIndexDictionaryRef theDictionary, bool typed, OCStringRef *outError) {
+    if (outError) *outError = NULL;
+    if (!theDictionary) {
+        if (outError) *outError = STR("OCIndexDictionary is NULL");
+        return cJSON_CreateNull();
+    }
+    OCIndex *keys = impl_OCIndexDictionaryCopySortedKeys(theDictionary);
+    cJSON *object = cJSON_CreateObject();
+    if (!keys || !object) {
+        if (outError) *outError = STR("Failed to create JSON object");
+        free(keys);
+        cJSON_Delete(object);
+        return cJSON_CreateNull();
+    }
+    for (uint64_t i = 0; i < theDictionary->count; i++) {
+        char name[24];
+        snprintf(name, sizeof name, "%lld", (long long)keys[i]);
+        cJSON *child = OCTypeCopyJSON(OCIndexDictionaryGetValue(theDictionary, keys[i]), typed, outError);
+        if (!child) {
+            if (outError && !*outError) *outError = STR("Failed to serialize OCIndexDictionary value");
+            free(keys);
+            cJSON_Delete(object);
+            return cJSON_CreateNull();
+        }
+        cJSON_AddItemToObject(object, name, child);
+    }
+    free(keys);
+    if (!typed)
+        return object;
+    cJSON *entry = cJSON_CreateObject();
+    cJSON_AddStringToObject(entry, "type", "OCIndexDictionary");
+    cJSON_AddItemToObject(entry, "value", object);
+    return entry;
+}
+OCIndexDictionaryRef OCIndexDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError) {
+    if (outError) *outError = NULL;
+    if (!cJSON_IsObject(json)) {
+        if (outError) *outError = STR("OCIndexDictionary JSON must be an object");
+        return NULL;
+    }
+    bool typed = false;
+    cJSON *type = cJSON_GetObjectItem(json, "type");
+    if (cJSON_IsString(type) && strcmp(cJSON_GetStringValue(type), "OCIndexDictionary") == 0) {
+        json = cJSON_GetObjectItem(json, "value");
+        typed = true;
+        if (!cJSON_IsObject(json)) {
+            if (outError) *outError = STR("Invalid typed JSON format: missing or invalid value field");
+            return NULL;
+        }
+    }
+    // Untyped values decode exactly as OCDictionary members do
+    OCDictionaryRef members = typed ? NULL : OCDictionaryCreateFromJSON(json, outError);
+    if (!typed && !members)
+        return NULL;
+    struct impl_OCIndexDictionary *dict = impl_OCIndexDictionaryCreate((uint64_t)cJSON_GetArraySize(json), true);
+    if (!dict) {
+        if (outError) *outError = STR("Failed to create OCIndexDictionary");
+        OCRelease(members);
+        return NULL;
+    }
+    bool ok = true;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, json) {
+        char *end = NULL;
+        errno = 0;
+        long long key = item->string ? strtoll(item->string, &end, 10) : 0;
+        if (!item->string || end == item->string || *end != '\0') {
+            if (outError) *outError = STR("OCIndexDictionary JSON member name is not an integer");
+            ok = false;
+            break;
+        }
+        // OCIndex is a long, which is 32 bits wide on LLP64 platforms
+        if (errno == ERANGE || key < LONG_MIN || key > LONG_MAX) {
+            if (outError) *outError = STR("OCIndexDictionary JSON member name is out of range");
+            ok = false;
+            break;
+        }
+        OCTypeRef value;
+        if (typed) {
+            value = OCTypeCreateFromJSONTyped(item, outError);
+        } else {
+            OCStringRef name = OCStringCreateWithCString(item->string);
+            value = OCDictionaryGetValue(members, name);
+            OCRelease(name);
+            if (value) OCRetain(value);
+        }
+        ok = value && OCIndexDictionarySetValue(dict, (OCIndex)key, value);
+        OCRelease(value);
+        if (!ok) {
+            if (outError && !*outError) *outError = STR("Failed to decode OCIndexDictionary value");
+            break;
+        }
+    }
+    OCRelease(members);
+    if (!ok) {
+        OCRelease(dict);
+        return NULL;
+    }
+    dict->isMutable = false;
+    return dict;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file OCIndexDictionary.h
+ * @brief Declares OCIndexDictionary and OCMutableIndexDictionary interfaces.
+ *
+ * OCIndexDictionary maps OCIndex keys to OCType values. Keys are stored
+ * inline in an open-addressed hash table, so lookups by numeric ID need no
+ * key objects at all, unlike an OCDictionary keyed by formatted strings or
+ * OCNumbers.
+ *
+ * @note Ownership follows CoreFoundation conventions:
+ *       The caller owns any object returned by functions with "Create" or
+ *       "Copy" in the name, and must call OCRelease().
+ */
+#ifndef OCINDEXDICTIONARY_H
+#define OCINDEXDICTIONARY_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "OCType.h"
+#include "cJSON.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @defgroup OCIndexDictionary OCIndexDictionary
+ * @brief APIs for maps from OCIndex keys to OCType values.
+ *
+ * Values are retained while stored. Iteration visits entries in no
+ * particular order.
+ * @{
+ */
+/**
+ * @brief Returns the OCTypeID for OCIndexDictionary objects.
+ * @return Type identifier for OCIndexDictionary.
+ * @ingroup OCIndexDictionary
+ */
+OCTypeID OCIndexDictionaryGetTypeID(void);
+/**
+ * @brief Creates an empty mutable index dictionary.
+ *
+ * @param capacity Expected number of entries (0 for a small default).
+ * @return New OCMutableIndexDictionaryRef or NULL on failure.
+ * @ingroup OCIndexDictionary
+ */
+OCMutableIndexDictionaryRef OCIndexDictionaryCreateMutable(uint64_t capacity);
+/**
+ * @brief Creates an immutable copy of an index dictionary.
+ *
+ * @param theDictionary Source dictionary.
+ * @return New OCIndexDictionaryRef, or NULL if the source is NULL or on error.
+ * @ingroup OCIndexDictionary
+ */
+OCIndexDictionaryRef OCIndexDictionaryCreateCopy(OCIndexDictionaryRef theDictionary);
+/**
+ * @brief Creates a mutable copy of an index dictionary.
+ *
+ * @param theDictionary Source dictionary.
+ * @return New OCMutableIndexDictionaryRef, or NULL if the source is NULL or on error.
+ * @ingroup OCIndexDictionary
+ */
+OCMutableIndexDictionaryRef OCIndexDictionaryCreateMutableCopy(OCIndexDictionaryRef theDictionary);
+/**
+ * @brief Gets the number of key-value pairs.
+ *
+ * @param theDictionary Dictionary to query.
+ * @return Count of entries.
+ * @ingroup OCIndexDictionary
+ */
+uint64_t OCIndexDictionaryGetCount(OCIndexDictionaryRef theDictionary);
+/**
+ * @brief Retrieves the value for a key.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to look up.
+ * @return Pointer to value (borrowed), or NULL if not found.
+ * @ingroup OCIndexDictionary
+ */
+const void *OCIndexDictionaryGetValue(OCIndexDictionaryRef theDictionary, OCIndex key);
+/**
+ * @brief Checks whether a key is present.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to test.
+ * @return true if the key is found, false otherwise.
+ * @ingroup OCIndexDictionary
+ */
+bool OCIndexDictionaryContainsKey(OCIndexDictionaryRef theDictionary, OCIndex key);
+/**
+ * @brief Adds or replaces the value for a key.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to set.
+ * @param value Value to store (retained).
+ * @return true on success, false on failure.
+ * @ingroup OCIndexDictionary
+ *
+ * @code
+ * OCMutableIndexDictionaryRef byID = OCIndexDictionaryCreateMutable(0);
+ * OCIndexDictionarySetValue(byID, 1042, record);
+ * OCTypeRef found = OCIndexDictionaryGetValue(byID, 1042);
+ * @endcode
+ */
+bool OCIndexDictionarySetValue(OCMutableIndexDictionaryRef theDictionary, OCIndex key, const void *value);
+/**
+ * @brief Removes a key and its value.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to remove.
+ * @return true if the key was found and removed, false otherwise.
+ * @ingroup OCIndexDictionary
+ */
+bool OCIndexDictionaryRemoveValue(OCMutableIndexDictionaryRef theDictionary, OCIndex key);
+/**
+ * @brief Callback invoked by OCIndexDictionaryApplyFunction() for each entry.
+ *
+ * @param key The entry's key.
+ * @param value The entry's value (borrowed; not retained).
+ * @param context The context pointer passed to OCIndexDictionaryApplyFunction().
+ * @ingroup OCIndexDictionary
+ */
+typedef void (*OCIndexDictionaryApplierFunction)(OCIndex key, const void *value, void *context);
+/**
+ * @brief Calls a function once for each key-value pair.
+ *
+ * The dictionary must not be mutated from inside @p applier.
+ *
+ * @param theDictionary Dictionary to walk.
+ * @param applier Function called for each entry.
+ * @param context Opaque pointer passed through to @p applier.
+ * @ingroup OCIndexDictionary
+ */
+void OCIndexDictionaryApplyFunction(OCIndexDictionaryRef theDictionary, OCIndexDictionaryApplierFunction applier, void *context);
+/**
+ * @brief Creates an OCIndexArray with all keys, in ascending order.
+ *
+ * @param theDictionary Dictionary to query.
+ * @return New OCIndexArrayRef, or NULL on failure.
+ * @ingroup OCIndexDictionary
+ */
+OCIndexArrayRef OCIndexDictionaryCreateIndexArrayWithAllKeys(OCIndexDictionaryRef theDictionary);
+/**
+ * @brief Creates an OCIndexDictionary from JSON.
+ *
+ * Accepts a JSON object whose member names are decimal integers, either bare
+ * (values decoded as untyped JSON) or wrapped as
+ * {"type": "OCIndexDictionary", "value": {...}} with typed values.
+ *
+ * @param json JSON object to decode.
+ * @param outError Optional; receives an error description on failure.
+ * @return New OCIndexDictionaryRef, or NULL on failure.
+ * @ingroup OCIndexDictionary
+ */
+OCIndexDictionaryRef OCIndexDictionaryCreateFromJSON(cJSON *json, OCStringRef *outError);
+/**
+ * @brief Creates a JSON representation of an OCIndexDictionary.
+ *
+ * Keys become decimal member names, written in ascending order. With
+ * typed=true the object is wrapped as {"type": "OCIndexDictionary",
+ * "value": {...}} and values are serialized typed.
+ *
+ * @param theDictionary Dictionary to serialize.
+ * @param typed Whether to include type information.
+ * @param outError Optional; receives an error description on failure.
+ * @return A new cJSON object, or cJSON null on failure.
+ * @ingroup OCIndexDictionary
+ */
+cJSON *OCIndexDictionaryCopyAsJSON(OCIndexDictionaryRef theDictionary, bool typed, OCStringRef *outError);
+/** @} */
+#ifdef __cplusplus
+}
+#endif
+#endif /* OCINDEXDICTIONARY_H */
@@ -14,9 +14,13 @@ struct impl_OCIndexPairSet {
     OCDataRef indexPairs;
     OCJSONEncoding encoding;
 };
+static uint64_t impl_OCIndexPairSetHash(const void *obj) {
+    return OCDataHash(((OCIndexPairSetRef)obj)->indexPairs);
+}
 OCTypeID OCIndexPairSetGetTypeID(void) {
     if (kOCIndexPairSetID == kOCNotATypeID) {
         kOCIndexPairSetID = OCRegisterType("OCIndexPairSet", (OCTypeRef (*)(cJSON *, OCStringRef *))OCIndexPairSetCreateFromJSON);
+        OCTypeSetHashFunction(kOCIndexPairSetID, impl_OCIndexPairSetHash);
     }
     return kOCIndexPairSetID;
 }
@@ -52,7 +52,8 @@ OCMutableIndexSetRef OCIndexSetAllocate(void);
 static void *impl_OCIndexSetDeepCopy(const void *obj) {
     OCIndexSetRef src = (OCIndexSetRef)obj;
     if (!src || !src->indexes) return NULL;
-    OCDataRef copyData = OCDataCreateCopy(src->indexes);
+    // Index sets append to their data in place, so hold a mutable copy
+    OCMutableDataRef copyData = OCDataCreateMutableCopy(0, src->indexes);
     if (!copyData) return NULL;
     OCMutableIndexSetRef copy = OCIndexSetAllocate();
     if (!copy) {
@@ -76,9 +77,15 @@ static void *impl_OCIndexSetDeepCopyMutable(const void *obj) {
     return copy;
 }
 // -- Type Registration --
+// Empty sets are equal whether or not they hold a data object
+static uint64_t impl_OCIndexSetHash(const void *obj) {
+    OCIndexSetRef s = (OCIndexSetRef)obj;
+    return s->indexes && OCDataGetLength(s->indexes) ? OCDataHash(s->indexes) : 0;
+}
 OCTypeID OCIndexSetGetTypeID(void) {
     if (kOCIndexSetID == kOCNotATypeID) {
         kOCIndexSetID = OCRegisterType("OCIndexSet", (OCTypeRef (*)(cJSON *, OCStringRef *))OCIndexSetCreateFromJSON);
+        OCTypeSetHashFunction(kOCIndexSetID, impl_OCIndexSetHash);
     }
     return kOCIndexSetID;
 }
@@ -111,7 +118,8 @@ OCMutableIndexSetRef OCIndexSetCreateMutableCopy(OCIndexSetRef src) {
 }
 OCIndexSetRef OCIndexSetCreateWithIndex(OCIndex index) {
     OCMutableIndexSetRef s = OCIndexSetAllocate();
-    s->indexes = OCDataCreate((const uint8_t *)&index, sizeof(OCIndex));
+    s->indexes = OCDataCreateMutable(sizeof(OCIndex));
+    OCDataAppendBytes((OCMutableDataRef)s->indexes, (const uint8_t *)&index, sizeof(OCIndex));
     return s;
 }
 OCIndexSetRef OCIndexSetCreateWithIndexesInRange(OCIndex location, OCIndex length) {
@@ -123,7 +131,8 @@ OCIndexSetRef OCIndexSetCreateWithIndexesInRange(OCIndex location, OCIndex lengt
         return NULL;
     }
     for (OCIndex i = 0; i < length; i++) temp[i] = location + i;
-    s->indexes = OCDataCreate((const uint8_t *)temp, length * sizeof(OCIndex));
+    s->indexes = OCDataCreateMutable(length * sizeof(OCIndex));
+    OCDataAppendBytes((OCMutableDataRef)s->indexes, (const uint8_t *)temp, length * sizeof(OCIndex));
     free(temp);
     return s;
 }
@@ -258,7 +267,7 @@ OCDataRef OCIndexSetCreateData(OCIndexSetRef set) {
 OCIndexSetRef OCIndexSetCreateWithData(OCDataRef data) {
     if (!data) return NULL;
     OCMutableIndexSetRef s = OCIndexSetAllocate();
-    s->indexes = (OCMutableDataRef)OCDataCreateCopy(data);
+    s->indexes = OCDataCreateMutableCopy(0, data);
     return s;
 }
 cJSON *OCIndexSetCopyAsJSON(OCIndexSetRef set, bool typed, OCStringRef *outError) {
@@ -114,5 +114,127 @@ double complex complex_tangent(double complex angle);
  * @ingroup OCMath
  */
 double complex raise_to_integer_power(double complex x, long power);
+/**
+ * @brief Buffer size that always holds the output of OCDoubleWriteShortestCString
+ *        and OCFloatWriteShortestCString, including the terminating NUL.
+ * @ingroup OCMath
+ */
+#define kOCShortestFloatingPointStringSize 32
+/**
+ * @brief Writes the shortest decimal string that reads back as exactly the same double.
+ *
+ * Digits come from the Schubfach algorithm, so no printf or strtod round trip is
+ * needed. Values in [1e-7, 1e21) are written as plain decimals ("0.1", "1024",
+ * "-123.456"), others in exponent form ("1e+21", "5e-324"). The output does
+ * not depend on the current locale. Infinities and NaN are written as "inf",
+ * "-inf" and "nan".
+ *
+ * @param value The value to format.
+ * @param buffer Destination; kOCShortestFloatingPointStringSize bytes always suffice.
+ * @param size Size of buffer in bytes.
+ * @return Number of characters written (excluding the NUL), or -1 if buffer is too small.
+ * @ingroup OCMath
+ *
+ * @code
+ * char text[kOCShortestFloatingPointStringSize];
+ * OCDoubleWriteShortestCString(0.1 + 0.2, text, sizeof(text));
+ * // text is "0.30000000000000004"
+ * @endcode
+ */
+int OCDoubleWriteShortestCString(double value, char *buffer, size_t size);
+/**
+ * @brief Writes the shortest decimal string that reads back as exactly the same float.
+ *
+ * Same layout as OCDoubleWriteShortestCString, but digits are chosen against
+ * float precision, so 3.14f is written as "3.14".
+ *
+ * @param value The value to format.
+ * @param buffer Destination; kOCShortestFloatingPointStringSize bytes always suffice.
+ * @param size Size of buffer in bytes.
+ * @return Number of characters written (excluding the NUL), or -1 if buffer is too small.
+ * @ingroup OCMath
+ */
+int OCFloatWriteShortestCString(float value, char *buffer, size_t size);
+/**
+ * @brief Parses a decimal floating-point number from the start of a character range.
+ *
+ * Accepts `[+-]digits[.digits][(e|E)[+-]digits]`, where either the integral or
+ * the fractional digits may be empty (".5", "5."). Leading whitespace,
+ * "inf"/"nan" and hexadecimal forms are not accepted. The result is correctly
+ * rounded and does not depend on the current locale; '.' is always the
+ * decimal point. Most inputs are converted with the Eisel-Lemire algorithm
+ * without allocating.
+ *
+ * @param first Start of the text.
+ * @param last One past the last readable character (the text need not be NUL-terminated).
+ * @param outValue Receives the value on success.
+ * @return Number of characters consumed, or 0 if no number starts at first.
+ * @ingroup OCMath
+ *
+ * @code
+ * const char *text = "6.02214076e23 mol";
+ * double avogadro;
+ * size_t used = OCDoubleFromChars(text, text + strlen(text), &avogadro);
+ * // used == 13, avogadro == 6.02214076e23
+ * @endcode
+ */
+size_t OCDoubleFromChars(const char *first, const char *last, double *outValue);
+/**
+ * @brief Parses a decimal number from a character range, rounding directly to float.
+ *
+ * Same syntax as OCDoubleFromChars. Rounds once to float precision rather
+ * than through double, so halfway cases come out right.
+ *
+ * @param first Start of the text.
+ * @param last One past the last readable character.
+ * @param outValue Receives the value on success.
+ * @return Number of characters consumed, or 0 if no number starts at first.
+ * @ingroup OCMath
+ */
+size_t OCFloatFromChars(const char *first, const char *last, float *outValue);
+/**
+ * @brief Parses a signed decimal integer from the start of a character range.
+ *
+ * Accepts an optional sign followed by decimal digits. Eight digits are
+ * converted at a time where possible.
+ *
+ * @param first Start of the text.
+ * @param last One past the last readable character.
+ * @param outValue Receives the value on success.
+ * @return Number of characters consumed, or 0 if there are no digits or the
+ *         value does not fit in int64_t.
+ * @ingroup OCMath
+ */
+size_t OCInt64FromChars(const char *first, const char *last, int64_t *outValue);
+/**
+ * @brief Parses an unsigned decimal integer from the start of a character range.
+ *
+ * Accepts an optional '+' followed by decimal digits. A leading '-' is not a
+ * number for this function.
+ *
+ * @param first Start of the text.
+ * @param last One past the last readable character.
+ * @param outValue Receives the value on success.
+ * @return Number of characters consumed, or 0 if there are no digits or the
+ *         value does not fit in uint64_t.
+ * @ingroup OCMath
+ */
+size_t OCUInt64FromChars(const char *first, const char *last, uint64_t *outValue);
+/**
+ * @brief Parses a plain complex literal from the start of a character range.
+ *
+ * Recognises a real term, an imaginary term written `bI`, `b*I` or `I*b`
+ * ('•' is accepted for '*'), or a real and an imaginary term joined by '+'
+ * or '-', e.g. "3", "-2.5I", "1+I*-0.5", "1e3 - 4*I". Numbers follow
+ * OCDoubleFromChars. Anything else, such as functions, parentheses or other
+ * operators, is left to OCComplexFromCString.
+ *
+ * @param first Start of the text.
+ * @param last One past the last readable character.
+ * @param outValue Receives the value on success.
+ * @return Number of characters consumed, or 0 if no literal starts at first.
+ * @ingroup OCMath
+ */
+size_t OCComplexFromChars(const char *first, const char *last, double complex *outValue);
 /** @} */  // end of OCMath group
 #endif     /* OCMath_h */
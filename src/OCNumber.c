@@ -1,6 +1,8 @@
 // OCNumber.c – Updated to use OCTypeAlloc and leak-safe finalization
 #include <complex.h>
+#include <ctype.h>
 #include <inttypes.h>
+#include <math.h>
 #include <stddef.h>  // for NULL
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,11 +12,6 @@
 #include <Accelerate/Accelerate.h>  // Apple Accelerate framework
 #define HAVE_ACCELERATE 1
 #endif
-// OpenMP support (widely available)
-#ifdef _OPENMP
-#include <omp.h>
-#define HAVE_OPENMP 1
-#endif
 // SIMD intrinsics for better performance
 #if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
 #include <emmintrin.h>  // SSE2
@@ -77,9 +74,14 @@ OCNumberType OCNumberTypeFromName(const char* name) {
     if (strcmp(name, "complex128") == 0) return kOCNumberComplex128Type;
     return kOCNumberTypeInvalid;  // Unrecognized name
 }
+static uint64_t impl_OCNumberHash(const void* obj);
+// Numbers never change, so OCTypeDeepCopyShared() always retains them
+static const OCTypeSharedCopyCallBacks kOCNumberSharedCopyCallBacks = {NULL, NULL, NULL, NULL};
 OCTypeID OCNumberGetTypeID(void) {
     if (kOCNumberID == kOCNotATypeID) {
         kOCNumberID = OCRegisterType("OCNumber", (OCTypeRef (*)(cJSON*, OCStringRef*))OCNumberCreateFromJSONTyped);
+        OCTypeSetHashFunction(kOCNumberID, impl_OCNumberHash);
+        OCTypeSetSharedCopyCallBacks(kOCNumberID, &kOCNumberSharedCopyCallBacks);
     }
     return kOCNumberID;
 }
@@ -214,10 +216,86 @@ static bool impl_OCNumberEqual(const void* a_, const void* b_) {
     if (ac || bc) return (ar == br && ai == bi);
     return ar == br;
 }
+// ——— Hash consistent with impl_OCNumberEqual ———
+// Equality converts mixed types to double, so every value is hashed through
+// its double form; an imaginary part only contributes when it is nonzero.
+static uint64_t impl_OCNumberHashDouble(double d) {
+    if (d == 0.0) d = 0.0;  // -0.0 == 0.0
+    uint64_t h;
+    memcpy(&h, &d, sizeof h);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+static uint64_t impl_OCNumberHash(const void* obj) {
+    OCNumberRef n = (OCNumberRef)obj;
+    double re, im = 0.0;
+    switch (n->type) {
+        case kOCNumberUInt8Type:
+            re = n->value.uint8Value;
+            break;
+        case kOCNumberSInt8Type:
+            re = n->value.int8Value;
+            break;
+        case kOCNumberUInt16Type:
+            re = n->value.uint16Value;
+            break;
+        case kOCNumberSInt16Type:
+            re = n->value.int16Value;
+            break;
+        case kOCNumberUInt32Type:
+            re = n->value.uint32Value;
+            break;
+        case kOCNumberSInt32Type:
+            re = n->value.int32Value;
+            break;
+        case kOCNumberUInt64Type:
+            re = (double)n->value.uint64Value;
+            break;
+        case kOCNumberSInt64Type:
+            re = (double)n->value.int64Value;
+            break;
+        case kOCNumberFloat32Type:
+            re = n->value.floatValue;
+            break;
+        case kOCNumberFloat64Type:
+            re = n->value.doubleValue;
+            break;
+        case kOCNumberComplex64Type:
+            re = crealf(n->value.floatComplexValue);
+            im = cimagf(n->value.floatComplexValue);
+            break;
+        case kOCNumberComplex128Type:
+            re = creal(n->value.doubleComplexValue);
+            im = cimag(n->value.doubleComplexValue);
+            break;
+        default:
+            return 0;
+    }
+    uint64_t h = impl_OCNumberHashDouble(re);
+    if (im != 0.0) h ^= impl_OCNumberHashDouble(im) * 0x9E3779B97F4A7C15ULL;
+    return h;
+}
 static void impl_OCNumberFinalize(const void* theType) {
     (void)theType;
 }
 #include <inttypes.h>
+#include <math.h>
+// ——— "re<sep>im" with each part in shortest round-trip form ———
+static OCStringRef impl_OCNumberCreateComplexString(OCNumberRef n, const char* separator) {
+    char re[kOCShortestFloatingPointStringSize], im[kOCShortestFloatingPointStringSize];
+    if (n->type == kOCNumberComplex64Type) {
+        OCFloatWriteShortestCString(crealf(n->value.floatComplexValue), re, sizeof(re));
+        OCFloatWriteShortestCString(cimagf(n->value.floatComplexValue), im, sizeof(im));
+    } else {
+        OCDoubleWriteShortestCString(creal(n->value.doubleComplexValue), re, sizeof(re));
+        OCDoubleWriteShortestCString(cimag(n->value.doubleComplexValue), im, sizeof(im));
+    }
+    return OCStringCreateWithFormat(STR("%s%s%s"), re, separator, im);
+}
 static OCStringRef impl_OCNumberCopyFormattingDesc(OCTypeRef theType) {
     if (!theType) return NULL;
     OCBase* base = (OCBase*)theType;
@@ -244,17 +322,11 @@ static OCStringRef impl_OCNumberCopyFormattingDesc(OCTypeRef theType) {
         case kOCNumberSInt64Type:
             return OCStringCreateWithFormat(STR("%" PRId64), n->value.int64Value);
         case kOCNumberFloat32Type:
-            return OCStringCreateWithFormat(STR("%f"), n->value.floatValue);
         case kOCNumberFloat64Type:
-            return OCStringCreateWithFormat(STR("%lf"), n->value.doubleValue);
+            return OCNumberCreateStringValue(n);
         case kOCNumberComplex64Type:
-            return OCStringCreateWithFormat(STR("%f+I•%f"),
-                                            crealf(n->value.floatComplexValue),
-                                            cimagf(n->value.floatComplexValue));
         case kOCNumberComplex128Type:
-            return OCStringCreateWithFormat(STR("%lf+I•%lf"),
-                                            creal(n->value.doubleComplexValue),
-                                            cimag(n->value.doubleComplexValue));
+            return impl_OCNumberCreateComplexString(n, "+I•");
     }
     return NULL;
 }
@@ -472,73 +544,195 @@ OCStringRef OCNumberCreateStringValue(OCNumberRef n) {
         case kOCNumberSInt64Type:
             return OCStringCreateWithFormat(STR("%" PRId64), (int64_t)n->value.int64Value);
         case kOCNumberFloat32Type:
-            return OCStringCreateWithFormat(STR("%.9g"), n->value.floatValue);  // Float precision
+            return OCFloatCreateStringValue(n->value.floatValue);  // Shortest round-trip
         case kOCNumberFloat64Type:
-            return OCStringCreateWithFormat(STR("%.17g"), n->value.doubleValue);  // Double precision
+            return OCDoubleCreateStringValue(n->value.doubleValue);  // Shortest round-trip
         case kOCNumberComplex64Type: {
             float r = crealf(n->value.floatComplexValue);
             float i = cimagf(n->value.floatComplexValue);
             if (r == 0.0f && i == 0.0f)
                 return OCStringCreateWithCString("0");
-            return OCStringCreateWithFormat(STR("%.9g+I*%.9g"), r, i);
+            return impl_OCNumberCreateComplexString(n, "+I*");
         }
         case kOCNumberComplex128Type: {
             double r = creal(n->value.doubleComplexValue);
             double i = cimag(n->value.doubleComplexValue);
             if (r == 0.0 && i == 0.0)
                 return OCStringCreateWithCString("0");
-            return OCStringCreateWithFormat(STR("%.17g+I*%.17g"), r, i);
+            return impl_OCNumberCreateComplexString(n, "+I*");
         }
     }
     return NULL;
 }
-OCNumberRef OCNumberCreateWithStringValue(OCNumberType type, const char* stringValue) {
-    if (!stringValue) return NULL;
-    union __Number value;
+// ——— "inf", "infinity" and "nan" as strtod spells them, any case ———
+static bool impl_OCNumberMatchWord(const char* p, size_t remaining, const char* word) {
+    size_t n = strlen(word);
+    if (remaining < n) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (tolower((unsigned char)p[i]) != word[i]) return false;
+    }
+    return true;
+}
+static size_t impl_OCNumberScanSpecialValue(const char* first, const char* last, double* outValue) {
+    const char* p = first;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    size_t remaining = (size_t)(last - p);
+    double value;
+    size_t n;
+    if (impl_OCNumberMatchWord(p, remaining, "infinity")) {
+        value = INFINITY;
+        n = 8;
+    } else if (impl_OCNumberMatchWord(p, remaining, "inf")) {
+        value = INFINITY;
+        n = 3;
+    } else if (impl_OCNumberMatchWord(p, remaining, "nan")) {
+        value = NAN;
+        n = 3;
+    } else {
+        return 0;
+    }
+    *outValue = negative ? -value : value;
+    return (size_t)(p - first) + n;
+}
+// ——— Parse one value of the given type from [first, last) ———
+// Returns the characters consumed, or 0 if there is no number or it is out of range.
+static size_t impl_OCNumberParseValue(OCNumberType type, const char* first, const char* last, union __Number* value) {
+    size_t n = 0;
     switch (type) {
         case kOCNumberUInt8Type:
-            value.uint8Value = (uint8_t)strtoul(stringValue, NULL, 10);
-            break;
-        case kOCNumberSInt8Type:
-            value.int8Value = (int8_t)strtol(stringValue, NULL, 10);
-            break;
         case kOCNumberUInt16Type:
-            value.uint16Value = (uint16_t)strtoul(stringValue, NULL, 10);
-            break;
-        case kOCNumberSInt16Type:
-            value.int16Value = (int16_t)strtol(stringValue, NULL, 10);
-            break;
         case kOCNumberUInt32Type:
-            value.uint32Value = (uint32_t)strtoul(stringValue, NULL, 10);
-            break;
+        case kOCNumberUInt64Type: {
+            uint64_t u = 0;
+            n = OCUInt64FromChars(first, last, &u);
+            if (n == 0) return 0;
+            if (type == kOCNumberUInt8Type) {
+                if (u > UINT8_MAX) return 0;
+                value->uint8Value = (uint8_t)u;
+            } else if (type == kOCNumberUInt16Type) {
+                if (u > UINT16_MAX) return 0;
+                value->uint16Value = (uint16_t)u;
+            } else if (type == kOCNumberUInt32Type) {
+                if (u > UINT32_MAX) return 0;
+                value->uint32Value = (uint32_t)u;
+            } else {
+                value->uint64Value = u;
+            }
+            return n;
+        }
+        case kOCNumberSInt8Type:
+        case kOCNumberSInt16Type:
         case kOCNumberSInt32Type:
-            value.int32Value = (int32_t)strtol(stringValue, NULL, 10);
-            break;
-        case kOCNumberUInt64Type:
-            value.uint64Value = (uint64_t)strtoull(stringValue, NULL, 10);
-            break;
-        case kOCNumberSInt64Type:
-            value.int64Value = (int64_t)strtoll(stringValue, NULL, 10);
-            break;
-        case kOCNumberFloat32Type:
-            value.floatValue = strtof(stringValue, NULL);
-            break;
+        case kOCNumberSInt64Type: {
+            int64_t i = 0;
+            n = OCInt64FromChars(first, last, &i);
+            if (n == 0) return 0;
+            if (type == kOCNumberSInt8Type) {
+                if (i < INT8_MIN || i > INT8_MAX) return 0;
+                value->int8Value = (int8_t)i;
+            } else if (type == kOCNumberSInt16Type) {
+                if (i < INT16_MIN || i > INT16_MAX) return 0;
+                value->int16Value = (int16_t)i;
+            } else if (type == kOCNumberSInt32Type) {
+                if (i < INT32_MIN || i > INT32_MAX) return 0;
+                value->int32Value = (int32_t)i;
+            } else {
+                value->int64Value = i;
+            }
+            return n;
+        }
+        case kOCNumberFloat32Type: {
+            n = OCFloatFromChars(first, last, &value->floatValue);
+            if (n == 0) {
+                double special;
+                n = impl_OCNumberScanSpecialValue(first, last, &special);
+                value->floatValue = (float)special;
+            }
+            return n;
+        }
         case kOCNumberFloat64Type:
-            value.doubleValue = strtod(stringValue, NULL);
-            break;
+            n = OCDoubleFromChars(first, last, &value->doubleValue);
+            if (n == 0) n = impl_OCNumberScanSpecialValue(first, last, &value->doubleValue);
+            return n;
         case kOCNumberComplex64Type: {
-            double complex z = OCComplexFromCString(stringValue);
-            value.floatComplexValue = (float complex)z;
-            break;
+            double complex z;
+            n = OCComplexFromChars(first, last, &z);
+            if (n) value->floatComplexValue = (float complex)z;
+            return n;
         }
         case kOCNumberComplex128Type:
-            value.doubleComplexValue = OCComplexFromCString(stringValue);
-            break;
-        default:
-            return NULL;  // Unsupported type
+            return OCComplexFromChars(first, last, &value->doubleComplexValue);
+    }
+    return 0;
+}
+OCNumberRef OCNumberCreateWithStringValue(OCNumberType type, const char* stringValue) {
+    if (!stringValue) return NULL;
+    const char* first = stringValue;
+    while (isspace((unsigned char)*first)) first++;
+    const char* last = first + strlen(first);
+    union __Number value;
+    size_t n = impl_OCNumberParseValue(type, first, last, &value);
+    if (type == kOCNumberComplex64Type || type == kOCNumberComplex128Type) {
+        // Plain literals are parsed directly; full expressions need the complex parser
+        const char* rest = first + n;
+        while (isspace((unsigned char)*rest)) rest++;
+        if (n == 0 || *rest != '\0') {
+            double complex z = OCComplexFromCString(stringValue);
+            if (type == kOCNumberComplex64Type) value.floatComplexValue = (float complex)z;
+            else value.doubleComplexValue = z;
+        }
+    } else if (n == 0) {
+        return NULL;  // Not a number, or out of range for the type
     }
     return OCNumberCreate(type, &value);
 }
+OCIndex OCNumberParseValuesFromCString(OCNumberType type,
+                                       const char* text,
+                                       size_t length,
+                                       void* outValues,
+                                       OCIndex capacity,
+                                       size_t* outBytesConsumed,
+                                       OCStringRef* outError) {
+    if (outError) *outError = NULL;
+    if (outBytesConsumed) *outBytesConsumed = 0;
+    int size = OCNumberTypeSize(type);
+    if (!text || !outValues || capacity < 0 || size <= 0) {
+        if (outError) *outError = STR("Invalid arguments to OCNumberParseValuesFromCString");
+        return -1;
+    }
+    const char* p = text;
+    const char* end = text + length;
+    uint8_t* out = (uint8_t*)outValues;
+    OCIndex count = 0;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    while (p < end && count < capacity) {
+        union __Number value;
+        size_t n = impl_OCNumberParseValue(type, p, end, &value);
+        const char* next = p + n;
+        if (n == 0 || (next < end && *next != ',' && !isspace((unsigned char)*next))) {
+            if (outBytesConsumed) *outBytesConsumed = (size_t)(p - text);
+            if (outError) *outError = STR("Malformed or out-of-range number in buffer");
+            return -1;
+        }
+        memcpy(out + (size_t)count * (size_t)size, &value, (size_t)size);
+        count++;
+        // One comma may separate values, with any whitespace around it
+        p = next;
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p < end && *p == ',') {
+            p++;
+            while (p < end && isspace((unsigned char)*p)) p++;
+            if (p < end && *p == ',') {
+                if (outBytesConsumed) *outBytesConsumed = (size_t)(p - text);
+                if (outError) *outError = STR("Empty field in number buffer");
+                return -1;
+            }
+        }
+    }
+    if (outBytesConsumed) *outBytesConsumed = (size_t)(p - text);
+    return count;
+}
 bool OCNumberGetValue(OCNumberRef number, OCNumberType type, void* valuePtr) {
     if (!number || !valuePtr) {
         // Consider logging an error or asserting for debug builds
@@ -621,6 +815,16 @@ bool OCNumberGetValue(OCNumberRef number, OCNumberType type, void* valuePtr) {
  * @param typed If true, include type information; if false, serialize value only
  * @return cJSON object representing the serialized number, or NULL on error
  */
+// ——— The double nearest to a float's shortest decimal form ———
+// Serialising that double prints "3.14" for 3.14f instead of the widened
+// "3.1400001049041748", and it still converts back to the same float.
+static double impl_OCFloatAsShortestDouble(float value) {
+    char buf[kOCShortestFloatingPointStringSize];
+    if (OCFloatWriteShortestCString(value, buf, sizeof(buf)) < 0) return value;
+    double d;
+    if (OCDoubleFromChars(buf, buf + strlen(buf), &d) == 0) return value;
+    return ((float)d == value) ? d : (double)value;
+}
 cJSON* OCNumberCopyAsJSON(OCNumberRef number, bool typed, OCStringRef* outError) {
     if (outError) *outError = NULL;
     if (!number) {
@@ -640,8 +844,8 @@ cJSON* OCNumberCopyAsJSON(OCNumberRef number, bool typed, OCStringRef* outError)
             }
             float real = crealf(number->value.floatComplexValue);
             float imag = cimagf(number->value.floatComplexValue);
-            cJSON* realJson = cJSON_CreateNumber(real);
-            cJSON* imagJson = cJSON_CreateNumber(imag);
+            cJSON* realJson = cJSON_CreateNumber(impl_OCFloatAsShortestDouble(real));
+            cJSON* imagJson = cJSON_CreateNumber(impl_OCFloatAsShortestDouble(imag));
             if (!realJson || !imagJson) {
                 if (outError) *outError = STR("Failed to create JSON numbers for complex64 components");
                 cJSON_Delete(result);
@@ -716,7 +920,7 @@ cJSON* OCNumberCopyAsJSON(OCNumberRef number, bool typed, OCStringRef* outError)
             result = cJSON_CreateNumber(number->value.int32Value);
             break;
         case kOCNumberFloat32Type:
-            result = cJSON_CreateNumber(number->value.floatValue);
+            result = cJSON_CreateNumber(impl_OCFloatAsShortestDouble(number->value.floatValue));
             break;
         case kOCNumberFloat64Type:
             result = cJSON_CreateNumber(number->value.doubleValue);
@@ -973,16 +1177,14 @@ OCNumberRef OCNumberCreateFromJSONTyped(cJSON* json, OCStringRef* outError) {
             return NULL;
         }
         union __Number val;
-        char* endptr;
+        const char* valueEnd = valueStr + strlen(valueStr);
         if (numberType == kOCNumberUInt64Type) {
-            val.uint64Value = strtoull(valueStr, &endptr, 10);
-            if (*endptr != '\0') {
+            if (OCUInt64FromChars(valueStr, valueEnd, &val.uint64Value) != (size_t)(valueEnd - valueStr)) {
                 if (outError) *outError = STR("Invalid uint64 number format");
                 return NULL;
             }
         } else {
-            val.int64Value = strtoll(valueStr, &endptr, 10);
-            if (*endptr != '\0') {
+            if (OCInt64FromChars(valueStr, valueEnd, &val.int64Value) != (size_t)(valueEnd - valueStr)) {
                 if (outError) *outError = STR("Invalid int64 number format");
                 return NULL;
             }
@@ -117,6 +117,10 @@ OCNumberRef OCNumberCreate(OCNumberType type, void *value);
 OCNumberType OCNumberGetType(OCNumberRef number);
 /**
  * @brief Create string representation of a number.
+ *
+ * Floating-point values (and complex parts, written as "re+I*im") use the
+ * shortest decimal that reads back as the same value at the stored precision.
+ *
  * @param number An OCNumberRef.
  * @return OCStringRef (caller must release).
  * @ingroup OCNumber
@@ -124,12 +128,48 @@ OCNumberType OCNumberGetType(OCNumberRef number);
 OCStringRef OCNumberCreateStringValue(OCNumberRef number);
 /**
  * @brief Create OCNumber from string and type.
+ *
+ * Leading whitespace is skipped and parsing stops at the first character that
+ * cannot continue the number. Parsing is exact and independent of the current
+ * locale. Complex types accept plain literals directly and fall back to the
+ * full expression parser for anything else.
+ *
  * @param type Target OCNumberType.
  * @param stringValue Null-terminated C string.
- * @return OCNumberRef or NULL on parse error.
+ * @return OCNumberRef or NULL on parse error or if an integer is out of range for @p type.
  * @ingroup OCNumber
  */
 OCNumberRef OCNumberCreateWithStringValue(OCNumberType type, const char *stringValue);
+/**
+ * @brief Parse a whitespace- or comma-separated list of numbers into a typed buffer.
+ *
+ * Values are separated by whitespace, optionally with a single comma.
+ * Each value is written to @p outValues as a native element of @p type.
+ * No allocation is performed. Parsing stops after @p capacity values.
+ *
+ * @code
+ * double v[4];
+ * OCIndex n = OCNumberParseValuesFromCString(kOCNumberFloat64Type, "1.5, 2 3e2", 10, v, 4, NULL, NULL);
+ * // n == 3
+ * @endcode
+ *
+ * @param type Element type written to @p outValues.
+ * @param text Input characters (need not be NUL-terminated).
+ * @param length Number of bytes in @p text.
+ * @param outValues Destination buffer of at least @p capacity elements.
+ * @param capacity Maximum number of values to parse.
+ * @param outBytesConsumed Optional; receives the bytes consumed, or the offset of the bad value on error.
+ * @param outError Optional; receives an error description on failure.
+ * @return Number of values parsed, or -1 on error.
+ * @ingroup OCNumber
+ */
+OCIndex OCNumberParseValuesFromCString(OCNumberType type,
+                                       const char *text,
+                                       size_t length,
+                                       void *outValues,
+                                       OCIndex capacity,
+                                       size_t *outBytesConsumed,
+                                       OCStringRef *outError);
 /**
  * @brief Copy a human-readable description of the number.
  * @param number An OCNumberRef.
@@ -76,9 +76,39 @@ static void *impl_OCSetDeepCopyMutable(const void *obj) {
     // OCSet is mutable, so same as deep copy
     return impl_OCSetDeepCopy(obj);
 }
+// OCTypeDeepCopyShared support. Nothing stops a set from changing, so every
+// set counts as mutable; its copy borrows the element array until either set
+// changes.
+static bool impl_OCSetIsMutable(const void *obj) {
+    (void)obj;
+    return true;
+}
+static bool impl_OCSetAnyChild(const void *obj, bool (*visit)(const void *, void *), void *info) {
+    OCSetRef set = (OCSetRef)obj;
+    OCIndex count = OCArrayGetCount(set->elements);
+    for (OCIndex i = 0; i < count; i++)
+        if (visit(OCArrayGetValueAtIndex(set->elements, i), info)) return true;
+    return false;
+}
+static void *impl_OCSetCreateShared(const void *obj) {
+    return (void *)OCSetCreateMutableCopy((OCSetRef)obj);
+}
+static bool impl_OCSetReplaceChildren(void *obj, const void *(*map)(const void *, void *), void *info) {
+    OCMutableSetRef set = (OCMutableSetRef)obj;
+    OCIndex count = OCArrayGetCount(set->elements);
+    for (OCIndex i = 0; i < count; i++) {
+        const void *value = OCArrayGetValueAtIndex(set->elements, i);
+        const void *replacement = map(value, info);
+        if (replacement != value && !OCArraySetValueAtIndex(set->elements, i, replacement)) return false;
+    }
+    return true;
+}
+static const OCTypeSharedCopyCallBacks kOCSetSharedCopyCallBacks = {
+    impl_OCSetIsMutable, impl_OCSetAnyChild, impl_OCSetCreateShared, impl_OCSetReplaceChildren};
 OCTypeID OCSetGetTypeID(void) {
     if (kOCSetID == kOCNotATypeID) {
         kOCSetID = OCRegisterType("OCSet", (OCTypeRef (*)(cJSON *, OCStringRef *))OCSetCreateFromJSONTyped);
+        OCTypeSetSharedCopyCallBacks(kOCSetID, &kOCSetSharedCopyCallBacks);
     }
     return kOCSetID;
 }
@@ -105,15 +135,18 @@ OCMutableSetRef OCSetCreateMutable(OCIndex capacity) {
     set->elements = OCArrayCreateMutable(capacity, &kOCTypeArrayCallBacks);
     return (OCMutableSetRef)set;
 }
+// The elements are already distinct, so the copy borrows the element array,
+// which is duplicated only when either set changes
 OCSetRef OCSetCreateCopy(OCSetRef theSet) {
     if (!theSet) return NULL;
-    OCSetRef copy = OCSetCreate();
-    OCIndex count = OCArrayGetCount(theSet->elements);
-    for (OCIndex i = 0; i < count; i++) {
-        OCTypeRef value = OCArrayGetValueAtIndex(theSet->elements, i);
-        OCSetAddValue((OCMutableSetRef)copy, value);
+    struct impl_OCSet *copy = OCSetAllocate();
+    if (!copy) return NULL;
+    copy->elements = OCArrayCreateMutableCopy(theSet->elements);
+    if (!copy->elements) {
+        OCRelease(copy);
+        return NULL;
     }
-    return copy;
+    return (OCSetRef)copy;
 }
 OCMutableSetRef OCSetCreateMutableCopy(OCSetRef theSet) {
     return (OCMutableSetRef)OCSetCreateCopy(theSet);
@@ -145,9 +178,7 @@ bool OCSetRemoveValue(OCMutableSetRef theSet, OCTypeRef value) {
 }
 void OCSetRemoveAllValues(OCMutableSetRef theSet) {
     if (!theSet) return;
-    while (OCSetGetCount(theSet) > 0) {
-        OCArrayRemoveValueAtIndex(theSet->elements, 0);
-    }
+    OCArrayRemoveValuesInRange(theSet->elements, OCRangeMake(0, (OCIndex)OCArrayGetCount(theSet->elements)));
 }
 bool OCSetEqual(OCSetRef a, OCSetRef b) {
     return impl_OCSetEqual(a, b);
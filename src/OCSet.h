@@ -43,6 +43,8 @@ OCMutableSetRef OCSetCreateMutable(OCIndex capacity);
 /**
  * @brief Creates an immutable copy of an existing set.
  *
+ * The copy shares the set's element storage until either set changes.
+ *
  * @param theSet The set to copy.
  * @return A new OCSetRef or NULL on error.
  *
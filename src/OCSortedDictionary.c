@@ -0,0 +1,784 @@
+// OCSortedDictionary.c – ordered OCType-keyed map built as a B+ tree
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L  // posix_memalign
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>  // _aligned_malloc
+#endif
+#include "OCTypes.h"
+static OCTypeID kOCSortedDictionaryID = kOCNotATypeID;
+// Entries live in the leaves, which are chained left to right for range
+// walks. Internal nodes hold separators, each no greater than every key of
+// the subtree to its right and greater than every key to its left; they are
+// retained, so a separator stays valid after its key is removed from the
+// leaves. Every node but the root is kept at least half full.
+//
+// A node is one 512-byte block aligned to a cache line: the count and the
+// keys take the first four lines, so the binary search inside a node reads
+// only those, and the values or children take the last four.
+#define kOCSortedDictionaryCacheLine 64
+#define kOCSortedDictionaryMaxKeys 31
+#define kOCSortedDictionaryMinKeys (kOCSortedDictionaryMaxKeys / 2)
+typedef struct impl_OCSortedDictionaryNode {
+    uint32_t count;
+    bool isLeaf;
+    const void *keys[kOCSortedDictionaryMaxKeys];
+    // A leaf's values, with the next leaf in the last slot; an internal
+    // node's count + 1 children
+    void *slots[kOCSortedDictionaryMaxKeys + 1];
+} impl_OCSortedDictionaryNode;
+#define impl_OCSortedDictionaryNextLeaf(leaf) ((impl_OCSortedDictionaryNode *)(leaf)->slots[kOCSortedDictionaryMaxKeys])
+struct impl_OCSortedDictionary {
+    OCBase base;
+    uint64_t count;
+    impl_OCSortedDictionaryNode *root;  // NULL when empty
+    OCComparatorFunction comparator;
+    void *context;
+    bool isMutable;
+};
+// ——— Nodes ———
+static impl_OCSortedDictionaryNode *impl_OCSortedDictionaryNodeCreate(bool isLeaf) {
+    size_t size = (sizeof(impl_OCSortedDictionaryNode) + kOCSortedDictionaryCacheLine - 1) /
+                  kOCSortedDictionaryCacheLine * kOCSortedDictionaryCacheLine;
+    void *block = NULL;
+#ifdef _WIN32
+    block = _aligned_malloc(size, kOCSortedDictionaryCacheLine);
+    if (!block) {
+#else
+    if (posix_memalign(&block, kOCSortedDictionaryCacheLine, size) != 0) {
+#endif
+        fprintf(stderr, "OCSortedDictionary: Memory allocation for a node failed.\n");
+        return NULL;
+    }
+    impl_OCSortedDictionaryNode *node = block;
+    node->count = 0;
+    node->isLeaf = isLeaf;
+    node->slots[kOCSortedDictionaryMaxKeys] = NULL;
+    return node;
+}
+// Frees one node block; aligned blocks need _aligned_free on Windows
+static void impl_OCSortedDictionaryNodeFree(impl_OCSortedDictionaryNode *node) {
+#ifdef _WIN32
+    _aligned_free(node);
+#else
+    free(node);
+#endif
+}
+// Frees a subtree, releasing its keys, separators and values
+static void impl_OCSortedDictionaryNodeRelease(impl_OCSortedDictionaryNode *node) {
+    if (!node)
+        return;
+    for (uint32_t i = 0; i < node->count; i++)
+        OCRelease(node->keys[i]);
+    if (node->isLeaf) {
+        for (uint32_t i = 0; i < node->count; i++)
+            OCRelease(node->slots[i]);
+    } else {
+        for (uint32_t i = 0; i <= node->count; i++)
+            impl_OCSortedDictionaryNodeRelease(node->slots[i]);
+    }
+    impl_OCSortedDictionaryNodeFree(node);
+}
+static inline OCComparisonResult impl_OCSortedDictionaryCompare(OCSortedDictionaryRef dict, const void *a, const void *b) {
+    return dict->comparator(a, b, dict->context);
+}
+// First position in node whose key is not less than key
+static uint32_t impl_OCSortedDictionaryLowerBound(OCSortedDictionaryRef dict, const impl_OCSortedDictionaryNode *node,
+                                                  const void *key) {
+    uint32_t low = 0, high = node->count;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (impl_OCSortedDictionaryCompare(dict, node->keys[mid], key) == kOCCompareLessThan)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+// First position in node whose key is greater than key; in an internal node,
+// the child whose subtree would hold key
+static uint32_t impl_OCSortedDictionaryUpperBound(OCSortedDictionaryRef dict, const impl_OCSortedDictionaryNode *node,
+                                                  const void *key) {
+    uint32_t low = 0, high = node->count;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (impl_OCSortedDictionaryCompare(dict, key, node->keys[mid]) == kOCCompareLessThan)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+static const impl_OCSortedDictionaryNode *impl_OCSortedDictionaryFindLeaf(OCSortedDictionaryRef dict, const void *key) {
+    const impl_OCSortedDictionaryNode *node = dict->root;
+    while (node && !node->isLeaf)
+        node = node->slots[impl_OCSortedDictionaryUpperBound(dict, node, key)];
+    return node;
+}
+static const impl_OCSortedDictionaryNode *impl_OCSortedDictionaryFirstLeaf(OCSortedDictionaryRef dict) {
+    const impl_OCSortedDictionaryNode *node = dict->root;
+    while (node && !node->isLeaf)
+        node = node->slots[0];
+    return node;
+}
+// ——— Bulk loading ———
+// Builds a tree over entries in ascending key order, retaining each key and
+// value. Leaves are filled as evenly as the count allows, then each level of
+// internal nodes is built over the one below, so every node is at least half
+// full and most are full.
+static bool impl_OCSortedDictionaryBuild(struct impl_OCSortedDictionary *dict, const void **keys, const void **values,
+                                         uint64_t count) {
+    dict->root = NULL;
+    dict->count = 0;
+    if (count == 0)
+        return true;
+    uint64_t leafCount = (count + kOCSortedDictionaryMaxKeys - 1) / kOCSortedDictionaryMaxKeys;
+    impl_OCSortedDictionaryNode **nodes = malloc(leafCount * sizeof(impl_OCSortedDictionaryNode *));
+    const void **lowest = malloc(leafCount * sizeof(const void *));  // smallest key under each node
+    if (!nodes || !lowest) {
+        fprintf(stderr, "OCSortedDictionary: Memory allocation for %llu nodes failed.\n", (unsigned long long)leafCount);
+        free(nodes);
+        free(lowest);
+        return false;
+    }
+    uint64_t next = 0;
+    for (uint64_t l = 0; l < leafCount; l++) {
+        impl_OCSortedDictionaryNode *leaf = impl_OCSortedDictionaryNodeCreate(true);
+        if (!leaf) {
+            for (uint64_t i = 0; i < l; i++) {
+                nodes[i]->slots[kOCSortedDictionaryMaxKeys] = NULL;
+                impl_OCSortedDictionaryNodeRelease(nodes[i]);
+            }
+            free(nodes);
+            free(lowest);
+            return false;
+        }
+        uint32_t size = (uint32_t)(count / leafCount + (l < count % leafCount));
+        for (uint32_t i = 0; i < size; i++, next++) {
+            leaf->keys[i] = OCRetain(keys[next]);
+            leaf->slots[i] = (void *)OCRetain(values[next]);
+        }
+        leaf->count = size;
+        if (l > 0)
+            nodes[l - 1]->slots[kOCSortedDictionaryMaxKeys] = leaf;
+        nodes[l] = leaf;
+        lowest[l] = leaf->keys[0];
+    }
+    uint64_t levelCount = leafCount;
+    while (levelCount > 1) {
+        uint64_t parentCount = (levelCount + kOCSortedDictionaryMaxKeys) / (kOCSortedDictionaryMaxKeys + 1);
+        uint64_t child = 0;
+        for (uint64_t p = 0; p < parentCount; p++) {
+            impl_OCSortedDictionaryNode *parent = impl_OCSortedDictionaryNodeCreate(false);
+            if (!parent) {
+                // Parents so far own their children; the rest are still loose
+                for (uint64_t i = 0; i < p; i++)
+                    impl_OCSortedDictionaryNodeRelease(nodes[i]);
+                for (uint64_t i = child; i < levelCount; i++)
+                    impl_OCSortedDictionaryNodeRelease(nodes[i]);
+                free(nodes);
+                free(lowest);
+                return false;
+            }
+            uint32_t children = (uint32_t)(levelCount / parentCount + (p < levelCount % parentCount));
+            for (uint32_t j = 0; j < children; j++) {
+                parent->slots[j] = nodes[child + j];
+                if (j > 0)
+                    parent->keys[j - 1] = OCRetain(lowest[child + j]);
+            }
+            parent->count = children - 1;
+            lowest[p] = lowest[child];
+            nodes[p] = parent;
+            child += children;
+        }
+        levelCount = parentCount;
+    }
+    dict->root = nodes[0];
+    dict->count = count;
+    free(nodes);
+    free(lowest);
+    return true;
+}
+// Collects the entries in key order into two arrays the caller frees
+static bool impl_OCSortedDictionaryCopyEntries(OCSortedDictionaryRef dict, const void ***outKeys, const void ***outValues) {
+    uint64_t n = dict->count ? dict->count : 1;
+    const void **keys = malloc(n * sizeof(const void *));
+    const void **values = malloc(n * sizeof(const void *));
+    if (!keys || !values) {
+        fprintf(stderr, "OCSortedDictionary: Memory allocation for %llu entries failed.\n", (unsigned long long)n);
+        free(keys);
+        free(values);
+        return false;
+    }
+    uint64_t i = 0;
+    for (const impl_OCSortedDictionaryNode *leaf = impl_OCSortedDictionaryFirstLeaf(dict); leaf;
+         leaf = impl_OCSortedDictionaryNextLeaf(leaf)) {
+        memcpy(keys + i, leaf->keys, leaf->count * sizeof(const void *));
+        memcpy(values + i, leaf->slots, leaf->count * sizeof(const void *));
+        i += leaf->count;
+    }
+    *outKeys = keys;
+    *outValues = values;
+    return true;
+}
+// ——— OCType callbacks ———
+static void impl_OCSortedDictionaryFinalize(const void *theType) {
+    if (NULL == theType) {
+        fprintf(stderr, "Finalize called with NULL pointer\n");
+        return;
+    }
+    struct impl_OCSortedDictionary *dict = (struct impl_OCSortedDictionary *)theType;
+    impl_OCSortedDictionaryNodeRelease(dict->root);
+    dict->root = NULL;
+}
+static bool impl_OCSortedDictionaryEqual(const void *theType1, const void *theType2) {
+    OCSortedDictionaryRef d1 = (OCSortedDictionaryRef)theType1;
+    OCSortedDictionaryRef d2 = (OCSortedDictionaryRef)theType2;
+    if (d1 == d2)
+        return true;
+    if (!d1 || !d2 || d1->base.typeID != d2->base.typeID || d1->count != d2->count)
+        return false;
+    // Both walks run in key order, so equal dictionaries pair up entry by entry
+    OCSortedDictionaryCursor c1, c2;
+    const void *k1, *v1, *k2, *v2;
+    OCSortedDictionaryCursorInit(&c1, d1, NULL, NULL);
+    OCSortedDictionaryCursorInit(&c2, d2, NULL, NULL);
+    while (OCSortedDictionaryCursorNext(&c1, &k1, &v1) && OCSortedDictionaryCursorNext(&c2, &k2, &v2)) {
+        if (!OCTypeEqual(k1, k2) || !OCTypeEqual(v1, v2))
+            return false;
+    }
+    return true;
+}
+static OCStringRef impl_OCSortedDictionaryCopyFormattingDesc(OCTypeRef cf) {
+    if (!cf)
+        return OCStringCreateWithCString("<OCSortedDictionary: NULL>");
+    uint64_t count = ((OCSortedDictionaryRef)cf)->count;
+    return OCStringCreateWithFormat(STR("<OCSortedDictionary: %llu pair%s>"),
+                                    (unsigned long long)count, count == 1 ? "" : "s");
+}
+static cJSON *impl_OCSortedDictionaryCopyJSON(const void *obj, bool typed, OCStringRef *outError) {
+    return OCSortedDictionaryCopyAsJSON((OCSortedDictionaryRef)obj, typed, outError);
+}
+static struct impl_OCSortedDictionary *impl_OCSortedDictionaryCreate(OCComparatorFunction comparator, void *context,
+                                                                      bool isMutable);
+static void *impl_OCSortedDictionaryDeepCopyWithMutability(const void *obj, bool isMutable) {
+    OCSortedDictionaryRef src = (OCSortedDictionaryRef)obj;
+    if (!src)
+        return NULL;
+    struct impl_OCSortedDictionary *copy = impl_OCSortedDictionaryCreate(src->comparator, src->context, isMutable);
+    const void **keys, **values;
+    if (!copy || !impl_OCSortedDictionaryCopyEntries(src, &keys, &values)) {
+        OCRelease(copy);
+        return NULL;
+    }
+    // Stored keys are immutable already; only the values need copying
+    uint64_t made = 0;
+    for (; made < src->count; made++) {
+        values[made] = OCTypeDeepCopy(values[made]);
+        if (!values[made])
+            break;
+    }
+    bool ok = made == src->count && impl_OCSortedDictionaryBuild(copy, keys, values, src->count);
+    for (uint64_t i = 0; i < made; i++)
+        OCRelease(values[i]);
+    free(keys);
+    free(values);
+    if (!ok) {
+        OCRelease(copy);
+        return NULL;
+    }
+    return copy;
+}
+static void *impl_OCSortedDictionaryDeepCopy(const void *obj) {
+    return impl_OCSortedDictionaryDeepCopyWithMutability(obj, false);
+}
+static void *impl_OCSortedDictionaryDeepCopyMutable(const void *obj) {
+    return impl_OCSortedDictionaryDeepCopyWithMutability(obj, true);
+}
+OCTypeID OCSortedDictionaryGetTypeID(void) {
+    if (kOCSortedDictionaryID == kOCNotATypeID) {
+        // No JSON factory: the comparator cannot be read back
+        kOCSortedDictionaryID = OCRegisterType("OCSortedDictionary", NULL);
+    }
+    return kOCSortedDictionaryID;
+}
+static struct impl_OCSortedDictionary *impl_OCSortedDictionaryCreate(OCComparatorFunction comparator, void *context,
+                                                                      bool isMutable) {
+    if (!comparator) {
+        fprintf(stderr, "OCSortedDictionary: A comparator is required.\n");
+        return NULL;
+    }
+    struct impl_OCSortedDictionary *dict = OCTypeAlloc(
+        struct impl_OCSortedDictionary,
+        OCSortedDictionaryGetTypeID(),
+        impl_OCSortedDictionaryFinalize,
+        impl_OCSortedDictionaryEqual,
+        impl_OCSortedDictionaryCopyFormattingDesc,
+        impl_OCSortedDictionaryCopyJSON,
+        impl_OCSortedDictionaryDeepCopy,
+        impl_OCSortedDictionaryDeepCopyMutable);
+    if (!dict)
+        return NULL;
+    dict->comparator = comparator;
+    dict->context = context;
+    dict->isMutable = isMutable;
+    return dict;
+}
+// ——— Creation and copying ———
+OCMutableSortedDictionaryRef OCSortedDictionaryCreateMutable(OCComparatorFunction comparator, void *context) {
+    return impl_OCSortedDictionaryCreate(comparator, context, true);
+}
+OCSortedDictionaryRef OCSortedDictionaryCreate(const void **keys, const void **values, uint64_t count,
+                                               OCComparatorFunction comparator, void *context) {
+    if (count > 0 && (!keys || !values))
+        return NULL;
+    struct impl_OCSortedDictionary *dict = impl_OCSortedDictionaryCreate(comparator, context, false);
+    if (!dict)
+        return NULL;
+    for (uint64_t i = 1; i < count; i++) {
+        if (comparator(keys[i - 1], keys[i], context) != kOCCompareLessThan) {
+            fprintf(stderr, "OCSortedDictionaryCreate: Keys %llu and %llu are not in ascending order.\n",
+                    (unsigned long long)(i - 1), (unsigned long long)i);
+            OCRelease(dict);
+            return NULL;
+        }
+    }
+    const void **copies = malloc((count ? count : 1) * sizeof(const void *));
+    if (!copies) {
+        fprintf(stderr, "OCSortedDictionaryCreate: Memory allocation for %llu keys failed.\n", (unsigned long long)count);
+        OCRelease(dict);
+        return NULL;
+    }
+    uint64_t made = 0;
+    for (; made < count; made++) {
+        copies[made] = impl_OCDictionaryCopyKey(keys[made]);
+        if (!copies[made]) {
+            fprintf(stderr, "OCSortedDictionaryCreate: Failed to copy key %llu.\n", (unsigned long long)made);
+            break;
+        }
+    }
+    bool ok = made == count && impl_OCSortedDictionaryBuild(dict, copies, values, count);
+    for (uint64_t i = 0; i < made; i++)
+        OCRelease(copies[i]);
+    free(copies);
+    if (!ok) {
+        OCRelease(dict);
+        return NULL;
+    }
+    return dict;
+}
+static struct impl_OCSortedDictionary *impl_OCSortedDictionaryCreateCopy(OCSortedDictionaryRef src, bool isMutable) {
+    if (!src)
+        return NULL;
+    struct impl_OCSortedDictionary *copy = impl_OCSortedDictionaryCreate(src->comparator, src->context, isMutable);
+    const void **keys, **values;
+    if (!copy || !impl_OCSortedDictionaryCopyEntries(src, &keys, &values)) {
+        OCRelease(copy);
+        return NULL;
+    }
+    bool ok = impl_OCSortedDictionaryBuild(copy, keys, values, src->count);
+    free(keys);
+    free(values);
+    if (!ok) {
+        OCRelease(copy);
+        return NULL;
+    }
+    return copy;
+}
+OCSortedDictionaryRef OCSortedDictionaryCreateCopy(OCSortedDictionaryRef theDictionary) {
+    if (theDictionary && !theDictionary->isMutable)
+        return (OCSortedDictionaryRef)OCRetain(theDictionary);
+    return impl_OCSortedDictionaryCreateCopy(theDictionary, false);
+}
+OCMutableSortedDictionaryRef OCSortedDictionaryCreateMutableCopy(OCSortedDictionaryRef theDictionary) {
+    return impl_OCSortedDictionaryCreateCopy(theDictionary, true);
+}
+// ——— Lookup ———
+uint64_t OCSortedDictionaryGetCount(OCSortedDictionaryRef theDictionary) {
+    return theDictionary ? theDictionary->count : 0;
+}
+const void *OCSortedDictionaryGetValue(OCSortedDictionaryRef theDictionary, const void *key) {
+    if (!theDictionary || !key)
+        return NULL;
+    const impl_OCSortedDictionaryNode *leaf = impl_OCSortedDictionaryFindLeaf(theDictionary, key);
+    if (!leaf)
+        return NULL;
+    uint32_t i = impl_OCSortedDictionaryLowerBound(theDictionary, leaf, key);
+    if (i == leaf->count || impl_OCSortedDictionaryCompare(theDictionary, leaf->keys[i], key) != kOCCompareEqualTo)
+        return NULL;
+    return leaf->slots[i];
+}
+bool OCSortedDictionaryContainsKey(OCSortedDictionaryRef theDictionary, const void *key) {
+    return OCSortedDictionaryGetValue(theDictionary, key) != NULL;
+}
+bool OCSortedDictionaryGetFloor(OCSortedDictionaryRef theDictionary, const void *key, const void **outKey,
+                                const void **outValue) {
+    if (!theDictionary || !key || !theDictionary->root)
+        return false;
+    // The floor is in the leaf key leads to unless every key there is
+    // greater, which happens once a separator's own key has been removed; it
+    // is then the last entry of the nearest subtree passed on the left.
+    const impl_OCSortedDictionaryNode *node = theDictionary->root;
+    const impl_OCSortedDictionaryNode *left = NULL;
+    while (!node->isLeaf) {
+        uint32_t c = impl_OCSortedDictionaryUpperBound(theDictionary, node, key);
+        if (c > 0)
+            left = node->slots[c - 1];
+        node = node->slots[c];
+    }
+    uint32_t i = impl_OCSortedDictionaryUpperBound(theDictionary, node, key);
+    if (i == 0) {
+        if (!left)
+            return false;
+        node = left;
+        while (!node->isLeaf)
+            node = node->slots[node->count];
+        i = node->count;
+    }
+    if (outKey)
+        *outKey = node->keys[i - 1];
+    if (outValue)
+        *outValue = node->slots[i - 1];
+    return true;
+}
+bool OCSortedDictionaryGetCeiling(OCSortedDictionaryRef theDictionary, const void *key, const void **outKey,
+                                  const void **outValue) {
+    OCSortedDictionaryCursor cursor;
+    if (!key)
+        return false;
+    OCSortedDictionaryCursorInit(&cursor, theDictionary, key, NULL);
+    return OCSortedDictionaryCursorNext(&cursor, outKey, outValue);
+}
+// ——— Insertion ———
+typedef struct {
+    impl_OCSortedDictionaryNode *right;  // new right sibling, or NULL if the node did not split
+    const void *separator;               // retained smallest key under right
+} impl_OCSortedDictionarySplit;
+static void impl_OCSortedDictionaryLeafInsertAt(impl_OCSortedDictionaryNode *leaf, uint32_t i, const void *key,
+                                                const void *value) {
+    memmove(leaf->keys + i + 1, leaf->keys + i, (leaf->count - i) * sizeof(const void *));
+    memmove(leaf->slots + i + 1, leaf->slots + i, (leaf->count - i) * sizeof(void *));
+    leaf->keys[i] = key;
+    leaf->slots[i] = (void *)value;
+    leaf->count++;
+}
+// Inserts or replaces in the subtree under node. Returns -1 on failure, 0 if
+// the key was present and 1 if an entry was added; when node had to split,
+// split receives its new right sibling.
+static int impl_OCSortedDictionaryInsert(struct impl_OCSortedDictionary *dict, impl_OCSortedDictionaryNode *node,
+                                         const void *key, const void *value, impl_OCSortedDictionarySplit *split) {
+    if (node->isLeaf) {
+        uint32_t i = impl_OCSortedDictionaryLowerBound(dict, node, key);
+        if (i < node->count && impl_OCSortedDictionaryCompare(dict, node->keys[i], key) == kOCCompareEqualTo) {
+            OCTypeRef old = node->slots[i];
+            node->slots[i] = (void *)OCRetain(value);
+            OCRelease(old);
+            return 0;
+        }
+        OCTypeRef keyCopy = impl_OCDictionaryCopyKey(key);
+        if (!keyCopy) {
+            fprintf(stderr, "OCSortedDictionarySetValue: Failed to copy key.\n");
+            return -1;
+        }
+        if (node->count < kOCSortedDictionaryMaxKeys) {
+            impl_OCSortedDictionaryLeafInsertAt(node, i, keyCopy, OCRetain(value));
+            return 1;
+        }
+        impl_OCSortedDictionaryNode *right = impl_OCSortedDictionaryNodeCreate(true);
+        if (!right) {
+            OCRelease(keyCopy);
+            return -1;
+        }
+        // Split so that both halves hold (kOCSortedDictionaryMaxKeys + 1) / 2
+        // entries once the new one is in
+        uint32_t half = (kOCSortedDictionaryMaxKeys + 1) / 2;
+        uint32_t from = i < half ? half - 1 : half;
+        right->count = node->count - from;
+        memcpy(right->keys, node->keys + from, right->count * sizeof(const void *));
+        memcpy(right->slots, node->slots + from, right->count * sizeof(void *));
+        node->count = from;
+        right->slots[kOCSortedDictionaryMaxKeys] = node->slots[kOCSortedDictionaryMaxKeys];
+        node->slots[kOCSortedDictionaryMaxKeys] = right;
+        if (i < half)
+            impl_OCSortedDictionaryLeafInsertAt(node, i, keyCopy, OCRetain(value));
+        else
+            impl_OCSortedDictionaryLeafInsertAt(right, i - from, keyCopy, OCRetain(value));
+        split->right = right;
+        split->separator = OCRetain(right->keys[0]);
+        return 1;
+    }
+    // A full node needs its sibling ready before the child below can split,
+    // so that a failed allocation leaves the tree untouched
+    impl_OCSortedDictionaryNode *spare = NULL;
+    if (node->count == kOCSortedDictionaryMaxKeys && !(spare = impl_OCSortedDictionaryNodeCreate(false)))
+        return -1;
+    uint32_t c = impl_OCSortedDictionaryUpperBound(dict, node, key);
+    impl_OCSortedDictionarySplit below = {NULL, NULL};
+    int added = impl_OCSortedDictionaryInsert(dict, node->slots[c], key, value, &below);
+    if (added < 0 || !below.right) {
+        impl_OCSortedDictionaryNodeFree(spare);
+        return added;
+    }
+    if (!spare) {
+        memmove(node->keys + c + 1, node->keys + c, (node->count - c) * sizeof(const void *));
+        memmove(node->slots + c + 2, node->slots + c + 1, (node->count - c) * sizeof(void *));
+        node->keys[c] = below.separator;
+        node->slots[c + 1] = below.right;
+        node->count++;
+        return added;
+    }
+    // Lay out the kOCSortedDictionaryMaxKeys + 1 separators and their
+    // children in order, keep the first half, push the middle separator up
+    // and move the rest to the sibling
+    const void *keys[kOCSortedDictionaryMaxKeys + 1];
+    void *children[kOCSortedDictionaryMaxKeys + 2];
+    memcpy(keys, node->keys, c * sizeof(const void *));
+    keys[c] = below.separator;
+    memcpy(keys + c + 1, node->keys + c, (node->count - c) * sizeof(const void *));
+    memcpy(children, node->slots, (c + 1) * sizeof(void *));
+    children[c + 1] = below.right;
+    memcpy(children + c + 2, node->slots + c + 1, (node->count - c) * sizeof(void *));
+    uint32_t half = (kOCSortedDictionaryMaxKeys + 1) / 2;
+    node->count = half;
+    memcpy(node->keys, keys, half * sizeof(const void *));
+    memcpy(node->slots, children, (half + 1) * sizeof(void *));
+    spare->count = kOCSortedDictionaryMaxKeys - half;
+    memcpy(spare->keys, keys + half + 1, spare->count * sizeof(const void *));
+    memcpy(spare->slots, children + half + 1, (spare->count + 1) * sizeof(void *));
+    split->right = spare;
+    split->separator = keys[half];
+    return added;
+}
+bool OCSortedDictionarySetValue(OCMutableSortedDictionaryRef theDictionary, const void *key, const void *value) {
+    if (!theDictionary || !key || !value)
+        return false;
+    if (!theDictionary->isMutable) {
+        fprintf(stderr, "OCSortedDictionarySetValue: Dictionary is immutable.\n");
+        return false;
+    }
+    if (!theDictionary->root && !(theDictionary->root = impl_OCSortedDictionaryNodeCreate(true)))
+        return false;
+    impl_OCSortedDictionaryNode *root = theDictionary->root;
+    impl_OCSortedDictionaryNode *spare = NULL;
+    if (root->count == kOCSortedDictionaryMaxKeys && !(spare = impl_OCSortedDictionaryNodeCreate(false)))
+        return false;
+    impl_OCSortedDictionarySplit split = {NULL, NULL};
+    int added = impl_OCSortedDictionaryInsert(theDictionary, root, key, value, &split);
+    if (split.right) {
+        // The root split, so the tree grows a level
+        spare->count = 1;
+        spare->keys[0] = split.separator;
+        spare->slots[0] = root;
+        spare->slots[1] = split.right;
+        theDictionary->root = spare;
+    } else {
+        impl_OCSortedDictionaryNodeFree(spare);
+    }
+    if (added < 0)
+        return false;
+    theDictionary->count += (uint64_t)added;
+    return true;
+}
+// ——— Removal ———
+// Merges the child right of separator i into the child left of it
+static void impl_OCSortedDictionaryMerge(impl_OCSortedDictionaryNode *parent, uint32_t i) {
+    impl_OCSortedDictionaryNode *left = parent->slots[i];
+    impl_OCSortedDictionaryNode *right = parent->slots[i + 1];
+    if (left->isLeaf) {
+        memcpy(left->keys + left->count, right->keys, right->count * sizeof(const void *));
+        memcpy(left->slots + left->count, right->slots, right->count * sizeof(void *));
+        left->count += right->count;
+        left->slots[kOCSortedDictionaryMaxKeys] = right->slots[kOCSortedDictionaryMaxKeys];
+        OCRelease(parent->keys[i]);
+    } else {
+        // The separator comes down between the two halves
+        left->keys[left->count] = parent->keys[i];
+        memcpy(left->keys + left->count + 1, right->keys, right->count * sizeof(const void *));
+        memcpy(left->slots + left->count + 1, right->slots, (right->count + 1) * sizeof(void *));
+        left->count += right->count + 1;
+    }
+    impl_OCSortedDictionaryNodeFree(right);
+    memmove(parent->keys + i, parent->keys + i + 1, (parent->count - i - 1) * sizeof(const void *));
+    memmove(parent->slots + i + 1, parent->slots + i + 2, (parent->count - i - 1) * sizeof(void *));
+    parent->count--;
+}
+// Brings child c of parent back to the minimum fill, borrowing an entry from
+// a sibling that can spare one or else merging with a sibling
+static void impl_OCSortedDictionaryRebalance(impl_OCSortedDictionaryNode *parent, uint32_t c) {
+    impl_OCSortedDictionaryNode *child = parent->slots[c];
+    impl_OCSortedDictionaryNode *left = c > 0 ? parent->slots[c - 1] : NULL;
+    impl_OCSortedDictionaryNode *right = c < parent->count ? parent->slots[c + 1] : NULL;
+    if (left && left->count > kOCSortedDictionaryMinKeys) {
+        memmove(child->keys + 1, child->keys, child->count * sizeof(const void *));
+        if (child->isLeaf) {
+            memmove(child->slots + 1, child->slots, child->count * sizeof(void *));
+            child->keys[0] = left->keys[left->count - 1];
+            child->slots[0] = left->slots[left->count - 1];
+            OCRelease(parent->keys[c - 1]);
+            parent->keys[c - 1] = OCRetain(child->keys[0]);
+        } else {
+            memmove(child->slots + 1, child->slots, (child->count + 1) * sizeof(void *));
+            child->keys[0] = parent->keys[c - 1];
+            child->slots[0] = left->slots[left->count];
+            parent->keys[c - 1] = left->keys[left->count - 1];
+        }
+        left->count--;
+        child->count++;
+    } else if (right && right->count > kOCSortedDictionaryMinKeys) {
+        if (child->isLeaf) {
+            child->keys[child->count] = right->keys[0];
+            child->slots[child->count] = right->slots[0];
+            memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(const void *));
+            memmove(right->slots, right->slots + 1, (right->count - 1) * sizeof(void *));
+            OCRelease(parent->keys[c]);
+            parent->keys[c] = OCRetain(right->keys[0]);
+        } else {
+            child->keys[child->count] = parent->keys[c];
+            child->slots[child->count + 1] = right->slots[0];
+            parent->keys[c] = right->keys[0];
+            memmove(right->keys, right->keys + 1, (right->count - 1) * sizeof(const void *));
+            memmove(right->slots, right->slots + 1, right->count * sizeof(void *));
+        }
+        right->count--;
+        child->count++;
+    } else {
+        impl_OCSortedDictionaryMerge(parent, left ? c - 1 : c);
+    }
+}
+static bool impl_OCSortedDictionaryRemove(struct impl_OCSortedDictionary *dict, impl_OCSortedDictionaryNode *node,
+                                          const void *key) {
+    if (node->isLeaf) {
+        uint32_t i = impl_OCSortedDictionaryLowerBound(dict, node, key);
+        if (i == node->count || impl_OCSortedDictionaryCompare(dict, node->keys[i], key) != kOCCompareEqualTo)
+            return false;
+        OCRelease(node->keys[i]);
+        OCRelease(node->slots[i]);
+        memmove(node->keys + i, node->keys + i + 1, (node->count - i - 1) * sizeof(const void *));
+        memmove(node->slots + i, node->slots + i + 1, (node->count - i - 1) * sizeof(void *));
+        node->count--;
+        return true;
+    }
+    uint32_t c = impl_OCSortedDictionaryUpperBound(dict, node, key);
+    if (!impl_OCSortedDictionaryRemove(dict, node->slots[c], key))
+        return false;
+    if (((impl_OCSortedDictionaryNode *)node->slots[c])->count < kOCSortedDictionaryMinKeys)
+        impl_OCSortedDictionaryRebalance(node, c);
+    return true;
+}
+bool OCSortedDictionaryRemoveValue(OCMutableSortedDictionaryRef theDictionary, const void *key) {
+    if (!theDictionary || !key)
+        return false;
+    if (!theDictionary->isMutable) {
+        fprintf(stderr, "OCSortedDictionaryRemoveValue: Dictionary is immutable.\n");
+        return false;
+    }
+    impl_OCSortedDictionaryNode *root = theDictionary->root;
+    if (!root || !impl_OCSortedDictionaryRemove(theDictionary, root, key))
+        return false;
+    theDictionary->count--;
+    // A root left with a single child hands over to it; an empty leaf root goes
+    if (!root->isLeaf && root->count == 0) {
+        theDictionary->root = root->slots[0];
+        impl_OCSortedDictionaryNodeFree(root);
+    } else if (root->isLeaf && root->count == 0) {
+        theDictionary->root = NULL;
+        impl_OCSortedDictionaryNodeFree(root);
+    }
+    return true;
+}
+// ——— Walking ———
+void OCSortedDictionaryCursorInit(OCSortedDictionaryCursor *cursor, OCSortedDictionaryRef theDictionary,
+                                  const void *lowKey, const void *highKey) {
+    if (!cursor)
+        return;
+    cursor->dictionary = theDictionary;
+    cursor->leaf = NULL;
+    cursor->index = 0;
+    cursor->highKey = highKey;
+    if (!theDictionary)
+        return;
+    if (!lowKey) {
+        cursor->leaf = impl_OCSortedDictionaryFirstLeaf(theDictionary);
+        return;
+    }
+    const impl_OCSortedDictionaryNode *leaf = impl_OCSortedDictionaryFindLeaf(theDictionary, lowKey);
+    cursor->leaf = leaf;
+    if (leaf)
+        cursor->index = impl_OCSortedDictionaryLowerBound(theDictionary, leaf, lowKey);
+}
+bool OCSortedDictionaryCursorNext(OCSortedDictionaryCursor *cursor, const void **outKey, const void **outValue) {
+    if (!cursor || !cursor->leaf)
+        return false;
+    const impl_OCSortedDictionaryNode *leaf = cursor->leaf;
+    if (cursor->index >= leaf->count) {
+        // Only the root leaf can be short of entries, and it has no successor
+        leaf = impl_OCSortedDictionaryNextLeaf(leaf);
+        cursor->leaf = leaf;
+        cursor->index = 0;
+        if (!leaf)
+            return false;
+    }
+    const void *key = leaf->keys[cursor->index];
+    if (cursor->highKey &&
+        impl_OCSortedDictionaryCompare(cursor->dictionary, key, cursor->highKey) != kOCCompareLessThan) {
+        cursor->leaf = NULL;
+        return false;
+    }
+    if (outKey)
+        *outKey = key;
+    if (outValue)
+        *outValue = leaf->slots[cursor->index];
+    cursor->index++;
+    return true;
+}
+void OCSortedDictionaryApplyFunction(OCSortedDictionaryRef theDictionary, const void *lowKey, const void *highKey,
+                                     OCSortedDictionaryApplierFunction applier, void *context) {
+    if (!theDictionary || !applier)
+        return;
+    OCSortedDictionaryCursor cursor;
+    const void *key, *value;
+    OCSortedDictionaryCursorInit(&cursor, theDictionary, lowKey, highKey);
+    while (OCSortedDictionaryCursorNext(&cursor, &key, &value))
+        applier(key, value, context);
+}
+// ——— JSON ———
+cJSON *OCSortedDictionaryCopyAsJSON(OCSortedDictionaryRef theDictionary, bool typed, OCStringRef *outError) {
+    if (outError) *outError = NULL;
+    if (!theDictionary) {
+        if (outError) *outError = STR("OCSortedDictionary is NULL");
+        return cJSON_CreateNull();
+    }
+    cJSON *pairs = cJSON_CreateArray();
+    if (!pairs) {
+        if (outError) *outError = STR("Failed to create JSON array");
+        return cJSON_CreateNull();
+    }
+    OCSortedDictionaryCursor cursor;
+    const void *key, *value;
+    OCSortedDictionaryCursorInit(&cursor, theDictionary, NULL, NULL);
+    while (OCSortedDictionaryCursorNext(&cursor, &key, &value)) {
+        cJSON *pair = cJSON_CreateArray();
+        cJSON *keyJSON = OCTypeCopyJSON(key, typed, outError);
+        cJSON *valueJSON = keyJSON ? OCTypeCopyJSON(value, typed, outError) : NULL;
+        if (!pair || !keyJSON || !valueJSON) {
+            if (outError && !*outError) *outError = STR("Failed to serialize OCSortedDictionary entry");
+            cJSON_Delete(pair);
+            cJSON_Delete(keyJSON);
+            cJSON_Delete(valueJSON);
+            cJSON_Delete(pairs);
+            return cJSON_CreateNull();
+        }
+        cJSON_AddItemToArray(pair, keyJSON);
+        cJSON_AddItemToArray(pair, valueJSON);
+        cJSON_AddItemToArray(pairs, pair);
+    }
+    if (!typed)
+        return pairs;
+    cJSON *entry = cJSON_CreateObject();
+    cJSON_AddStringToObject(entry, "type", "OCSortedDictionary");
+    cJSON_AddItemToObject(entry, "value", pairs);
+    return entry;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file OCSortedDictionary.h
+ * @brief Declares OCSortedDictionary and OCMutableSortedDictionary interfaces.
+ *
+ * OCSortedDictionary maps OCType keys to OCType values and keeps the keys in
+ * the order given by an OCComparatorFunction. It is a B+ tree, so lookups,
+ * inserts and removals take O(log n) comparisons and moves, and entries can
+ * be walked in key order from any starting key, unlike a sorted OCArray
+ * searched with OCArrayBSearchValues(), where every insert shifts the tail.
+ *
+ * @note Ownership follows CoreFoundation conventions:
+ *       The caller owns any object returned by functions with "Create" or
+ *       "Copy" in the name, and must call OCRelease().
+ */
+#ifndef OCSORTEDDICTIONARY_H
+#define OCSORTEDDICTIONARY_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "OCType.h"
+#include "cJSON.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @defgroup OCSortedDictionary OCSortedDictionary
+ * @brief APIs for maps from OCType keys to OCType values kept in key order.
+ *
+ * Keys are copied on insertion as OCDictionary copies them, so a key cannot
+ * change its place in the order; values are retained while stored. Two keys
+ * are the same key when the comparator finds them equal. The comparator must
+ * define a total order and must not change while the dictionary exists.
+ * @{
+ */
+/**
+ * @brief Returns the OCTypeID for OCSortedDictionary objects.
+ * @return Type identifier for OCSortedDictionary.
+ * @ingroup OCSortedDictionary
+ */
+OCTypeID OCSortedDictionaryGetTypeID(void);
+/**
+ * @brief Creates an empty mutable sorted dictionary.
+ *
+ * @param comparator Function ordering the keys (required).
+ * @param context Opaque pointer passed through to @p comparator.
+ * @return New OCMutableSortedDictionaryRef, or NULL on failure.
+ * @ingroup OCSortedDictionary
+ *
+ * @code
+ * static OCComparisonResult compareNames(const void *a, const void *b, void *context) {
+ *     return OCStringCompare((OCStringRef)a, (OCStringRef)b, 0);
+ * }
+ * OCMutableSortedDictionaryRef byName = OCSortedDictionaryCreateMutable(compareNames, NULL);
+ * @endcode
+ */
+OCMutableSortedDictionaryRef OCSortedDictionaryCreateMutable(OCComparatorFunction comparator, void *context);
+/**
+ * @brief Creates an immutable sorted dictionary from keys already in order.
+ *
+ * The tree is built bottom-up in a single pass with full nodes, which is
+ * much faster than inserting the entries one at a time.
+ *
+ * @param keys Keys in strictly ascending order under @p comparator.
+ * @param values Values matching @p keys.
+ * @param count Number of entries (may be 0).
+ * @param comparator Function ordering the keys (required).
+ * @param context Opaque pointer passed through to @p comparator.
+ * @return New OCSortedDictionaryRef, or NULL if the keys are out of order,
+ *         repeat a key, or on failure.
+ * @ingroup OCSortedDictionary
+ */
+OCSortedDictionaryRef OCSortedDictionaryCreate(const void **keys, const void **values, uint64_t count,
+                                               OCComparatorFunction comparator, void *context);
+/**
+ * @brief Creates an immutable copy of a sorted dictionary.
+ *
+ * Copying an immutable dictionary returns it retained.
+ *
+ * @param theDictionary Source dictionary.
+ * @return New OCSortedDictionaryRef, or NULL if the source is NULL or on error.
+ * @ingroup OCSortedDictionary
+ */
+OCSortedDictionaryRef OCSortedDictionaryCreateCopy(OCSortedDictionaryRef theDictionary);
+/**
+ * @brief Creates a mutable copy of a sorted dictionary.
+ *
+ * @param theDictionary Source dictionary.
+ * @return New OCMutableSortedDictionaryRef, or NULL if the source is NULL or on error.
+ * @ingroup OCSortedDictionary
+ */
+OCMutableSortedDictionaryRef OCSortedDictionaryCreateMutableCopy(OCSortedDictionaryRef theDictionary);
+/**
+ * @brief Gets the number of key-value pairs.
+ *
+ * @param theDictionary Dictionary to query.
+ * @return Count of entries.
+ * @ingroup OCSortedDictionary
+ */
+uint64_t OCSortedDictionaryGetCount(OCSortedDictionaryRef theDictionary);
+/**
+ * @brief Retrieves the value for a key.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to look up.
+ * @return Pointer to value (borrowed), or NULL if not found.
+ * @ingroup OCSortedDictionary
+ */
+const void *OCSortedDictionaryGetValue(OCSortedDictionaryRef theDictionary, const void *key);
+/**
+ * @brief Checks whether a key is present.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to test.
+ * @return true if the key is found, false otherwise.
+ * @ingroup OCSortedDictionary
+ */
+bool OCSortedDictionaryContainsKey(OCSortedDictionaryRef theDictionary, const void *key);
+/**
+ * @brief Finds the entry with the greatest key less than or equal to a key.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to compare against.
+ * @param outKey Optional; receives the stored key (borrowed).
+ * @param outValue Optional; receives the value (borrowed).
+ * @return true if such an entry exists, false otherwise.
+ * @ingroup OCSortedDictionary
+ */
+bool OCSortedDictionaryGetFloor(OCSortedDictionaryRef theDictionary, const void *key, const void **outKey,
+                                const void **outValue);
+/**
+ * @brief Finds the entry with the least key greater than or equal to a key.
+ *
+ * @param theDictionary Dictionary to search.
+ * @param key Key to compare against.
+ * @param outKey Optional; receives the stored key (borrowed).
+ * @param outValue Optional; receives the value (borrowed).
+ * @return true if such an entry exists, false otherwise.
+ * @ingroup OCSortedDictionary
+ */
+bool OCSortedDictionaryGetCeiling(OCSortedDictionaryRef theDictionary, const void *key, const void **outKey,
+                                  const void **outValue);
+/**
+ * @brief Adds or replaces the value for a key.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to set (copied when new).
+ * @param value Value to store (retained).
+ * @return true on success, false on failure.
+ * @ingroup OCSortedDictionary
+ */
+bool OCSortedDictionarySetValue(OCMutableSortedDictionaryRef theDictionary, const void *key, const void *value);
+/**
+ * @brief Removes a key and its value.
+ *
+ * @param theDictionary Dictionary to modify.
+ * @param key Key to remove.
+ * @return true if the key was found and removed, false otherwise.
+ * @ingroup OCSortedDictionary
+ */
+bool OCSortedDictionaryRemoveValue(OCMutableSortedDictionaryRef theDictionary, const void *key);
+/**
+ * @brief Callback invoked by OCSortedDictionaryApplyFunction() for each entry.
+ *
+ * @param key The entry's key (borrowed).
+ * @param value The entry's value (borrowed).
+ * @param context The context pointer passed to OCSortedDictionaryApplyFunction().
+ * @ingroup OCSortedDictionary
+ */
+typedef void (*OCSortedDictionaryApplierFunction)(const void *key, const void *value, void *context);
+/**
+ * @brief Calls a function for each entry with a key in [lowKey, highKey), in key order.
+ *
+ * The dictionary must not be mutated from inside @p applier.
+ *
+ * @param theDictionary Dictionary to walk.
+ * @param lowKey First key of the range, or NULL to start at the smallest key.
+ * @param highKey Key that ends the range (excluded), or NULL to run to the end.
+ * @param applier Function called for each entry.
+ * @param context Opaque pointer passed through to @p applier.
+ * @ingroup OCSortedDictionary
+ */
+void OCSortedDictionaryApplyFunction(OCSortedDictionaryRef theDictionary, const void *lowKey, const void *highKey,
+                                     OCSortedDictionaryApplierFunction applier, void *context);
+/**
+ * @brief Position within a sorted dictionary walk; declare it on the stack.
+ *
+ * The fields are private. Initialize with OCSortedDictionaryCursorInit() and
+ * advance with OCSortedDictionaryCursorNext(). A cursor does not retain its
+ * dictionary, and the dictionary must not be mutated while a cursor is in use.
+ * @ingroup OCSortedDictionary
+ */
+typedef struct OCSortedDictionaryCursor {
+    OCSortedDictionaryRef dictionary;
+    const void *leaf;
+    uint32_t index;
+    const void *highKey;
+} OCSortedDictionaryCursor;
+/**
+ * @brief Positions a cursor before the first entry with a key in [lowKey, highKey).
+ *
+ * Finding the first entry takes O(log n) comparisons; each step after that
+ * is O(1), plus one comparison when @p highKey is given.
+ *
+ * @param cursor Cursor to initialize.
+ * @param theDictionary Dictionary to walk (may be NULL, yielding no entries).
+ * @param lowKey First key of the range, or NULL to start at the smallest key.
+ * @param highKey Key that ends the range (excluded, and not retained), or NULL
+ *                to run to the end.
+ * @ingroup OCSortedDictionary
+ */
+void OCSortedDictionaryCursorInit(OCSortedDictionaryCursor *cursor, OCSortedDictionaryRef theDictionary,
+                                  const void *lowKey, const void *highKey);
+/**
+ * @brief Advances a cursor and returns the next entry in key order.
+ *
+ * @param cursor Cursor initialized with OCSortedDictionaryCursorInit().
+ * @param outKey Optional; receives the key (borrowed).
+ * @param outValue Optional; receives the value (borrowed).
+ * @return true if an entry was returned, false when the range is finished.
+ * @ingroup OCSortedDictionary
+ *
+ * @code
+ * OCSortedDictionaryCursor cursor;
+ * const void *key, *value;
+ * OCSortedDictionaryCursorInit(&cursor, byTime, start, end);
+ * while (OCSortedDictionaryCursorNext(&cursor, &key, &value)) {
+ *     // entries with start <= key < end, in order
+ * }
+ * @endcode
+ */
+bool OCSortedDictionaryCursorNext(OCSortedDictionaryCursor *cursor, const void **outKey, const void **outValue);
+/**
+ * @brief Creates a JSON representation of an OCSortedDictionary.
+ *
+ * Entries are written in key order as an array of [key, value] pairs. With
+ * typed=true the array is wrapped as {"type": "OCSortedDictionary",
+ * "value": [...]} and keys and values are serialized typed. There is no
+ * matching factory, since the comparator cannot be serialized.
+ *
+ * @param theDictionary Dictionary to serialize.
+ * @param typed Whether to include type information.
+ * @param outError Optional; receives an error description on failure.
+ * @return A new cJSON item, or cJSON null on failure.
+ * @ingroup OCSortedDictionary
+ */
+cJSON *OCSortedDictionaryCopyAsJSON(OCSortedDictionaryRef theDictionary, bool typed, OCStringRef *outError);
+/** @} */
+#ifdef __cplusplus
+}
+#endif
+#endif /* OCSORTEDDICTIONARY_H */
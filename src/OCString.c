@@ -8,6 +8,7 @@
 #include <stddef.h>  // ptrdiff_t, size_t
 #include <stdint.h>  // uint32_t
 #include <stdio.h>
+#include <pthread.h>
 #ifdef _WIN32
 #include <setjmp.h>  // For setjmp/longjmp
 #include <signal.h>  // For Windows signal handling
@@ -19,7 +20,24 @@
 #include "OCArray.h"       // For OCArrayCallBacks, OCArrayCreateMutable, etc.
 #include "OCData.h"        // For OCDataGetLength, OCDataGetBytesPtr
 #include "OCDictionary.h"  // For OCMutableDictionaryRef, OCDictionaryCreateMutable, etc.
+#include "OCIndexPairSet.h"  // For OCIndexPair match results
+#include "OCMath.h"          // For OCDoubleWriteShortestCString
+// SIMD intrinsics for the ASCII fast path of the UTF-8 scanners
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+#include <emmintrin.h>  // SSE2
+#ifndef HAVE_SSE2
+#define HAVE_SSE2 1
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#ifndef HAVE_NEON
+#define HAVE_NEON 1
+#endif
+#endif
 static OCMutableDictionaryRef impl_constantStringTable = NULL;
+// STR() may intern from any thread
+static pthread_mutex_t impl_constantStringTableLock = PTHREAD_MUTEX_INITIALIZER;
 // Forward declaration for OCStringFindWithOptions
 bool OCStringFindWithOptions(OCStringRef string, OCStringRef stringToFind, OCRange rangeToSearch, OCOptionFlags compareOptions, OCRange* result);
 // Forward declaration for getConstantStringTable
@@ -80,6 +98,90 @@ static uint32_t utf8_next(const char** p) {
     }
     return ch;
 }
+// ——— Length of the leading run of 7-bit ASCII bytes in s[0..n) ———
+// Scans 32 bytes per iteration (two SSE2/NEON vectors, or four machine words)
+// and only falls back to single bytes for the tail.
+static size_t oc_utf8_ascii_prefix(const char* s, size_t n) {
+    const unsigned char* p = (const unsigned char*)s;
+    size_t i = 0;
+#if defined(HAVE_SSE2)
+    for (; i + 32 <= n; i += 32) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 16));
+        int mask = _mm_movemask_epi8(_mm_or_si128(a, b));
+        if (mask) {
+            int ma = _mm_movemask_epi8(a);
+            return ma ? i + (size_t)__builtin_ctz((unsigned)ma)
+                      : i + 16 + (size_t)__builtin_ctz((unsigned)_mm_movemask_epi8(b));
+        }
+    }
+#elif defined(HAVE_NEON) && defined(__aarch64__)
+    for (; i + 32 <= n; i += 32) {
+        uint8x16_t a = vld1q_u8(p + i);
+        uint8x16_t b = vld1q_u8(p + i + 16);
+        if (vmaxvq_u8(vorrq_u8(a, b)) & 0x80) break;  // locate the byte below
+    }
+#else
+    for (; i + 32 <= n; i += 32) {
+        uint64_t w[4];
+        memcpy(w, p + i, sizeof(w));
+        if ((w[0] | w[1] | w[2] | w[3]) & UINT64_C(0x8080808080808080)) break;
+    }
+#endif
+    for (; i < n; i++) {
+        if (p[i] & 0x80) return i;
+    }
+    return n;
+}
+// ——— True if the first n bytes of s are all 7-bit ASCII ———
+static inline bool oc_utf8_is_ascii(const char* s, size_t n) {
+    return oc_utf8_ascii_prefix(s, n) == n;
+}
+// ——— Strictly validate n bytes of UTF-8 ———
+// Rejects stray continuation bytes, truncated sequences, overlong encodings,
+// UTF-16 surrogates and code points above U+10FFFF. On failure stores the
+// byte offset of the first invalid sequence in *errorOffset.
+static bool oc_utf8_validate(const char* s, size_t n, size_t* errorOffset) {
+    const unsigned char* p = (const unsigned char*)s;
+    size_t i = 0;
+    while (i < n) {
+        i += oc_utf8_ascii_prefix(s + i, n - i);
+        if (i >= n) break;
+        unsigned char c = p[i];
+        size_t need;
+        unsigned char lo = 0x80, hi = 0xBF;  // allowed range of the first continuation byte
+        if (c >= 0xC2 && c <= 0xDF) {
+            need = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            need = 2;
+            if (c == 0xE0) lo = 0xA0;       // overlong
+            else if (c == 0xED) hi = 0x9F;  // surrogates
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            need = 3;
+            if (c == 0xF0) lo = 0x90;       // overlong
+            else if (c == 0xF4) hi = 0x8F;  // > U+10FFFF
+        } else {
+            if (errorOffset) *errorOffset = i;
+            return false;
+        }
+        if (i + need >= n) {  // truncated sequence
+            if (errorOffset) *errorOffset = i;
+            return false;
+        }
+        if (p[i + 1] < lo || p[i + 1] > hi) {
+            if (errorOffset) *errorOffset = i;
+            return false;
+        }
+        for (size_t k = 2; k <= need; k++) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                if (errorOffset) *errorOffset = i;
+                return false;
+            }
+        }
+        i += need + 1;
+    }
+    return true;
+}
 // ——— Map a code-point index to its byte offset in the UTF-8 string ———
 static ptrdiff_t oc_utf8_offset_for_index(const char* s, size_t idx) {
     const char* p = s;
@@ -94,9 +196,10 @@ static ptrdiff_t oc_utf8_offset_for_index(const char* s, size_t idx) {
     // Allow pointing just past the last code-point
     return (idx == count) ? (p - s) : -1;
 }
-// ——— Count the number of Unicode code-points in a UTF-8 string ———
-static size_t oc_utf8_strlen(const char* s) {
+// ——— Count the number of Unicode code-points in the first n bytes of a UTF-8 string ———
+static size_t oc_utf8_strlen_n(const char* s, size_t n) {
     const char* p = s;
+    const char* end = s + n;
     size_t len = 0;
     uint32_t cp = 0;
     bool in_emoji_sequence = false;
@@ -104,7 +207,16 @@ static size_t oc_utf8_strlen(const char* s) {
     // 1. Combining characters (e.g., é̀́)
     // 2. Emoji ZWJ sequences (e.g., 👨‍👩‍👧‍👦)
     // 3. Regional indicators for flag emojis (e.g., 🇺🇸)
-    while (*p) {
+    // Runs of ASCII are counted in bulk; the grapheme rules below only see
+    // the non-ASCII stretches (and the ASCII byte following a ZWJ).
+    while (p < end && *p) {
+        if (!in_emoji_sequence && !((unsigned char)*p & 0x80)) {
+            size_t run = oc_utf8_ascii_prefix(p, (size_t)(end - p));
+            len += run;
+            p += run;
+            cp = (unsigned char)p[-1];
+            continue;
+        }
         uint32_t prev_cp = cp;
         cp = utf8_next(&p);
         // Skip counting if this is a combining character (0x0300-0x036F, 0x1AB0-0x1AFF, 0x1DC0-0x1DFF, 0x20D0-0x20FF, 0xFE20-0xFE2F)
@@ -133,7 +245,7 @@ static size_t oc_utf8_strlen(const char* s) {
         // If we were in emoji sequence and this isn't a continuation,
         // count it as one emoji
         if (in_emoji_sequence) {
-            if (*p && utf8_next(&p) != 0x200D) {
+            if (p < end && *p && utf8_next(&p) != 0x200D) {
                 // End of sequence
                 in_emoji_sequence = false;
             }
@@ -143,64 +255,106 @@ static size_t oc_utf8_strlen(const char* s) {
     }
     return len;
 }
-// ——— Helper: replace all occurrences of a C‐string ———
-// Returns a newly malloc’d buffer, and sets *count to the number of replacements.
-// The returned buffer always has enough space for the final string + '\0'.
-static char* str_replace(const char* orig,
-                         const char* rep,
-                         const char* with,
-                         int64_t* count) {
-    const char* ins = orig;
-    char* result;
-    char* tmp;
-    size_t len_rep = strlen(rep);
-    size_t len_with = strlen(with);
-    size_t orig_len = strlen(orig);
-    int64_t n = 0;
-    if (len_rep == 0) {
-        *count = 0;
-        return NULL;  // nothing to replace
-    }
-    // 1) Count occurrences of 'rep' in 'orig'
-    while ((ins = strstr(ins, rep))) {
+// ——— Byte-level substring search ———
+// Short needles use memchr to jump between candidate first bytes and memcmp to
+// confirm; needles of OC_SEARCH_HORSPOOL_MIN bytes or more use Boyer-Moore-
+// Horspool. With 'fold' set, ASCII letters compare case-insensitively without
+// building lower-cased copies (bytes >= 0x80 are never folded, so UTF-8
+// sequences still match exactly).
+#define OC_SEARCH_HORSPOOL_MIN 8
+typedef struct {
+    const unsigned char* needle;
+    size_t length;
+    bool fold;
+    size_t skip[256];  // only filled for Horspool-sized needles
+} oc_searcher;
+static inline unsigned char oc_ascii_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+static bool oc_bytes_equal_folded(const unsigned char* a, const unsigned char* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (oc_ascii_fold(a[i]) != oc_ascii_fold(b[i])) return false;
+    }
+    return true;
+}
+static void oc_searcher_init(oc_searcher* sr, const char* needle, size_t length, bool fold) {
+    sr->needle = (const unsigned char*)needle;
+    sr->length = length;
+    sr->fold = fold;
+    if (length < OC_SEARCH_HORSPOOL_MIN) return;
+    for (size_t c = 0; c < 256; c++) sr->skip[c] = length;
+    for (size_t i = 0; i + 1 < length; i++) {
+        unsigned char c = sr->needle[i];
+        sr->skip[c] = length - 1 - i;
+        if (fold) {
+            unsigned char f = oc_ascii_fold(c);
+            sr->skip[f] = length - 1 - i;
+            if (f >= 'a' && f <= 'z') sr->skip[f - ('a' - 'A')] = length - 1 - i;
+        }
+    }
+}
+// Returns the offset of the first match in hay[from..n), or -1.
+static ptrdiff_t oc_searcher_find(const oc_searcher* sr, const char* hay, size_t n, size_t from) {
+    const unsigned char* h = (const unsigned char*)hay;
+    const unsigned char* nd = sr->needle;
+    size_t m = sr->length;
+    if (m == 0 || n < m || from > n - m) return -1;
+    size_t last = n - m;  // last possible start
+    if (m >= OC_SEARCH_HORSPOOL_MIN) {
+        size_t i = from;
+        unsigned char tail = sr->fold ? oc_ascii_fold(nd[m - 1]) : nd[m - 1];
+        while (i <= last) {
+            unsigned char c = h[i + m - 1];
+            unsigned char cmp = sr->fold ? oc_ascii_fold(c) : c;
+            if (cmp == tail &&
+                (sr->fold ? oc_bytes_equal_folded(h + i, nd, m - 1) : memcmp(h + i, nd, m - 1) == 0)) {
+                return (ptrdiff_t)i;
+            }
+            i += sr->skip[c];
+        }
+        return -1;
+    }
+    if (!sr->fold) {
+        size_t i = from;
+        while (i <= last) {
+            const unsigned char* p = memchr(h + i, nd[0], last - i + 1);
+            if (!p) return -1;
+            i = (size_t)(p - h);
+            if (memcmp(p + 1, nd + 1, m - 1) == 0) return (ptrdiff_t)i;
+            i++;
+        }
+        return -1;
+    }
+    unsigned char first = oc_ascii_fold(nd[0]);
+    for (size_t i = from; i <= last; i++) {
+        if (oc_ascii_fold(h[i]) == first && oc_bytes_equal_folded(h + i + 1, nd + 1, m - 1)) {
+            return (ptrdiff_t)i;
+        }
+    }
+    return -1;
+}
+// ——— Number of code points (utf8_next steps) between two positions ———
+static size_t oc_utf8_count_between(const char* p, const char* q) {
+    size_t n = 0;
+    while (p < q) {
+        size_t run = oc_utf8_ascii_prefix(p, (size_t)(q - p));
+        n += run;
+        p += run;
+        if (p >= q) break;
+        utf8_next(&p);
         n++;
-        ins += len_rep;
-    }
-    *count = n;
-    // 2) Compute new length safely: if 'with' is longer, we add the extra;
-    //    otherwise we leave orig_len (allocating a bit more than strictly needed
-    //    but never less).
-    size_t delta = (len_with > len_rep)
-                       ? (len_with - len_rep)
-                       : 0;
-    size_t new_len = orig_len + delta * n;
-    // 3) Allocate new buffer (+1 for NUL)
-    result = malloc(new_len + 1);
-    if (NULL == result) {
-        fprintf(stderr, "str_replace: Memory allocation failed.\n");
-        *count = 0;
-        return NULL;
     }
-    // 4) Perform the replacement pass
-    tmp = result;
-    ins = orig;
-    while (n--) {
-        const char* pos = strstr(ins, rep);
-        size_t front = pos - ins;
-        // copy up to the match
-        memcpy(tmp, ins, front);
-        tmp += front;
-        // copy the replacement
-        memcpy(tmp, with, len_with);
-        tmp += len_with;
-        // advance past the matched segment
-        ins += front + len_rep;
-    }
-    // 5) Copy any remaining text (including the final '\0')
-    memcpy(tmp, ins, strlen(ins) + 1);
-    return result;
+    return n;
 }
 static OCTypeID kOCStringID = kOCNotATypeID;
+// Sparse code-point index: offsets[k] is the byte offset of code point
+// k*OC_UTF8_INDEX_STRIDE. A complete table reaches the end of the string.
+typedef struct impl_OCStringIndex {
+    uint64_t count;
+    uint64_t capacity;
+    bool complete;
+    uint64_t offsets[];
+} impl_OCStringIndex;
 // OCString Opaque Type
 struct impl_OCString {
     OCBase base;
@@ -208,7 +362,481 @@ struct impl_OCString {
     char* string;
     uint64_t length;
     uint64_t capacity;
+    // Indexing support: ASCII strings index bytes directly; other strings use a
+    // sparse table of byte offsets, one every OC_UTF8_INDEX_STRIDE code points,
+    // built by the first lookup. An immutable string may be shared, so its
+    // table is built whole and published once; a mutable string's table is
+    // trimmed by edits and completed again in place.
+    bool isASCII;
+    impl_OCStringIndex* utf8Index;
+    // Borrowed storage: an immutable substring of an immutable string, or a
+    // string over an OCData's bytes, retains the object that owns the bytes as
+    // 'parent' and points 'string' into its buffer (not NUL-terminated), with
+    // 'capacity' holding the byte count. A view is never rewritten in place:
+    // it may be read from several threads, so a C string request that needs a
+    // terminator gets 'cString', a terminated copy published once and kept
+    // until finalize. Copies of a mutable string are views of an immutable
+    // string that took over its buffer, and so is the mutable string itself
+    // until it next changes, when it takes the bytes over.
+    bool isMutable;
+    OCTypeRef parent;
+    char* cString;
+    // Parsed form of this string when used as a format (immutable strings only)
+    struct impl_OCCompiledFormat* compiledFormat;
+    // Rope builders keep their text in a tree of chunks while appends, inserts
+    // and deletes are applied; 'string' is NULL until the rope is flattened.
+    bool usesRope;
+    struct impl_OCRope* rope;
+};
+#define OC_UTF8_INDEX_STRIDE 64
+// ——— Drop sparse index entries that an edit starting at byteOffset may invalidate ———
+// utf8_next may look up to three bytes past a code point's first byte, so an entry
+// is only kept if every byte consulted while reaching it lies before the edit.
+static void impl_OCStringInvalidateIndexFrom(struct impl_OCString* s, size_t byteOffset) {
+    if (s->compiledFormat) {
+        free(s->compiledFormat);
+        s->compiledFormat = NULL;
+    }
+    impl_OCStringIndex* index = s->utf8Index;
+    if (!index) return;
+    while (index->count > 1 && index->offsets[index->count - 1] + 4 > byteOffset) {
+        index->count--;
+    }
+    index->complete = false;
+}
+static void impl_OCStringResetIndex(struct impl_OCString* s, bool isASCII) {
+    if (s->compiledFormat) {
+        free(s->compiledFormat);
+        s->compiledFormat = NULL;
+    }
+    s->isASCII = isASCII;
+    if (s->utf8Index) {
+        s->utf8Index->count = 1;
+        s->utf8Index->complete = false;
+    }
+}
+// ——— Number of content bytes, without requiring NUL termination ———
+static inline size_t impl_OCStringByteLength(OCStringRef s) {
+    return s->parent ? (size_t)s->capacity : strlen(s->string);
+}
+static bool impl_OCStringFlatten(OCStringRef str);
+// ——— Give a view its own NUL-terminated buffer and drop the parent ———
+// For writers only: this rewrites the string, so it must not be reached from
+// a read of a string other threads may hold (see impl_OCStringReadCString).
+static const char* impl_OCStringCString(OCStringRef str) {
+    struct impl_OCString* s = (struct impl_OCString*)str;
+    if (s->rope && !impl_OCStringFlatten(str)) return NULL;
+    if (!s->parent) return s->string;
+    if (OCGetTypeID(s->parent) == OCStringGetTypeID() && OCTypeGetRetainCount(s->parent) == 1) {
+        // Nothing else shares the buffer; take it over if the view covers all of it
+        struct impl_OCString* root = (struct impl_OCString*)s->parent;
+        if (root->string == s->string && s->string[s->capacity] == '\0') {
+            s->capacity = root->capacity;
+            root->string = NULL;
+            s->parent = NULL;
+            OCRelease(root);
+            return s->string;
+        }
+    }
+    char* buf = malloc(s->capacity + 1);
+    if (NULL == buf) {
+        fprintf(stderr, "OCStringGetCString: Memory allocation failed for substring buffer.\n");
+        return NULL;
+    }
+    memcpy(buf, s->string, s->capacity);
+    buf[s->capacity] = '\0';
+    OCTypeRef parent = s->parent;
+    s->string = buf;  // byte offsets are unchanged, so the UTF-8 index stays valid
+    s->parent = NULL;
+    OCRelease(parent);
+    return s->string;
+}
+// ——— NUL-terminated bytes for reading ———
+// Immutable strings are shared between threads, so a view is left as it is:
+// when its bytes are not already terminated a copy is made and published
+// with a compare-and-swap, and a reader that loses the race uses the
+// winner's. Mutable strings are not shared and take their bytes over.
+static const char* impl_OCStringReadCString(OCStringRef str) {
+    struct impl_OCString* s = (struct impl_OCString*)str;
+    if (!s->parent) return impl_OCStringCString(str);
+    // A view that runs to the end of its string's buffer is already terminated
+    if (OCGetTypeID(s->parent) == OCStringGetTypeID() && s->string[s->capacity] == '\0') return s->string;
+    if (s->isMutable) return impl_OCStringCString(str);
+#if defined(__GNUC__) || defined(__clang__)
+    char* published = __atomic_load_n(&s->cString, __ATOMIC_ACQUIRE);
+#else
+    char* published = s->cString;
+#endif
+    if (published) return published;
+    char* buf = malloc(s->capacity + 1);
+    if (NULL == buf) {
+        fprintf(stderr, "OCStringGetCString: Memory allocation failed for substring buffer.\n");
+        return NULL;
+    }
+    memcpy(buf, s->string, s->capacity);
+    buf[s->capacity] = '\0';
+#if defined(__GNUC__) || defined(__clang__)
+    if (!__atomic_compare_exchange_n(&s->cString, &published, buf, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(buf);
+        return published;
+    }
+#else
+    s->cString = buf;
+#endif
+    return buf;
+}
+// ——— Record every stride boundary past the table's last entry ———
+// Starts a table when index is NULL. Returns the table, which may have
+// moved, or NULL after freeing it if it could not grow.
+static impl_OCStringIndex* impl_OCStringIndexComplete(const char* bytes, size_t byteCount, impl_OCStringIndex* index) {
+    if (!index) {
+        index = malloc(sizeof(impl_OCStringIndex) + 16 * sizeof(uint64_t));
+        if (!index) return NULL;
+        index->capacity = 16;
+        index->offsets[0] = 0;
+        index->count = 1;
+    }
+    const char* p = bytes + index->offsets[index->count - 1];
+    const char* end = bytes + byteCount;
+    unsigned step = 0;
+    while (p < end) {
+        utf8_next(&p);
+        if (++step < OC_UTF8_INDEX_STRIDE) continue;
+        step = 0;
+        if (index->count == index->capacity) {
+            uint64_t newCap = index->capacity * 2;
+            impl_OCStringIndex* table = realloc(index, sizeof(impl_OCStringIndex) + newCap * sizeof(uint64_t));
+            if (!table) {
+                free(index);
+                return NULL;
+            }
+            index = table;
+            index->capacity = newCap;
+        }
+        index->offsets[index->count++] = (uint64_t)(p - bytes);
+    }
+    index->complete = true;
+    return index;
+}
+// ——— Map a code-point index to its byte offset, using the ASCII flag or sparse index ———
+static ptrdiff_t impl_OCStringOffsetForIndex(OCStringRef str, uint64_t idx) {
+    struct impl_OCString* s = (struct impl_OCString*)str;
+    if (!s->string) return -1;
+    if (s->isASCII) {
+        // One byte per code point
+        return (idx <= s->length) ? (ptrdiff_t)idx : -1;
+    }
+    size_t byteCount = impl_OCStringByteLength(s);
+    impl_OCStringIndex* index;
+    if (s->isMutable) {
+        // Only the owner edits a mutable string, so its table is kept in place
+        index = s->utf8Index;
+        if (!index || !index->complete) {
+            index = s->utf8Index = impl_OCStringIndexComplete(s->string, byteCount, index);
+            if (!index) return oc_utf8_offset_for_index(s->string, idx);
+        }
+    } else {
+        // Lookups on a shared immutable string may race to build the table;
+        // whichever build lands first is kept
+#if defined(__GNUC__) || defined(__clang__)
+        index = __atomic_load_n(&s->utf8Index, __ATOMIC_ACQUIRE);
+#else
+        index = s->utf8Index;
+#endif
+        if (!index) {
+            impl_OCStringIndex* built = impl_OCStringIndexComplete(s->string, byteCount, NULL);
+            if (!built) return oc_utf8_offset_for_index(s->string, idx);
+#if defined(__GNUC__) || defined(__clang__)
+            if (!__atomic_compare_exchange_n(&s->utf8Index, &index, built, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                free(built);
+            } else {
+                index = built;
+            }
+#else
+            s->utf8Index = index = built;
+#endif
+        }
+    }
+    uint64_t k = idx / OC_UTF8_INDEX_STRIDE;
+    if (k >= index->count) k = index->count - 1;
+    const char* p = s->string + index->offsets[k];
+    const char* end = s->string + byteCount;
+    uint64_t cp = k * OC_UTF8_INDEX_STRIDE;
+    while (cp < idx && p < end) {
+        utf8_next(&p);
+        cp++;
+    }
+    // Allow pointing just past the last code-point
+    return (cp == idx) ? (p - s->string) : -1;
+}
+// ——— Rope storage for builder strings ———
+// A treap ordered by position: each node owns one NUL-terminated chunk and
+// caches the byte and code-point totals of its subtree, so finding, splitting
+// and joining at a code-point index walk one root-to-leaf path.
+#define OC_ROPE_CHUNK_BYTES 4096
+typedef struct impl_OCRopeNode {
+    struct impl_OCRopeNode* left;
+    struct impl_OCRopeNode* right;
+    uint32_t priority;
+    char* bytes;
+    size_t byteCount;
+    size_t charCount;
+    size_t capacity;
+    size_t totalBytes;
+    size_t totalChars;
+} impl_OCRopeNode;
+struct impl_OCRope {
+    impl_OCRopeNode* root;
+    uint32_t seed;
 };
+static uint32_t impl_OCRopeNextPriority(struct impl_OCRope* rope) {
+    uint32_t x = rope->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rope->seed = x;
+    return x;
+}
+static inline size_t impl_OCRopeTotalBytes(const impl_OCRopeNode* n) {
+    return n ? n->totalBytes : 0;
+}
+static inline size_t impl_OCRopeTotalChars(const impl_OCRopeNode* n) {
+    return n ? n->totalChars : 0;
+}
+static inline void impl_OCRopeUpdate(impl_OCRopeNode* n) {
+    n->totalBytes = impl_OCRopeTotalBytes(n->left) + n->byteCount + impl_OCRopeTotalBytes(n->right);
+    n->totalChars = impl_OCRopeTotalChars(n->left) + n->charCount + impl_OCRopeTotalChars(n->right);
+}
+static impl_OCRopeNode* impl_OCRopeNodeCreate(struct impl_OCRope* rope, const char* bytes, size_t n, size_t capacity) {
+    impl_OCRopeNode* node = malloc(sizeof(impl_OCRopeNode));
+    if (!node) return NULL;
+    if (capacity < n) capacity = n;
+    node->bytes = malloc(capacity + 1);
+    if (!node->bytes) {
+        free(node);
+        return NULL;
+    }
+    memcpy(node->bytes, bytes, n);
+    node->bytes[n] = '\0';
+    node->left = node->right = NULL;
+    node->priority = impl_OCRopeNextPriority(rope);
+    node->byteCount = n;
+    node->charCount = oc_utf8_is_ascii(bytes, n) ? n : oc_utf8_strlen_n(node->bytes, n);
+    node->capacity = capacity;
+    impl_OCRopeUpdate(node);
+    return node;
+}
+static void impl_OCRopeFree(impl_OCRopeNode* n) {
+    if (!n) return;
+    impl_OCRopeFree(n->left);
+    impl_OCRopeFree(n->right);
+    free(n->bytes);
+    free(n);
+}
+static impl_OCRopeNode* impl_OCRopeMerge(impl_OCRopeNode* a, impl_OCRopeNode* b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->priority >= b->priority) {
+        a->right = impl_OCRopeMerge(a->right, b);
+        impl_OCRopeUpdate(a);
+        return a;
+    }
+    b->left = impl_OCRopeMerge(a, b->left);
+    impl_OCRopeUpdate(b);
+    return b;
+}
+// Splits t into the first k code points (*outLeft) and the rest (*outRight).
+// A chunk straddling the split point is cut in two; returns false only if that fails.
+static bool impl_OCRopeSplit(struct impl_OCRope* rope, impl_OCRopeNode* t, size_t k, impl_OCRopeNode** outLeft, impl_OCRopeNode** outRight) {
+    if (!t) {
+        *outLeft = *outRight = NULL;
+        return true;
+    }
+    size_t leftChars = impl_OCRopeTotalChars(t->left);
+    if (k <= leftChars) {
+        impl_OCRopeNode* rest;
+        if (!impl_OCRopeSplit(rope, t->left, k, outLeft, &rest)) return false;
+        t->left = rest;
+        impl_OCRopeUpdate(t);
+        *outRight = t;
+        return true;
+    }
+    if (k >= leftChars + t->charCount) {
+        impl_OCRopeNode* head;
+        if (!impl_OCRopeSplit(rope, t->right, k - leftChars - t->charCount, &head, outRight)) return false;
+        t->right = head;
+        impl_OCRopeUpdate(t);
+        *outLeft = t;
+        return true;
+    }
+    // The split falls inside this chunk: keep the head here, move the tail to a new node
+    const char* p = t->bytes;
+    const char* end = t->bytes + t->byteCount;
+    for (size_t i = k - leftChars; i > 0 && p < end; i--) utf8_next(&p);
+    size_t headBytes = (size_t)(p - t->bytes);
+    impl_OCRopeNode* tail = impl_OCRopeNodeCreate(rope, p, t->byteCount - headBytes, 0);
+    if (!tail) return false;
+    tail->priority = t->priority;  // takes t's place above t's right subtree
+    tail->right = t->right;
+    impl_OCRopeUpdate(tail);
+    t->right = NULL;
+    t->byteCount = headBytes;
+    t->bytes[headBytes] = '\0';
+    t->charCount = oc_utf8_is_ascii(t->bytes, headBytes) ? headBytes : oc_utf8_strlen_n(t->bytes, headBytes);
+    impl_OCRopeUpdate(t);
+    *outLeft = t;
+    *outRight = tail;
+    return true;
+}
+// Builds a subtree from n bytes, cut into chunks at UTF-8 boundaries.
+// Chunks get spare capacity when 'forAppend' so later appends fill them in place.
+static bool impl_OCRopeBuild(struct impl_OCRope* rope, const char* bytes, size_t n, bool forAppend, impl_OCRopeNode** out) {
+    impl_OCRopeNode* tree = NULL;
+    while (n > 0) {
+        size_t piece = n;
+        if (piece > OC_ROPE_CHUNK_BYTES) {
+            piece = OC_ROPE_CHUNK_BYTES;
+            while (piece > 1 && ((unsigned char)bytes[piece] & 0xC0) == 0x80) piece--;
+        }
+        impl_OCRopeNode* node = impl_OCRopeNodeCreate(rope, bytes, piece, forAppend ? OC_ROPE_CHUNK_BYTES : piece);
+        if (!node) {
+            impl_OCRopeFree(tree);
+            return false;
+        }
+        tree = impl_OCRopeMerge(tree, node);
+        bytes += piece;
+        n -= piece;
+    }
+    *out = tree;
+    return true;
+}
+// Appends into the last chunk when it has room; totals are fixed up on the way back.
+static bool impl_OCRopeAppendInPlace(impl_OCRopeNode* t, const char* bytes, size_t n, size_t chars) {
+    if (!t) return false;
+    if (t->right) {
+        if (!impl_OCRopeAppendInPlace(t->right, bytes, n, chars)) return false;
+    } else {
+        if (t->capacity - t->byteCount < n) return false;
+        memcpy(t->bytes + t->byteCount, bytes, n);
+        t->byteCount += n;
+        t->bytes[t->byteCount] = '\0';
+        t->charCount += chars;
+    }
+    impl_OCRopeUpdate(t);
+    return true;
+}
+static void impl_OCRopeCopyBytes(const impl_OCRopeNode* t, char* out) {
+    while (t) {
+        impl_OCRopeCopyBytes(t->left, out);
+        out += impl_OCRopeTotalBytes(t->left);
+        memcpy(out, t->bytes, t->byteCount);
+        out += t->byteCount;
+        t = t->right;
+    }
+}
+static bool impl_OCRopeWrite(const impl_OCRopeNode* t, FILE* stream) {
+    while (t) {
+        if (!impl_OCRopeWrite(t->left, stream)) return false;
+        if (t->byteCount && fwrite(t->bytes, 1, t->byteCount, stream) != t->byteCount) return false;
+        t = t->right;
+    }
+    return true;
+}
+// ——— Move a rope builder's text into one NUL-terminated buffer ———
+static bool impl_OCStringFlatten(OCStringRef str) {
+    struct impl_OCString* s = (struct impl_OCString*)str;
+    if (!s || !s->rope) return true;
+    size_t total = impl_OCRopeTotalBytes(s->rope->root);
+    char* buf = malloc(total + 1);
+    if (NULL == buf) {
+        fprintf(stderr, "OCStringGetCString: Memory allocation failed for flattened rope.\n");
+        return false;
+    }
+    impl_OCRopeCopyBytes(s->rope->root, buf);
+    buf[total] = '\0';
+    impl_OCRopeFree(s->rope->root);
+    free(s->rope);
+    s->rope = NULL;
+    s->string = buf;
+    s->capacity = total;
+    size_t asciiBytes = oc_utf8_ascii_prefix(buf, total);
+    s->length = asciiBytes == total ? total : asciiBytes + oc_utf8_strlen_n(buf + asciiBytes, total - asciiBytes);
+    impl_OCStringResetIndex(s, asciiBytes == total);
+    return true;
+}
+// ——— Give a rope builder back its rope after a flattening read ———
+// The flat buffer is returned through outOldBuffer rather than freed, since the
+// bytes about to be inserted may point into it.
+static bool impl_OCStringEnsureRope(struct impl_OCString* s, char** outOldBuffer) {
+    *outOldBuffer = NULL;
+    if (s->rope) return true;
+    if (s->parent && !impl_OCStringCString(s)) return false;
+    struct impl_OCRope* rope = malloc(sizeof(struct impl_OCRope));
+    if (!rope) return false;
+    rope->root = NULL;
+    rope->seed = 0x9E3779B9u;
+    size_t n = s->string ? strlen(s->string) : 0;
+    if (!impl_OCRopeBuild(rope, s->string, n, true, &rope->root)) {
+        free(rope);
+        return false;
+    }
+    *outOldBuffer = s->string;
+    s->string = NULL;
+    s->capacity = 0;
+    s->rope = rope;
+    impl_OCStringResetIndex(s, s->isASCII);
+    return true;
+}
+// ——— Replace the code points [location, location + length) of a rope builder with n bytes ———
+// A location of SIZE_MAX appends.
+static void impl_OCStringRopeReplace(struct impl_OCString* s, size_t location, size_t length, const char* bytes, size_t n) {
+    char* oldBuffer = NULL;
+    if (!impl_OCStringEnsureRope(s, &oldBuffer)) {
+        fprintf(stderr, "OCStringReplace: Memory allocation failed for rope.\n");
+        return;
+    }
+    struct impl_OCRope* rope = s->rope;
+    size_t total = impl_OCRopeTotalChars(rope->root);
+    if (location == SIZE_MAX) location = total;  // append
+    if (location > total || length > total - location) {
+        free(oldBuffer);
+        return;
+    }
+    bool ascii = oc_utf8_is_ascii(bytes, n);
+    if (length == 0 && location == total && n > 0 && n <= OC_ROPE_CHUNK_BYTES) {
+        // Cheap append: fill the last chunk in place
+        size_t chars = ascii ? n : oc_utf8_strlen_n(bytes, n);
+        if (impl_OCRopeAppendInPlace(rope->root, bytes, n, chars)) {
+            s->length = impl_OCRopeTotalChars(rope->root);
+            s->isASCII = s->isASCII && ascii;
+            free(oldBuffer);
+            return;
+        }
+    }
+    impl_OCRopeNode *head, *rest, *middle, *tail, *inserted;
+    if (!impl_OCRopeBuild(rope, bytes, n, location == total, &inserted)) {
+        fprintf(stderr, "OCStringReplace: Memory allocation failed for rope chunk.\n");
+        free(oldBuffer);
+        return;
+    }
+    // A failed split leaves its input untouched
+    if (!impl_OCRopeSplit(rope, rope->root, location, &head, &rest)) {
+        impl_OCRopeFree(inserted);
+        free(oldBuffer);
+        return;
+    }
+    if (!impl_OCRopeSplit(rope, rest, length, &middle, &tail)) {
+        rope->root = impl_OCRopeMerge(head, rest);
+        impl_OCRopeFree(inserted);
+        free(oldBuffer);
+        return;
+    }
+    impl_OCRopeFree(middle);
+    rope->root = impl_OCRopeMerge(impl_OCRopeMerge(head, inserted), tail);
+    s->length = impl_OCRopeTotalChars(rope->root);
+    s->isASCII = s->isASCII && ascii;
+    free(oldBuffer);
+}
 static bool impl_OCStringEqual(const void* theType1, const void* theType2) {
     OCStringRef theString1 = (OCStringRef)theType1;
     OCStringRef theString2 = (OCStringRef)theType2;
@@ -218,6 +846,7 @@ static bool impl_OCStringEqual(const void* theType1, const void* theType2) {
     if (NULL == theString1 || NULL == theString2) return false;
     // 3. Now it's safe to access members. Check typeID.
     if (theString1->base.typeID != theString2->base.typeID) return false;
+    if (!impl_OCStringFlatten(theString1) || !impl_OCStringFlatten(theString2)) return false;
     // 4. Compare lengths. If lengths differ, strings cannot be equal.
     if (theString1->length != theString2->length) return false;
     // 5. If lengths are 0 (and typeIDs and lengths are equal), they are equal (both are empty strings).
@@ -228,13 +857,25 @@ static bool impl_OCStringEqual(const void* theType1, const void* theType2) {
     //    If string pointers could be NULL here despite length > 0 (which would be an inconsistency),
     //    an additional check like `if (!theString1->string || !theString2->string) return false;` (or specific handling)
     //    would be needed. Assuming valid OCString construction, string pointers are non-NULL if length > 0.
-    if (strcmp(theString1->string, theString2->string) != 0) return false;
-    return true;
+    size_t n1 = impl_OCStringByteLength(theString1);
+    if (n1 != impl_OCStringByteLength(theString2)) return false;
+    return memcmp(theString1->string, theString2->string, n1) == 0;
 }
 static void impl_OCStringFinalize(const void* theType) {
     if (NULL == theType) return;
     OCStringRef theString = (OCStringRef)theType;
-    free(theString->string);
+    if (theString->parent) {
+        OCRelease(theString->parent);
+    } else {
+        free(theString->string);
+    }
+    if (theString->rope) {
+        impl_OCRopeFree(theString->rope->root);
+        free(theString->rope);
+    }
+    free(theString->cString);
+    free(theString->utf8Index);
+    free(theString->compiledFormat);
 }
 static OCStringRef impl_OCStringCopyFormattingDesc(OCTypeRef cf) {
     if (!cf) return NULL;
@@ -249,18 +890,34 @@ static cJSON*
 impl_OCStringCopyJSON(const void* obj, bool typed, OCStringRef* outError) {
     return OCStringCopyAsJSON((OCStringRef)obj, typed, outError);
 }
+static struct impl_OCString* impl_OCStringCreateOwnedCopy(OCStringRef theString, bool isMutable);
 static void* impl_OCStringDeepCopy(const void* obj) {
     OCStringRef src = (OCStringRef)obj;
-    if (!src) return NULL;
-    return (void*)OCStringCreateCopy(src);  // Safe cast, as OCStringCreateCopy allocates
+    if (!src || !impl_OCStringFlatten(src)) return NULL;
+    return impl_OCStringCreateOwnedCopy(src, false);
 }
 static void* impl_OCStringDeepCopyMutable(const void* obj) {
     OCStringRef src = (OCStringRef)obj;
     if (!src) return NULL;
     return OCStringCreateMutableCopy(src);  // Returns OCMutableStringRef
 }
+static uint64_t impl_OCStringHash(const void* obj) {
+    return OCStringHash((OCStringRef)obj);
+}
+static bool impl_OCStringIsMutable(const void* obj) {
+    return ((OCStringRef)obj)->isMutable;
+}
+static void* impl_OCStringCreateShared(const void* obj) {
+    OCStringRef str = (OCStringRef)obj;
+    return str->isMutable ? (void*)OCStringCreateMutableCopy(str) : (void*)OCStringCreateCopy(str);
+}
+static const OCTypeSharedCopyCallBacks kOCStringSharedCopyCallBacks = {impl_OCStringIsMutable, NULL, impl_OCStringCreateShared, NULL};
 OCTypeID OCStringGetTypeID(void) {
-    if (kOCStringID == kOCNotATypeID) kOCStringID = OCRegisterType("OCString", (OCTypeRef (*)(cJSON*, OCStringRef*))OCStringCreateFromJSON);
+    if (kOCStringID == kOCNotATypeID) {
+        kOCStringID = OCRegisterType("OCString", (OCTypeRef (*)(cJSON*, OCStringRef*))OCStringCreateFromJSON);
+        OCTypeSetHashFunction(kOCStringID, impl_OCStringHash);
+        OCTypeSetSharedCopyCallBacks(kOCStringID, &kOCStringSharedCopyCallBacks);
+    }
     return kOCStringID;
 }
 static struct impl_OCString* OCStringAllocate() {
@@ -275,6 +932,14 @@ static struct impl_OCString* OCStringAllocate() {
     obj->string = NULL;
     obj->length = 0;
     obj->capacity = 0;
+    obj->isASCII = true;
+    obj->utf8Index = NULL;
+    obj->isMutable = false;
+    obj->parent = NULL;
+    obj->cString = NULL;
+    obj->compiledFormat = NULL;
+    obj->usesRope = false;
+    obj->rope = NULL;
     return obj;
 }
 cJSON* OCStringCopyAsJSON(OCStringRef str, bool typed, OCStringRef* outError) {
@@ -321,16 +986,15 @@ OCStringRef OCStringCreateFromJSON(cJSON* json, OCStringRef* outError) {
 // Core OCString Constructors
 // -----------------------------------------------------------------------------
 // A single mutable dictionary to intern all constant strings
+static void impl_OCStringUnpinConstant(OCStringRef key, const void* value, void* context) {
+    (void)key;
+    (void)context;
+    OCTypeSetStaticInstance(value, false);
+}
 void cleanupConstantStringTable(void) {
     if (!impl_constantStringTable) return;
-    OCArrayRef keys = OCDictionaryCreateArrayWithAllKeys(impl_constantStringTable);
-    for (size_t i = 0; i < OCArrayGetCount(keys); ++i) {
-        OCStringRef key = (OCStringRef)OCArrayGetValueAtIndex(keys, i);
-        OCStringRef value = (OCStringRef)OCDictionaryGetValue(impl_constantStringTable, key);
-        OCTypeSetStaticInstance(value, false);
-        OCDictionaryRemoveValue(impl_constantStringTable, key);
-    }
-    OCRelease(keys);
+    // Unpin every interned string; releasing the table then frees them with their keys
+    OCDictionaryApplyFunction(impl_constantStringTable, impl_OCStringUnpinConstant, NULL);
     OCRelease(impl_constantStringTable);
     impl_constantStringTable = NULL;  // ← clear the global cache
 }
@@ -343,38 +1007,146 @@ static OCMutableDictionaryRef getConstantStringTable(void) {
 OCStringRef impl_OCStringMakeConstantString(const char* cStr) {
     // Create a temporary OCString to look up in the table
     OCStringRef tmp = OCStringCreateWithCString(cStr);
+    pthread_mutex_lock(&impl_constantStringTableLock);
     OCMutableDictionaryRef table = getConstantStringTable();
+    OCStringRef result;
     if (OCDictionaryContainsKey(table, tmp)) {
         // Already interned: return existing and drop the temporary
-        OCStringRef existing = (OCStringRef)OCDictionaryGetValue(table, tmp);
+        result = (OCStringRef)OCDictionaryGetValue(table, tmp);
         OCRelease(tmp);
-        return existing;
     } else {
         // First time: add it and set it as static instance
         OCTypeSetStaticInstance(tmp, true);
         OCDictionaryAddValue(table, tmp, tmp);
         OCRelease(tmp);
-        return tmp;
+        result = tmp;
     }
+    pthread_mutex_unlock(&impl_constantStringTableLock);
+    return result;
 }
 OCStringRef
 OCStringCreateWithExternalRepresentation(OCDataRef data) {
     if (!data || OCDataGetLength(data) == 0)
         return STR("");
+    // Copy straight out of the data; a mutable OCData may change after we return
+    const char* bytes = (const char*)OCDataGetBytesPtr(data);
     size_t len = OCDataGetLength(data);
-    const uint8_t* bytes = OCDataGetBytesPtr(data);
-    // make a nul-terminated buffer
-    char* buf = (char*)malloc(len + 1);
-    if (!buf) return STR("");
-    memcpy(buf, bytes, len);
-    buf[len] = '\0';
-    // now feed it into your existing UTF-8 string constructor
-    OCStringRef s = OCStringCreateWithCString(buf);
-    free(buf);
+    const char* nul = memchr(bytes, '\0', len);
+    if (nul) len = (size_t)(nul - bytes);
+    struct impl_OCString* s = OCStringAllocate();
+    if (!s) return NULL;
+    s->string = malloc(len + 1);
+    if (NULL == s->string) {
+        fprintf(stderr, "OCStringCreateWithExternalRepresentation: Memory allocation failed for string.\n");
+        OCRelease(s);
+        return NULL;
+    }
+    memcpy(s->string, bytes, len);
+    s->string[len] = '\0';
+    s->capacity = len;
+    size_t asciiBytes = oc_utf8_ascii_prefix(s->string, len);
+    s->isASCII = (asciiBytes == len);
+    s->length = s->isASCII ? len : asciiBytes + oc_utf8_strlen_n(s->string + asciiBytes, len - asciiBytes);
+    return s;
+}
+// ——— Immutable string that borrows the bytes of an OCData ———
+OCStringRef OCStringCreateWithDataNoCopy(OCDataRef data) {
+    if (!data) return NULL;
+    size_t len = OCDataGetLength(data);
+    if (len == 0) return OCStringCreateWithCString("");
+    // Later writes to mutable data must not reach the string; copying the
+    // data only shares its bytes until then
+    OCDataRef frozen = OCDataCreateCopy(data);
+    if (!frozen) return NULL;
+    const char* bytes = (const char*)OCDataGetBytesPtr(frozen);
+    // Like a C string, the text ends at the first NUL
+    const char* nul = memchr(bytes, '\0', len);
+    if (nul) len = (size_t)(nul - bytes);
+    // The decoder trusts sequence lengths, so a truncated tail would read
+    // past the end of the buffer
+    size_t badOffset = 0;
+    if (!oc_utf8_validate(bytes, len, &badOffset)) {
+        fprintf(stderr, "OCStringCreateWithDataNoCopy: Invalid UTF-8 at byte %zu.\n", badOffset);
+        OCRelease(frozen);
+        return NULL;
+    }
+    struct impl_OCString* s = OCStringAllocate();
+    if (!s) {
+        OCRelease(frozen);
+        return NULL;
+    }
+    s->parent = (OCTypeRef)frozen;
+    s->string = (char*)bytes;
+    s->capacity = len;
+    size_t asciiBytes = oc_utf8_ascii_prefix(bytes, len);
+    s->isASCII = (asciiBytes == len);
+    s->length = s->isASCII ? len : asciiBytes + oc_utf8_strlen_n(bytes + asciiBytes, len - asciiBytes);
+    return s;
+}
+OCStringRef OCStringCreateWithBytesNoCopy(const char* bytes,
+                                          uint64_t length,
+                                          OCStringDeallocatorCallBack deallocator,
+                                          void* context) {
+    if (!bytes && length > 0) return NULL;
+    // Reject invalid text before the data takes ownership, so the caller
+    // keeps the bytes when creation fails
+    const char* nul = length ? memchr(bytes, '\0', length) : NULL;
+    size_t badOffset = 0;
+    if (!oc_utf8_validate(bytes, nul ? (size_t)(nul - bytes) : length, &badOffset)) {
+        fprintf(stderr, "OCStringCreateWithBytesNoCopy: Invalid UTF-8 at byte %zu.\n", badOffset);
+        return NULL;
+    }
+    // The OCData owns the bytes and hands them back to the deallocator when the
+    // last string (or substring view) using them is released
+    OCDataRef data = OCDataCreateWithBytesNoCopyDeallocator((const uint8_t*)bytes, length, deallocator, context);
+    if (!data) return NULL;
+    OCStringRef s = OCStringCreateWithDataNoCopy(data);
+    OCRelease(data);
+    return s;
+}
+// ——— Hand a mutable string's buffer to a new immutable string and view it ———
+// Strings are not thread-safe while mutable, so unlike OCArray and OCData no
+// atomic publish is needed here.
+static OCTypeRef impl_OCStringShareStorage(struct impl_OCString* str) {
+    if (str->parent) return str->parent;
+    struct impl_OCString* root = OCStringAllocate();
+    if (!root) return NULL;
+    root->string = str->string;
+    root->capacity = str->capacity;
+    root->length = str->length;
+    root->isASCII = str->isASCII;
+    str->capacity = strlen(str->string);
+    str->parent = (OCTypeRef)root;
+    return (OCTypeRef)root;
+}
+static struct impl_OCString* impl_OCStringCreateView(OCStringRef str, OCTypeRef root, bool isMutable) {
+    struct impl_OCString* s = OCStringAllocate();
+    if (!s) return NULL;
+    s->parent = OCRetain(root);
+    s->string = str->string;
+    s->capacity = str->capacity;
+    s->length = str->length;
+    s->isASCII = str->isASCII;
+    s->isMutable = isMutable;
     return s;
 }
 OCStringRef OCStringCreateCopy(OCStringRef theString) {
-    return theString ? OCStringCreateWithCString(theString->string) : NULL;
+    if (!theString || !impl_OCStringFlatten(theString)) return NULL;
+    // An immutable string is its own copy; interned constants ignore
+    // retain/release, so they still get a private one
+    if (!theString->isMutable && !OCTypeGetStaticInstance(theString)) return OCRetain(theString);
+    if (theString->isMutable) {
+        OCTypeRef root = impl_OCStringShareStorage((struct impl_OCString*)theString);
+        return root ? impl_OCStringCreateView(theString, root, false) : NULL;
+    }
+    return impl_OCStringCreateOwnedCopy(theString, false);
+}
+OCStringRef impl_OCStringCreateKeyCopy(OCStringRef theString) {
+    if (!theString || !impl_OCStringFlatten(theString)) return NULL;
+    // A substring view would keep its whole parent alive for the life of
+    // the key, so it gets bytes of its own
+    if (!theString->isMutable && theString->parent) return impl_OCStringCreateOwnedCopy(theString, false);
+    return OCStringCreateCopy(theString);
 }
 OCMutableStringRef OCStringCreateMutable(uint64_t capacity) {
     struct impl_OCString* s = OCStringAllocate();
@@ -388,6 +1160,14 @@ OCMutableStringRef OCStringCreateMutable(uint64_t capacity) {
         return NULL;
     }
     s->string[0] = '\0';
+    s->isMutable = true;
+    return (OCMutableStringRef)s;
+}
+// ——— Create an empty mutable OCString whose edits go through a rope ———
+OCMutableStringRef OCStringCreateMutableRope(void) {
+    struct impl_OCString* s = (struct impl_OCString*)OCStringCreateMutable(0);
+    if (!s) return NULL;
+    s->usesRope = true;
     return (OCMutableStringRef)s;
 }
 // ——— Create a mutable OCString from a C‐string ———
@@ -400,7 +1180,10 @@ OCMutableStringCreateWithCString(const char* cString) {
     // Measure byte‐length vs. code‐point length
     size_t byteLen = strlen(cString);
     s->capacity = byteLen;
-    s->length = oc_utf8_strlen(cString);
+    size_t asciiBytes = oc_utf8_ascii_prefix(cString, byteLen);
+    s->isASCII = (asciiBytes == byteLen);
+    s->length = s->isASCII ? byteLen
+                           : asciiBytes + oc_utf8_strlen_n(cString + asciiBytes, byteLen - asciiBytes);
     // Allocate memory for the string content
     s->string = malloc(byteLen + 1);
     if (NULL == s->string) {
@@ -410,53 +1193,120 @@ OCMutableStringCreateWithCString(const char* cString) {
     }
     // Copy the C string into the allocated memory
     memcpy(s->string, cString, byteLen + 1);
+    s->isMutable = true;
     return s;
 }
 // ——— Immutable wrapper onto the mutable creator ———
 OCStringRef OCStringCreateWithCString(const char* cString) {
-    OCStringRef theString = (OCStringRef)OCMutableStringCreateWithCString(cString);
-    return theString;
+    OCMutableStringRef theString = OCMutableStringCreateWithCString(cString);
+    if (theString) theString->isMutable = false;
+    return (OCStringRef)theString;
+}
+OCStringRef OCStringCreateWithUTF8Bytes(const void* bytes, uint64_t length, OCIndex* outInvalidOffset) {
+    if (outInvalidOffset) *outInvalidOffset = kOCNotFound;
+    if (!bytes && length > 0) return NULL;
+    const char* src = (const char*)bytes;
+    size_t badOffset = 0;
+    if (!oc_utf8_validate(src, length, &badOffset)) {
+        if (outInvalidOffset) *outInvalidOffset = (OCIndex)badOffset;
+        return NULL;
+    }
+    // OCString storage is NUL-terminated, so an embedded NUL cannot be represented
+    const char* nul = length ? memchr(src, '\0', length) : NULL;
+    if (nul) {
+        if (outInvalidOffset) *outInvalidOffset = (OCIndex)(nul - src);
+        return NULL;
+    }
+    struct impl_OCString* s = OCStringAllocate();
+    if (!s) return NULL;
+    s->string = malloc(length + 1);
+    if (NULL == s->string) {
+        fprintf(stderr, "OCStringCreateWithUTF8Bytes: Memory allocation failed for string.\n");
+        OCRelease(s);
+        return NULL;
+    }
+    if (length) memcpy(s->string, src, length);
+    s->string[length] = '\0';
+    s->capacity = length;
+    size_t asciiBytes = oc_utf8_ascii_prefix(s->string, length);
+    s->isASCII = (asciiBytes == length);
+    s->length = s->isASCII ? length
+                           : asciiBytes + oc_utf8_strlen_n(s->string + asciiBytes, length - asciiBytes);
+    return s;
 }
-OCMutableStringRef OCStringCreateMutableCopy(OCStringRef theString) {
-    if (!theString) return NULL;
+// ——— Copy a flat string's bytes into a new string with its own buffer ———
+static struct impl_OCString* impl_OCStringCreateOwnedCopy(OCStringRef theString, bool isMutable) {
     struct impl_OCString* s = OCStringAllocate();
     if (!s) return NULL;
     // Preserve both byte‐capacity and code‐point length
-    size_t byteLen = strlen(theString->string);
+    size_t byteLen = impl_OCStringByteLength(theString);
     s->capacity = byteLen;
     s->length = theString->length;
+    s->isASCII = theString->isASCII;
+    s->isMutable = isMutable;
     s->string = malloc(byteLen + 1);
     if (NULL == s->string) {
-        fprintf(stderr, "OCStringCreateMutableCopy: Memory allocation failed for string.\n");
+        fprintf(stderr, "OCStringCreateCopy: Memory allocation failed for string.\n");
         OCRelease(s);
         return NULL;
     }
-    memcpy(s->string, theString->string, byteLen + 1);
-    return (OCMutableStringRef)s;
+    memcpy(s->string, theString->string, byteLen);
+    s->string[byteLen] = '\0';
+    return s;
+}
+OCMutableStringRef OCStringCreateMutableCopy(OCStringRef theString) {
+    if (!theString || !impl_OCStringFlatten(theString)) return NULL;
+    if (!OCTypeGetStaticInstance(theString)) {
+        // Read the same bytes until the copy first changes
+        OCTypeRef root;
+        if (theString->isMutable)
+            root = impl_OCStringShareStorage((struct impl_OCString*)theString);
+        else
+            root = theString->parent ? theString->parent : (OCTypeRef)theString;
+        if (!root) return NULL;
+        struct impl_OCString* s = impl_OCStringCreateView(theString, root, true);
+        if (s && root == (OCTypeRef)theString) s->capacity = strlen(theString->string);
+        return s;
+    }
+    return impl_OCStringCreateOwnedCopy(theString, true);
 }
 OCStringRef OCStringCreateWithSubstring(OCStringRef str, OCRange range) {
-    if (!str) return NULL;
+    if (!str || !impl_OCStringFlatten(str)) return NULL;
     // Map code‐point range → byte offsets
-    ptrdiff_t off1 = oc_utf8_offset_for_index(str->string, range.location);
-    ptrdiff_t off2 = oc_utf8_offset_for_index(str->string, range.location + range.length);
+    ptrdiff_t off1 = impl_OCStringOffsetForIndex(str, range.location);
+    ptrdiff_t off2 = impl_OCStringOffsetForIndex(str, range.location + range.length);
     if (off1 < 0 || off2 < 0 || off2 < off1) {
         // Special case: empty slice at end of string
         if ((uint64_t)range.location == str->length && range.length == 0) {
-            off1 = off2 = strlen(str->string);
+            off1 = off2 = impl_OCStringByteLength(str);
         } else {
             return NULL;
         }
     }
     size_t byteCount = off2 - off1;
-    char* buf = malloc(byteCount + 1);
-    if (NULL == buf) {
-        fprintf(stderr, "OCStringCreateWithSubstring: Memory allocation failed for substring buffer.\n");
-        return NULL;
+    const char* bytes = str->string + off1;
+    struct impl_OCString* sub = OCStringAllocate();
+    if (!sub) return NULL;
+    sub->capacity = byteCount;
+    sub->isASCII = str->isASCII || oc_utf8_is_ascii(bytes, byteCount);
+    OCTypeRef root = str->parent ? str->parent : (OCTypeRef)str;
+    if (str->isMutable || OCTypeGetStaticInstance(root)) {
+        // A mutable parent may change underneath us, and interned constants
+        // ignore retain/release, so take a private copy
+        sub->string = malloc(byteCount + 1);
+        if (NULL == sub->string) {
+            fprintf(stderr, "OCStringCreateWithSubstring: Memory allocation failed for substring buffer.\n");
+            OCRelease(sub);
+            return NULL;
+        }
+        memcpy(sub->string, bytes, byteCount);
+        sub->string[byteCount] = '\0';
+    } else {
+        // Share the parent's bytes; views of views point at the owning string
+        sub->parent = OCRetain(root);
+        sub->string = (char*)bytes;
     }
-    memcpy(buf, str->string + off1, byteCount);
-    buf[byteCount] = '\0';
-    OCStringRef sub = OCStringCreateWithCString(buf);
-    free(buf);
+    sub->length = sub->isASCII ? byteCount : oc_utf8_strlen_n(bytes, byteCount);
     return sub;
 }
 #include <stdio.h>   // fputs, stdout
@@ -464,16 +1314,22 @@ OCStringRef OCStringCreateWithSubstring(OCStringRef str, OCRange range) {
 #include <string.h>  // strlen, strdup
 // ——— Inspectors ———
 const char* OCStringGetCString(OCStringRef s) {
-    return s ? s->string : NULL;
+    if (!s) return NULL;
+    return impl_OCStringReadCString(s);
 }
 uint64_t OCStringGetLength(OCStringRef s) {
     return s ? s->length : 0;
 }
 void OCStringShow(OCStringRef s) {
-    if (s && s->string) {
-        fputs(s->string, stdout);
-        fflush(stdout);
-    }
+    if (s && OCStringWriteToStream(s, stdout)) fflush(stdout);
+}
+bool OCStringWriteToStream(OCStringRef s, FILE* stream) {
+    if (!s || !stream) return false;
+    // Rope builders write chunk by chunk rather than flattening first
+    if (s->rope) return impl_OCRopeWrite(s->rope->root, stream);
+    if (!s->string) return false;
+    size_t n = impl_OCStringByteLength(s);
+    return n == 0 || fwrite(s->string, 1, n, stream) == n;
 }
 bool OCStringEqual(OCStringRef a, OCStringRef b) {
     return impl_OCStringEqual(a, b);
@@ -483,19 +1339,30 @@ bool OCStringEqual(OCStringRef a, OCStringRef b) {
 // Here we return the Unicode code-point cast to char (low byte).
 // MODIFIED: Now returns the full uint32_t Unicode code-point.
 uint32_t OCStringGetCharacterAtIndex(OCStringRef s, uint64_t idx) {
-    if (!s) return 0;
-    ptrdiff_t off = oc_utf8_offset_for_index(s->string, idx);
+    if (!s || !impl_OCStringFlatten(s) || !s->string) return 0;
+    if (s->isASCII) {
+        return idx < s->length ? (unsigned char)s->string[idx] : 0;
+    }
+    ptrdiff_t off = impl_OCStringOffsetForIndex(s, idx);
     if (off < 0) return 0;
     const char* p = s->string + off;
     uint32_t cp = utf8_next(&p);
     return cp;
 }
 // ——— Mutators ———
-void OCStringAppendCString(OCMutableStringRef s, const char* cString) {
-    if (!s || !cString || !s->string) return;  // Ensure s and s->string are valid
-    size_t append_cString_byte_len = strlen(cString);
+// Appends n bytes (no NUL required) to s; the bytes may alias s's own buffer.
+static void impl_OCStringAppendBytes(OCMutableStringRef s, const char* cString, size_t append_cString_byte_len) {
     if (append_cString_byte_len == 0) return;  // Nothing to append
+    if (s->usesRope) {
+        impl_OCStringRopeReplace(s, SIZE_MAX, 0, cString, append_cString_byte_len);
+        return;
+    }
+    if (!impl_OCStringCString(s)) return;      // A view needs its own buffer before growing
     size_t current_content_byte_len = strlen(s->string);
+    ptrdiff_t selfOffset = -1;
+    if (cString >= s->string && cString <= s->string + current_content_byte_len) {
+        selfOffset = cString - s->string;
+    }
     size_t required_total_content_byte_len = current_content_byte_len + append_cString_byte_len;
     // Check if current capacity is enough for the new total content length
     // s->capacity is the max content bytes, s->string is allocated for s->capacity + 1 bytes
@@ -518,23 +1385,42 @@ void OCStringAppendCString(OCMutableStringRef s, const char* cString) {
         }
         s->string = new_s_string_buffer;
         s->capacity = new_capacity;
+        if (selfOffset >= 0) cString = s->string + selfOffset;
     }
     // Append cString to the end of the current content in s->string
-    // memcpy is safe here because we've ensured s->string has enough space.
-    memcpy(s->string + current_content_byte_len, cString, append_cString_byte_len + 1);  // +1 to copy NUL from cString
-    // Update the code-point length
-    s->length += oc_utf8_strlen(cString);  // oc_utf8_strlen calculates codepoints from a C-string
+    // memmove is safe here because we've ensured s->string has enough space.
+    memmove(s->string + current_content_byte_len, cString, append_cString_byte_len);
+    s->string[current_content_byte_len + append_cString_byte_len] = '\0';
+    // Update the code-point length and indexing state
+    impl_OCStringInvalidateIndexFrom(s, current_content_byte_len);
+    if (oc_utf8_is_ascii(cString, append_cString_byte_len)) {
+        s->length += append_cString_byte_len;
+    } else {
+        s->isASCII = false;
+        s->length += oc_utf8_strlen_n(cString, append_cString_byte_len);  // codepoints of the appended bytes
+    }
+}
+void OCStringAppendCString(OCMutableStringRef s, const char* cString) {
+    if (!s || !cString || (!s->string && !s->rope)) return;  // Ensure s has storage
+    impl_OCStringAppendBytes(s, cString, strlen(cString));
 }
 void OCStringAppend(OCMutableStringRef s, OCStringRef app) {
-    if (!s || !app || app->length == 0) return;
-    OCStringAppendCString(s, app->string);
+    if (!s || !app || app->length == 0 || !impl_OCStringFlatten(app)) return;
+    impl_OCStringAppendBytes(s, app->string, impl_OCStringByteLength(app));
 }
 void OCStringDelete(OCMutableStringRef s, OCRange range) {
     if (!s) return;
+    if (s->usesRope) {
+        if (range.location >= 0 && range.length >= 0)
+            impl_OCStringRopeReplace(s, (size_t)range.location, (size_t)range.length, "", 0);
+        return;
+    }
+    if (!impl_OCStringCString(s)) return;
     // map code-point indices → byte offsets
-    ptrdiff_t off1 = oc_utf8_offset_for_index(s->string, range.location);
-    ptrdiff_t off2 = oc_utf8_offset_for_index(s->string, range.location + range.length);
+    ptrdiff_t off1 = impl_OCStringOffsetForIndex(s, range.location);
+    ptrdiff_t off2 = impl_OCStringOffsetForIndex(s, range.location + range.length);
     if (off1 < 0 || off2 < 0 || off2 < off1) return;
+    impl_OCStringInvalidateIndexFrom(s, off1);
     size_t totalBytes = strlen(s->string);
     size_t tailBytes = totalBytes - off2;
     memmove(s->string + off1,
@@ -548,10 +1434,16 @@ void OCStringInsert(OCMutableStringRef str, int64_t idx, OCStringRef insertedStr
     OCStringReplace(str, OCRangeMake(idx, 0), insertedStr);
 }
 void OCStringReplace(OCMutableStringRef s, OCRange range, OCStringRef rep) {
-    if (!s || !rep) return;
+    if (!s || !rep || !impl_OCStringFlatten(rep)) return;
+    if (s->usesRope) {
+        if (range.location >= 0 && range.length >= 0)
+            impl_OCStringRopeReplace(s, (size_t)range.location, (size_t)range.length, rep->string, impl_OCStringByteLength(rep));
+        return;
+    }
+    if (!impl_OCStringCString(s)) return;
     // 1) Find byte offsets of the code‐point range
-    ptrdiff_t off1 = oc_utf8_offset_for_index(s->string, range.location);
-    ptrdiff_t off2 = oc_utf8_offset_for_index(s->string, range.location + range.length);
+    ptrdiff_t off1 = impl_OCStringOffsetForIndex(s, range.location);
+    ptrdiff_t off2 = impl_OCStringOffsetForIndex(s, range.location + range.length);
     if (off1 < 0 || off2 < 0 || off2 < off1) return;
     // 2) Figure out how many bytes the parts have
     size_t origBytes = strlen(s->string);
@@ -582,31 +1474,37 @@ void OCStringReplace(OCMutableStringRef s, OCRange range, OCStringRef rep) {
     free(s->string);
     s->string = newbuf;
     s->capacity = newDataBytes;
-    s->length = oc_utf8_strlen(newbuf);
+    impl_OCStringInvalidateIndexFrom(s, off1);
+    if (s->isASCII && rep->isASCII) {
+        s->length = newDataBytes;
+    } else {
+        s->isASCII = false;
+        s->length = oc_utf8_strlen_n(newbuf, newDataBytes);
+    }
 }
 void OCStringReplaceAll(OCMutableStringRef s, OCStringRef rep) {
     OCStringReplace(s, OCRangeMake(0, s->length), rep);
 }
 // ——— Case conversions and trimming ———
+// ASCII bytes never occur inside a multi-byte UTF-8 sequence, so a single byte
+// scan touches exactly the ASCII code points and leaves code-point boundaries
+// (and therefore the sparse index) unchanged.
 void OCStringLowercase(OCMutableStringRef s) {
-    if (!s) return;
+    if (!s || !impl_OCStringCString(s)) return;
     // ASCII-only lowercase
-    for (uint64_t i = 0; i < s->length; i++) {
-        ptrdiff_t off = oc_utf8_offset_for_index(s->string, i);
-        unsigned char* c = (unsigned char*)(s->string + off);
+    for (unsigned char* c = (unsigned char*)s->string; *c; c++) {
         if (*c >= 'A' && *c <= 'Z') *c += 'a' - 'A';
     }
 }
 void OCStringUppercase(OCMutableStringRef s) {
-    if (!s) return;
-    for (uint64_t i = 0; i < s->length; i++) {
-        ptrdiff_t off = oc_utf8_offset_for_index(s->string, i);
-        unsigned char* c = (unsigned char*)(s->string + off);
+    if (!s || !impl_OCStringCString(s)) return;
+    for (unsigned char* c = (unsigned char*)s->string; *c; c++) {
         if (*c >= 'a' && *c <= 'z') *c -= 'a' - 'A';
     }
 }
 void OCStringTrim(OCMutableStringRef s, OCStringRef t) {
-    if (!s || !t || t->length == 0 || s->length == 0) return;
+    if (!s || !t || !impl_OCStringFlatten(s) || !impl_OCStringFlatten(t)) return;
+    if (t->length == 0 || s->length == 0) return;
     OCRange r;
     // Trim from the beginning
     while (s->length >= t->length) {
@@ -626,12 +1524,12 @@ void OCStringTrim(OCMutableStringRef s, OCStringRef t) {
     }
 }
 void OCStringTrimWhitespace(OCMutableStringRef s) {
-    if (!s || !s->string || s->length == 0) return;
+    if (!s || !impl_OCStringCString(s) || s->length == 0) return;
     uint64_t start_cp_idx = 0;                    // code-point index
     size_t current_byte_len = strlen(s->string);  // Get initial byte length for boundary checks
     // Find the first non-space character from the beginning (code-point wise)
     while (start_cp_idx < s->length) {
-        ptrdiff_t byte_offset = oc_utf8_offset_for_index(s->string, start_cp_idx);
+        ptrdiff_t byte_offset = impl_OCStringOffsetForIndex(s, start_cp_idx);
         if (byte_offset < 0 || (size_t)byte_offset >= current_byte_len) {
             // Invalid offset or past end of actual C-string, stop.
             break;
@@ -661,6 +1559,7 @@ void OCStringTrimWhitespace(OCMutableStringRef s) {
         }
         s->length = 0;
         s->capacity = 0;  // strlen("") is 0
+        impl_OCStringResetIndex(s, true);
         return;
     }
     // Create substring from the trimmed range
@@ -678,6 +1577,7 @@ void OCStringTrimWhitespace(OCMutableStringRef s) {
         }
         s->length = 0;
         s->capacity = 0;
+        impl_OCStringResetIndex(s, true);
         return;
     }
     // Replace the content of 's' with the content of 'sub'
@@ -693,10 +1593,11 @@ void OCStringTrimWhitespace(OCMutableStringRef s) {
     }
     s->capacity = strlen(s->string);  // Byte capacity from the new string
     s->length = sub->length;          // Code-point length from 'sub'
+    impl_OCStringResetIndex(s, sub->isASCII);
     OCRelease(sub);                   // Release the temporary substring 'sub'
 }
 bool OCStringTrimMatchingParentheses(OCMutableStringRef s) {
-    if (!s || !s->string || s->length < 2) return false;  // Added s->string check
+    if (!s || !impl_OCStringFlatten(s) || !s->string || s->length < 2) return false;  // Added s->string check
     bool trimmed = false;
     // Trim only one layer of parentheses as per test expectation for ((double)) -> (double)
     if (OCStringGetCharacterAtIndex(s, 0) == '(' &&
@@ -708,9 +1609,20 @@ bool OCStringTrimMatchingParentheses(OCMutableStringRef s) {
     }
     return trimmed;
 }
+// ——— Plain "a", "b*I" or "a±b•I" literals parsed in place, skipping the expression parser ———
+static bool impl_OCStringParsePlainComplex(OCStringRef string, double complex* out) {
+    if (!impl_OCStringFlatten(string)) return false;
+    const char* first = string->string;
+    const char* last = first + impl_OCStringByteLength(string);
+    while (first < last && (*first == ' ' || *first == '\t')) first++;
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t')) last--;
+    return first < last && OCComplexFromChars(first, last, out) == (size_t)(last - first);
+}
 // ——— Extract a float-precision complex value from an OCString ———
 float complex OCStringGetFloatComplexValue(OCStringRef string) {
     if (!string) return nanf("") + nanf("") * I;
+    double complex z;
+    if (impl_OCStringParsePlainComplex(string, &z)) return (float complex)z;
     // Replace ‘•’ with ‘*’ for multiplication
     OCMutableStringRef m = OCStringCreateMutableCopy(string);
     OCStringFindAndReplace2(m, STR("•"), STR("*"));
@@ -721,6 +1633,8 @@ float complex OCStringGetFloatComplexValue(OCStringRef string) {
 // ——— Extract a double-precision complex value from an OCString ———
 double complex OCStringGetDoubleComplexValue(OCStringRef string) {
     if (!string) return nan("") + nan("") * I;
+    double complex z;
+    if (impl_OCStringParsePlainComplex(string, &z)) return z;
     OCMutableStringRef m = OCStringCreateMutableCopy(string);
     OCStringFindAndReplace2(m, STR("•"), STR("*"));
     double complex v = OCComplexFromCString(m->string);
@@ -729,35 +1643,34 @@ double complex OCStringGetDoubleComplexValue(OCStringRef string) {
 }
 // ——— Create an OCString representing a float value ———
 OCStringRef OCFloatCreateStringValue(float value) {
-    // Determine needed buffer size
-    int n = snprintf(NULL, 0, "%g", value);
-    char* buf = malloc(n + 1);
-    if (NULL == buf) {
-        fprintf(stderr, "OCFloatCreateStringValue: Memory allocation failed for string buffer.\n");
-        return NULL;
-    }
-    snprintf(buf, n + 1, "%g", value);
-    OCStringRef s = OCStringCreateWithCString(buf);
-    free(buf);
-    return s;
+    char buf[kOCShortestFloatingPointStringSize];
+    if (OCFloatWriteShortestCString(value, buf, sizeof(buf)) < 0) return NULL;
+    return OCStringCreateWithCString(buf);
 }
 // ——— Create an OCString representing a double value ———
 OCStringRef OCDoubleCreateStringValue(double value) {
-    int n = snprintf(NULL, 0, "%g", value);
-    char* buf = malloc(n + 1);
-    if (NULL == buf) {
-        fprintf(stderr, "OCDoubleCreateStringValue: Memory allocation failed for string buffer.\n");
-        return NULL;
-    }
-    snprintf(buf, n + 1, "%g", value);
-    OCStringRef s = OCStringCreateWithCString(buf);
-    free(buf);
-    return s;
+    char buf[kOCShortestFloatingPointStringSize];
+    if (OCDoubleWriteShortestCString(value, buf, sizeof(buf)) < 0) return NULL;
+    return OCStringCreateWithCString(buf);
+}
+// ——— Shortest "re±imi" text for the default complex format ———
+static OCStringRef impl_OCComplexCreateShortestString(const char* re, const char* im) {
+    char buf[2 * kOCShortestFloatingPointStringSize + 2];
+    snprintf(buf, sizeof(buf), "%s%s%si", re, im[0] == '-' ? "" : "+", im);
+    return OCStringCreateWithCString(buf);
 }
 // ——— Create an OCString representing a float complex value using a format OCString ———
-// Format string must include two specifiers, e.g. "%g%+gi"
+// Format string must include two specifiers, e.g. "%g%+gi"; NULL gives the
+// shortest round-trip form of both parts, e.g. "1.5-0.25i"
 OCStringRef OCFloatComplexCreateStringValue(float complex v, OCStringRef format) {
-    const char* fmt = format ? format->string : "%g%+gi";
+    if (!format) {
+        char re[kOCShortestFloatingPointStringSize], im[kOCShortestFloatingPointStringSize];
+        OCFloatWriteShortestCString(crealf(v), re, sizeof(re));
+        OCFloatWriteShortestCString(cimagf(v), im, sizeof(im));
+        return impl_OCComplexCreateShortestString(re, im);
+    }
+    const char* fmt = impl_OCStringReadCString(format);
+    if (!fmt) return NULL;
     double real = crealf(v), imag = cimagf(v);
     int n = snprintf(NULL, 0, fmt, real, imag);
     char* buf = malloc(n + 1);
@@ -772,7 +1685,14 @@ OCStringRef OCFloatComplexCreateStringValue(float complex v, OCStringRef format)
 }
 // ——— Create an OCString representing a double complex value using a format OCString ———
 OCStringRef OCDoubleComplexCreateStringValue(double complex v, OCStringRef format) {
-    const char* fmt = format ? format->string : "%g%+gi";
+    if (!format) {
+        char re[kOCShortestFloatingPointStringSize], im[kOCShortestFloatingPointStringSize];
+        OCDoubleWriteShortestCString(creal(v), re, sizeof(re));
+        OCDoubleWriteShortestCString(cimag(v), im, sizeof(im));
+        return impl_OCComplexCreateShortestString(re, im);
+    }
+    const char* fmt = impl_OCStringReadCString(format);
+    if (!fmt) return NULL;
     double real = creal(v), imag = cimag(v);
     int n = snprintf(NULL, 0, fmt, real, imag);
     char* buf = malloc(n + 1);
@@ -789,7 +1709,8 @@ OCStringRef OCDoubleComplexCreateStringValue(double complex v, OCStringRef forma
 OCRange OCStringFind(OCStringRef string,
                      OCStringRef stringToFind,
                      OCOptionFlags compareOptions) {
-    if (!string || !stringToFind || !string->string || !stringToFind->string) {
+    if (!string || !stringToFind || !impl_OCStringFlatten(string) || !impl_OCStringFlatten(stringToFind) ||
+        !string->string || !stringToFind->string) {
         return OCRangeMake(kOCNotFound, 0);
     }
     OCRange result_range;
@@ -803,22 +1724,61 @@ OCRange OCStringFind(OCStringRef string,
         return OCRangeMake(kOCNotFound, 0);
     }
 }
+// ——— Replace every match of findStr inside s's bytes [b0, b1) in a single pass ———
+// Counts the matches, then builds the result in one exact-size allocation.
+static int64_t impl_OCStringReplaceInByteRange(OCMutableStringRef s,
+                                               size_t b0,
+                                               size_t b1,
+                                               OCStringRef findStr,
+                                               OCStringRef replaceStr,
+                                               bool fold) {
+    size_t findBytes = impl_OCStringByteLength(findStr);
+    size_t repBytes = impl_OCStringByteLength(replaceStr);
+    if (findBytes == 0 || b1 < b0 || b1 - b0 < findBytes) return 0;
+    oc_searcher sr;
+    oc_searcher_init(&sr, findStr->string, findBytes, fold);
+    int64_t count = 0;
+    for (ptrdiff_t at = oc_searcher_find(&sr, s->string, b1, b0); at >= 0;
+         at = oc_searcher_find(&sr, s->string, b1, (size_t)at + findBytes)) {
+        count++;
+    }
+    if (count == 0) return 0;
+    size_t origBytes = impl_OCStringByteLength(s);
+    size_t newBytes = origBytes - (size_t)count * findBytes + (size_t)count * repBytes;
+    char* newBuf = malloc(newBytes + 1);
+    if (NULL == newBuf) {
+        fprintf(stderr, "OCStringFindAndReplace: Memory allocation failed for new string buffer.\n");
+        return 0;
+    }
+    char* out = newBuf;
+    memcpy(out, s->string, b0);
+    out += b0;
+    size_t cursor = b0;
+    for (ptrdiff_t at = oc_searcher_find(&sr, s->string, b1, b0); at >= 0;
+         at = oc_searcher_find(&sr, s->string, b1, (size_t)at + findBytes)) {
+        memcpy(out, s->string + cursor, (size_t)at - cursor);
+        out += (size_t)at - cursor;
+        memcpy(out, replaceStr->string, repBytes);
+        out += repBytes;
+        cursor = (size_t)at + findBytes;
+    }
+    memcpy(out, s->string + cursor, origBytes - cursor);
+    newBuf[newBytes] = '\0';
+    free(s->string);
+    s->string = newBuf;
+    s->capacity = newBytes;
+    impl_OCStringResetIndex(s, oc_utf8_is_ascii(newBuf, newBytes));
+    s->length = s->isASCII ? newBytes : oc_utf8_strlen_n(newBuf, newBytes);
+    return count;
+}
 // ——— Replace all literal occurrences in the entire string ———
 int64_t OCStringFindAndReplace2(OCMutableStringRef s,
                                 OCStringRef findStr,
                                 OCStringRef replaceStr) {
     if (!s || !findStr || !replaceStr) return 0;
-    int64_t count = 0;
-    char* newBuf = str_replace(s->string,
-                               findStr->string,
-                               replaceStr->string,
-                               &count);
-    if (!newBuf) return 0;
-    free(s->string);
-    s->string = newBuf;
-    s->capacity = strlen(newBuf);
-    s->length = oc_utf8_strlen(newBuf);
-    return count;
+    if (!impl_OCStringFlatten(findStr) || !impl_OCStringFlatten(replaceStr)) return 0;
+    if (!impl_OCStringCString(s) || !findStr->string || !replaceStr->string) return 0;
+    return impl_OCStringReplaceInByteRange(s, 0, strlen(s->string), findStr, replaceStr, false);
 }
 // ——— Replace within a specified code-point range ———
 int64_t OCStringFindAndReplace(OCMutableStringRef s,
@@ -826,7 +1786,8 @@ int64_t OCStringFindAndReplace(OCMutableStringRef s,
                                OCStringRef replaceStr,
                                OCRange rangeToSearch,
                                OCOptionFlags compareOptions) {
-    if (!s || !s->string || !findStr || !replaceStr || !findStr->string || !replaceStr->string) {
+    if (!s || !findStr || !replaceStr || !impl_OCStringFlatten(s) || !impl_OCStringFlatten(findStr) ||
+        !impl_OCStringFlatten(replaceStr) || !s->string || !findStr->string || !replaceStr->string) {
         // Ensure all string objects and their internal C-strings are valid
         return 0;
     }
@@ -842,48 +1803,18 @@ int64_t OCStringFindAndReplace(OCMutableStringRef s,
     if (rangeToSearch.length < 0 || (uint64_t)rangeToSearch.location + (uint64_t)rangeToSearch.length > s->length) {
         rangeToSearch.length = s->length - (uint64_t)rangeToSearch.location;
     }
-    // If the effective search range is empty, no match is possible.
-    if (rangeToSearch.length == 0) {
-        return 0;
-    }
     // If search range is shorter than findStr, no match is possible.
-    if (rangeToSearch.length < 0 || (uint64_t)rangeToSearch.length < findStr->length) {
+    if (rangeToSearch.length == 0 || (uint64_t)rangeToSearch.length < findStr->length) {
         return 0;
     }
-    int64_t count = 0;
-    uint64_t scan_start_location_in_s = rangeToSearch.location;
-    // This is the end boundary of the original search area, relative to the original string 's'.
-    // We need to track this because 's' will change length.
-    uint64_t original_search_area_end_location_in_s = rangeToSearch.location + rangeToSearch.length;
-    int64_t cumulative_length_change = 0;  // Tracks total change in s->length due to replacements
-    while (true) {
-        // Calculate the current effective end of the search area in 's', accounting for length changes
-        uint64_t current_effective_search_area_end_in_s = original_search_area_end_location_in_s + cumulative_length_change;
-        // Stop if scan_start_location_in_s has reached or passed the end of 's' or the effective search area
-        if (scan_start_location_in_s >= s->length || scan_start_location_in_s >= current_effective_search_area_end_in_s) {
-            break;
-        }
-        OCRange current_look_in_range;
-        current_look_in_range.location = scan_start_location_in_s;
-        current_look_in_range.length = current_effective_search_area_end_in_s - scan_start_location_in_s;
-        // If remaining search length is less than findStr's length, no more matches are possible
-        if (current_look_in_range.length < 0 || (uint64_t)current_look_in_range.length < findStr->length) {
-            break;
-        }
-        OCRange found_at_range_in_s;  // Will store the range of the found substring in the current state of 's'
-        if (OCStringFindWithOptions(s, findStr, current_look_in_range, compareOptions, &found_at_range_in_s)) {
-            OCStringReplace(s, found_at_range_in_s, replaceStr);
-            count++;
-            // Update the cumulative length change
-            cumulative_length_change += ((int64_t)replaceStr->length - (int64_t)findStr->length);
-            // Advance the scan_start_location_in_s to the position immediately after the inserted replaceStr
-            scan_start_location_in_s = found_at_range_in_s.location + replaceStr->length;
-        } else {
-            // No more occurrences of findStr in the remaining search range
-            break;
-        }
-    }
-    return count;
+    if (!impl_OCStringCString(s)) return 0;
+    // Map the code-point range to bytes and replace all matches in one pass
+    ptrdiff_t b0 = impl_OCStringOffsetForIndex(s, rangeToSearch.location);
+    ptrdiff_t b1 = impl_OCStringOffsetForIndex(s, rangeToSearch.location + rangeToSearch.length);
+    if (b0 < 0) return 0;
+    if (b1 < 0) b1 = (ptrdiff_t)strlen(s->string);
+    return impl_OCStringReplaceInByteRange(s, (size_t)b0, (size_t)b1, findStr, replaceStr,
+                                           (compareOptions & kOCCompareCaseInsensitive) != 0);
 }
 // ——— Character-type helper functions (ASCII only) ———
 bool characterIsUpperCaseLetter(uint32_t character) {
@@ -903,7 +1834,7 @@ bool characterIsDigitOrDecimalPointOrSpace(uint32_t character) {
 // UTF-8 helpers must already be in scope:
 //   static uint32_t utf8_next(const char **p);
 //   static ptrdiff_t oc_utf8_offset_for_index(const char *s, size_t idx);
-//   static size_t    oc_utf8_strlen(const char *s);
+//   static size_t    oc_utf8_strlen_n(const char *s, size_t n);
 /**
  * @brief Finds a substring within an OCString with specified options.
  * @param string        Source OCString.
@@ -919,6 +1850,7 @@ bool OCStringFindWithOptions(OCStringRef string,
                              OCOptionFlags compareOptions,
                              OCRange* result) {
     if (!string || !stringToFind || !result) return false;
+    if (!impl_OCStringFlatten(string) || !impl_OCStringFlatten(stringToFind)) return false;
     uint64_t strLen = OCStringGetLength(string);
     uint64_t needleLen = OCStringGetLength(stringToFind);
     // Sanity: empty needle or out-of-bounds or not enough space to find needle
@@ -928,28 +1860,73 @@ bool OCStringFindWithOptions(OCStringRef string,
         needleLen > (uint64_t)rangeToSearch.length) {
         return false;
     }
-    bool caseInsensitive = (compareOptions & kOCCompareCaseInsensitive) != 0;
-    uint64_t maxStart = (uint64_t)rangeToSearch.location + (uint64_t)rangeToSearch.length - needleLen;
-    for (uint64_t pos = (uint64_t)rangeToSearch.location; pos <= maxStart; ++pos) {
-        bool match = true;
-        for (uint64_t j = 0; j < needleLen; ++j) {
-            uint32_t c1 = OCStringGetCharacterAtIndex(string, pos + j);
-            uint32_t c2 = OCStringGetCharacterAtIndex(stringToFind, j);
-            if (caseInsensitive) {
-                if (c1 >= 'A' && c1 <= 'Z') c1 += 'a' - 'A';
-                if (c2 >= 'A' && c2 <= 'Z') c2 += 'a' - 'A';
-            }
-            if (c1 != c2) {
-                match = false;
-                break;
+    if (!string->string || !stringToFind->string) return false;
+    // Search the bytes of the requested range, then map the hit back to a code-point index
+    ptrdiff_t b0 = impl_OCStringOffsetForIndex(string, rangeToSearch.location);
+    ptrdiff_t b1 = impl_OCStringOffsetForIndex(string, rangeToSearch.location + rangeToSearch.length);
+    if (b0 < 0) return false;
+    if (b1 < 0) b1 = (ptrdiff_t)impl_OCStringByteLength(string);
+    oc_searcher sr;
+    oc_searcher_init(&sr, stringToFind->string, impl_OCStringByteLength(stringToFind),
+                     (compareOptions & kOCCompareCaseInsensitive) != 0);
+    ptrdiff_t at = oc_searcher_find(&sr, string->string, (size_t)b1, (size_t)b0);
+    if (at < 0) return false;
+    uint64_t pos = (uint64_t)rangeToSearch.location +
+                   (string->isASCII ? (uint64_t)(at - b0)
+                                    : oc_utf8_count_between(string->string + b0, string->string + at));
+    *result = OCRangeMake(pos, needleLen);
+    return true;
+}
+// ——— Collect every non-overlapping match in a code-point range ———
+// Stores (location, length) pairs in a malloc'd array and returns the count,
+// or -1 on allocation failure. Code-point positions are accumulated
+// incrementally so the whole scan is linear in the searched bytes.
+static OCIndex impl_OCStringFindAllPairs(OCStringRef string,
+                                         OCStringRef stringToFind,
+                                         OCRange rangeToSearch,
+                                         OCOptionFlags compareOptions,
+                                         OCIndexPair** outPairs) {
+    *outPairs = NULL;
+    if (!impl_OCStringFlatten(string) || !impl_OCStringFlatten(stringToFind)) return -1;
+    if (!string->string || !stringToFind->string || stringToFind->length == 0) return 0;
+    // Clip the search range to the string’s length
+    if (rangeToSearch.location < 0 || (uint64_t)rangeToSearch.location > string->length) return 0;
+    if (rangeToSearch.length < 0 || (uint64_t)rangeToSearch.location + (uint64_t)rangeToSearch.length > string->length) {
+        rangeToSearch.length = string->length - (uint64_t)rangeToSearch.location;
+    }
+    ptrdiff_t b0 = impl_OCStringOffsetForIndex(string, rangeToSearch.location);
+    ptrdiff_t b1 = impl_OCStringOffsetForIndex(string, rangeToSearch.location + rangeToSearch.length);
+    if (b0 < 0) return 0;
+    if (b1 < 0) b1 = (ptrdiff_t)impl_OCStringByteLength(string);
+    size_t findBytes = impl_OCStringByteLength(stringToFind);
+    oc_searcher sr;
+    oc_searcher_init(&sr, stringToFind->string, findBytes, (compareOptions & kOCCompareCaseInsensitive) != 0);
+    OCIndexPair* pairs = NULL;
+    OCIndex count = 0, capacity = 0;
+    size_t cursorByte = (size_t)b0;
+    uint64_t cursorCp = (uint64_t)rangeToSearch.location;
+    for (ptrdiff_t at = oc_searcher_find(&sr, string->string, (size_t)b1, (size_t)b0); at >= 0;
+         at = oc_searcher_find(&sr, string->string, (size_t)b1, (size_t)at + findBytes)) {
+        cursorCp += string->isASCII ? (uint64_t)((size_t)at - cursorByte)
+                                    : oc_utf8_count_between(string->string + cursorByte, string->string + at);
+        cursorByte = (size_t)at;
+        if (count == capacity) {
+            OCIndex newCapacity = capacity ? capacity * 2 : 8;
+            OCIndexPair* grown = realloc(pairs, (size_t)newCapacity * sizeof(OCIndexPair));
+            if (!grown) {
+                fprintf(stderr, "OCStringFindAll: Memory allocation failed for match ranges.\n");
+                free(pairs);
+                return -1;
             }
+            pairs = grown;
+            capacity = newCapacity;
         }
-        if (match) {
-            *result = OCRangeMake(pos, needleLen);
-            return true;
-        }
+        pairs[count].index = (OCIndex)cursorCp;
+        pairs[count].value = (OCIndex)stringToFind->length;
+        count++;
     }
-    return false;
+    *outPairs = pairs;
+    return count;
 }
 OCComparisonResult
 OCStringCompare(OCStringRef theString1,
@@ -959,45 +1936,71 @@ OCStringCompare(OCStringRef theString1,
     if (theString1 == theString2) return kOCCompareEqualTo;
     if (theString1 == NULL) return kOCCompareLessThan;
     if (theString2 == NULL) return kOCCompareGreaterThan;
+    impl_OCStringFlatten(theString1);
+    impl_OCStringFlatten(theString2);
     const char* s1 = theString1->string;
     const char* s2 = theString2->string;
+    size_t n1 = impl_OCStringByteLength(theString1);
+    size_t n2 = impl_OCStringByteLength(theString2);
+    size_t n = n1 < n2 ? n1 : n2;
     int diff;
     if (compareOptions & kOCCompareCaseInsensitive) {
         // ASCII-only case-insensitive
-        diff = strcasecmp(s1, s2);
+        diff = strncasecmp(s1, s2, n);
     } else {
         // Literal byte-wise UTF-8 comparison
-        diff = strcmp(s1, s2);
+        diff = memcmp(s1, s2, n);
     }
+    if (diff == 0) diff = (n1 > n2) - (n1 < n2);  // a proper prefix sorts first
     if (diff < 0) return kOCCompareLessThan;
     if (diff > 0) return kOCCompareGreaterThan;
     return kOCCompareEqualTo;
 }
+uint64_t OCStringHash(OCStringRef theString) {
+    if (!theString || !impl_OCStringFlatten(theString)) return 0;
+    // 64-bit FNV-1a over the bytes, finished with a murmur-style mix so the
+    // low bits used by hash tables depend on every input byte
+    const unsigned char* p = (const unsigned char*)theString->string;
+    size_t n = impl_OCStringByteLength(theString);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+// The byte at p, or NUL at or past end; formats need not be NUL-terminated
+static inline char impl_OCFormatByteAt(const char* p, const char* end) {
+    return p < end ? *p : '\0';
+}
 // Returns a pointer just after the full specifier, writes up to maxlen bytes (including NUL) to out.
-static const char* parse_printf_spec(const char* p, char* out, size_t maxlen, char* lenmod, size_t lenmod_max) {
+static const char* parse_printf_spec(const char* p, const char* end, char* out, size_t maxlen, char* lenmod, size_t lenmod_max) {
     const char* start = p;
     *lenmod = 0;
-    if (*p != '%') return NULL;
+    if (impl_OCFormatByteAt(p, end) != '%') return NULL;
     p++;  // skip '%'
     // Flags
-    while (strchr("-+ #0", *p)) p++;
+    while (impl_OCFormatByteAt(p, end) && strchr("-+ #0", *p)) p++;
     // Width
-    while (*p >= '0' && *p <= '9') p++;
-    if (*p == '*') p++;
+    while (impl_OCFormatByteAt(p, end) >= '0' && impl_OCFormatByteAt(p, end) <= '9') p++;
+    if (impl_OCFormatByteAt(p, end) == '*') p++;
     // Precision
-    if (*p == '.') {
+    if (impl_OCFormatByteAt(p, end) == '.') {
         p++;
-        while (*p >= '0' && *p <= '9') p++;
-        if (*p == '*') p++;
+        while (impl_OCFormatByteAt(p, end) >= '0' && impl_OCFormatByteAt(p, end) <= '9') p++;
+        if (impl_OCFormatByteAt(p, end) == '*') p++;
     }
     // Length modifier ("hh", "h", "ll", "l", "j", "z", "t", "L", possibly more)
-    if ((p[0] == 'h' && p[1] == 'h')) {
+    if (impl_OCFormatByteAt(p, end) == 'h' && impl_OCFormatByteAt(p + 1, end) == 'h') {
         strncpy(lenmod, "hh", lenmod_max);
         p += 2;
-    } else if ((p[0] == 'l' && p[1] == 'l')) {
+    } else if (impl_OCFormatByteAt(p, end) == 'l' && impl_OCFormatByteAt(p + 1, end) == 'l') {
         strncpy(lenmod, "ll", lenmod_max);
         p += 2;
-    } else if (strchr("hljztL", *p)) {
+    } else if (impl_OCFormatByteAt(p, end) && strchr("hljztL", *p)) {
         lenmod[0] = *p;
         lenmod[1] = 0;
         p++;
@@ -1005,13 +2008,239 @@ static const char* parse_printf_spec(const char* p, char* out, size_t maxlen, ch
         lenmod[0] = 0;
     }
     // Conversion specifier
-    if (*p) p++;
+    if (impl_OCFormatByteAt(p, end)) p++;
     size_t len = (size_t)(p - start);
     if (len >= maxlen) len = maxlen - 1;
     memcpy(out, start, len);
     out[len] = '\0';
     return p;
 }
+// ——— Compiled format strings ———
+// A format is parsed once into a flat list of ops: literal byte runs, %@
+// insertions and printf conversions. Immutable formats (including every STR()
+// constant) keep their list in compiledFormat, so repeated calls skip parsing.
+typedef enum {
+    kOCFormatOpLiteral,   // bytes [offset, offset + length) of the format
+    kOCFormatOpObject,    // %@
+    kOCFormatOpSigned,    // d i
+    kOCFormatOpUnsigned,  // u x X o
+    kOCFormatOpDouble,    // f e E g G a A
+    kOCFormatOpCString,   // s
+    kOCFormatOpChar,      // c
+    kOCFormatOpPointer,   // p
+    kOCFormatOpVerbatim   // unknown conversion, emitted as written
+} impl_OCFormatOpKind;
+typedef enum {
+    kOCFormatLengthDefault,
+    kOCFormatLengthHH,
+    kOCFormatLengthH,
+    kOCFormatLengthL,
+    kOCFormatLengthLL,
+    kOCFormatLengthZ,
+    kOCFormatLengthJ,
+    kOCFormatLengthT,
+    kOCFormatLengthLongDouble,
+    kOCFormatLengthIncomplete  // trailing specifier with no conversion character
+} impl_OCFormatLength;
+typedef struct {
+    uint8_t kind;
+    uint8_t lengthModifier;
+    uint32_t offset;
+    uint32_t length;
+    char spec[32];  // conversions: the NUL-terminated printf spec, e.g. "%08.3f"
+} impl_OCFormatOp;
+struct impl_OCCompiledFormat {
+    uint32_t opCount;
+    int argCount;          // conversions that consume an argument
+    size_t literalBytes;   // total literal output, used to pre-size the destination
+    impl_OCFormatOp ops[];
+};
+static struct impl_OCCompiledFormat* impl_OCFormatAddOp(struct impl_OCCompiledFormat* cf, uint32_t* capacity, impl_OCFormatOp op) {
+    if (cf->opCount == *capacity) {
+        uint32_t newCapacity = *capacity * 2;
+        struct impl_OCCompiledFormat* grown = realloc(cf, sizeof(*cf) + newCapacity * sizeof(impl_OCFormatOp));
+        if (!grown) {
+            free(cf);
+            return NULL;
+        }
+        cf = grown;
+        *capacity = newCapacity;
+    }
+    cf->ops[cf->opCount++] = op;
+    if (op.kind == kOCFormatOpLiteral) cf->literalBytes += op.length;
+    return cf;
+}
+// Compiles the byteCount bytes at format, which need not be NUL-terminated
+static struct impl_OCCompiledFormat* impl_OCFormatCompile(const char* format, size_t byteCount) {
+    uint32_t capacity = 8;
+    struct impl_OCCompiledFormat* cf = malloc(sizeof(*cf) + capacity * sizeof(impl_OCFormatOp));
+    if (!cf) return NULL;
+    cf->opCount = 0;
+    cf->argCount = 0;
+    cf->literalBytes = 0;
+    const char* p = format;
+    const char* lit = format;
+    const char* end = format + byteCount;
+    while (cf && p < end && *p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        impl_OCFormatOp op = {0};
+        op.kind = kOCFormatOpLiteral;
+        op.offset = (uint32_t)(lit - format);
+        if (impl_OCFormatByteAt(p + 1, end) == '%') {
+            // Literal run up to and including one '%'
+            op.length = (uint32_t)(p + 1 - lit);
+            cf = impl_OCFormatAddOp(cf, &capacity, op);
+            p += 2;
+            lit = p;
+            continue;
+        }
+        if (p > lit) {
+            op.length = (uint32_t)(p - lit);
+            cf = impl_OCFormatAddOp(cf, &capacity, op);
+            if (!cf) break;
+        }
+        memset(&op, 0, sizeof(op));
+        if (impl_OCFormatByteAt(p + 1, end) == '@') {
+            op.kind = kOCFormatOpObject;
+            p += 2;
+        } else {
+            char lenmod[4];
+            p = parse_printf_spec(p, end, op.spec, sizeof(op.spec), lenmod, sizeof(lenmod));
+            char spec = op.spec[strlen(op.spec) - 1];
+            if (strcmp(lenmod, "hh") == 0) op.lengthModifier = kOCFormatLengthHH;
+            else if (strcmp(lenmod, "h") == 0) op.lengthModifier = kOCFormatLengthH;
+            else if (strcmp(lenmod, "l") == 0) op.lengthModifier = kOCFormatLengthL;
+            else if (strcmp(lenmod, "ll") == 0) op.lengthModifier = kOCFormatLengthLL;
+            else if (strcmp(lenmod, "z") == 0) op.lengthModifier = kOCFormatLengthZ;
+            else if (strcmp(lenmod, "j") == 0) op.lengthModifier = kOCFormatLengthJ;
+            else if (strcmp(lenmod, "t") == 0) op.lengthModifier = kOCFormatLengthT;
+            else if (strcmp(lenmod, "L") == 0) op.lengthModifier = kOCFormatLengthLongDouble;
+            if (spec == 'd' || spec == 'i') op.kind = kOCFormatOpSigned;
+            else if (spec == 'u' || spec == 'x' || spec == 'X' || spec == 'o') op.kind = kOCFormatOpUnsigned;
+            else if (strchr("feEgGaA", spec)) op.kind = kOCFormatOpDouble;
+            else if (spec == 's') op.kind = kOCFormatOpCString;
+            else if (spec == 'c') op.kind = kOCFormatOpChar;
+            else if (spec == 'p') op.kind = kOCFormatOpPointer;
+            else op.kind = kOCFormatOpVerbatim;
+            // A specifier cut off by the end of the format has no conversion and takes no argument
+            if (!impl_OCFormatByteAt(p, end) && (op.spec[1] == '\0' || strchr("-+ #0123456789*.hljztL", spec))) op.lengthModifier = kOCFormatLengthIncomplete;
+        }
+        if (op.lengthModifier != kOCFormatLengthIncomplete) cf->argCount++;
+        cf = impl_OCFormatAddOp(cf, &capacity, op);
+        lit = p;
+    }
+    if (cf && p > lit) {
+        impl_OCFormatOp op = {0};
+        op.kind = kOCFormatOpLiteral;
+        op.offset = (uint32_t)(lit - format);
+        op.length = (uint32_t)(p - lit);
+        cf = impl_OCFormatAddOp(cf, &capacity, op);
+    }
+    return cf;
+}
+// ——— Look up (or build and cache) the compiled form of a format string ———
+// Formats that may still change are compiled into *owned for one-time use.
+static const struct impl_OCCompiledFormat* impl_OCStringGetCompiledFormat(OCStringRef format,
+                                                                         struct impl_OCCompiledFormat** owned) {
+    struct impl_OCString* f = (struct impl_OCString*)format;
+    *owned = NULL;
+#if defined(__GNUC__) || defined(__clang__)
+    struct impl_OCCompiledFormat* cached = __atomic_load_n(&f->compiledFormat, __ATOMIC_ACQUIRE);
+#else
+    struct impl_OCCompiledFormat* cached = f->compiledFormat;
+#endif
+    if (cached) return cached;
+    // Compile from the bytes in place: a shared view has no terminator and
+    // must not be given one
+    if (!impl_OCStringFlatten(format) || !format->string) return NULL;
+    struct impl_OCCompiledFormat* cf = impl_OCFormatCompile(format->string, impl_OCStringByteLength(format));
+    if (!cf) {
+        fprintf(stderr, "OCStringCreateWithFormat: Memory allocation failed for compiled format.\n");
+        return NULL;
+    }
+    if (f->isMutable) {
+        *owned = cf;
+        return cf;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    // Constant formats are shared between threads; keep whichever compile lands first
+    struct impl_OCCompiledFormat* expected = NULL;
+    if (!__atomic_compare_exchange_n(&f->compiledFormat, &expected, cf, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(cf);
+        return expected;
+    }
+#else
+    f->compiledFormat = cf;
+#endif
+    return cf;
+}
+// ——— Grow a mutable string's buffer to hold at least 'needed' content bytes ———
+static bool impl_OCStringReserve(OCMutableStringRef s, size_t needed) {
+    if (needed <= s->capacity) return true;
+    uint64_t new_capacity = s->capacity ? s->capacity : 16;
+    while (needed > new_capacity) new_capacity *= 2;
+    char* grown = realloc(s->string, new_capacity + 1);  // +1 for NUL
+    if (NULL == grown) {
+        fprintf(stderr, "OCStringAppendFormat: Memory allocation failed for string buffer.\n");
+        return false;
+    }
+    s->string = grown;
+    s->capacity = new_capacity;
+    return true;
+}
+typedef union {
+    int i;
+    long l;
+    long long ll;
+    unsigned int u;
+    unsigned long ul;
+    unsigned long long ull;
+    size_t z;
+    ptrdiff_t t;
+    intmax_t j;
+    uintmax_t uj;
+    double d;
+    long double ld;
+    const char* s;
+    const void* p;
+} impl_OCFormatArg;
+// Formats one conversion into dst (snprintf semantics: returns the full length).
+static int impl_OCFormatConversion(char* dst, size_t size, const impl_OCFormatOp* op, const impl_OCFormatArg* v) {
+    switch (op->kind) {
+        case kOCFormatOpSigned:
+            switch (op->lengthModifier) {
+                case kOCFormatLengthLL: return snprintf(dst, size, op->spec, v->ll);
+                case kOCFormatLengthL: return snprintf(dst, size, op->spec, v->l);
+                case kOCFormatLengthZ:
+                case kOCFormatLengthT: return snprintf(dst, size, op->spec, v->t);
+                case kOCFormatLengthJ: return snprintf(dst, size, op->spec, v->j);
+                case kOCFormatLengthH: return snprintf(dst, size, op->spec, (short)v->i);          // 'short' promoted to int
+                case kOCFormatLengthHH: return snprintf(dst, size, op->spec, (signed char)v->i);   // 'char' promoted
+                default: return snprintf(dst, size, op->spec, v->i);
+            }
+        case kOCFormatOpUnsigned:
+            switch (op->lengthModifier) {
+                case kOCFormatLengthLL: return snprintf(dst, size, op->spec, v->ull);
+                case kOCFormatLengthL: return snprintf(dst, size, op->spec, v->ul);
+                case kOCFormatLengthZ:
+                case kOCFormatLengthT: return snprintf(dst, size, op->spec, v->z);
+                case kOCFormatLengthJ: return snprintf(dst, size, op->spec, v->uj);
+                case kOCFormatLengthH: return snprintf(dst, size, op->spec, (unsigned short)v->u);
+                case kOCFormatLengthHH: return snprintf(dst, size, op->spec, (unsigned char)v->u);
+                default: return snprintf(dst, size, op->spec, v->u);
+            }
+        case kOCFormatOpDouble:
+            if (op->lengthModifier == kOCFormatLengthLongDouble) return snprintf(dst, size, op->spec, v->ld);
+            return snprintf(dst, size, op->spec, v->d);
+        case kOCFormatOpCString: return snprintf(dst, size, op->spec, v->s ? v->s : "(null)");
+        case kOCFormatOpChar: return snprintf(dst, size, op->spec, v->i);
+        case kOCFormatOpPointer: return snprintf(dst, size, op->spec, v->p);
+        default: return snprintf(dst, size, "%s", op->spec);
+    }
+}
 #ifdef _WIN32
 // Windows-specific: Signal handling for va_arg safety
 static jmp_buf va_arg_jmpbuf;
@@ -1028,19 +2257,41 @@ static void va_arg_signal_handler(int sig) {
  * @param result Mutable OCString.
  * @param format Format OCString.
  * @param args Variable arguments for the format string.
- * @param max_args Maximum number of arguments to process.
+ * @param outError Optional; receives a description of the first bad argument.
  * @ingroup OCString
  */
-// Pass arg_index by pointer to update it
 static void OCStringAppendFormatWithArgumentsSafe(
     OCMutableStringRef result,
     OCStringRef format,
     va_list args,
-    int max_args,
     OCStringRef* outError) {
-    if (!result || !format || !format->string) return;
-    int arg_index = 0;
+    if (!result || !format || !impl_OCStringFlatten(format) || !format->string) return;
+    if (result->usesRope) {
+        // Format into a flat scratch string, then add it to the rope as one edit
+        OCMutableStringRef scratch = OCStringCreateMutable(0);
+        if (!scratch) return;
+        OCStringAppendFormatWithArgumentsSafe(scratch, format, args, outError);
+        impl_OCStringAppendBytes(result, scratch->string, strlen(scratch->string));
+        OCRelease(scratch);
+        return;
+    }
+    if (!impl_OCStringCString(result)) return;
+    if ((OCStringRef)result == format) {
+        // The destination grows while the format is read; format from a snapshot
+        OCStringRef snapshot = OCStringCreateCopy(format);
+        if (!snapshot) return;
+        OCStringAppendFormatWithArgumentsSafe(result, snapshot, args, outError);
+        OCRelease(snapshot);
+        return;
+    }
+    struct impl_OCCompiledFormat* owned = NULL;
+    const struct impl_OCCompiledFormat* cf = impl_OCStringGetCompiledFormat(format, &owned);
+    if (!cf) return;
     const char* f = format->string;
+    int max_args = cf->argCount;
+    int arg_index = 0;
+    size_t start = strlen(result->string);
+    size_t pos = start;
     va_list arglist;
     va_copy(arglist, args);
 #ifdef _WIN32
@@ -1050,173 +2301,136 @@ static void OCStringAppendFormatWithArgumentsSafe(
     if (setjmp(va_arg_jmpbuf) != 0) {
         // We caught a segfault from va_arg - insufficient arguments
         fprintf(stderr, "[OCString] WARNING: Caught segfault due to insufficient arguments\n");
+        result->string[pos] = '\0';
         OCStringAppendCString(result, "[INSUFFICIENT_ARGS]");
         signal(SIGSEGV, old_handler);  // Restore original handler
         va_end(arglist);
+        free(owned);
         return;
     }
 #endif
-    while (*f) {
-        if (f[0] == '%' && f[1] == '@') {
-            if (arg_index >= max_args) {
-                OCStringAppendCString(result, "[MISSING]");
-                if (outError && !*outError) {
-                    *outError = STR("Not enough arguments for %@");
-                }
-                arg_index++;
-                f += 2;
-                continue;
-            } else {
-                OCStringRef s = va_arg(arglist, OCStringRef);
-                // Defensive: check plausibility before dereferencing
-                if (!s) {
-                    // DO NOT append "[NULL]"—skip, just set error
-                    if (outError && !*outError) {
-                        *outError = STR("NULL OCStringRef passed to %@");
-                    }
-                } else if ((uintptr_t)s < 4096) {  // catch NULL/tiny invalid pointers
-                    if (outError && !*outError) {
-                        *outError = STR("Invalid pointer passed to %@");
-                    }
-                } else if (s->base.typeID != OCStringGetTypeID()) {
-                    if (outError && !*outError) {
-                        *outError = STR("Invalid type passed to %@ (not an OCString)");
-                    }
-                } else if (s->string) {
-                    OCStringAppendCString(result, s->string);
-                } else {
-                    // Don't append, just set error
-                    if (outError && !*outError) {
-                        *outError = STR("OCStringRef has NULL string content");
-                    }
-                }
-                arg_index++;
-                f += 2;
-            }
-        } else if (f[0] == '%' && f[1] == '%') {
-            OCStringAppendCString(result, "%");
-            f += 2;
-        } else if (f[0] == '%') {
-            char subfmt[32], lenmod[4];
-            const char* after = parse_printf_spec(f, subfmt, sizeof(subfmt), lenmod, sizeof(lenmod));
-            if (!after) {
-                OCStringAppendCString(result, "%");
-                f++;
-                continue;
-            }
-            char spec = subfmt[strlen(subfmt) - 1];
-            char buf[128] = {0};
-            if (arg_index >= max_args) {
-                OCStringAppendCString(result, "[MISSING]");
-                if (outError && !*outError) {
-                    *outError = STR("Not enough arguments for printf format specifier");
-                }
-                arg_index++;
-                f = after;
-                continue;
+    // Size for the literal text plus a typical conversion width up front
+    if (!impl_OCStringReserve(result, pos + cf->literalBytes + 16 * (size_t)cf->argCount)) goto done;
+    for (uint32_t k = 0; k < cf->opCount; k++) {
+        const impl_OCFormatOp* op = &cf->ops[k];
+        if (op->kind == kOCFormatOpLiteral) {
+            if (!impl_OCStringReserve(result, pos + op->length)) goto done;
+            memcpy(result->string + pos, f + op->offset, op->length);
+            pos += op->length;
+            continue;
+        }
+        if (op->lengthModifier == kOCFormatLengthIncomplete) {
+            size_t n = strlen(op->spec);
+            if (!impl_OCStringReserve(result, pos + n)) goto done;
+            memcpy(result->string + pos, op->spec, n);
+            pos += n;
+            continue;
+        }
+        if (arg_index >= max_args) {
+            static const char missing[] = "[MISSING]";
+            if (!impl_OCStringReserve(result, pos + sizeof(missing) - 1)) goto done;
+            memcpy(result->string + pos, missing, sizeof(missing) - 1);
+            pos += sizeof(missing) - 1;
+            if (outError && !*outError) {
+                *outError = op->kind == kOCFormatOpObject ? STR("Not enough arguments for %@")
+                                                          : STR("Not enough arguments for printf format specifier");
             }
-            // Now it's safe to va_arg (but C can't check type here)
-            if ((spec == 'd' || spec == 'i')) {
-                if (strcmp(lenmod, "ll") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, long long));
-                else if (strcmp(lenmod, "l") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, long));
-                else if (strcmp(lenmod, "h") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, (short)va_arg(arglist, int));  // 'short' promoted to int
-                else if (strcmp(lenmod, "hh") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, (signed char)va_arg(arglist, int));  // 'char' promoted
-                else
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, int));
-            } else if (spec == 'u' || spec == 'x' || spec == 'X' || spec == 'o') {
-                if (strcmp(lenmod, "ll") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, unsigned long long));
-                else if (strcmp(lenmod, "l") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, unsigned long));
-                else if (strcmp(lenmod, "h") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, (unsigned short)va_arg(arglist, unsigned int));
-                else if (strcmp(lenmod, "hh") == 0)
-                    snprintf(buf, sizeof(buf), subfmt, (unsigned char)va_arg(arglist, unsigned int));
-                else
-                    snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, unsigned int));
-            } else if (spec == 'f' || spec == 'e' || spec == 'E' || spec == 'g' || spec == 'G' || spec == 'a' || spec == 'A') {
-                snprintf(buf, sizeof(buf), subfmt, va_arg(arglist, double));
-            } else if (spec == 's') {
-                const char* v = va_arg(arglist, const char*);
-                snprintf(buf, sizeof(buf), subfmt, v ? v : "(null)");
-            } else if (spec == 'c') {
-                int v = va_arg(arglist, int);
-                snprintf(buf, sizeof(buf), subfmt, v);
-            } else if (spec == 'p') {
-                const void* v = va_arg(arglist, void*);
-                snprintf(buf, sizeof(buf), subfmt, v);
+            arg_index++;
+            continue;
+        }
+        if (op->kind == kOCFormatOpObject) {
+            OCStringRef s = va_arg(arglist, OCStringRef);
+            arg_index++;
+            // Defensive: check plausibility before dereferencing
+            if (!s) {
+                // DO NOT append "[NULL]"—skip, just set error
+                if (outError && !*outError) *outError = STR("NULL OCStringRef passed to %@");
+            } else if ((uintptr_t)s < 4096) {  // catch NULL/tiny invalid pointers
+                if (outError && !*outError) *outError = STR("Invalid pointer passed to %@");
+            } else if (s->base.typeID != OCStringGetTypeID()) {
+                if (outError && !*outError) *outError = STR("Invalid type passed to %@ (not an OCString)");
+            } else if (!impl_OCStringFlatten(s) || !s->string) {
+                // Rope builders are flattened first, as hashing and equality do;
+                // otherwise don't append, just set error
+                if (outError && !*outError) *outError = STR("OCStringRef has NULL string content");
             } else {
-                snprintf(buf, sizeof(buf), "%s", subfmt);
+                // Appending the destination to itself copies what has been written so far
+                size_t n = (s == result) ? pos : impl_OCStringByteLength(s);
+                if (!impl_OCStringReserve(result, pos + n)) goto done;
+                memmove(result->string + pos, s->string, n);
+                pos += n;
             }
-            OCStringAppendCString(result, buf);
-            arg_index++;
-            f = after;
-        } else {
-            const char tmp[2] = {*f, '\0'};
-            OCStringAppendCString(result, tmp);
-            f++;
+            continue;
         }
+        // Pull the argument exactly once, then format straight into the buffer
+        impl_OCFormatArg v = {0};
+        switch (op->kind) {
+            case kOCFormatOpSigned:
+                if (op->lengthModifier == kOCFormatLengthLL) v.ll = va_arg(arglist, long long);
+                else if (op->lengthModifier == kOCFormatLengthL) v.l = va_arg(arglist, long);
+                else if (op->lengthModifier == kOCFormatLengthZ || op->lengthModifier == kOCFormatLengthT) v.t = va_arg(arglist, ptrdiff_t);
+                else if (op->lengthModifier == kOCFormatLengthJ) v.j = va_arg(arglist, intmax_t);
+                else v.i = va_arg(arglist, int);
+                break;
+            case kOCFormatOpUnsigned:
+                if (op->lengthModifier == kOCFormatLengthLL) v.ull = va_arg(arglist, unsigned long long);
+                else if (op->lengthModifier == kOCFormatLengthL) v.ul = va_arg(arglist, unsigned long);
+                else if (op->lengthModifier == kOCFormatLengthZ || op->lengthModifier == kOCFormatLengthT) v.z = va_arg(arglist, size_t);
+                else if (op->lengthModifier == kOCFormatLengthJ) v.uj = va_arg(arglist, uintmax_t);
+                else v.u = va_arg(arglist, unsigned int);
+                break;
+            case kOCFormatOpDouble:
+                if (op->lengthModifier == kOCFormatLengthLongDouble) v.ld = va_arg(arglist, long double);
+                else v.d = va_arg(arglist, double);
+                break;
+            case kOCFormatOpCString: v.s = va_arg(arglist, const char*); break;
+            case kOCFormatOpChar: v.i = va_arg(arglist, int); break;
+            case kOCFormatOpPointer: v.p = va_arg(arglist, void*); break;
+            default: break;
+        }
+        arg_index++;
+        size_t avail = result->capacity - pos;
+        int n = impl_OCFormatConversion(result->string + pos, avail + 1, op, &v);
+        if (n < 0) continue;
+        if ((size_t)n > avail) {
+            if (!impl_OCStringReserve(result, pos + (size_t)n)) goto done;
+            impl_OCFormatConversion(result->string + pos, (size_t)n + 1, op, &v);
+        }
+        pos += (size_t)n;
+    }
+done:
+    result->string[pos] = '\0';
+    // One pass over the appended bytes to update length and indexing state
+    impl_OCStringInvalidateIndexFrom(result, start);
+    if (oc_utf8_is_ascii(result->string + start, pos - start)) {
+        result->length += pos - start;
+    } else {
+        result->isASCII = false;
+        result->length += oc_utf8_strlen_n(result->string + start, pos - start);
     }
 #ifdef _WIN32
     // Restore original signal handler
     signal(SIGSEGV, old_handler);
 #endif
     va_end(arglist);
-}
-// Helper to count how many format arguments are expected (including %@)
-static int count_format_args(const char* f) {
-    int count = 0;
-    while (*f) {
-        if (f[0] == '%' && f[1] == '%') {
-            f += 2;
-            continue;
-        }  // Escaped percent
-        if (f[0] == '%' && f[1] == '@') {
-            count++;
-            f += 2;
-            continue;
-        }
-        if (f[0] == '%') {
-            f++;  // skip '%'
-            while (strchr("-+ #0", *f)) f++;
-            while (*f >= '0' && *f <= '9') f++;
-            if (*f == '*') f++;
-            if (*f == '.') {
-                f++;
-                while (*f >= '0' && *f <= '9') f++;
-                if (*f == '*') f++;
-            }
-            while (strchr("hljztL", *f)) f++;
-            if (*f) {
-                count++;
-                f++;
-            }
-            continue;
-        }
-        f++;
-    }
-    return count;
+    free(owned);
 }
 OCStringRef OCStringCreateWithFormat(OCStringRef format, ...) {
-    if (!format || !format->string) return NULL;
+    if (!format || !impl_OCStringFlatten(format) || !format->string) return NULL;
     OCMutableStringRef result = OCStringCreateMutable(0);
-    int max_args = count_format_args(format->string);
+    if (!result) return NULL;
     va_list args;
     va_start(args, format);
-    OCStringAppendFormatWithArgumentsSafe(result, format, args, max_args, NULL);
+    OCStringAppendFormatWithArgumentsSafe(result, format, args, NULL);
     va_end(args);
+    result->isMutable = false;
     return (OCStringRef)result;
 }
 void OCStringAppendFormat(OCMutableStringRef theString, OCStringRef format, ...) {
-    if (!theString || !format || !format->string) return;
-    int max_args = count_format_args(format->string);
+    if (!theString || !format || !impl_OCStringFlatten(format) || !format->string) return;
     va_list args;
     va_start(args, format);
-    OCStringAppendFormatWithArgumentsSafe(theString, format, args, max_args, NULL);
+    OCStringAppendFormatWithArgumentsSafe(theString, format, args, NULL);
     va_end(args);
 }
 /**
@@ -1226,73 +2440,80 @@ OCArrayRef OCStringCreateArrayWithFindResults(OCStringRef string,
                                               OCStringRef stringToFind,
                                               OCRange rangeToSearch,
                                               OCOptionFlags compareOptions) {
-    if (!string || !stringToFind) return NULL;
-    // Clip the search range to the string’s length
+    if (!string || !stringToFind || !impl_OCStringFlatten(string)) return NULL;
     if (rangeToSearch.location < 0 || (uint64_t)rangeToSearch.location > string->length) return NULL;
-    if (rangeToSearch.length < 0 || (uint64_t)rangeToSearch.location + (uint64_t)rangeToSearch.length > string->length) {
-        rangeToSearch.length = string->length - (uint64_t)rangeToSearch.location;
+    OCIndexPair* pairs = NULL;
+    OCIndex count = impl_OCStringFindAllPairs(string, stringToFind, rangeToSearch, compareOptions, &pairs);
+    if (count <= 0) {
+        free(pairs);
+        return NULL;
     }
-    OCMutableArrayRef result = OCArrayCreateMutable(0, &kOCRangeArrayCallBacks);
-    if (!result) return NULL;
-    OCRange search = rangeToSearch, found;
-    while (OCStringFindWithOptions(string, stringToFind, search, compareOptions, &found)) {
+    OCMutableArrayRef result = OCArrayCreateMutable(count, &kOCRangeArrayCallBacks);
+    if (!result) {
+        free(pairs);
+        return NULL;
+    }
+    for (OCIndex i = 0; i < count; i++) {
         OCRange* r = malloc(sizeof(OCRange));
         if (NULL == r) {
             fprintf(stderr, "OCStringCreateArrayWithFindResults: Memory allocation failed for range.\n");
+            free(pairs);
             OCRelease(result);
             return NULL;
         }
-        *r = found;
+        *r = OCRangeMake(pairs[i].index, pairs[i].value);
         OCArrayAppendValue(result, r);
-        // Advance past this match
-        search.location = found.location + found.length;
-        uint64_t end = (uint64_t)rangeToSearch.location + (uint64_t)rangeToSearch.length;
-        if ((uint64_t)search.location >= end) break;
-        search.length = end - search.location;
-    }
-    if (OCArrayGetCount(result) == 0) {
-        OCRelease(result);
-        return NULL;
     }
+    free(pairs);
+    return result;
+}
+OCIndexPairSetRef OCStringCreateIndexPairSetWithFindResults(OCStringRef string,
+                                                            OCStringRef stringToFind,
+                                                            OCRange rangeToSearch,
+                                                            OCOptionFlags compareOptions) {
+    if (!string || !stringToFind) return NULL;
+    OCIndexPair* pairs = NULL;
+    OCIndex count = impl_OCStringFindAllPairs(string, stringToFind, rangeToSearch, compareOptions, &pairs);
+    if (count < 0) return NULL;
+    OCIndexPairSetRef result = count ? OCIndexPairSetCreateWithIndexPairArray(pairs, (int)count)
+                                     : OCIndexPairSetCreate();
+    free(pairs);
     return result;
 }
 OCArrayRef
 OCStringCreateArrayBySeparatingStrings(OCStringRef string,
                                        OCStringRef separator) {
-    if (!string || !string->string ||
-        !separator || !separator->string)
+    if (!string || !separator || !impl_OCStringFlatten(string) || !impl_OCStringFlatten(separator)) return NULL;
+    if (!string->string || !separator->string)
         return NULL;
     // Full range of the input string in code-points
     OCRange fullRange = OCRangeMake(0, OCStringGetLength(string));
     // Find all occurrences of 'separator'
-    OCArrayRef findResults =
-        OCStringCreateArrayWithFindResults(string,
-                                           separator,
-                                           fullRange,
-                                           0);
-    if (!findResults) {
+    OCIndexPair* seps = NULL;
+    OCIndex sepCount = impl_OCStringFindAllPairs(string, separator, fullRange, 0, &seps);
+    if (sepCount <= 0) {
         // No occurrences or error => treat as single token
+        free(seps);
         OCMutableArrayRef single = OCArrayCreateMutable(1, &kOCTypeArrayCallBacks);
         OCArrayAppendValue(single, string);
         return single;
     }
-    uint64_t sepCount = OCArrayGetCount(findResults);
     // Preallocate result slots (sepCount separators ⇒ sepCount+1 tokens)
     OCMutableArrayRef result =
         OCArrayCreateMutable((uint32_t)(sepCount + 1), &kOCTypeArrayCallBacks);
     // Walk through each found separator, slicing out the preceding chunk
+    // (substrings of an immutable string are views, so no bytes are copied)
     uint64_t prevEnd = 0;
-    for (uint64_t i = 0; i < sepCount; ++i) {
-        const OCRange* r = (const OCRange*)OCArrayGetValueAtIndex(findResults, i);
-        // substring from prevEnd of length (r->location - prevEnd)
-        OCRange slice = OCRangeMake(prevEnd, r->location - prevEnd);
+    for (OCIndex i = 0; i < sepCount; ++i) {
+        // substring from prevEnd of length (location - prevEnd)
+        OCRange slice = OCRangeMake(prevEnd, seps[i].index - prevEnd);
         OCStringRef piece = OCStringCreateWithSubstring(string, slice);
         if (piece) {
             OCArrayAppendValue(result, piece);
             OCRelease(piece);
         }
         // advance past this separator
-        prevEnd = r->location + r->length;
+        prevEnd = seps[i].index + seps[i].value;
     }
     // Add final token after last separator
     if (prevEnd <= (uint64_t)fullRange.length) {
@@ -1304,7 +2525,7 @@ OCStringCreateArrayBySeparatingStrings(OCStringRef string,
             OCRelease(piece);
         }
     }
-    OCRelease(findResults);
+    free(seps);
     return result;
 }
 OCStringRef OCCreateISO8601Timestamp(void) {
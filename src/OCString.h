@@ -67,8 +67,34 @@ OCTypeID OCStringGetTypeID(void);
  * @endcode
  */
 OCStringRef OCStringCreateWithCString(const char *string);
+/**
+ * @brief Creates an immutable OCString from UTF-8 bytes after validating them.
+ *
+ * Unlike OCStringCreateWithCString(), which silently decodes malformed input
+ * as U+FFFD, this constructor rejects stray continuation bytes, truncated
+ * sequences, overlong encodings, UTF-16 surrogates, code points above
+ * U+10FFFF and embedded NUL bytes. Pure-ASCII input is checked 32 bytes at a
+ * time.
+ *
+ * @param bytes Pointer to the UTF-8 data (need not be NUL-terminated).
+ * @param length Number of bytes to read from @p bytes.
+ * @param outInvalidOffset Optional; receives the byte offset of the first
+ *        invalid sequence, or kOCNotFound when the input is valid.
+ * @return New OCStringRef, or NULL if the input is invalid or allocation fails.
+ * @ingroup OCString
+ *
+ * @code
+ * OCIndex bad;
+ * OCStringRef s = OCStringCreateWithUTF8Bytes("ab\xC3\x28", 4, &bad);
+ * // s == NULL, bad == 2
+ * @endcode
+ */
+OCStringRef OCStringCreateWithUTF8Bytes(const void *bytes, uint64_t length, OCIndex *outInvalidOffset);
 /**
  * @brief Creates a mutable copy of an immutable OCString.
+ *
+ * The copy reads the source's bytes until it is first edited.
+ *
  * @param theString Immutable OCString to copy.
  * @return New OCMutableStringRef (ownership transferred to caller).
  * @ingroup OCString
@@ -115,8 +141,8 @@ OCStringRef OCStringCreateFromJSON(cJSON *json, OCStringRef *outError);
  * @brief Creates an OCString by decoding raw data as UTF-8 text.
  *
  * This function takes an OCDataRef containing UTF-8 encoded bytes and
- * produces a newly allocated OCStringRef. On platforms without CFString,
- * this performs a simple UTF-8 decode via OCStringCreateWithCString.
+ * produces a newly allocated OCStringRef, copying the bytes once. Use
+ * OCStringCreateWithDataNoCopy() to share the bytes instead.
  *
  * @param data  OCDataRef containing the raw UTF-8 bytes.
  * @return A new OCStringRef representing the decoded text.
@@ -138,8 +164,68 @@ OCStringRef OCStringCreateFromJSON(cJSON *json, OCStringRef *outError);
  */
 OCStringRef
 OCStringCreateWithExternalRepresentation(OCDataRef data);
+/**
+ * @brief Callback that releases the bytes of a no-copy string.
+ *
+ * Same signature as OCDataDeallocatorCallBack.
+ *
+ * @param bytes The byte pointer the string was created with.
+ * @param length The length the string was created with.
+ * @param context The context pointer passed at creation.
+ * @ingroup OCString
+ */
+typedef void (*OCStringDeallocatorCallBack)(void *bytes, uint64_t length, void *context);
+/**
+ * @brief Creates an immutable OCString that uses caller-owned bytes in place.
+ *
+ * The bytes need not be NUL-terminated; the text ends at @p length or at the
+ * first NUL byte. They are not copied, except into a separate terminated
+ * buffer when OCStringGetCString() needs one, and substrings of the result
+ * share them too. When the string and every view of it have been released,
+ * @p deallocator is called once with the original arguments.
+ *
+ * @param bytes UTF-8 text, e.g. inside an mmapped file or a parser buffer.
+ * @param length Number of bytes available at @p bytes.
+ * @param deallocator Called when the bytes are no longer used, or NULL if the
+ *        caller keeps ownership and guarantees they outlive the string.
+ * @param context Opaque pointer passed to @p deallocator.
+ * @return New OCStringRef, or NULL if the text is not valid UTF-8 (the
+ *         bytes then stay with the caller) or on failure.
+ * @ingroup OCString
+ *
+ * @code
+ * static void freeBytes(void *bytes, uint64_t length, void *context) { free(bytes); }
+ * char *text = strdup("Hello, world!");
+ * OCStringRef s = OCStringCreateWithBytesNoCopy(text, strlen(text), freeBytes, NULL);
+ * OCRelease(s);  // frees text
+ * @endcode
+ */
+OCStringRef OCStringCreateWithBytesNoCopy(const char *bytes,
+                                          uint64_t length,
+                                          OCStringDeallocatorCallBack deallocator,
+                                          void *context);
+/**
+ * @brief Creates an immutable OCString backed by the bytes of an OCData.
+ *
+ * The string holds an immutable copy of @p data, which shares its bytes, so
+ * nothing is copied unless mutable data is changed afterwards; the string
+ * keeps the original text. The text ends at the data's length or at the
+ * first NUL byte.
+ *
+ * @param data OCDataRef holding UTF-8 text.
+ * @return New OCStringRef, or NULL if the text is not valid UTF-8 or on failure.
+ * @ingroup OCString
+ */
+OCStringRef OCStringCreateWithDataNoCopy(OCDataRef data);
 /**
  * @brief Creates an immutable OCString from a substring.
+ *
+ * When @p str is immutable the result is a lightweight view: it retains the
+ * string that owns the bytes and references a byte range inside it, so no
+ * character data is copied. OCStringGetCString() on a view that does not run
+ * to the end of its string makes a terminated copy once, alongside the view.
+ * Substrings of mutable strings are always independent copies.
+ *
  * @param str Source OCString.
  * @param range Range of substring to extract.
  * @return New OCStringRef, or NULL on failure.
@@ -214,6 +300,28 @@ void OCStringAppendCString(OCMutableStringRef theString, const char *cString);
  * @endcode
  */
 OCMutableStringRef OCStringCreateMutable(uint64_t capacity);
+/**
+ * @brief Creates an empty mutable OCString for building large text.
+ *
+ * The string keeps its text in a rope of chunks, so appends fill the last
+ * chunk in place and OCStringInsert(), OCStringReplace() and OCStringDelete()
+ * take O(log n) instead of moving the tail of the buffer. The text is
+ * flattened into one buffer when OCStringGetCString() or another read that
+ * needs contiguous bytes is called; the next edit moves it back into a rope.
+ * OCStringWriteToStream() writes the chunks without flattening.
+ *
+ * @return New OCMutableStringRef (ownership transferred to caller), or NULL on failure.
+ * @ingroup OCString
+ *
+ * @code
+ * OCMutableStringRef report = OCStringCreateMutableRope();
+ * for (int i = 0; i < 100000; i++) OCStringAppendFormat(report, STR("row %d\n"), i);
+ * OCStringInsert(report, 0, STR("header\n"));
+ * OCStringWriteToStream(report, stdout);
+ * OCRelease(report);
+ * @endcode
+ */
+OCMutableStringRef OCStringCreateMutableRope(void);
 /**
  * @brief Creates a mutable OCString from a null-terminated C string.
  * @param cString Null-terminated UTF-8 C string.
@@ -237,6 +345,10 @@ OCMutableStringRef OCMutableStringCreateWithCString(const char *cString);
  * @brief Returns a C string representation of an immutable OCString.
  * @param theString Immutable OfCString.
  * @return Null-terminated UTF-8 C string.
+ * @note An immutable string is not changed by this call, so it is safe to
+ *       call from several threads at once. A substring view that needs a
+ *       terminator gets a copy of its bytes, made once and owned by
+ *       @p theString; the view keeps its parent until it is released.
  * @ingroup OCString
  *
  * @code
@@ -256,6 +368,11 @@ OCMutableStringRef OCMutableStringCreateWithCString(const char *cString);
 const char *OCStringGetCString(OCStringRef theString);
 /**
  * @brief Creates a new immutable copy of an OCString.
+ *
+ * Copying an immutable string retains it. A mutable string shares its buffer
+ * with the copy until it is next edited. String constants made with STR()
+ * are copied into a new string.
+ *
  * @param theString Source OCString.
  * @return New OCStringRef (ownership transferred to caller).
  * @ingroup OCString
@@ -266,7 +383,7 @@ const char *OCStringGetCString(OCStringRef theString);
  * // Create a copy
  * OCStringRef copy = OCStringCreateCopy(original);
  *
- * // Both strings have the same content but are separate objects
+ * // Both references have the same content
  * bool areEqual = OCStringEqual(original, copy);  // Returns true
  *
  * // Release both strings when done
@@ -301,6 +418,18 @@ OCStringRef OCStringCreateCopy(OCStringRef theString);
  * @endcode
  */
 OCComparisonResult OCStringCompare(OCStringRef theString1, OCStringRef theString2, OCStringCompareFlags compareOptions);
+/**
+ * @brief Returns a hash of the string's UTF-8 bytes.
+ *
+ * Strings that compare equal with OCStringCompare() and no flags have equal
+ * hashes. The value is not cached, so a mutable string may hash differently
+ * after it is modified.
+ *
+ * @param theString OCString to hash (NULL hashes to 0).
+ * @return 64-bit hash value.
+ * @ingroup OCString
+ */
+uint64_t OCStringHash(OCStringRef theString);
 /**
  * @brief Returns the length of an OCString.
  * @param theString OCString.
@@ -680,6 +809,34 @@ int64_t OCStringFindAndReplace(OCMutableStringRef string,
  * @endcode
  */
 OCArrayRef OCStringCreateArrayWithFindResults(OCStringRef string, OCStringRef stringToFind, OCRange rangeToSearch, OCOptionFlags compareOptions);
+/**
+ * @brief Finds all non-overlapping occurrences of a substring and returns them compactly.
+ *
+ * Equivalent to OCStringCreateArrayWithFindResults(), but the matches are
+ * stored inline as OCIndexPair values (index = location, value = length, both
+ * in characters) in a single OCIndexPairSet instead of one heap-allocated
+ * OCRange per match.
+ *
+ * @param string Source OCString.
+ * @param stringToFind Substring to find.
+ * @param rangeToSearch Range within string to search.
+ * @param compareOptions Comparison options flags (kOCCompareCaseInsensitive is honored for ASCII).
+ * @return A new OCIndexPairSetRef (empty when nothing matches), or NULL on failure.
+ * @ingroup OCString
+ *
+ * @code
+ * OCStringRef text = STR("a,b,,c");
+ * OCIndexPairSetRef hits =
+ *     OCStringCreateIndexPairSetWithFindResults(text, STR(","), OCRangeMake(0, OCStringGetLength(text)), 0);
+ * OCIndexPair *pairs = OCIndexPairSetGetBytesPtr(hits);
+ * // OCIndexPairSetGetCount(hits) == 3, pairs[1].index == 3
+ * OCRelease(hits);
+ * @endcode
+ */
+OCIndexPairSetRef OCStringCreateIndexPairSetWithFindResults(OCStringRef string,
+                                                            OCStringRef stringToFind,
+                                                            OCRange rangeToSearch,
+                                                            OCOptionFlags compareOptions);
 /**
  * @brief Creates an array of OCStrings by splitting a string using a separator string.
  * @param string Source OCString.
@@ -730,6 +887,18 @@ OCArrayRef OCStringCreateArrayBySeparatingStrings(OCStringRef string, OCStringRe
  * @endcode
  */
 void OCStringShow(OCStringRef theString);
+/**
+ * @brief Writes the UTF-8 bytes of an OCString to a stream.
+ *
+ * Strings created with OCStringCreateMutableRope() are written chunk by chunk
+ * without being flattened. No terminator or newline is written.
+ *
+ * @param theString OCString to write.
+ * @param stream Destination FILE*.
+ * @return true if every byte was written, false on error or NULL arguments.
+ * @ingroup OCString
+ */
+bool OCStringWriteToStream(OCStringRef theString, FILE *stream);
 /**
  * @brief Compares two OCStrings for equality.
  * @param theString1 First OCString.
@@ -805,6 +974,16 @@ void OCStringAppendFormat(OCMutableStringRef theString, OCStringRef format, ...)
  * @return A compile-time constant OCStringRef; do not release.
  */
 OCStringRef impl_OCStringMakeConstantString(const char *cStr);
+/**
+ * @brief Creates an immutable copy of a string for use as a dictionary key; private API.
+ *
+ * Like OCStringCreateCopy(), except that a substring view is copied into
+ * bytes of its own instead of being retained, so a stored key does not
+ * keep a larger string alive.
+ * @param theString Key to copy.
+ * @return New OCStringRef, or NULL on failure.
+ */
+OCStringRef impl_OCStringCreateKeyCopy(OCStringRef theString);
 /** \endcond */
 /**
  * @brief Calculates and returns the double complex value represented by the complex arithmetic expression in the string.
@@ -828,6 +1007,10 @@ OCStringRef impl_OCStringMakeConstantString(const char *cStr);
 double complex OCComplexFromCString(const char *string);
 /**
  * @brief Creates an OCString representing a float value.
+ *
+ * Uses the shortest decimal that reads back as the same float
+ * (see OCFloatWriteShortestCString).
+ *
  * @param value Float value.
  * @return New OCStringRef representing the float.
  * @ingroup OCString
@@ -846,6 +1029,10 @@ double complex OCComplexFromCString(const char *string);
 OCStringRef OCFloatCreateStringValue(float value);
 /**
  * @brief Creates an OCString representing a double value.
+ *
+ * Uses the shortest decimal that reads back as the same double
+ * (see OCDoubleWriteShortestCString).
+ *
  * @param value Double value.
  * @return New OCStringRef representing the double.
  * @ingroup OCString
@@ -865,7 +1052,7 @@ OCStringRef OCDoubleCreateStringValue(double value);
 /**
  * @brief Creates an OCString representing a float complex value using a format.
  * @param value Float complex value.
- * @param format Format OCString.
+ * @param format Format OCString, or NULL for the shortest round-trip form (e.g. "2.5+3.7i").
  * @return New OCStringRef representing the complex value.
  * @ingroup OCString
  *
@@ -892,7 +1079,7 @@ OCStringRef OCFloatComplexCreateStringValue(float complex value, OCStringRef for
 /**
  * @brief Creates an OCString representing a double complex value using a format.
  * @param value Double complex value.
- * @param format Format OCString.
+ * @param format Format OCString, or NULL for the shortest round-trip form (e.g. "1.234-5.678i").
  * @return New OCStringRef representing the complex value.
  * @ingroup OCString
  *
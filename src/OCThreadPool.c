@@ -0,0 +1,306 @@
+// OCThreadPool.c — library-wide worker threads with work stealing
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#include "OCTypes.h"
+#if defined(_MSC_VER)
+#define OC_THREAD_LOCAL __declspec(thread)
+#else
+#define OC_THREAD_LOCAL __thread
+#endif
+#define kOCThreadPoolMaxThreads 256
+#define kOCThreadPoolSlicesPerThread 4
+typedef struct {
+    OCTaskFunction function;
+    void *context;
+    OCTaskGroupRef group;
+} impl_OCTask;
+// Ring buffer of tasks. The owning worker pushes and pops at the back;
+// thieves take from the front, where the oldest and usually largest tasks are.
+typedef struct {
+    impl_OCTask *tasks;
+    uint64_t capacity;  // power of two
+    uint64_t front;
+    uint64_t count;
+} impl_OCTaskDeque;
+struct impl_OCTaskGroup {
+    uint64_t pending;
+};
+typedef struct {
+    pthread_t *threads;
+    impl_OCTaskDeque *deques;  // one per worker
+    unsigned workerCount;
+    unsigned nextDeque;  // round robin for tasks submitted from outside the pool
+    uint64_t queued;
+    bool stopping;
+} impl_OCThreadPool;
+typedef struct {
+    impl_OCThreadPool *pool;
+    unsigned index;
+} impl_OCThreadPoolWorkerStart;
+// Tasks are coarse, so one lock guards every deque, task group and the pool
+// pointer itself; the deques give the scheduling order, not lock freedom.
+// A single condition is broadcast whenever a task is queued or a group
+// drains, which wakes both idle workers and waiting callers.
+static pthread_mutex_t impl_OCThreadPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t impl_OCThreadPoolChanged = PTHREAD_COND_INITIALIZER;
+static impl_OCThreadPool *impl_OCThreadPoolShared = NULL;
+static uint64_t impl_OCThreadPoolConfiguredCount = 0;  // 0 = default
+static struct impl_OCTaskGroup impl_OCThreadPoolDefaultGroup = {0};
+// Set on pool threads, so nested submissions stay in the pool that runs them
+static OC_THREAD_LOCAL impl_OCThreadPool *impl_OCThreadPoolCurrent = NULL;
+static OC_THREAD_LOCAL unsigned impl_OCThreadPoolCurrentIndex = 0;
+static bool impl_OCTaskDequePush(impl_OCTaskDeque *deque, impl_OCTask task) {
+    if (deque->count == deque->capacity) {
+        uint64_t capacity = deque->capacity ? deque->capacity * 2 : 64;
+        impl_OCTask *tasks = (impl_OCTask *)malloc(capacity * sizeof(impl_OCTask));
+        if (tasks == NULL) return false;
+        for (uint64_t i = 0; i < deque->count; i++)
+            tasks[i] = deque->tasks[(deque->front + i) & (deque->capacity - 1)];
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->front = 0;
+    }
+    deque->tasks[(deque->front + deque->count) & (deque->capacity - 1)] = task;
+    deque->count++;
+    return true;
+}
+static impl_OCTask impl_OCTaskDequePopBack(impl_OCTaskDeque *deque) {
+    deque->count--;
+    return deque->tasks[(deque->front + deque->count) & (deque->capacity - 1)];
+}
+static impl_OCTask impl_OCTaskDequePopFront(impl_OCTaskDeque *deque) {
+    impl_OCTask task = deque->tasks[deque->front];
+    deque->front = (deque->front + 1) & (deque->capacity - 1);
+    deque->count--;
+    return task;
+}
+// Takes the next task for worker `self` (or for a thread outside the pool
+// when self >= workerCount): its own newest task, else the oldest task of the
+// next worker that has one. Called with the lock held.
+static bool impl_OCThreadPoolTake(impl_OCThreadPool *pool, unsigned self, impl_OCTask *outTask) {
+    if (pool == NULL || pool->queued == 0) return false;
+    if (self < pool->workerCount && pool->deques[self].count) {
+        *outTask = impl_OCTaskDequePopBack(&pool->deques[self]);
+        pool->queued--;
+        return true;
+    }
+    unsigned start = self < pool->workerCount ? self + 1 : 0;
+    for (unsigned i = 0; i < pool->workerCount; i++) {
+        impl_OCTaskDeque *victim = &pool->deques[(start + i) % pool->workerCount];
+        if (victim->count) {
+            *outTask = impl_OCTaskDequePopFront(victim);
+            pool->queued--;
+            return true;
+        }
+    }
+    return false;
+}
+// Runs a task outside the lock and retires it from its group
+static void impl_OCThreadPoolRun(impl_OCTask task) {
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    task.function(task.context);
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    if (--task.group->pending == 0) pthread_cond_broadcast(&impl_OCThreadPoolChanged);
+}
+static void *impl_OCThreadPoolWorkerMain(void *arg) {
+    impl_OCThreadPoolWorkerStart start = *(impl_OCThreadPoolWorkerStart *)arg;
+    free(arg);
+    impl_OCThreadPool *pool = start.pool;
+    impl_OCThreadPoolCurrent = pool;
+    impl_OCThreadPoolCurrentIndex = start.index;
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    for (;;) {
+        impl_OCTask task;
+        if (impl_OCThreadPoolTake(pool, start.index, &task)) {
+            impl_OCThreadPoolRun(task);
+        } else if (pool->stopping) {
+            break;
+        } else {
+            pthread_cond_wait(&impl_OCThreadPoolChanged, &impl_OCThreadPoolLock);
+        }
+    }
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    return NULL;
+}
+static uint64_t impl_OCThreadPoolDefaultCount(void) {
+    const char *env = getenv("OCTYPES_THREADS");
+    if (env && *env) {
+        char *end = NULL;
+        unsigned long n = strtoul(env, &end, 10);
+        if (end && *end == '\0' && n > 0) return n < kOCThreadPoolMaxThreads ? n : kOCThreadPoolMaxThreads;
+        fprintf(stderr, "OCThreadPool: Ignoring invalid OCTYPES_THREADS value \"%s\".\n", env);
+    }
+    long cpus = 1;
+#if defined(_SC_NPROCESSORS_ONLN)
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpus < 1) cpus = 1;
+    return cpus < kOCThreadPoolMaxThreads ? (uint64_t)cpus : kOCThreadPoolMaxThreads;
+}
+static uint64_t impl_OCThreadPoolResolvedCount(void) {
+    return impl_OCThreadPoolConfiguredCount ? impl_OCThreadPoolConfiguredCount : impl_OCThreadPoolDefaultCount();
+}
+static void impl_OCThreadPoolFree(impl_OCThreadPool *pool) {
+    for (unsigned i = 0; i < pool->workerCount; i++)
+        free(pool->deques[i].tasks);
+    free(pool->deques);
+    free(pool->threads);
+    free(pool);
+}
+// Starts the shared pool. Called with the lock held, which the new workers
+// wait on until the pool is fully set up.
+static impl_OCThreadPool *impl_OCThreadPoolStart(void) {
+    unsigned count = (unsigned)impl_OCThreadPoolResolvedCount();
+    impl_OCThreadPool *pool = (impl_OCThreadPool *)calloc(1, sizeof(impl_OCThreadPool));
+    if (pool == NULL) return NULL;
+    pool->threads = (pthread_t *)calloc(count, sizeof(pthread_t));
+    pool->deques = (impl_OCTaskDeque *)calloc(count, sizeof(impl_OCTaskDeque));
+    if (pool->threads == NULL || pool->deques == NULL) {
+        impl_OCThreadPoolFree(pool);
+        return NULL;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        impl_OCThreadPoolWorkerStart *start = (impl_OCThreadPoolWorkerStart *)malloc(sizeof(*start));
+        if (start == NULL) break;
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, impl_OCThreadPoolWorkerMain, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->workerCount++;
+    }
+    if (pool->workerCount == 0) {
+        fprintf(stderr, "OCThreadPool: Could not start any worker threads.\n");
+        impl_OCThreadPoolFree(pool);
+        return NULL;
+    }
+    impl_OCThreadPoolShared = pool;
+    return pool;
+}
+uint64_t OCThreadPoolGetThreadCount(void) {
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    uint64_t count = impl_OCThreadPoolShared ? impl_OCThreadPoolShared->workerCount : impl_OCThreadPoolResolvedCount();
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    return count;
+}
+bool OCThreadPoolSetThreadCount(uint64_t threadCount) {
+    if (impl_OCThreadPoolCurrent) {
+        fprintf(stderr, "OCThreadPoolSetThreadCount: Cannot resize the pool from one of its own threads.\n");
+        return false;
+    }
+    OCThreadPoolShutdown();
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    impl_OCThreadPoolConfiguredCount = threadCount < kOCThreadPoolMaxThreads ? threadCount : kOCThreadPoolMaxThreads;
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    return true;
+}
+void OCThreadPoolShutdown(void) {
+    if (impl_OCThreadPoolCurrent) {
+        fprintf(stderr, "OCThreadPoolShutdown: Cannot stop the pool from one of its own threads.\n");
+        return;
+    }
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    impl_OCThreadPool *pool = impl_OCThreadPoolShared;
+    if (pool == NULL) {
+        pthread_mutex_unlock(&impl_OCThreadPoolLock);
+        return;
+    }
+    // Later submissions from outside start a fresh pool; tasks already
+    // queued here, and any they fork, still run before the workers exit.
+    impl_OCThreadPoolShared = NULL;
+    pool->stopping = true;
+    pthread_cond_broadcast(&impl_OCThreadPoolChanged);
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    for (unsigned i = 0; i < pool->workerCount; i++)
+        pthread_join(pool->threads[i], NULL);
+    impl_OCThreadPoolFree(pool);
+}
+OCTaskGroupRef OCTaskGroupCreate(void) {
+    OCTaskGroupRef group = (OCTaskGroupRef)calloc(1, sizeof(struct impl_OCTaskGroup));
+    if (group == NULL) fprintf(stderr, "OCTaskGroupCreate: Memory allocation failed.\n");
+    return group;
+}
+bool OCTaskGroupSubmit(OCTaskGroupRef group, OCTaskFunction function, void *context) {
+    if (group == NULL || function == NULL) return false;
+    impl_OCTask task = {function, context, group};
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    impl_OCThreadPool *pool = impl_OCThreadPoolCurrent;
+    unsigned target = impl_OCThreadPoolCurrentIndex;
+    if (pool == NULL) {
+        pool = impl_OCThreadPoolShared ? impl_OCThreadPoolShared : impl_OCThreadPoolStart();
+        if (pool) target = pool->nextDeque++ % pool->workerCount;
+    }
+    if (pool && impl_OCTaskDequePush(&pool->deques[target], task)) {
+        pool->queued++;
+        group->pending++;
+        pthread_cond_broadcast(&impl_OCThreadPoolChanged);
+        pthread_mutex_unlock(&impl_OCThreadPoolLock);
+        return true;
+    }
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+    fprintf(stderr, "OCTaskGroupSubmit: Could not queue the task.\n");
+    return false;
+}
+void OCTaskGroupWait(OCTaskGroupRef group) {
+    if (group == NULL) return;
+    pthread_mutex_lock(&impl_OCThreadPoolLock);
+    while (group->pending) {
+        impl_OCThreadPool *pool = impl_OCThreadPoolCurrent ? impl_OCThreadPoolCurrent : impl_OCThreadPoolShared;
+        unsigned self = impl_OCThreadPoolCurrent ? impl_OCThreadPoolCurrentIndex : (unsigned)-1;
+        impl_OCTask task;
+        if (impl_OCThreadPoolTake(pool, self, &task))
+            impl_OCThreadPoolRun(task);
+        else
+            pthread_cond_wait(&impl_OCThreadPoolChanged, &impl_OCThreadPoolLock);
+    }
+    pthread_mutex_unlock(&impl_OCThreadPoolLock);
+}
+void OCTaskGroupRelease(OCTaskGroupRef group) {
+    if (group == NULL) return;
+    OCTaskGroupWait(group);
+    free(group);
+}
+bool OCThreadPoolSubmit(OCTaskFunction function, void *context) {
+    return OCTaskGroupSubmit(&impl_OCThreadPoolDefaultGroup, function, context);
+}
+void OCThreadPoolWait(void) {
+    OCTaskGroupWait(&impl_OCThreadPoolDefaultGroup);
+}
+typedef struct {
+    OCRangeTaskFunction function;
+    void *context;
+    OCRange range;
+} impl_OCRangeTask;
+static void impl_OCRangeTaskRun(void *arg) {
+    impl_OCRangeTask *task = (impl_OCRangeTask *)arg;
+    task->function(task->range, task->context);
+}
+void OCThreadPoolApplyRange(OCRange range, uint64_t grainSize, OCRangeTaskFunction function, void *context) {
+    if (function == NULL || range.length <= 0) return;
+    uint64_t length = (uint64_t)range.length;
+    uint64_t slices = length / (grainSize ? grainSize : 1);
+    uint64_t maxSlices = OCThreadPoolGetThreadCount() * kOCThreadPoolSlicesPerThread;
+    if (slices > maxSlices) slices = maxSlices;
+    impl_OCRangeTask *tasks = slices > 1 ? (impl_OCRangeTask *)malloc(slices * sizeof(impl_OCRangeTask)) : NULL;
+    if (tasks == NULL) {
+        function(range, context);
+        return;
+    }
+    for (uint64_t s = 0; s < slices; s++) {
+        uint64_t start = length * s / slices, end = length * (s + 1) / slices;
+        tasks[s] = (impl_OCRangeTask){function, context, {range.location + (OCIndex)start, (OCIndex)(end - start)}};
+    }
+    struct impl_OCTaskGroup group = {0};
+    for (uint64_t s = 1; s < slices; s++) {
+        if (!OCTaskGroupSubmit(&group, impl_OCRangeTaskRun, &tasks[s])) impl_OCRangeTaskRun(&tasks[s]);
+    }
+    impl_OCRangeTaskRun(&tasks[0]);
+    OCTaskGroupWait(&group);
+    free(tasks);
+}
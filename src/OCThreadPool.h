@@ -0,0 +1,162 @@
+/**
+ * @file OCThreadPool.h
+ * @brief Library-wide worker thread pool and task groups.
+ *
+ * OCTypes keeps one pool of worker threads that is shared by everything that
+ * runs in parallel, such as concurrent sorts and OCArrayApplyFunction(), and
+ * that applications may use for their own work. Each worker has its own
+ * deque of tasks: it runs the tasks it submitted itself newest first and,
+ * when it runs dry, steals the oldest task from another worker.
+ *
+ * The pool starts on first use with one worker per online CPU, or with the
+ * number given in the OCTYPES_THREADS environment variable.
+ * OCThreadPoolSetThreadCount() changes the size at run time, and
+ * OCTypesShutdown() stops the workers after the queued tasks have run.
+ *
+ * Tasks should be coarse, at least tens of microseconds of work each;
+ * OCThreadPoolApplyRange() cuts a range into slices of a caller-chosen
+ * minimum size for that reason.
+ */
+#ifndef OCTHREADPOOL_H
+#define OCTHREADPOOL_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "OCType.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @defgroup OCThreadPool OCThreadPool
+ * @brief Shared worker threads, task groups and parallel loops.
+ * @{
+ */
+/**
+ * @brief A task run by the pool.
+ * @param context The pointer passed when the task was submitted.
+ * @ingroup OCThreadPool
+ */
+typedef void (*OCTaskFunction)(void *context);
+/**
+ * @brief A loop body run by OCThreadPoolApplyRange() for one slice.
+ * @param range The slice of the loop's range to process.
+ * @param context The pointer passed to OCThreadPoolApplyRange().
+ * @ingroup OCThreadPool
+ */
+typedef void (*OCRangeTaskFunction)(OCRange range, void *context);
+/**
+ * @brief Returns the number of worker threads the pool runs with.
+ *
+ * This is the configured size; the pool itself starts on first use.
+ *
+ * @return Worker thread count, at least 1.
+ * @ingroup OCThreadPool
+ */
+uint64_t OCThreadPoolGetThreadCount(void);
+/**
+ * @brief Sets the number of worker threads.
+ *
+ * A running pool is stopped once its queued tasks have run, and is restarted
+ * with the new size on next use. Must not be called from inside a task.
+ *
+ * @param threadCount Number of workers, or 0 to return to the default.
+ * @return true on success, false if called from a pool thread.
+ * @ingroup OCThreadPool
+ */
+bool OCThreadPoolSetThreadCount(uint64_t threadCount);
+/**
+ * @brief Queues a task that nothing waits for individually.
+ *
+ * Use OCThreadPoolWait() to wait for all such tasks. A task that cannot be
+ * queued is not run; the caller may run it itself.
+ *
+ * @param function Task to run.
+ * @param context Opaque pointer passed to @p function.
+ * @return true if the task was queued; false if @p function is NULL, or if
+ *         no worker could be started or the queue could not grow.
+ * @ingroup OCThreadPool
+ */
+bool OCThreadPoolSubmit(OCTaskFunction function, void *context);
+/**
+ * @brief Waits until every task queued with OCThreadPoolSubmit() has run.
+ *
+ * The calling thread runs queued tasks while it waits.
+ *
+ * @ingroup OCThreadPool
+ */
+void OCThreadPoolWait(void);
+/**
+ * @brief Runs a loop body over a range in parallel and waits for it.
+ *
+ * The range is cut into contiguous slices of at least @p grainSize elements
+ * (except when the whole range is shorter), and @p function is called once per
+ * slice on the pool's threads and the calling thread. Slices may run in any
+ * order.
+ *
+ * @param range Range to cover.
+ * @param grainSize Minimum slice length, or 0 for 1.
+ * @param function Loop body.
+ * @param context Opaque pointer passed to @p function.
+ * @ingroup OCThreadPool
+ *
+ * @code
+ * static void scale(OCRange r, void *context) {
+ *     double *v = context;
+ *     for (OCIndex i = r.location; i < r.location + r.length; i++) v[i] *= 2.0;
+ * }
+ * OCThreadPoolApplyRange(OCRangeMake(0, count), 4096, scale, values);
+ * @endcode
+ */
+void OCThreadPoolApplyRange(OCRange range, uint64_t grainSize, OCRangeTaskFunction function, void *context);
+/**
+ * @brief Stops the worker threads once the queued tasks have run.
+ *
+ * Called by OCTypesShutdown(). The pool restarts if it is used again.
+ *
+ * @ingroup OCThreadPool
+ */
+void OCThreadPoolShutdown(void);
+/**
+ * @brief Creates an empty task group.
+ *
+ * A task group counts the tasks submitted to it so that a caller can wait for
+ * exactly those. Groups may be used from inside tasks to fork nested work.
+ *
+ * @return New OCTaskGroupRef, or NULL on failure.
+ * @ingroup OCThreadPool
+ */
+OCTaskGroupRef OCTaskGroupCreate(void);
+/**
+ * @brief Queues a task as a member of a group.
+ *
+ * A task that cannot be queued is not run and is not counted by the group;
+ * the caller may run it itself.
+ *
+ * @param group Group to add the task to.
+ * @param function Task to run.
+ * @param context Opaque pointer passed to @p function.
+ * @return true if the task was queued; false if an argument is NULL, or if
+ *         no worker could be started or the queue could not grow.
+ * @ingroup OCThreadPool
+ */
+bool OCTaskGroupSubmit(OCTaskGroupRef group, OCTaskFunction function, void *context);
+/**
+ * @brief Waits until every task submitted to a group has run.
+ *
+ * The calling thread runs queued tasks, of this group or any other, while it
+ * waits. The group can be reused afterwards.
+ *
+ * @param group Group to wait for.
+ * @ingroup OCThreadPool
+ */
+void OCTaskGroupWait(OCTaskGroupRef group);
+/**
+ * @brief Waits for a group's tasks and frees the group.
+ * @param group Group to release; NULL is ignored.
+ * @ingroup OCThreadPool
+ */
+void OCTaskGroupRelease(OCTaskGroupRef group);
+/** @} */
+#ifdef __cplusplus
+}
+#endif
+#endif /* OCTHREADPOOL_H */
@@ -4,6 +4,7 @@
 //
 //  Created by Philip on 11/18/12.
 //
+#include <pthread.h>
 #include <stdio.h>  // For perror
 #include <stdlib.h>
 #include <string.h>
@@ -12,10 +13,27 @@
 #ifndef __has_feature
 #define __has_feature(x) 0
 #endif
+// Retain counts are updated atomically so objects can be shared between
+// threads (for example through OCConcurrentDictionary)
+#if defined(__GNUC__) || defined(__clang__)
+#define impl_OCRetainCountLoad(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define impl_OCRetainCountIncrement(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#define impl_OCRetainCountDecrement(p) __atomic_sub_fetch((p), 1, __ATOMIC_ACQ_REL)
+#else
+#define impl_OCRetainCountLoad(p) (*(p))
+#define impl_OCRetainCountIncrement(p) (++*(p))
+#define impl_OCRetainCountDecrement(p) (--*(p))
+#endif
 static bool ocTypesShutdownCalled = false;
+// Serializes type registration, which may first happen on any thread
+static pthread_mutex_t typeIDTableLock = PTHREAD_MUTEX_INITIALIZER;
 static char **typeIDTable = NULL;
 static OCTypeID typeIDTableCount = 0;
 static OCTypeRef (*createFromJSONTypedTable[256])(cJSON *, OCStringRef *) = {NULL};
+// Hash functions stay registered across OCTypesShutdown, like the type IDs
+// cached by each GetTypeID function
+static OCTypeHashFunction hashFunctionTable[256] = {NULL};
+static const OCTypeSharedCopyCallBacks *sharedCopyTable[256] = {NULL};
 void cleanupTypeIDTable(void) {
     if (typeIDTable) {
         for (OCTypeID i = 0; i < typeIDTableCount; i++) {
@@ -47,6 +65,7 @@ static bool TypeIDTableContainsName(const char *typeName) {
 void OCTypesShutdown(void) {
     if (ocTypesShutdownCalled) return;
     ocTypesShutdownCalled = true;
+    OCThreadPoolShutdown();
     OCAutoreleasePoolCleanup();
     cleanupConstantStringTable();
 // #if defined(DEBUG)                                \
@@ -67,12 +86,16 @@ void OCTypesShutdown(void) {
         OCReportLeaksForTypeDetailed(OCSetGetTypeID());
     if (TypeIDTableContainsName("OCIndexArray"))
         OCReportLeaksForTypeDetailed(OCIndexArrayGetTypeID());
+    if (TypeIDTableContainsName("OCIndexDictionary"))
+        OCReportLeaksForTypeDetailed(OCIndexDictionaryGetTypeID());
     if (TypeIDTableContainsName("OCIndexSet"))
         OCReportLeaksForTypeDetailed(OCIndexSetGetTypeID());
     if (TypeIDTableContainsName("OCIndexPairSet"))
         OCReportLeaksForTypeDetailed(OCIndexPairSetGetTypeID());
     if (TypeIDTableContainsName("OCDictionary"))
         OCReportLeaksForTypeDetailed(OCDictionaryGetTypeID());
+    if (TypeIDTableContainsName("OCConcurrentDictionary"))
+        OCReportLeaksForTypeDetailed(OCConcurrentDictionaryGetTypeID());
 #endif
     cleanupTypeIDTable();
 }
@@ -108,6 +131,25 @@ bool OCTypeEqual(const void *theType1, const void *theType2) {
     }
     return typeRef1->base.equal(theType1, theType2);
 }
+void OCTypeSetHashFunction(OCTypeID typeID, OCTypeHashFunction hash) {
+    if (typeID == kOCNotATypeID || typeID > 256)
+        return;
+    pthread_mutex_lock(&typeIDTableLock);
+    hashFunctionTable[typeID - 1] = hash;
+    pthread_mutex_unlock(&typeIDTableLock);
+}
+uint64_t OCTypeHash(const void *obj) {
+    if (NULL == obj)
+        return 0;
+    OCTypeID typeID = ((OCTypeRef)obj)->base.typeID;
+    if (typeID == kOCNotATypeID || typeID > 256)
+        return 0;
+    OCTypeHashFunction hash = hashFunctionTable[typeID - 1];
+    if (hash)
+        return hash(obj);
+    // Equal objects share a type, so a per-type constant is always consistent
+    return (uint64_t)typeID * 0x9E3779B97F4A7C15ULL;
+}
 /**
  * @brief Registers a new OCType with the system and optional JSON factory.
  * @param typeName A null-terminated C string representing the type name.
@@ -115,7 +157,7 @@ bool OCTypeEqual(const void *theType1, const void *theType2) {
  * @return The OCTypeID assigned, or kOCNotATypeID on failure.
  * @ingroup OCType
  */
-OCTypeID OCRegisterType(const char *typeName, OCTypeRef (*factory)(cJSON *, OCStringRef *)) {
+static OCTypeID impl_OCRegisterTypeLocked(const char *typeName, OCTypeRef (*factory)(cJSON *, OCStringRef *)) {
     // Return an invalid type ID if typeName is NULL.
     if (NULL == typeName) {
         return kOCNotATypeID;
@@ -155,6 +197,12 @@ OCTypeID OCRegisterType(const char *typeName, OCTypeRef (*factory)(cJSON *, OCSt
     }
     return kOCNotATypeID;
 }
+OCTypeID OCRegisterType(const char *typeName, OCTypeRef (*factory)(cJSON *, OCStringRef *)) {
+    pthread_mutex_lock(&typeIDTableLock);
+    OCTypeID typeID = impl_OCRegisterTypeLocked(typeName, factory);
+    pthread_mutex_unlock(&typeIDTableLock);
+    return typeID;
+}
 void OCRelease(const void *ptr) {
     struct impl_OCType *theType = (struct impl_OCType *)ptr;
     if (NULL == theType) return;
@@ -169,12 +217,14 @@ void OCRelease(const void *ptr) {
                 theType, OCTypeIDName(theType));
         return;
     }
-    if (theType->base.retainCount < 1) {
+    if (impl_OCRetainCountLoad(&theType->base.retainCount) < 1) {
         fprintf(stderr, "ERROR: OCRelease called on (%p) with retainCount < 1, typeID = %s\n",
                 theType, OCTypeIDName(theType));
         return;
     }
-    if (theType->base.retainCount == 1) {
+    if (impl_OCRetainCountDecrement(&theType->base.retainCount) == 0) {
+        // Finalizers see the object as it was while it was last owned
+        theType->base.retainCount = 1;
         if (theType->base.finalize) {
             theType->base.flags.finalized = true;
             theType->base.finalize(theType);  // Clean up internal fields only
@@ -183,9 +233,7 @@ void OCRelease(const void *ptr) {
             impl_OCUntrack(theType);
         }
         free((void *)theType);
-        return;
     }
-    theType->base.retainCount--;
 }
 const void *OCRetain(const void *ptr) {
     if (ptr == NULL) {
@@ -206,11 +254,11 @@ const void *OCRetain(const void *ptr) {
         fprintf(stderr, "*** WARNING: OCRetain called on already-finalized object (%p), typeID = %s\n", ptr, typeName);
         return ptr;
     }
-    if (theType->base.retainCount == UINT16_MAX) {
+    if (impl_OCRetainCountLoad(&theType->base.retainCount) == UINT32_MAX) {
         fprintf(stderr, "*** WARNING: OCRetain overflow on object (%p), typeID = %s\n", ptr, typeName);
         return ptr;
     }
-    theType->base.retainCount++;
+    impl_OCRetainCountIncrement(&theType->base.retainCount);
     return ptr;
 }
 cJSON *OCTypeCopyJSON(OCTypeRef obj, bool typed, OCStringRef *outError) {
@@ -268,6 +316,111 @@ void *OCTypeDeepCopyMutable(const void *obj) {
     const struct impl_OCType *type = (const struct impl_OCType *)obj;
     return type->base.copyDeepMutable ? type->base.copyDeepMutable(obj) : NULL;
 }
+void OCTypeSetSharedCopyCallBacks(OCTypeID typeID, const OCTypeSharedCopyCallBacks *callBacks) {
+    if (typeID == kOCNotATypeID || typeID > 256)
+        return;
+    pthread_mutex_lock(&typeIDTableLock);
+    sharedCopyTable[typeID - 1] = callBacks;
+    pthread_mutex_unlock(&typeIDTableLock);
+}
+// ——— Shared deep copy ———
+// The walk runs in two passes over one map keyed by object address. The first
+// marks each container reached with kOCBooleanTrue if anything below it is
+// mutable and kOCBooleanFalse otherwise; a container met again while its own
+// children are still being checked lies on a cycle, and every cycle runs
+// through a mutable container, so it is taken as true. Immutable containers
+// found to hold nothing mutable are also marked in their base, so copying a
+// graph again skips their contents. The second pass replaces
+// the true marks (and the entries for mutable leaves) with the copies, each
+// recorded before its children are visited so cycles and repeated references
+// resolve to the same copy.
+typedef struct {
+    OCMutableIndexDictionaryRef visited;
+    bool failed;
+} impl_OCTypeSharedCopyContext;
+static inline const OCTypeSharedCopyCallBacks *impl_OCTypeSharedCopyCallBacksFor(const void *obj) {
+    OCTypeID typeID = ((OCTypeRef)obj)->base.typeID;
+    if (typeID == kOCNotATypeID || typeID > 256)
+        return NULL;
+    return sharedCopyTable[typeID - 1];
+}
+static bool impl_OCTypeSharedCopyNeedsCopy(const void *obj, void *info) {
+    if (!obj || OCTypeGetStaticInstance(obj))
+        return false;
+    struct impl_OCType *type = (struct impl_OCType *)obj;
+#if defined(__GNUC__) || defined(__clang__)
+    if (__atomic_load_n(&type->base.deeplyImmutable, __ATOMIC_RELAXED))
+        return false;
+#else
+    if (type->base.deeplyImmutable)
+        return false;
+#endif
+    const OCTypeSharedCopyCallBacks *cb = impl_OCTypeSharedCopyCallBacksFor(obj);
+    if (!cb)
+        return true;  // no way to tell, so copy it as OCTypeDeepCopy() would
+    if (cb->isMutable && cb->isMutable(obj))
+        return true;
+    if (!cb->anyChild)
+        return false;
+    impl_OCTypeSharedCopyContext *context = info;
+    OCIndex key = (OCIndex)(intptr_t)obj;
+    const void *mark = OCIndexDictionaryGetValue(context->visited, key);
+    if (mark)
+        return mark != kOCBooleanFalse;
+    if (!OCIndexDictionarySetValue(context->visited, key, kOCBooleanTrue)) {
+        context->failed = true;
+        return true;
+    }
+    bool needsCopy = cb->anyChild(obj, impl_OCTypeSharedCopyNeedsCopy, context);
+    if (!needsCopy) {
+        // A false answer never rests on a cycle, and an immutable container
+        // keeps its children, so later copies can stop here
+        OCIndexDictionarySetValue(context->visited, key, kOCBooleanFalse);
+#if defined(__GNUC__) || defined(__clang__)
+        __atomic_store_n(&type->base.deeplyImmutable, 1, __ATOMIC_RELAXED);
+#else
+        type->base.deeplyImmutable = 1;
+#endif
+    }
+    return needsCopy;
+}
+// Returns the copy to use in place of obj, owned by the visited map
+static const void *impl_OCTypeSharedCopyChild(const void *obj, void *info) {
+    impl_OCTypeSharedCopyContext *context = info;
+    if (!obj || context->failed || !impl_OCTypeSharedCopyNeedsCopy(obj, context))
+        return obj;
+    OCIndex key = (OCIndex)(intptr_t)obj;
+    const void *copy = OCIndexDictionaryGetValue(context->visited, key);
+    if (copy && copy != kOCBooleanTrue)
+        return copy;
+    const OCTypeSharedCopyCallBacks *cb = impl_OCTypeSharedCopyCallBacksFor(obj);
+    void *made = cb ? cb->createShared(obj) : OCTypeDeepCopy(obj);
+    if (!made || !OCIndexDictionarySetValue(context->visited, key, made)) {
+        if (made)
+            OCRelease(made);
+        context->failed = true;
+        return obj;
+    }
+    OCRelease(made);
+    if (cb && cb->replaceChildren && !cb->replaceChildren(made, impl_OCTypeSharedCopyChild, context))
+        context->failed = true;
+    return made;
+}
+void *OCTypeDeepCopyShared(const void *obj) {
+    if (!obj)
+        return NULL;
+    impl_OCTypeSharedCopyContext context = {OCIndexDictionaryCreateMutable(0), false};
+    if (!context.visited) {
+        fprintf(stderr, "OCTypeDeepCopyShared: Memory allocation failed.\n");
+        return NULL;
+    }
+    const void *copy = impl_OCTypeSharedCopyChild(obj, &context);
+    void *result = context.failed ? NULL : (void *)OCRetain(copy);
+    OCRelease(context.visited);
+    if (!result)
+        fprintf(stderr, "OCTypeDeepCopyShared: Copying the object graph failed.\n");
+    return result;
+}
 // Returns a formatted description of the object.
 OCStringRef OCTypeCopyFormattingDesc(const void *ptr) {
     if (NULL == ptr) return NULL;
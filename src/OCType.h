@@ -35,6 +35,7 @@ typedef const struct impl_OCSet *OCSetRef;
 typedef struct impl_OCSet *OCMutableSetRef;
 typedef const struct impl_OCDictionary *OCDictionaryRef;
 typedef struct impl_OCDictionary *OCMutableDictionaryRef;
+typedef struct impl_OCConcurrentDictionary *OCConcurrentDictionaryRef;
 typedef const struct impl_OCBoolean *OCBooleanRef;
 typedef const struct impl_OCNull *OCNullRef;
 typedef const struct impl_OCData *OCDataRef;
@@ -44,9 +45,14 @@ typedef const struct impl_OCIndexSet *OCIndexSetRef;
 typedef struct impl_OCIndexSet *OCMutableIndexSetRef;
 typedef const struct impl_OCIndexArray *OCIndexArrayRef;
 typedef struct impl_OCIndexArray *OCMutableIndexArrayRef;
+typedef const struct impl_OCIndexDictionary *OCIndexDictionaryRef;
+typedef struct impl_OCIndexDictionary *OCMutableIndexDictionaryRef;
 typedef const struct impl_OCIndexPairSet *OCIndexPairSetRef;
 typedef struct impl_OCIndexPairSet *OCMutableIndexPairSetRef;
+typedef const struct impl_OCSortedDictionary *OCSortedDictionaryRef;
+typedef struct impl_OCSortedDictionary *OCMutableSortedDictionaryRef;
 typedef struct impl_OCAutoreleasePool *OCAutoreleasePoolRef;
+typedef struct impl_OCTaskGroup *OCTaskGroupRef;
 /**
  * @typedef OCOptionFlags
  * @brief Base type for option flags, typically an unsigned long.
@@ -180,6 +186,34 @@ typedef void (*OCFinalizerFunc)(const void *);
  * @ingroup OCType
  */
 bool OCTypeEqual(const void *theType1, const void *theType2);
+/**
+ * @brief Function type for hashing an OCType-compatible object.
+ *
+ * Objects that compare equal with OCTypeEqual() must hash to the same value.
+ */
+typedef uint64_t (*OCTypeHashFunction)(const void *);
+/**
+ * @brief Registers the hash function used by OCTypeHash() for a type.
+ *
+ * Types call this once from their GetTypeID function, after OCRegisterType().
+ *
+ * @param typeID Registered type identifier.
+ * @param hash Hash function for instances of the type, or NULL to remove it.
+ * @ingroup OCType
+ */
+void OCTypeSetHashFunction(OCTypeID typeID, OCTypeHashFunction hash);
+/**
+ * @brief Returns a hash of an OCType object consistent with OCTypeEqual().
+ *
+ * OCString, OCNumber, OCData, OCIndexSet, OCIndexArray and OCIndexPairSet
+ * hash their contents. Other types hash to a per-type constant, which keeps
+ * hashed containers correct but makes their instances collide.
+ *
+ * @param obj Object to hash.
+ * @return The hash, or 0 for NULL.
+ * @ingroup OCType
+ */
+uint64_t OCTypeHash(const void *obj);
 /**
  * @brief Performs a deep copy of an OCType object.
  *
@@ -206,6 +240,57 @@ void *OCTypeDeepCopy(const void *obj);
  * @ingroup OCType
  */
 void *OCTypeDeepCopyMutable(const void *obj);
+/**
+ * @brief Hooks through which OCTypeDeepCopyShared() reads and copies a type.
+ *
+ * Leaf types fill in only @c isMutable and @c createShared; containers also
+ * fill in @c anyChild and @c replaceChildren. Static tables of these are
+ * registered with OCTypeSetSharedCopyCallBacks().
+ */
+typedef struct OCTypeSharedCopyCallBacks {
+    /** Returns true if the instance can change in place; NULL for types that never can. */
+    bool (*isMutable)(const void *obj);
+    /** Calls @c visit on each OCType the instance holds until one call returns true, and returns
+     *  whether one did; NULL for leaves. */
+    bool (*anyChild)(const void *obj, bool (*visit)(const void *child, void *info), void *info);
+    /** Returns a new instance, retained, with the same contents and mutability that shares
+     *  storage with @c obj until either changes. */
+    void *(*createShared)(const void *obj);
+    /** Replaces each child of a copy made by @c createShared with @c map(child), touching only
+     *  children that differ, and restores the copy's mutability; NULL for leaves. */
+    bool (*replaceChildren)(void *copy, const void *(*map)(const void *child, void *info), void *info);
+} OCTypeSharedCopyCallBacks;
+/**
+ * @brief Registers the callbacks used by OCTypeDeepCopyShared() for a type.
+ *
+ * Types call this once from their GetTypeID function, after OCRegisterType().
+ *
+ * @param typeID Registered type identifier.
+ * @param callBacks Callbacks for instances of the type, or NULL to remove them.
+ * @ingroup OCType
+ */
+void OCTypeSetSharedCopyCallBacks(OCTypeID typeID, const OCTypeSharedCopyCallBacks *callBacks);
+/**
+ * @brief Deep-copies an object graph, sharing everything that cannot change.
+ *
+ * The result is equal to @p obj and independent of it: changing either graph
+ * never shows through the other. Immutable objects, and immutable containers
+ * with nothing mutable below them, are retained rather than copied. Mutable
+ * objects are copied with OCArrayCreateMutableCopy() and its counterparts,
+ * which share storage until the first change, and keep their mutability.
+ * Each object is copied once, so an object reached along several paths, and
+ * any cycle, is reproduced with the same shape in the copy.
+ *
+ * OCArray (with kOCTypeArrayCallBacks), OCDictionary, OCSet, OCString,
+ * OCData and OCNumber take part. Objects of other types are copied with
+ * OCTypeDeepCopy().
+ *
+ * @param obj The root of the graph to copy.
+ * @return The copy of the root, to be released with OCRelease(), or NULL on
+ *         failure.
+ * @ingroup OCType
+ */
+void *OCTypeDeepCopyShared(const void *obj);
 /**
  * @brief Registers a new OCType with the system and optional JSON factory.
  *
@@ -353,8 +438,8 @@ const char *OCTypeNameFromTypeID(OCTypeID typeID);
  */
 typedef struct impl_OCBase {
     OCTypeID typeID;       // 2 bytes
-    uint16_t retainCount;  // 2 bytes
-    // 4 bytes total so far
+    uint32_t retainCount;  // 4 bytes (2-byte aligned gap after typeID)
+    // 8 bytes total so far
     // Virtual methods (8-byte aligned after padding)
     void (*finalize)(const void *);
     bool (*equal)(const void *, const void *);
@@ -369,6 +454,10 @@ typedef struct impl_OCBase {
         uint8_t tracked : 1;          // 1 bit
         uint8_t reserved : 5;         // 5 bits reserved for future use
     } flags;                          // 1 byte total
+    // Set by OCTypeDeepCopyShared() on an immutable object once it has found
+    // nothing mutable reachable from it; kept apart from flags so it can be
+    // stored atomically. Fits in the padding after flags.
+    uint8_t deeplyImmutable;
 } OCBase;
 /**
  * @brief Allocates and initializes a new OCType-compatible object with virtual method table.
@@ -29,10 +29,12 @@
 #include "OCArray.h"
 #include "OCAutoreleasePool.h"
 #include "OCBoolean.h"
+#include "OCConcurrentDictionary.h"
 #include "OCData.h"
 #include "OCDictionary.h"
 #include "OCFileUtilities.h"
 #include "OCIndexArray.h"
+#include "OCIndexDictionary.h"
 #include "OCIndexPairSet.h"
 #include "OCIndexSet.h"
 #include "OCLeakTracker.h"
@@ -40,6 +42,8 @@
 #include "OCNull.h"
 #include "OCNumber.h"
 #include "OCSet.h"
+#include "OCSortedDictionary.h"
 #include "OCString.h"
+#include "OCThreadPool.h"
 // Additional convenience definitions can be added here if needed
 #endif /* OCTypes_h */
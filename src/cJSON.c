@@ -50,6 +50,7 @@
 #pragma GCC visibility pop
 #endif
 #include "cJSON.h"
+#include "OCMath.h" /* OCDoubleWriteShortestCString */
 /* define our own boolean type */
 #ifdef true
 #undef true
@@ -211,15 +212,6 @@ cJSON_Delete(cJSON *item) {
         item = next;
     }
 }
-/* get the decimal point character of the current locale */
-static unsigned char get_decimal_point(void) {
-#ifdef ENABLE_LOCALES
-    struct lconv *lconv = localeconv();
-    return (unsigned char)lconv->decimal_point[0];
-#else
-    return '.';
-#endif
-}
 typedef struct
 {
     const unsigned char *content;
@@ -238,64 +230,19 @@ typedef struct
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON *const item, parse_buffer *const input_buffer) {
     double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char *number_c_string;
-    unsigned char decimal_point = get_decimal_point();
-    size_t i = 0;
-    size_t number_string_length = 0;
-    cJSON_bool has_decimal_point = false;
+    size_t consumed = 0;
+    const char *first;
     if ((input_buffer == NULL) || (input_buffer->content == NULL)) {
         return false;
     }
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; can_access_at_index(input_buffer, i); i++) {
-        switch (buffer_at_offset(input_buffer)[i]) {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_string_length++;
-                break;
-            case '.':
-                number_string_length++;
-                has_decimal_point = true;
-                break;
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    /* malloc for temporary buffer, add 1 for '\0' */
-    number_c_string = (unsigned char *)input_buffer->hooks.allocate(number_string_length + 1);
-    if (number_c_string == NULL) {
-        return false; /* allocation failure */
-    }
-    memcpy(number_c_string, buffer_at_offset(input_buffer), number_string_length);
-    number_c_string[number_string_length] = '\0';
-    if (has_decimal_point) {
-        for (i = 0; i < number_string_length; i++) {
-            if (number_c_string[i] == '.') {
-                /* replace '.' with the decimal point of the current locale (for strtod) */
-                number_c_string[i] = decimal_point;
-            }
-        }
+    if (!can_access_at_index(input_buffer, 0)) {
+        return false;
     }
-    number = strtod((const char *)number_c_string, (char **)&after_end);
-    if (number_c_string == after_end) {
-        /* free the temporary buffer */
-        input_buffer->hooks.deallocate(number_c_string);
+    /* parse in place: exact, locale-independent and bounded by the buffer length,
+     * so no temporary '\0'-terminated copy is needed */
+    first = (const char *)buffer_at_offset(input_buffer);
+    consumed = OCDoubleFromChars(first, first + (input_buffer->length - input_buffer->offset), &number);
+    if (consumed == 0) {
         return false; /* parse_error */
     }
     item->valuedouble = number;
@@ -308,9 +255,7 @@ loop_end:
         item->valueint = (int)number;
     }
     item->type = cJSON_Number;
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    /* free the temporary buffer */
-    input_buffer->hooks.deallocate(number_c_string);
+    input_buffer->offset += consumed;
     return true;
 }
 /* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
@@ -446,26 +391,18 @@ static cJSON_bool print_number(const cJSON *const item, printbuffer *const outpu
     unsigned char *output_pointer = NULL;
     double d = item->valuedouble;
     int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
+    char number_buffer[kOCShortestFloatingPointStringSize] = {0}; /* temporary buffer to print the number into */
     if (output_buffer == NULL) {
         return false;
     }
     /* This checks for NaN and Infinity */
     if (isnan(d) || isinf(d)) {
-        length = sprintf((char *)number_buffer, "null");
+        length = sprintf(number_buffer, "null");
     } else if (d == (double)item->valueint) {
-        length = sprintf((char *)number_buffer, "%d", item->valueint);
+        length = sprintf(number_buffer, "%d", item->valueint);
     } else {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char *)number_buffer, "%1.15g", d);
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char *)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d)) {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char *)number_buffer, "%1.17g", d);
-        }
+        /* Shortest digits that read back as the same double; always uses '.' */
+        length = OCDoubleWriteShortestCString(d, number_buffer, sizeof(number_buffer));
     }
     /* sprintf failed or buffer overrun occurred */
     if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1))) {
@@ -476,16 +413,7 @@ static cJSON_bool print_number(const cJSON *const item, printbuffer *const outpu
     if (output_pointer == NULL) {
         return false;
     }
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++) {
-        if (number_buffer[i] == decimal_point) {
-            output_pointer[i] = '.';
-            continue;
-        }
-        output_pointer[i] = number_buffer[i];
-    }
-    output_pointer[i] = '\0';
+    memcpy(output_pointer, number_buffer, (size_t)length + 1);
     output_buffer->offset += (size_t)length;
     return true;
 }
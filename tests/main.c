@@ -18,11 +18,14 @@
 #include "test_dictionary.h"
 #include "test_fileutils.h"
 #include "test_indexarray.h"
+#include "test_indexdictionary.h"
 #include "test_indexpairset.h"
 #include "test_indexset.h"
+#include "test_sorteddictionary.h"
 #include "test_math.h"
 #include "test_number.h"
 #include "test_string.h"
+#include "test_threadpool.h"
 #include "test_type.h"
 #include "test_json_typed.h"
 #include "test_null.h"
@@ -42,13 +45,17 @@ int main(int argc, const char* argv[]) {
     if (!typeTest0()) failures++;
     if (!typeTest1()) failures++;  // New: type description tests
     if (!typeTest2()) failures++;  // New: type description tests
+    if (!typeTest3_deep_copy_shared()) failures++;
     if (!mathTest0()) failures++;
     if (!mathTest1()) failures++;  // New: extra math API tests
+    if (!mathTest_shortest_format()) failures++;
+    if (!mathTest_from_chars()) failures++;
     if (!dataTest0()) failures++;
     if (!dataTest1()) failures++;                  // New: mutable-data API tests
     if (!dataTest_deepcopy()) failures++;          // New: OCData deep copy tests
     if (!dataTest_base64_roundtrip()) failures++;  // New: Base64 roundtrip tests
     if (!dataTest_json_encoding()) failures++;     // New: JSON encoding tests
+    if (!dataTest_copy_on_write()) failures++;
     if (!booleanTest0()) failures++;
     if (!test_number_comprehensive()) failures++;    // ← Comprehensive OCNumber tests (basic + JSON)
     if (!dictionaryTest0()) failures++;              // ← Invoke OCDictionary tests
@@ -59,11 +66,26 @@ int main(int argc, const char* argv[]) {
     if (!dictionaryTest5()) failures++;              // ← New: Invoke OCDictionary deep nesting tests
     if (!OCDictionaryTestDeepCopy()) failures++;     // ← New: Invoke OCDictionary deep copy tests
     if (!test_OCDictionary_deepcopy2()) failures++;  // ← New: Invoke OCDictionary deep copy tests
+    if (!dictionaryTest_iteration()) failures++;     // ← Callback and cursor iteration
+    if (!dictionaryTest_ordered_removal()) failures++;
+    if (!dictionaryTest_shared_keys()) failures++;
+    if (!dictionaryTest_frozen()) failures++;
+    if (!dictionaryTest_concurrent()) failures++;
+    if (!dictionaryTest_concurrent_json()) failures++;
+    if (!dictionaryTest_generic_keys()) failures++;
+    if (!dictionaryTest_copy_on_write()) failures++;
     if (!arrayTest0()) failures++;
     if (!arrayTest1_creation()) failures++;
     if (!arrayTest2_access()) failures++;
     if (!arrayTest3_modification()) failures++;
     if (!arrayTest4_search_sort()) failures++;
+    if (!arrayTest5_range_operations()) failures++;
+    if (!arrayTest6_sorting()) failures++;
+    if (!arrayTest7_apply_map_filter()) failures++;
+    if (!arrayTest8_value_index()) failures++;
+    if (!arrayTest9_deque_storage()) failures++;
+    if (!arrayTest10_persistent()) failures++;
+    if (!arrayTest11_copy_on_write()) failures++;
     if (!stringTest1()) failures++;
     if (!stringTest2()) failures++;
     if (!stringTest3()) failures++;
@@ -78,6 +100,14 @@ int main(int argc, const char* argv[]) {
     if (!stringTest10()) failures++;
     if (!stringTest11()) failures++;
     if (!stringTest_deepcopy()) failures++;
+    if (!stringTest_indexing()) failures++;
+    if (!stringTest_utf8_validation()) failures++;
+    if (!stringTest_substring_views()) failures++;
+    if (!stringTest_search_engine()) failures++;
+    if (!stringTest_format_cache()) failures++;
+    if (!stringTest_no_copy()) failures++;
+    if (!stringTest_rope_builder()) failures++;
+    if (!stringTest_copy_on_write()) failures++;
     if (!complex_parser_Test0()) failures++;
     if (!OCIndexArrayCreateAndCount_test()) failures++;
     if (!OCIndexArrayGetValueAtIndex_test()) failures++;
@@ -86,6 +116,14 @@ int main(int argc, const char* argv[]) {
     if (!OCIndexArrayRemoveValuesAtIndexes_test()) failures++;
     if (!OCIndexArrayDeepCopy_test()) failures++;
     if (!OCIndexArrayJSONEncoding_test()) failures++;
+    if (!OCIndexDictionarySetGetRemove_test()) failures++;
+    if (!OCIndexDictionaryCopy_test()) failures++;
+    if (!OCIndexDictionaryJSONEncoding_test()) failures++;
+    if (!OCSortedDictionarySetGetRemove_test()) failures++;
+    if (!OCSortedDictionaryRangeQuery_test()) failures++;
+    if (!OCSortedDictionaryBulkLoad_test()) failures++;
+    if (!OCThreadPoolTaskGroup_test()) failures++;
+    if (!OCThreadPoolApplyRange_test()) failures++;
     if (!OCIndexSetCreateAndAccess_test()) failures++;
     if (!OCIndexSetAddAndContains_test()) failures++;
     if (!OCIndexSetRangeAndBounds_test()) failures++;
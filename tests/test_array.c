@@ -1,8 +1,11 @@
 #include "test_array.h"
-#include <inttypes.h>         // For PRIu64
-#include "../src/OCArray.h"   // For OCArray specific functions like OCArrayCreateMutable, OCArrayAppendValue etc.
-#include "../src/OCNumber.h"  // For OCNumberRef, OCNumberCreateWithDouble, OCNumberCreateWithSInt32
-#include "../src/OCString.h"  // For OCStringRef, OCStringCreateWithCString, OCStringEqual, OCRelease
+#include <inttypes.h>                  // For PRIu64
+#include <string.h>                    // For strcmp
+#include "../src/OCArray.h"            // For OCArray specific functions like OCArrayCreateMutable, OCArrayAppendValue etc.
+#include "../src/OCAutoreleasePool.h"  // For OCAutorelease
+#include "../src/OCIndexSet.h"         // For OCIndexSetCreateMutable, OCIndexSetAddIndex
+#include "../src/OCNumber.h"           // For OCNumberRef, OCNumberCreateWithDouble, OCNumberCreateWithSInt32
+#include "../src/OCString.h"           // For OCStringRef, OCStringCreateWithCString, OCStringEqual, OCRelease
 // Adapter for OCArraySortValues on OCStringRefs:
 OCComparisonResult OCStringCompareAdapter(const void *a, const void *b, void *ctx) {
     (void)ctx;  // Context not used in this adapter
@@ -130,7 +133,7 @@ bool arrayTest1_creation(void) {
     if (!arr1_copy || OCArrayGetCount(arr1_copy) != 2 ||
         !OCTypeEqual(OCArrayGetValueAtIndex(arr1_copy, 0), s1) ||
         !OCTypeEqual(OCArrayGetValueAtIndex(arr1_copy, 1), s2) ||
-        arr1_copy == arr1) {
+        arr1_copy != arr1) {  // an immutable array is its own copy
         fprintf(stderr, "Error: OCArrayCreateCopy validation failed\n");
         goto cleanup;
     }
@@ -614,3 +617,617 @@ cleanup:
     }
     return success;
 }
+// Reads element i of an array of numbers as an int
+static int arrayTest5_value(OCArrayRef array, uint64_t i) {
+    int32_t v = -1;
+    OCNumberTryGetSInt32((OCNumberRef)OCArrayGetValueAtIndex(array, i), &v);
+    return v;
+}
+bool arrayTest5_range_operations(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    OCNumberRef numbers[10] = {NULL};
+    OCMutableArrayRef marr = NULL;
+    OCMutableIndexSetRef doomed = NULL;
+    for (int i = 0; i < 10; i++) {
+        numbers[i] = OCNumberCreateWithSInt32(i);
+        if (!numbers[i]) goto cleanup;
+    }
+    marr = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCArraySetGrowthPolicy(marr, kOCArrayGrowthOneAndHalf);
+    // Insert a run into an empty array, then into the middle
+    if (!OCArrayInsertValuesAtIndex(marr, 0, (const void **)numbers, 4)) goto cleanup;
+    if (!OCArrayInsertValuesAtIndex(marr, 2, (const void **)&numbers[4], 3)) goto cleanup;
+    // 0 1 4 5 6 2 3
+    int expected1[] = {0, 1, 4, 5, 6, 2, 3};
+    if (OCArrayGetCount(marr) != 7) goto cleanup;
+    for (uint64_t i = 0; i < 7; i++)
+        if (arrayTest5_value(marr, i) != expected1[i]) goto cleanup;
+    if (OCTypeGetRetainCount(numbers[4]) != 2) goto cleanup;
+    // Shrinking and growing replacements
+    const void *nine[] = {numbers[9]};
+    if (!OCArrayReplaceValuesInRange(marr, OCRangeMake(2, 3), nine, 1)) goto cleanup;
+    if (OCTypeGetRetainCount(numbers[4]) != 1 || OCTypeGetRetainCount(numbers[9]) != 2) goto cleanup;
+    if (!OCArrayReplaceValuesInRange(marr, OCRangeMake(0, 1), (const void **)&numbers[7], 2)) goto cleanup;
+    // 7 8 1 9 2 3
+    int expected2[] = {7, 8, 1, 9, 2, 3};
+    if (OCArrayGetCount(marr) != 6) goto cleanup;
+    for (uint64_t i = 0; i < 6; i++)
+        if (arrayTest5_value(marr, i) != expected2[i]) goto cleanup;
+    // Out of bounds and NULL values leave the array alone
+    if (OCArrayReplaceValuesInRange(marr, OCRangeMake(5, 2), NULL, 0)) goto cleanup;
+    const void *withNull[] = {numbers[0], NULL};
+    if (OCArrayInsertValuesAtIndex(marr, 0, withNull, 2) || OCArrayGetCount(marr) != 6) goto cleanup;
+    // Appending an array to itself reads from its own buffer
+    if (!OCArrayAppendArray(marr, marr, OCRangeMake(0, 6)) || OCArrayGetCount(marr) != 12) goto cleanup;
+    for (uint64_t i = 0; i < 6; i++)
+        if (arrayTest5_value(marr, i + 6) != expected2[i]) goto cleanup;
+    if (!OCArrayRemoveValuesInRange(marr, OCRangeMake(6, 6)) || OCArrayGetCount(marr) != 6) goto cleanup;
+    // Remove 7, 9 and 3 by index
+    doomed = OCIndexSetCreateMutable();
+    OCIndexSetAddIndex(doomed, 5);
+    OCIndexSetAddIndex(doomed, 0);
+    OCIndexSetAddIndex(doomed, 3);
+    if (!OCArrayRemoveValuesAtIndexes(marr, doomed)) goto cleanup;
+    int expected3[] = {8, 1, 2};
+    if (OCArrayGetCount(marr) != 3) goto cleanup;
+    for (uint64_t i = 0; i < 3; i++)
+        if (arrayTest5_value(marr, i) != expected3[i]) goto cleanup;
+    if (OCTypeGetRetainCount(numbers[9]) != 1 || OCTypeGetRetainCount(numbers[8]) != 2) goto cleanup;
+    OCIndexSetAddIndex(doomed, 7);
+    if (OCArrayRemoveValuesAtIndexes(marr, doomed) || OCArrayGetCount(marr) != 3) goto cleanup;
+    // Exact reservations
+    OCArraySetGrowthPolicy(marr, kOCArrayGrowthExact);
+    if (!OCArrayReserveCapacity(marr, 100)) goto cleanup;
+    for (int i = 0; i < 50; i++)
+        if (!OCArrayAppendValue(marr, numbers[i % 10])) goto cleanup;
+    if (!OCArrayRemoveValuesInRange(marr, OCRangeMake(0, (OCIndex)OCArrayGetCount(marr)))) goto cleanup;
+    if (OCArrayGetCount(marr) != 0 || OCTypeGetRetainCount(numbers[0]) != 1) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    for (int i = 0; i < 10; i++)
+        if (numbers[i]) OCRelease(numbers[i]);
+    if (doomed) OCRelease(doomed);
+    if (marr) OCRelease(marr);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+static OCComparisonResult arrayTest6_compareNumbers(const void *a, const void *b, void *ctx) {
+    (void)ctx;
+    int32_t x = 0, y = 0;
+    OCNumberTryGetSInt32((OCNumberRef)a, &x);
+    OCNumberTryGetSInt32((OCNumberRef)b, &y);
+    return x < y ? kOCCompareLessThan : x > y ? kOCCompareGreaterThan : kOCCompareEqualTo;
+}
+static bool arrayTest6_isSorted(OCArrayRef array, bool descending) {
+    for (uint64_t i = 1; i < OCArrayGetCount(array); i++) {
+        OCComparisonResult r = arrayTest6_compareNumbers(OCArrayGetValueAtIndex(array, i - 1),
+                                                         OCArrayGetValueAtIndex(array, i), NULL);
+        if (r == (descending ? kOCCompareLessThan : kOCCompareGreaterThan)) return false;
+    }
+    return true;
+}
+bool arrayTest6_sorting(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    OCMutableArrayRef numbers = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCMutableArrayRef strings = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCArrayRef top = NULL;
+    // Large enough to be split when several cores are available
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < 100000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        OCNumberRef n = OCNumberCreateWithSInt32((int32_t)(state % 1000) - 500);
+        OCArrayAppendValue(numbers, n);
+        OCRelease(n);
+    }
+    OCMutableArrayRef copy = OCArrayCreateMutableCopy(numbers);
+    OCRange all = OCRangeMake(0, (OCIndex)OCArrayGetCount(numbers));
+    if (!OCArraySortValuesWithOptions(copy, all, arrayTest6_compareNumbers, NULL, kOCArraySortConcurrent)) goto cleanup;
+    if (!arrayTest6_isSorted(copy, false)) goto cleanup;
+    if (!OCArraySortNumbers(numbers, all, kOCArraySortConcurrent | kOCArraySortDescending)) goto cleanup;
+    if (!arrayTest6_isSorted(numbers, true)) goto cleanup;
+    OCRelease(copy);
+    copy = NULL;
+    // Top-k leaves the source alone; partial sort reorders it in place
+    top = OCArrayCreateWithFirstSortedValues(numbers, 5, arrayTest6_compareNumbers, NULL);
+    if (!top || OCArrayGetCount(top) != 5 || !arrayTest6_isSorted(top, false)) goto cleanup;
+    int32_t smallest = 0;
+    OCNumberTryGetSInt32((OCNumberRef)OCArrayGetValueAtIndex(top, 0), &smallest);
+    if (smallest != -500) goto cleanup;
+    if (!OCArrayPartialSortValues(numbers, all, 5, arrayTest6_compareNumbers, NULL)) goto cleanup;
+    for (uint64_t i = 0; i < 5; i++)
+        if (!OCTypeEqual(OCArrayGetValueAtIndex(numbers, i), OCArrayGetValueAtIndex(top, i))) goto cleanup;
+    // Stability: 5 and 5.0 compare equal and must keep their order
+    OCMutableArrayRef mixed = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCNumberRef five = OCNumberCreateWithSInt32(5);
+    OCNumberRef fiveDouble = OCNumberCreateWithDouble(5.0);
+    OCNumberRef one = OCNumberCreateWithSInt32(1);
+    const void *mixedValues[] = {fiveDouble, one, five, one};
+    OCArrayInsertValuesAtIndex(mixed, 0, mixedValues, 4);
+    bool stable = OCArraySortNumbers(mixed, OCRangeMake(0, 4), kOCArraySortDefault) &&
+                  OCArrayGetValueAtIndex(mixed, 2) == fiveDouble && OCArrayGetValueAtIndex(mixed, 3) == five;
+    stable = stable && OCArraySortNumbers(mixed, OCRangeMake(0, 4), kOCArraySortDescending) &&
+             OCArrayGetValueAtIndex(mixed, 0) == fiveDouble && OCArrayGetValueAtIndex(mixed, 1) == five;
+    // Non-numbers are rejected without touching the array
+    stable = stable && OCArrayAppendValue(mixed, STR("x")) &&
+             !OCArraySortNumbers(mixed, OCRangeMake(0, 5), kOCArraySortDefault) &&
+             OCArrayGetValueAtIndex(mixed, 0) == fiveDouble;
+    OCRelease(mixed);
+    OCRelease(five);
+    OCRelease(fiveDouble);
+    OCRelease(one);
+    if (!stable) goto cleanup;
+    // 64-bit integers past 2^53 differ though their doubles collide; with a
+    // double among them the keys tie and the exact values decide
+    int64_t big[] = {(1LL << 53) + 1, 1LL << 53, (1LL << 53) + 3, (1LL << 53) + 2};
+    OCMutableArrayRef wide = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    for (int i = 0; i < 4; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt64(big[i]);
+        OCArrayAppendValue(wide, n);
+        OCRelease(n);
+    }
+    bool exact = OCArraySortNumbers(wide, OCRangeMake(0, 4), kOCArraySortDefault);
+    for (int i = 0; exact && i < 4; i++) {
+        int64_t v = 0;
+        exact = OCNumberTryGetSInt64(OCArrayGetValueAtIndex(wide, i), &v) && v == (1LL << 53) + i;
+    }
+    OCNumberRef twoTo53 = OCNumberCreateWithDouble(0x1p53);
+    OCNumberRef unsignedBig = OCNumberCreateWithUInt64((1ULL << 53) + 1);
+    OCArrayAppendValue(wide, twoTo53);
+    OCArrayAppendValue(wide, unsignedBig);
+    exact = exact && OCArraySortNumbers(wide, OCRangeMake(0, 6), kOCArraySortDescending);
+    const int64_t wideOrder[] = {3, 2, 1, 1, 0, 0};
+    for (int i = 0; exact && i < 6; i++) {
+        // Equal values stay in insertion order, so the late arrivals come last
+        const void *v = OCArrayGetValueAtIndex(wide, i);
+        int64_t s = 0;
+        if (v == twoTo53)
+            exact = i == 5;
+        else if (v == unsignedBig)
+            exact = i == 3;
+        else
+            exact = OCNumberTryGetSInt64(v, &s) && s == (1LL << 53) + wideOrder[i];
+    }
+    OCRelease(twoTo53);
+    OCRelease(unsignedBig);
+    OCRelease(wide);
+    if (!exact) goto cleanup;
+    // Strings sharing long prefixes, and one that is a prefix of another
+    const char *words[] = {"prefix-shared-b", "prefix-shared-a", "b", "prefix", "", "prefix-shared", "a\xc3\xa9", "ab"};
+    const char *sorted[] = {"", "ab", "a\xc3\xa9", "b", "prefix", "prefix-shared", "prefix-shared-a", "prefix-shared-b"};
+    for (int i = 0; i < 8; i++) {
+        OCStringRef s = OCStringCreateWithCString(words[i]);
+        OCArrayAppendValue(strings, s);
+        OCRelease(s);
+    }
+    if (!OCArraySortStrings(strings, OCRangeMake(0, 8), kOCArraySortDefault)) goto cleanup;
+    for (int i = 0; i < 8; i++)
+        if (strcmp(OCStringGetCString(OCArrayGetValueAtIndex(strings, i)), sorted[i]) != 0) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    if (copy) OCRelease(copy);
+    if (top) OCRelease(top);
+    OCRelease(numbers);
+    OCRelease(strings);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+static void arrayTest7_sum(const void *value, void *context) {
+    int32_t v = 0;
+    OCNumberTryGetSInt32((OCNumberRef)value, &v);
+    __atomic_add_fetch((int64_t *)context, v, __ATOMIC_RELAXED);
+}
+// Returns an autoreleased temporary, as callers are allowed to
+static const void *arrayTest7_double(const void *value, void *context) {
+    (void)context;
+    int32_t v = 0;
+    OCNumberTryGetSInt32((OCNumberRef)value, &v);
+    if (v < 0) return NULL;
+    return OCAutorelease(OCNumberCreateWithSInt32(2 * v));
+}
+static bool arrayTest7_isMultipleOfThree(const void *value, void *context) {
+    (void)context;
+    int32_t v = 0;
+    OCNumberTryGetSInt32((OCNumberRef)value, &v);
+    return v % 3 == 0;
+}
+bool arrayTest7_apply_map_filter(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    OCArrayRef mapped = NULL;
+    OCArrayRef filtered = NULL;
+    OCMutableArrayRef values = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    const int count = 20000;
+    for (int i = 0; i < count; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt32(i);
+        OCArrayAppendValue(values, n);
+        OCRelease(n);
+    }
+    OCRange all = OCRangeMake(0, count);
+    for (int pass = 0; pass < 2; pass++) {
+        OCArrayApplyOptions options = pass ? kOCArrayApplyConcurrent : kOCArrayApplyDefault;
+        int64_t total = 0;
+        OCArrayApplyFunction(values, all, arrayTest7_sum, &total, options);
+        if (total != (int64_t)count * (count - 1) / 2) goto cleanup;
+        mapped = OCArrayCreateByMapping(values, arrayTest7_double, NULL, &kOCTypeArrayCallBacks, options);
+        if (!mapped || OCArrayGetCount(mapped) != (uint64_t)count) goto cleanup;
+        for (int i = 0; i < count; i += 997) {
+            int32_t v = -1;
+            OCNumberTryGetSInt32((OCNumberRef)OCArrayGetValueAtIndex(mapped, (uint64_t)i), &v);
+            if (v != 2 * i) goto cleanup;
+        }
+        // Only the result array holds the mapped values once the pools drain
+        if (OCTypeGetRetainCount(OCArrayGetValueAtIndex(mapped, 0)) != 1) goto cleanup;
+        filtered = OCArrayCreateByFiltering(values, arrayTest7_isMultipleOfThree, NULL, options);
+        if (!filtered || OCArrayGetCount(filtered) != (uint64_t)(count + 2) / 3) goto cleanup;
+        for (uint64_t i = 0; i < OCArrayGetCount(filtered); i++) {
+            if (OCArrayGetValueAtIndex(filtered, i) != OCArrayGetValueAtIndex(values, 3 * i)) goto cleanup;
+        }
+        OCRelease(mapped);
+        OCRelease(filtered);
+        mapped = filtered = NULL;
+    }
+    // A mapper returning NULL abandons the mapping
+    OCNumberRef negative = OCNumberCreateWithSInt32(-1);
+    OCArrayAppendValue(values, negative);
+    OCRelease(negative);
+    if (OCArrayCreateByMapping(values, arrayTest7_double, NULL, &kOCTypeArrayCallBacks, kOCArrayApplyDefault)) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    if (mapped) OCRelease(mapped);
+    if (filtered) OCRelease(filtered);
+    OCRelease(values);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+// Reference answer for OCArrayGetFirstIndexOfValue by plain scan
+static OCIndex arrayTest8_scan(OCArrayRef array, const void *value) {
+    for (uint64_t i = 0; i < OCArrayGetCount(array); i++) {
+        if (OCTypeEqual(OCArrayGetValueAtIndex(array, i), value)) return (OCIndex)i;
+    }
+    return kOCNotFound;
+}
+static bool arrayTest8_agrees(OCArrayRef array, int32_t maxValue) {
+    for (int32_t v = -1; v <= maxValue; v++) {
+        OCNumberRef n = OCNumberCreateWithSInt32(v);
+        OCIndex expected = arrayTest8_scan(array, n);
+        bool ok = OCArrayGetFirstIndexOfValue(array, n) == expected &&
+                  OCArrayContainsValue(array, n) == (expected != kOCNotFound);
+        OCRelease(n);
+        if (!ok) return false;
+    }
+    return true;
+}
+static bool arrayTest8_equalNumbers(const void *a, const void *b) {
+    return OCTypeEqual(a, b);
+}
+bool arrayTest8_value_index(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    OCArrayRef immutable = NULL;
+    OCMutableArrayRef nested = NULL;
+    OCMutableArrayRef values = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    // 0..499 twice, so first indexes must win over later duplicates
+    for (int i = 0; i < 1000; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt32(i % 500);
+        OCArrayAppendValue(values, n);
+        OCRelease(n);
+    }
+    if (OCArrayIsValueIndexEnabled(values) || !OCArraySetValueIndexEnabled(values, true)) goto cleanup;
+    if (!OCArrayIsValueIndexEnabled(values) || !arrayTest8_agrees(values, 600)) goto cleanup;
+    // Appends extend the index, past the point where it has to grow
+    for (int i = 500; i < 2000; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt32(i);
+        OCArrayAppendValue(values, n);
+        OCRelease(n);
+        if (i % 250 == 0 && !arrayTest8_agrees(values, i + 1)) goto cleanup;
+    }
+    if (!arrayTest8_agrees(values, 2001)) goto cleanup;
+    // Every other mutation must leave lookups correct
+    OCNumberRef seven = OCNumberCreateWithSInt32(7);
+    OCArrayInsertValueAtIndex(values, 0, seven);
+    bool ok = arrayTest8_agrees(values, 2001) && OCArrayGetFirstIndexOfValue(values, seven) == 0;
+    OCArraySetValueAtIndex(values, 3, seven);
+    ok = ok && arrayTest8_agrees(values, 2001);
+    OCRelease(seven);
+    if (!ok) goto cleanup;
+    OCArrayRemoveValueAtIndex(values, 0);
+    if (!arrayTest8_agrees(values, 2001)) goto cleanup;
+    OCArrayRemoveValuesInRange(values, OCRangeMake(100, 400));
+    if (!arrayTest8_agrees(values, 2001)) goto cleanup;
+    OCArraySortNumbers(values, OCRangeMake(0, (OCIndex)OCArrayGetCount(values)), kOCArraySortDescending);
+    if (!arrayTest8_agrees(values, 2001)) goto cleanup;
+    OCArraySetValueIndexEnabled(values, false);
+    if (OCArrayIsValueIndexEnabled(values) || !arrayTest8_agrees(values, 2001)) goto cleanup;
+    // Immutable arrays can be indexed too
+    immutable = OCArrayCreateCopy(values);
+    if (!OCArraySetValueIndexEnabled(immutable, true) || !arrayTest8_agrees(immutable, 2001)) goto cleanup;
+    // Arrays have no hash function, so a long run of them gives up on the index
+    nested = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    for (int i = 0; i < 300; i++) {
+        OCMutableArrayRef inner = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+        OCNumberRef n = OCNumberCreateWithSInt32(i);
+        OCArrayAppendValue(inner, n);
+        OCArrayAppendValue(nested, inner);
+        OCRelease(n);
+        OCRelease(inner);
+    }
+    if (!OCArraySetValueIndexEnabled(nested, true)) goto cleanup;
+    for (uint64_t i = 0; i < 300; i += 37) {
+        if (OCArrayGetFirstIndexOfValue(nested, OCArrayGetValueAtIndex(nested, i)) != (OCIndex)i) goto cleanup;
+    }
+    // A custom equal callback has no hash to go with it
+    OCArrayCallBacks custom = kOCTypeArrayCallBacks;
+    custom.equal = arrayTest8_equalNumbers;
+    OCMutableArrayRef customArray = OCArrayCreateMutable(0, &custom);
+    ok = !OCArraySetValueIndexEnabled(customArray, true) && !OCArrayIsValueIndexEnabled(customArray);
+    OCRelease(customArray);
+    if (!ok) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    if (immutable) OCRelease(immutable);
+    if (nested) OCRelease(nested);
+    OCRelease(values);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+static bool arrayTest9_matches(OCArrayRef array, const int32_t *model, uint64_t count) {
+    if (OCArrayGetCount(array) != count) return false;
+    for (uint64_t i = 0; i < count; i++) {
+        int32_t v = -1;
+        OCNumberTryGetSInt32((OCNumberRef)OCArrayGetValueAtIndex(array, i), &v);
+        if (v != model[i]) return false;
+    }
+    return true;
+}
+bool arrayTest9_deque_storage(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    enum { kMaxCount = 4096 };
+    int32_t *model = malloc(2 * kMaxCount * sizeof(int32_t));
+    OCMutableArrayRef queue = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    if (!model || !queue) goto cleanup;
+    if (OCArrayGetStorageMode(queue) != kOCArrayStorageLinear) goto cleanup;
+    // First in, first out on the default storage
+    for (int32_t i = 0; i < kMaxCount; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt32(i);
+        OCArrayAppendValue(queue, n);
+        OCRelease(n);
+    }
+    for (int32_t i = 0; i < kMaxCount; i++) {
+        int32_t v = -1;
+        OCNumberRef head = (OCNumberRef)OCArrayGetValueAtIndex(queue, 0);
+        if (!OCNumberTryGetSInt32(head, &v) || v != i) goto cleanup;
+        if (OCTypeGetRetainCount(head) != 1 || !OCArrayRemoveValueAtIndex(queue, 0)) goto cleanup;
+        // Interleave appends so the freed front room gets reused
+        if (i % 3 == 0) {
+            OCNumberRef n = OCNumberCreateWithSInt32(kMaxCount + i);
+            OCArrayAppendValue(queue, n);
+            OCRelease(n);
+        }
+    }
+    if (OCArrayGetCount(queue) != (kMaxCount + 2) / 3) goto cleanup;
+    OCArrayRemoveValuesInRange(queue, OCRangeMake(0, (OCIndex)OCArrayGetCount(queue)));
+    // Random pushes and pops at both ends and edits in the middle, checked
+    // against a plain C array, in both storage modes
+    for (int mode = 0; mode < 2; mode++) {
+        OCArraySetStorageMode(queue, mode ? kOCArrayStorageDeque : kOCArrayStorageLinear);
+        uint64_t count = 0;
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int32_t step = 0; step < 40000; step++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            unsigned op = (unsigned)(state % 10);
+            OCNumberRef n = OCNumberCreateWithSInt32(step);
+            if (op < 3 && count < kMaxCount) {
+                OCArrayInsertValueAtIndex(queue, 0, n);
+                memmove(model + 1, model, count * sizeof(int32_t));
+                model[0] = step;
+                count++;
+            } else if (op < 6 && count < kMaxCount) {
+                OCArrayAppendValue(queue, n);
+                model[count++] = step;
+            } else if (op < 8 && count > 0) {
+                OCArrayRemoveValueAtIndex(queue, 0);
+                memmove(model, model + 1, --count * sizeof(int32_t));
+            } else if (op == 8 && count > 0) {
+                OCArrayRemoveValueAtIndex(queue, --count);
+            } else if (count > 4) {
+                // Replace two values with one a quarter of the way in
+                uint64_t at = count / 4;
+                const void *one[1] = {n};
+                OCArrayReplaceValuesInRange(queue, OCRangeMake((OCIndex)at, 2), one, 1);
+                model[at] = step;
+                memmove(model + at + 1, model + at + 2, (count - at - 2) * sizeof(int32_t));
+                count--;
+            }
+            OCRelease(n);
+            if (step % 997 == 0 && !arrayTest9_matches(queue, model, count)) goto cleanup;
+        }
+        if (!arrayTest9_matches(queue, model, count)) goto cleanup;
+        OCArrayRemoveValuesInRange(queue, OCRangeMake(0, (OCIndex)count));
+    }
+    if (OCArrayGetStorageMode(queue) != kOCArrayStorageDeque) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    free(model);
+    if (queue) OCRelease(queue);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+static bool arrayTest10_matches(OCArrayRef array, const int32_t *model, uint64_t count) {
+    return OCArrayIsPersistent(array) && arrayTest9_matches(array, model, count);
+}
+static bool arrayTest10_isEven(const void *value, void *context) {
+    (void)context;
+    int32_t v = 0;
+    OCNumberTryGetSInt32((OCNumberRef)value, &v);
+    return v % 2 == 0;
+}
+bool arrayTest10_persistent(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    // Enough values for three levels above the leaves
+    enum { kCount = 40000, kSnapshots = 5 };
+    const uint64_t snapshotCounts[kSnapshots] = {31, 32, 1056, 1057, 32800};
+    OCArrayRef snapshots[kSnapshots] = {NULL};
+    int32_t *model = malloc(kCount * sizeof(int32_t));
+    OCArrayRef version = OCArrayCreate(NULL, 0, &kOCTypeArrayCallBacks);
+    OCArrayRef edited = NULL, copy = NULL, filtered = NULL;
+    OCMutableArrayRef flat = NULL;
+    OCNumberRef probe = NULL;
+    if (!model || !version || OCArrayIsPersistent(version)) goto cleanup;
+    for (int32_t i = 0; i < kCount; i++) {
+        for (int s = 0; s < kSnapshots; s++)
+            if (snapshotCounts[s] == (uint64_t)i) snapshots[s] = OCArrayCreateCopy(version);
+        OCNumberRef n = OCNumberCreateWithSInt32(i);
+        OCArrayRef next = OCArrayCreateByAppendingValue(version, n);
+        OCRelease(n);
+        OCRelease(version);
+        version = next;
+        if (!version) goto cleanup;
+        model[i] = i;
+    }
+    if (!arrayTest10_matches(version, model, kCount)) goto cleanup;
+    // Older versions still see exactly their own values
+    for (int s = 0; s < kSnapshots; s++)
+        if (!arrayTest10_matches(snapshots[s], model, snapshotCounts[s])) goto cleanup;
+    // Sets on a chain of versions, in the trie and in the tail
+    edited = OCArrayCreateCopy(version);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int32_t step = 0; step < 3000; step++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        uint64_t at = step % 10 == 0 ? kCount - 1 - state % 32 : state % kCount;
+        OCNumberRef n = OCNumberCreateWithSInt32(-step);
+        OCArrayRef next = OCArrayCreateBySettingValueAtIndex(edited, at, n);
+        OCRelease(n);
+        OCRelease(edited);
+        edited = next;
+        if (!edited) goto cleanup;
+        model[at] = -step;
+    }
+    if (!arrayTest10_matches(edited, model, kCount)) goto cleanup;
+    for (int32_t i = 0; i < kCount; i++) model[i] = i;
+    if (!arrayTest10_matches(version, model, kCount)) goto cleanup;
+    if (OCArrayCreateBySettingValueAtIndex(version, kCount, version) != NULL) goto cleanup;
+    // A copy shares the leaf, so the value is retained once for both
+    probe = OCNumberCreateWithSInt32(kCount);
+    copy = OCArrayCreateByAppendingValue(snapshots[0], probe);
+    OCArrayRef shared = OCArrayCreateCopy(copy);
+    bool ok = shared && OCTypeGetRetainCount(probe) == 2 && OCArrayGetValueAtIndex(shared, 31) == probe;
+    OCRelease(shared);
+    if (!ok) goto cleanup;
+    // Bulk operations go through the flat view and agree with a flat array
+    flat = OCArrayCreateMutableCopy(version);
+    if (!flat || OCArrayIsPersistent(flat) || !OCTypeEqual(flat, version) || OCTypeEqual(flat, edited)) goto cleanup;
+    // A flat array converts on its first persistent edit
+    OCArrayRef converted = OCArrayCreateBySettingValueAtIndex(flat, 0, probe);
+    model[0] = kCount;
+    ok = converted && arrayTest10_matches(converted, model, kCount) && OCArrayGetValueAtIndex(flat, 0) != probe;
+    model[0] = 0;
+    if (converted) OCRelease(converted);
+    if (!ok) goto cleanup;
+    OCNumberRef needle = OCNumberCreateWithSInt32(kCount - 40);
+    ok = OCArrayGetFirstIndexOfValue(version, needle) == kCount - 40 && !OCArrayContainsValue(version, probe);
+    OCRelease(needle);
+    if (!ok) goto cleanup;
+    filtered = OCArrayCreateByFiltering(version, arrayTest10_isEven, NULL, kOCArrayApplyConcurrent);
+    if (!filtered || OCArrayGetCount(filtered) != kCount / 2) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    for (int s = 0; s < kSnapshots; s++)
+        if (snapshots[s]) OCRelease(snapshots[s]);
+    if (version) OCRelease(version);
+    if (edited) OCRelease(edited);
+    if (copy) OCRelease(copy);
+    if (flat) OCRelease(flat);
+    if (filtered) OCRelease(filtered);
+    if (probe) {
+        if (success && OCTypeGetRetainCount(probe) != 1) {
+            fprintf(stderr, "persistent arrays leaked a reference\n");
+            success = false;
+        }
+        OCRelease(probe);
+    }
+    free(model);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
+bool arrayTest11_copy_on_write(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = false;
+    OCMutableArrayRef source = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCArrayRef snapshot = NULL, again = NULL;
+    OCMutableArrayRef edit = NULL;
+    OCNumberRef probe = OCNumberCreateWithInt(-1);
+    if (!source || !probe) goto cleanup;
+    for (int i = 0; i < 100; i++) {
+        OCNumberRef n = OCNumberCreateWithInt(i);
+        OCArrayAppendValue(source, n);
+        OCRelease(n);
+    }
+    OCArrayAppendValue(source, probe);
+    // Copies hold no references of their own until something changes
+    snapshot = OCArrayCreateCopy(source);
+    edit = OCArrayCreateMutableCopy(source);
+    if (!snapshot || !edit || OCTypeGetRetainCount(probe) != 2) goto cleanup;
+    if (!OCTypeEqual(snapshot, source) || !OCTypeEqual(edit, source)) goto cleanup;
+    again = OCArrayCreateCopy(snapshot);
+    if (again != snapshot) goto cleanup;
+    // Each array gets its own buffer on its first change; the others keep theirs
+    OCArrayRemoveValueAtIndex(source, 0);
+    if (OCArrayGetCount(source) != 100 || OCArrayGetCount(snapshot) != 101 || OCArrayGetCount(edit) != 101) goto cleanup;
+    if (OCTypeGetRetainCount(probe) != 3) goto cleanup;
+    OCArraySetValueAtIndex(edit, 100, kOCBooleanTrue);
+    if (OCArrayGetValueAtIndex(snapshot, 100) != probe || OCArrayGetValueAtIndex(edit, 100) != kOCBooleanTrue) goto cleanup;
+    if (OCTypeGetRetainCount(probe) != 3) goto cleanup;
+    // Once the other copies are gone the last borrower takes the buffer back
+    OCRelease(again);
+    again = NULL;
+    OCRelease(source);
+    source = NULL;
+    OCMutableArrayRef reclaimed = OCArrayCreateMutableCopy(snapshot);
+    OCRelease(snapshot);
+    snapshot = NULL;
+    if (!reclaimed) goto cleanup;
+    OCArrayAppendValue(reclaimed, probe);
+    bool same = OCArrayGetCount(reclaimed) == 102 && OCTypeGetRetainCount(probe) == 3;
+    OCRelease(reclaimed);
+    if (!same || OCTypeGetRetainCount(probe) != 1) goto cleanup;
+    fprintf(stderr, " passed\n");
+    success = true;
+cleanup:
+    if (again) OCRelease(again);
+    if (snapshot) OCRelease(snapshot);
+    if (edit) OCRelease(edit);
+    if (source) OCRelease(source);
+    if (probe) OCRelease(probe);
+    if (!success) {
+        fprintf(stderr, "Test %s FAILED (due to prior error or assertion failure) in file %s\n", __func__, __FILE__);
+    }
+    return success;
+}
@@ -9,6 +9,13 @@ bool arrayTest1_creation(void);
 bool arrayTest2_access(void);
 bool arrayTest3_modification(void);
 bool arrayTest4_search_sort(void);
+bool arrayTest5_range_operations(void);
+bool arrayTest6_sorting(void);
+bool arrayTest7_apply_map_filter(void);
+bool arrayTest8_value_index(void);
+bool arrayTest9_deque_storage(void);
+bool arrayTest10_persistent(void);
+bool arrayTest11_copy_on_write(void);
 // Adapter for OCArraySortValues on OCStringRefs (used by arrayTest0)
 OCComparisonResult OCStringCompareAdapter(const void *a, const void *b, void *ctx);
 #endif /* TEST_ARRAY_H */
@@ -65,7 +65,7 @@ bool dataTest0(void) {
         PRINTERROR;
     }
     const uint8_t *ptr3 = OCDataGetBytesPtr(data3);
-    if (ptr3 == ptr1) {
+    if (data3 != data1 || ptr3 != ptr1) {  // immutable data is its own copy
         OCRelease(data3);
         OCRelease(data1);
         PRINTERROR;
@@ -325,3 +325,48 @@ bool dataTest_json_encoding(void) {
     fprintf(stderr, " passed\n");
     return true;
 }
+bool dataTest_copy_on_write(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    uint8_t bytes[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    OCMutableDataRef source = OCDataCreateMutable(0);
+    OCDataAppendBytes(source, bytes, sizeof(bytes));
+    // Copies read the source's bytes until one of them changes
+    OCDataRef snapshot = OCDataCreateCopy(source);
+    OCMutableDataRef edit = OCDataCreateMutableCopy(64, snapshot);
+    ASSERT_NOT_NULL(snapshot, "OCDataCreateCopy should not return NULL");
+    ASSERT_NOT_NULL(edit, "OCDataCreateMutableCopy should not return NULL");
+    ASSERT_TRUE(OCDataGetBytesPtr(snapshot) == OCDataGetBytesPtr(source), "Copy should share the source's bytes");
+    ASSERT_TRUE(OCDataGetBytesPtr(edit) == OCDataGetBytesPtr(source), "Mutable copy should share the source's bytes");
+    OCDataRef again = OCDataCreateCopy(snapshot);
+    ASSERT_TRUE(again == snapshot, "Copying immutable data should retain it");
+    OCRelease(again);
+    // Writing through either side leaves the other untouched
+    OCDataGetMutableBytes(source)[0] = 0xFF;
+    ASSERT_TRUE(OCDataGetBytesPtr(snapshot)[0] == 1, "Snapshot should keep the old bytes");
+    ASSERT_TRUE(OCDataGetBytesPtr(edit)[0] == 1, "Mutable copy should keep the old bytes");
+    ASSERT_TRUE(OCDataAppendBytes(edit, bytes, 2), "Appending to the mutable copy should succeed");
+    ASSERT_TRUE(OCDataGetLength(edit) == 10 && OCDataGetLength(snapshot) == 8, "Lengths should be independent");
+    ASSERT_TRUE(OCDataGetBytesPtr(edit)[8] == 1 && OCDataGetBytesPtr(edit)[9] == 2, "Appended bytes should follow");
+    // The last borrower takes the buffer back instead of copying it
+    OCMutableDataRef last = OCDataCreateMutableCopy(0, snapshot);
+    const uint8_t *shared = OCDataGetBytesPtr(last);
+    OCRelease(snapshot);
+    ASSERT_TRUE(OCDataGetMutableBytes(last) == shared, "Sole borrower should reuse the buffer");
+    ASSERT_TRUE(OCDataSetLength(last, 4) && OCDataGetBytesPtr(last)[3] == 4, "Truncated copy should keep its prefix");
+    // Bytes already handed out may still be written through, so later
+    // copies of that data get their own
+    uint8_t *exposed = OCDataGetMutableBytes(edit);
+    OCDataRef afterExposure = OCDataCreateCopy(edit);
+    OCMutableDataRef mutableAfterExposure = OCDataCreateMutableCopy(0, edit);
+    exposed[0] = 99;
+    ASSERT_TRUE(OCDataGetBytesPtr(afterExposure)[0] == 1, "Copy should not see writes through exposed bytes");
+    ASSERT_TRUE(OCDataGetBytesPtr(mutableAfterExposure)[0] == 1, "Mutable copy should not see writes through exposed bytes");
+    ASSERT_TRUE(OCDataGetLength(afterExposure) == 10, "Eager copy should keep the length");
+    OCRelease(mutableAfterExposure);
+    OCRelease(afterExposure);
+    OCRelease(last);
+    OCRelease(edit);
+    OCRelease(source);
+    fprintf(stderr, " passed\n");
+    return true;
+}
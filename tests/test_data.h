@@ -10,4 +10,6 @@ bool dataTest_deepcopy(void);
 bool dataTest_base64_roundtrip(void);
 // JSON encoding tests
 bool dataTest_json_encoding(void);
+// Copies share bytes until first mutation
+bool dataTest_copy_on_write(void);
 #endif /* TEST_DATA_H */
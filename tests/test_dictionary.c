@@ -1,5 +1,6 @@
 // tests/test_dictionary.c
 #include <complex.h>  // for float complex / double complex
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>  // for strncmp
@@ -7,6 +8,7 @@
 #include "../src/OCArray.h"
 #include "../src/OCAutoreleasePool.h"
 #include "../src/OCBoolean.h"
+#include "../src/OCConcurrentDictionary.h"
 #include "../src/OCDictionary.h"
 #include "../src/OCNumber.h"
 #include "../src/OCString.h"
@@ -654,8 +656,11 @@ bool test_OCDictionary_deepcopy2(void) {
     OCStringRef v2 = STR("v2");
     const void *keys[] = {k1, k2};
     const void *values[] = {v1, v2};
-    OCDictionaryRef dict = OCDictionaryCreate(keys, values, 2);
-    ASSERT_NOT_NULL(dict, "failed to create dictionary");
+    OCDictionaryRef frozen = OCDictionaryCreate(keys, values, 2);
+    ASSERT_NOT_NULL(frozen, "failed to create dictionary");
+    OCMutableDictionaryRef dict = OCDictionaryCreateMutableCopy(frozen);
+    OCRelease(frozen);
+    ASSERT_NOT_NULL(dict, "failed to create mutable copy");
     ASSERT_EQUAL(
         OCDictionaryGetCount(dict),
         2,
@@ -681,7 +686,7 @@ bool test_OCDictionary_deepcopy2(void) {
     // Mutate original: change "k1" → "new"
     OCStringRef newVal = STR("new");
     ASSERT_TRUE(
-        OCDictionarySetValue((OCMutableDictionaryRef)dict, k1, newVal),
+        OCDictionarySetValue(dict, k1, newVal),
         "failed to set new value for k1");
     // Now original and copy must differ at k1
     OCTypeRef mutated_v1 = (OCTypeRef)OCDictionaryGetValue(dict, k1);
@@ -694,3 +699,478 @@ bool test_OCDictionary_deepcopy2(void) {
     OCRelease(dict);
     return true;
 }
+static void sumEntryValues(OCStringRef key, const void *value, void *context) {
+    int64_t *sums = (int64_t *)context;
+    int v = 0;
+    OCNumberTryGetInt((OCNumberRef)value, &v);
+    sums[0] += v;
+    sums[1] += (int64_t)OCStringGetLength(key);
+}
+bool dictionaryTest_iteration(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    OCMutableDictionaryRef dict = OCDictionaryCreateMutable(0);
+    if (!dict) PRINTERROR;
+    int64_t expectedSum = 0, expectedKeyChars = 0;
+    for (int i = 0; i < 1000; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("key%d"), i);
+        OCNumberRef value = OCNumberCreateWithInt(i);
+        OCDictionaryAddValue(dict, key, value);
+        expectedSum += i;
+        expectedKeyChars += (int64_t)OCStringGetLength(key);
+        OCRelease(key);
+        OCRelease(value);
+    }
+    // Callback walk
+    int64_t sums[2] = {0, 0};
+    OCDictionaryApplyFunction(dict, sumEntryValues, sums);
+    if (sums[0] != expectedSum || sums[1] != expectedKeyChars) PRINTERROR;
+    // Cursor walk: every entry once, and each key maps to the value returned with it
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    uint64_t visited = 0;
+    OCDictionaryCursorInit(&cursor, dict);
+    while (OCDictionaryCursorNext(&cursor, &key, &value)) {
+        if (OCDictionaryGetValue(dict, key) != value) PRINTERROR;
+        visited++;
+    }
+    if (visited != OCDictionaryGetCount(dict)) PRINTERROR;
+    // A finished cursor stays finished; NULL and empty dictionaries yield nothing
+    if (OCDictionaryCursorNext(&cursor, NULL, NULL)) PRINTERROR;
+    OCDictionaryCursorInit(&cursor, NULL);
+    if (OCDictionaryCursorNext(&cursor, &key, &value)) PRINTERROR;
+    OCMutableDictionaryRef empty = OCDictionaryCreateMutable(0);
+    OCDictionaryCursorInit(&cursor, empty);
+    if (OCDictionaryCursorNext(&cursor, &key, &value)) PRINTERROR;
+    OCDictionaryApplyFunction(empty, sumEntryValues, sums);
+    OCArrayRef noKeys = OCDictionaryCreateArrayWithAllKeys(empty);
+    if (!noKeys || OCArrayGetCount(noKeys) != 0) PRINTERROR;
+    OCRelease(noKeys);
+    OCRelease(empty);
+    // Walkers built on the cursor
+    OCArrayRef keys = OCDictionaryCreateArrayWithAllKeys(dict);
+    OCArrayRef values = OCDictionaryCreateArrayWithAllValues(dict);
+    if (OCArrayGetCount(keys) != 1000 || OCArrayGetCount(values) != 1000) PRINTERROR;
+    if (OCDictionaryGetValue(dict, OCArrayGetValueAtIndex(keys, 7)) != OCArrayGetValueAtIndex(values, 7)) PRINTERROR;
+    OCRelease(keys);
+    OCRelease(values);
+    cJSON *json = OCDictionaryCopyAsJSON(dict, false, NULL);
+    if (!json || cJSON_GetArraySize(json) != 1000) PRINTERROR;
+    cJSON *item = cJSON_GetObjectItem(json, "key999");
+    if (!item || cJSON_GetNumberValue(item) != 999) PRINTERROR;
+    cJSON_Delete(json);
+    OCDictionaryRef copy = (OCDictionaryRef)OCTypeDeepCopy(dict);
+    if (!copy || !OCTypeEqual(copy, dict)) PRINTERROR;
+    OCRelease(copy);
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool dictionaryTest_ordered_removal(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    const int n = 2000;
+    OCMutableDictionaryRef dict = OCDictionaryCreateMutable(0);
+    if (!dict) PRINTERROR;
+    for (int i = 0; i < n; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("k%d"), i);
+        OCNumberRef value = OCNumberCreateWithInt(i);
+        if (!OCDictionaryAddValue(dict, key, value)) PRINTERROR;
+        OCRelease(key);
+        OCRelease(value);
+    }
+    // Remove every entry except multiples of 10; enough to force compaction
+    for (int i = 0; i < n; i++) {
+        if (i % 10 == 0) continue;
+        OCStringRef key = OCStringCreateWithFormat(STR("k%d"), i);
+        if (!OCDictionaryRemoveValue(dict, key)) PRINTERROR;
+        if (OCDictionaryRemoveValue(dict, key)) PRINTERROR;  // already gone
+        OCRelease(key);
+    }
+    if (OCDictionaryGetCount(dict) != (uint64_t)(n / 10)) PRINTERROR;
+    // Survivors are still found and still come out in insertion order
+    OCDictionaryCursor cursor;
+    OCStringRef key;
+    const void *value;
+    int expected = 0;
+    OCDictionaryCursorInit(&cursor, dict);
+    while (OCDictionaryCursorNext(&cursor, &key, &value)) {
+        int v = -1;
+        OCNumberTryGetInt((OCNumberRef)value, &v);
+        if (v != expected) PRINTERROR;
+        if (OCDictionaryGetValue(dict, key) != value) PRINTERROR;
+        expected += 10;
+    }
+    if (expected != n) PRINTERROR;
+    // A re-added key goes to the end; replacing a value keeps its position
+    OCStringRef first = STR("k0");
+    OCNumberRef replacement = OCNumberCreateWithInt(-1);
+    OCDictionarySetValue(dict, STR("k10"), replacement);
+    OCDictionaryRemoveValue(dict, first);
+    OCDictionaryAddValue(dict, first, replacement);
+    OCRelease(replacement);
+    OCArrayRef keys = OCDictionaryCreateArrayWithAllKeys(dict);
+    if (OCStringCompare(OCArrayGetValueAtIndex(keys, 0), STR("k10"), 0) != kOCCompareEqualTo) PRINTERROR;
+    if (OCStringCompare(OCArrayGetValueAtIndex(keys, OCArrayGetCount(keys) - 1), first, 0) != kOCCompareEqualTo) PRINTERROR;
+    OCRelease(keys);
+    // Copies preserve order and compare equal
+    OCDictionaryRef copy = OCDictionaryCreateCopy(dict);
+    if (!OCTypeEqual(copy, dict)) PRINTERROR;
+    OCRelease(copy);
+    // Emptying the dictionary and refilling it reuses the storage
+    keys = OCDictionaryCreateArrayWithAllKeys(dict);
+    for (uint64_t i = 0; i < OCArrayGetCount(keys); i++)
+        OCDictionaryRemoveValue(dict, OCArrayGetValueAtIndex(keys, i));
+    OCRelease(keys);
+    if (OCDictionaryGetCount(dict) != 0 || OCDictionaryGetValue(dict, first)) PRINTERROR;
+    OCDictionaryAddValue(dict, first, kOCBooleanTrue);
+    if (OCDictionaryGetValue(dict, first) != kOCBooleanTrue) PRINTERROR;
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool dictionaryTest_shared_keys(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    // An array of same-shaped records decodes into dictionaries sharing one key table
+    cJSON *json = cJSON_Parse("[{\"id\":1,\"name\":\"a\",\"ok\":true},"
+                              "{\"id\":2,\"name\":\"b\",\"ok\":false},"
+                              "{\"id\":3,\"name\":\"c\"},"
+                              "{\"name\":\"d\",\"id\":4},"
+                              "{\"id\":5,\"name\":\"e\",\"ok\":true}]");
+    if (!json) PRINTERROR;
+    OCStringRef err = NULL;
+    OCArrayRef records = OCArrayCreateFromJSON(json, &err);
+    cJSON_Delete(json);
+    if (!records || OCArrayGetCount(records) != 5) PRINTERROR;
+    OCMutableDictionaryRef r0 = (OCMutableDictionaryRef)OCArrayGetValueAtIndex(records, 0);
+    OCDictionaryRef r1 = OCArrayGetValueAtIndex(records, 1);
+    OCDictionaryRef r2 = OCArrayGetValueAtIndex(records, 2);
+    OCDictionaryRef r3 = OCArrayGetValueAtIndex(records, 3);
+    OCArrayRef k0 = OCDictionaryCreateArrayWithAllKeys(r0);
+    OCArrayRef k1 = OCDictionaryCreateArrayWithAllKeys(r1);
+    OCArrayRef k2 = OCDictionaryCreateArrayWithAllKeys(r2);
+    OCArrayRef k3 = OCDictionaryCreateArrayWithAllKeys(r3);
+    // The same key objects back every record of the shape, including a prefix
+    bool shared = OCArrayGetValueAtIndex(k0, 1) == OCArrayGetValueAtIndex(k1, 1) &&
+                  OCArrayGetValueAtIndex(k0, 0) == OCArrayGetValueAtIndex(k2, 0);
+    // A record with its keys in another order keeps that order
+    bool reordered = OCStringCompare(OCArrayGetValueAtIndex(k3, 0), STR("name"), 0) == kOCCompareEqualTo;
+    OCRelease(k0);
+    OCRelease(k1);
+    OCRelease(k2);
+    OCRelease(k3);
+    if (!shared || !reordered) PRINTERROR;
+    if (OCDictionaryGetCount(r2) != 2 || OCDictionaryContainsKey(r2, STR("ok"))) PRINTERROR;
+    OCStringRef name = OCDictionaryGetValue(r1, STR("name"));
+    if (!name || OCStringCompare(name, STR("b"), 0) != kOCCompareEqualTo) PRINTERROR;
+    // Copies share too and compare equal; mutation falls back transparently
+    OCMutableDictionaryRef copy = OCDictionaryCreateMutableCopy(r0);
+    if (!OCTypeEqual(copy, r0)) PRINTERROR;
+    OCDictionarySetValue(copy, STR("extra"), kOCBooleanTrue);
+    if (OCDictionaryGetCount(copy) != 4 || OCDictionaryGetValue(copy, STR("extra")) != kOCBooleanTrue) PRINTERROR;
+    if (OCDictionaryContainsKey(r0, STR("extra"))) PRINTERROR;
+    if (!OCDictionaryRemoveValue(copy, STR("id")) || OCDictionaryContainsKey(copy, STR("id"))) PRINTERROR;
+    if (!OCDictionaryGetValue(copy, STR("name"))) PRINTERROR;
+    OCRelease(copy);
+    // Removing the last key keeps the record compact and usable
+    if (!OCDictionaryRemoveValue(r0, STR("ok")) || OCDictionaryGetCount(r0) != 2) PRINTERROR;
+    if (!OCDictionaryAddValue(r0, STR("ok"), kOCBooleanFalse) || OCDictionaryGetValue(r0, STR("ok")) != kOCBooleanFalse) PRINTERROR;
+    // Explicit construction from a template, out-of-order insertion
+    OCMutableDictionaryRef row = OCDictionaryCreateMutableWithSharedKeys(r1);
+    OCDictionaryAddValue(row, STR("name"), STR("x"));
+    OCDictionaryAddValue(row, STR("id"), kOCBooleanTrue);
+    if (OCDictionaryGetCount(row) != 2 || OCDictionaryGetValue(row, STR("id")) != kOCBooleanTrue) PRINTERROR;
+    OCRelease(row);
+    // Round trip through JSON
+    cJSON *out = OCArrayCopyAsJSON(records, false, NULL);
+    char *text = cJSON_PrintUnformatted(out);
+    bool ok = text && strstr(text, "{\"id\":2,\"name\":\"b\",\"ok\":false}") != NULL;
+    free(text);
+    cJSON_Delete(out);
+    if (!ok) PRINTERROR;
+    OCRelease(records);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool dictionaryTest_frozen(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    const int n = 5000;
+    OCMutableDictionaryRef source = OCDictionaryCreateMutable(0);
+    for (int i = 0; i < n; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("frozen-%d"), i);
+        OCNumberRef value = OCNumberCreateWithInt(i);
+        OCDictionaryAddValue(source, key, value);
+        OCRelease(key);
+        OCRelease(value);
+    }
+    OCDictionaryRemoveValue(source, STR("frozen-7"));
+    // Copies of a mutable dictionary borrow its storage, so freeze through
+    // OCDictionaryCreate to get the perfect hash
+    const void **sourceKeys = malloc(n * sizeof(void *));
+    const void **sourceValues = malloc(n * sizeof(void *));
+    OCDictionaryGetKeysAndValues(source, sourceKeys, sourceValues);
+    OCDictionaryRef frozen = OCDictionaryCreate(sourceKeys, sourceValues, OCDictionaryGetCount(source));
+    free(sourceKeys);
+    free(sourceValues);
+    if (!frozen || OCDictionaryGetCount(frozen) != (uint64_t)(n - 1)) PRINTERROR;
+    if (!OCTypeEqual(frozen, source)) PRINTERROR;
+    // Every key resolves; absent keys do not
+    for (int i = 0; i < n; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("frozen-%d"), i);
+        const void *value = OCDictionaryGetValue(frozen, key);
+        bool same = value == OCDictionaryGetValue(source, key);
+        OCRelease(key);
+        if ((i == 7) != (value == NULL) || !same) PRINTERROR;
+    }
+    if (OCDictionaryGetValue(frozen, STR("frozen-")) || OCDictionaryContainsKey(frozen, STR("x"))) PRINTERROR;
+    // Read-only, and copying just retains
+    if (OCDictionaryAddValue((OCMutableDictionaryRef)frozen, STR("x"), kOCBooleanTrue)) PRINTERROR;
+    if (OCDictionaryRemoveValue((OCMutableDictionaryRef)frozen, STR("frozen-1"))) PRINTERROR;
+    if (OCDictionaryReplaceValue((OCMutableDictionaryRef)frozen, STR("frozen-1"), kOCBooleanTrue)) PRINTERROR;
+    if (OCDictionaryGetCount(frozen) != (uint64_t)(n - 1)) PRINTERROR;
+    OCDictionaryRef again = OCDictionaryCreateCopy(frozen);
+    if (again != frozen) PRINTERROR;
+    OCRelease(again);
+    // Insertion order survives freezing; a mutable copy can be edited
+    OCArrayRef keys = OCDictionaryCreateArrayWithAllKeys(frozen);
+    if (OCStringCompare(OCArrayGetValueAtIndex(keys, 7), STR("frozen-8"), 0) != kOCCompareEqualTo) PRINTERROR;
+    OCRelease(keys);
+    OCMutableDictionaryRef thawed = OCDictionaryCreateMutableCopy(frozen);
+    if (!OCDictionaryAddValue(thawed, STR("x"), kOCBooleanTrue) || OCDictionaryGetCount(thawed) != (uint64_t)n) PRINTERROR;
+    OCRelease(thawed);
+    // OCDictionaryCreate freezes too, keeping the last value for a repeated key
+    const void *k[] = {STR("a"), STR("b"), STR("a")};
+    const void *v[] = {kOCBooleanTrue, kOCBooleanFalse, kOCBooleanFalse};
+    OCDictionaryRef small = OCDictionaryCreate(k, v, 3);
+    if (OCDictionaryGetCount(small) != 2 || OCDictionaryGetValue(small, STR("a")) != kOCBooleanFalse) PRINTERROR;
+    if (OCDictionarySetValue((OCMutableDictionaryRef)small, STR("c"), kOCBooleanTrue)) PRINTERROR;
+    OCRelease(small);
+    OCDictionaryRef none = OCDictionaryCreate(k, v, 0);
+    if (!none || OCDictionaryGetCount(none) != 0 || OCDictionaryGetValue(none, STR("a"))) PRINTERROR;
+    OCRelease(none);
+    OCRelease(frozen);
+    OCRelease(source);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+#define kConcurrentTestThreads 4
+#define kConcurrentTestCounters 16
+#define kConcurrentTestIterations 2000
+static void *concurrentTestWorker(void *arg) {
+    OCConcurrentDictionaryRef counters = arg;
+    OCNumberRef zero = OCNumberCreateWithInt(0);
+    for (int i = 0; i < kConcurrentTestIterations; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("counter-%d"), i % kConcurrentTestCounters);
+        // Every thread races to create the counter, then bumps it with CAS
+        OCTypeRef current = OCConcurrentDictionaryCopyOrAddValue(counters, key, zero, NULL);
+        for (;;) {
+            int32_t n = -1;
+            OCNumberTryGetSInt32((OCNumberRef)current, &n);
+            OCNumberRef next = OCNumberCreateWithInt(n + 1);
+            bool swapped = OCConcurrentDictionaryCompareAndSwapValue(counters, key, current, next);
+            OCRelease(next);
+            OCRelease(current);
+            if (swapped)
+                break;
+            current = OCConcurrentDictionaryCopyValue(counters, key);
+        }
+        OCRelease(key);
+    }
+    OCRelease(zero);
+    return NULL;
+}
+bool dictionaryTest_concurrent(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    OCConcurrentDictionaryRef counters = OCConcurrentDictionaryCreate(0);
+    if (!counters) PRINTERROR;
+    pthread_t threads[kConcurrentTestThreads];
+    for (int t = 0; t < kConcurrentTestThreads; t++)
+        if (pthread_create(&threads[t], NULL, concurrentTestWorker, (void *)counters) != 0) PRINTERROR;
+    for (int t = 0; t < kConcurrentTestThreads; t++)
+        pthread_join(threads[t], NULL);
+    // No increment was lost
+    if (OCConcurrentDictionaryGetCount(counters) != kConcurrentTestCounters) PRINTERROR;
+    for (int c = 0; c < kConcurrentTestCounters; c++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("counter-%d"), c);
+        OCNumberRef value = (OCNumberRef)OCConcurrentDictionaryCopyValue(counters, key);
+        int32_t n = 0;
+        bool ok = value && OCNumberTryGetSInt32(value, &n) &&
+                  n == kConcurrentTestThreads * kConcurrentTestIterations / kConcurrentTestCounters;
+        OCRelease(value);
+        OCRelease(key);
+        if (!ok) PRINTERROR;
+    }
+    // The losing value of get-or-insert is not stored
+    bool added = true;
+    OCTypeRef existing = OCConcurrentDictionaryCopyOrAddValue(counters, STR("counter-0"), kOCBooleanTrue, &added);
+    if (added || !existing || existing == (OCTypeRef)kOCBooleanTrue) PRINTERROR;
+    // CAS with a stale value fails; NULL means absent on either side
+    if (OCConcurrentDictionaryCompareAndSwapValue(counters, STR("counter-0"), kOCBooleanTrue, kOCBooleanFalse)) PRINTERROR;
+    if (!OCConcurrentDictionaryCompareAndSwapValue(counters, STR("counter-0"), existing, NULL)) PRINTERROR;
+    OCRelease(existing);
+    if (OCConcurrentDictionaryContainsKey(counters, STR("counter-0"))) PRINTERROR;
+    if (!OCConcurrentDictionaryCompareAndSwapValue(counters, STR("flag"), NULL, kOCBooleanTrue)) PRINTERROR;
+    if (OCConcurrentDictionaryCompareAndSwapValue(counters, STR("flag"), NULL, kOCBooleanFalse)) PRINTERROR;
+    if (!OCConcurrentDictionaryRemoveValue(counters, STR("flag")) || OCConcurrentDictionaryRemoveValue(counters, STR("flag"))) PRINTERROR;
+    // Snapshots and deep copies see the same entries
+    OCDictionaryRef snapshot = OCConcurrentDictionaryCreateSnapshot(counters);
+    if (!snapshot || OCDictionaryGetCount(snapshot) != kConcurrentTestCounters - 1) PRINTERROR;
+    if (OCDictionaryGetValue(snapshot, STR("counter-0")) || !OCDictionaryGetValue(snapshot, STR("counter-5"))) PRINTERROR;
+    OCConcurrentDictionaryRef copy = (OCConcurrentDictionaryRef)OCTypeDeepCopy(counters);
+    if (!copy || !OCTypeEqual(copy, counters)) PRINTERROR;
+    OCConcurrentDictionarySetValue(copy, STR("counter-5"), kOCBooleanTrue);
+    if (OCTypeEqual(copy, counters)) PRINTERROR;
+    OCRelease(copy);
+    OCRelease(snapshot);
+    OCRelease(counters);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+#define kConcurrentJSONKeys 64
+#define kConcurrentJSONRounds 50
+static void *concurrentJSONWorker(void *arg) {
+    OCConcurrentDictionaryRef dict = arg;
+    for (int r = 0; r < kConcurrentJSONRounds; r++) {
+        cJSON *json = OCTypeCopyJSON((OCTypeRef)dict, false, NULL);
+        bool ok = json && cJSON_GetArraySize(json) == kConcurrentJSONKeys && cJSON_GetObjectItem(json, "key-7");
+        cJSON_Delete(json);
+        if (!ok) return arg;
+    }
+    return NULL;
+}
+static void *concurrentLookupWorker(void *arg) {
+    OCConcurrentDictionaryRef dict = arg;
+    for (int r = 0; r < kConcurrentJSONRounds * kConcurrentJSONKeys; r++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("key-%d"), r % kConcurrentJSONKeys);
+        bool ok = OCConcurrentDictionaryContainsKey(dict, key);
+        OCRelease(key);
+        if (!ok) return arg;
+    }
+    return NULL;
+}
+bool dictionaryTest_concurrent_json(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    // Keys cut out of a longer line are substring views of it; the
+    // dictionary stores copies of their own, so exporting them from several
+    // threads while others look them up never touches a shared view
+    OCConcurrentDictionaryRef dict = OCConcurrentDictionaryCreate(0);
+    if (!dict) PRINTERROR;
+    for (int i = 0; i < kConcurrentJSONKeys; i++) {
+        OCStringRef line = OCStringCreateWithFormat(STR("key-%d,value-%d"), i, i);
+        OCArrayRef fields = OCStringCreateArrayBySeparatingStrings(line, STR(","));
+        OCConcurrentDictionarySetValue(dict, OCArrayGetValueAtIndex(fields, 0), OCArrayGetValueAtIndex(fields, 1));
+        OCRelease(fields);
+        // Only the stored value still refers to the line
+        if (OCTypeGetRetainCount(line) != 2) PRINTERROR;
+        OCRelease(line);
+    }
+    pthread_t threads[kConcurrentTestThreads];
+    for (int t = 0; t < kConcurrentTestThreads; t++)
+        if (pthread_create(&threads[t], NULL, t % 2 ? concurrentLookupWorker : concurrentJSONWorker, (void *)dict) != 0)
+            PRINTERROR;
+    bool ok = true;
+    for (int t = 0; t < kConcurrentTestThreads; t++) {
+        void *failed = NULL;
+        pthread_join(threads[t], &failed);
+        ok &= failed == NULL;
+    }
+    if (!ok) PRINTERROR;
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool dictionaryTest_generic_keys(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    OCMutableDictionaryRef dict = OCDictionaryCreateMutable(0);
+    if (!dict) PRINTERROR;
+    // Numbers compare by value across representations
+    OCNumberRef intKey = OCNumberCreateWithInt(5);
+    OCNumberRef doubleKey = OCNumberCreateWithDouble(5.0);
+    OCDictionarySetValue(dict, intKey, STR("five"));
+    if (OCDictionaryGetValue(dict, doubleKey) != STR("five")) PRINTERROR;
+    if (OCTypeHash(intKey) != OCTypeHash(doubleKey)) PRINTERROR;
+    // Byte buffers and index sets hash by content
+    const uint8_t bytes[] = {1, 2, 3, 4};
+    OCDataRef dataKey = OCDataCreate(bytes, sizeof bytes);
+    OCDataRef sameData = OCDataCreate(bytes, sizeof bytes);
+    OCDictionarySetValue(dict, dataKey, STR("data"));
+    if (OCDictionaryGetValue(dict, sameData) != STR("data")) PRINTERROR;
+    OCMutableIndexSetRef setKey = OCIndexSetCreateMutable();
+    OCIndexSetAddIndex(setKey, 3);
+    OCIndexSetAddIndex(setKey, 7);
+    OCDictionarySetValue(dict, setKey, STR("set"));
+    // The dictionary copied the mutable key, so changing it afterwards
+    // leaves the stored entry reachable by its original contents
+    OCIndexSetAddIndex(setKey, 11);
+    if (OCDictionaryContainsKey(dict, setKey)) PRINTERROR;
+    OCMutableIndexSetRef original = OCIndexSetCreateMutable();
+    OCIndexSetAddIndex(original, 7);
+    OCIndexSetAddIndex(original, 3);
+    if (OCDictionaryGetValue(dict, original) != STR("set")) PRINTERROR;
+    // String keys still share the table with other key types
+    OCDictionarySetValue(dict, STR("5"), STR("string"));
+    if (OCDictionaryGetCount(dict) != 4) PRINTERROR;
+    if (OCDictionaryGetValue(dict, intKey) != STR("five")) PRINTERROR;
+    if (!OCDictionaryRemoveValue(dict, doubleKey)) PRINTERROR;
+    if (OCDictionaryGetCount(dict) != 3) PRINTERROR;
+    // JSON object members are strings, so other keys cannot be written
+    OCStringRef error = NULL;
+    cJSON *json = OCDictionaryCopyAsJSON(dict, false, &error);
+    if (!error || (json && !cJSON_IsNull(json))) PRINTERROR;
+    cJSON_Delete(json);
+    OCRelease(intKey);
+    OCRelease(doubleKey);
+    OCRelease(dataKey);
+    OCRelease(sameData);
+    OCRelease(setKey);
+    OCRelease(original);
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool dictionaryTest_copy_on_write(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    OCMutableDictionaryRef source = OCDictionaryCreateMutable(0);
+    OCNumberRef probe = OCNumberCreateWithInt(42);
+    for (int i = 0; i < 50; i++) {
+        OCStringRef key = OCStringCreateWithFormat(STR("key-%d"), i);
+        OCDictionarySetValue(source, key, probe);
+        OCRelease(key);
+    }
+    if (OCTypeGetRetainCount(probe) != 51) PRINTERROR;
+    // Copies hold no references of their own until something changes
+    OCDictionaryRef snapshot = OCDictionaryCreateCopy(source);
+    OCMutableDictionaryRef edit = OCDictionaryCreateMutableCopy(source);
+    if (!snapshot || !edit || OCTypeGetRetainCount(probe) != 51) PRINTERROR;
+    if (!OCTypeEqual(snapshot, source) || !OCTypeEqual(edit, source)) PRINTERROR;
+    if (OCDictionaryCreateCopy(snapshot) != snapshot) PRINTERROR;
+    OCRelease(snapshot);
+    if (OCDictionarySetValue((OCMutableDictionaryRef)snapshot, STR("x"), kOCBooleanTrue)) PRINTERROR;
+    // Changes stay with the dictionary that made them
+    OCDictionaryRemoveValue(source, STR("key-0"));
+    OCDictionarySetValue(edit, STR("key-1"), kOCBooleanTrue);
+    if (OCDictionaryGetCount(source) != 49 || OCDictionaryGetCount(snapshot) != 50 || OCDictionaryGetCount(edit) != 50) PRINTERROR;
+    if (OCDictionaryGetValue(snapshot, STR("key-0")) != probe || OCDictionaryGetValue(snapshot, STR("key-1")) != probe) PRINTERROR;
+    if (OCDictionaryGetValue(edit, STR("key-1")) != kOCBooleanTrue) PRINTERROR;
+    if (OCTypeGetRetainCount(probe) != 1 + 49 + 50 + 49) PRINTERROR;
+    OCRelease(snapshot);
+    OCRelease(source);
+    // Records in the split layout share values the same way
+    const char *json = "[{\"a\":1,\"b\":2},{\"a\":3,\"b\":4}]";
+    cJSON *root = cJSON_Parse(json);
+    OCStringRef err = NULL;
+    OCArrayRef records = OCArrayCreateFromJSON(root, &err);
+    cJSON_Delete(root);
+    if (!records || OCArrayGetCount(records) != 2) PRINTERROR;
+    OCDictionaryRef record = OCArrayGetValueAtIndex(records, 1);
+    OCMutableDictionaryRef recordCopy = OCDictionaryCreateMutableCopy(record);
+    OCDictionarySetValue(recordCopy, STR("a"), kOCBooleanFalse);
+    if (OCDictionaryGetValue(recordCopy, STR("a")) != kOCBooleanFalse || OCDictionaryGetValue(record, STR("a")) == kOCBooleanFalse) PRINTERROR;
+    if (!OCDictionaryGetValue(recordCopy, STR("b"))) PRINTERROR;
+    OCRelease(recordCopy);
+    OCRelease(records);
+    OCRelease(edit);
+    if (OCTypeGetRetainCount(probe) != 1) PRINTERROR;
+    OCRelease(probe);
+    fprintf(stderr, " passed\n");
+    return true;
+}
@@ -10,4 +10,12 @@ bool dictionaryTest4(void);  // Test for extreme cases and capacity handling
 bool dictionaryTest5(void);  // Test for iteration performance and deep nesting
 bool OCDictionaryTestDeepCopy(void);
 bool test_OCDictionary_deepcopy2(void);
+bool dictionaryTest_iteration(void);  // Callback and cursor walks
+bool dictionaryTest_ordered_removal(void);  // Removal keeps insertion order
+bool dictionaryTest_shared_keys(void);  // Records decoded from JSON share keys
+bool dictionaryTest_frozen(void);  // Immutable dictionaries with perfect-hash lookup
+bool dictionaryTest_concurrent(void);  // Striped dictionary shared between threads
+bool dictionaryTest_concurrent_json(void);  // JSON export racing lookups on view keys
+bool dictionaryTest_generic_keys(void);  // OCNumber, OCData and OCIndexSet keys
+bool dictionaryTest_copy_on_write(void);  // Copies share storage until first mutation
 #endif /* TEST_DICTIONARY_H */
@@ -0,0 +1,99 @@
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "../src/OCTypes.h"
+#include "test_utils.h"
+bool OCIndexDictionarySetGetRemove_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    OCMutableIndexDictionaryRef dict = OCIndexDictionaryCreateMutable(0);
+    success &= (dict && OCIndexDictionaryGetCount(dict) == 0);
+    // Enough keys to grow the table several times, including negatives
+    for (OCIndex i = -500; i < 500; i++) {
+        OCNumberRef n = OCNumberCreateWithSInt64(i * 10);
+        success &= OCIndexDictionarySetValue(dict, i, n);
+        OCRelease(n);
+    }
+    success &= (OCIndexDictionaryGetCount(dict) == 1000);
+    for (OCIndex i = -500; i < 500; i++) {
+        int64_t v = 0;
+        OCNumberRef n = OCIndexDictionaryGetValue(dict, i);
+        success &= (n && OCNumberTryGetSInt64(n, &v) && v == i * 10);
+    }
+    success &= !OCIndexDictionaryContainsKey(dict, 500);
+    // Replacing keeps the count
+    success &= OCIndexDictionarySetValue(dict, 7, STR("seven"));
+    success &= (OCIndexDictionaryGetCount(dict) == 1000);
+    success &= (OCIndexDictionaryGetValue(dict, 7) == STR("seven"));
+    // Remove every other key; the rest must stay reachable
+    for (OCIndex i = -500; i < 500; i += 2)
+        success &= OCIndexDictionaryRemoveValue(dict, i);
+    success &= !OCIndexDictionaryRemoveValue(dict, -500);
+    success &= (OCIndexDictionaryGetCount(dict) == 500);
+    for (OCIndex i = -499; i < 500; i += 2)
+        success &= OCIndexDictionaryContainsKey(dict, i);
+    success &= !OCIndexDictionaryContainsKey(dict, 0);
+    OCIndexArrayRef keys = OCIndexDictionaryCreateIndexArrayWithAllKeys(dict);
+    success &= (keys && OCIndexArrayGetCount(keys) == 500);
+    success &= (OCIndexArrayGetValueAtIndex(keys, 0) == -499 && OCIndexArrayGetValueAtIndex(keys, 499) == 499);
+    OCRelease(keys);
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return success;
+}
+bool OCIndexDictionaryCopy_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    OCMutableIndexDictionaryRef dict = OCIndexDictionaryCreateMutable(4);
+    OCIndexDictionarySetValue(dict, 1, STR("one"));
+    OCIndexDictionarySetValue(dict, 2, STR("two"));
+    OCIndexDictionaryRef copy = OCIndexDictionaryCreateCopy(dict);
+    success &= (copy && OCTypeEqual(copy, dict));
+    // Immutable copies reject writes
+    success &= !OCIndexDictionarySetValue((OCMutableIndexDictionaryRef)copy, 3, STR("three"));
+    OCMutableIndexDictionaryRef mutableCopy = OCIndexDictionaryCreateMutableCopy(copy);
+    success &= OCIndexDictionarySetValue(mutableCopy, 3, STR("three"));
+    success &= !OCTypeEqual(mutableCopy, dict);
+    OCIndexDictionaryRef deep = OCTypeDeepCopy(mutableCopy);
+    success &= (deep && OCTypeEqual(deep, mutableCopy));
+    OCRelease(deep);
+    OCRelease(mutableCopy);
+    OCRelease(copy);
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return success;
+}
+bool OCIndexDictionaryJSONEncoding_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    OCMutableIndexDictionaryRef dict = OCIndexDictionaryCreateMutable(0);
+    OCNumberRef n = OCNumberCreateWithSInt32(42);
+    OCIndexDictionarySetValue(dict, 10, n);
+    OCIndexDictionarySetValue(dict, -3, STR("minus three"));
+    OCIndexDictionarySetValue(dict, LONG_MIN, STR("lowest"));
+    OCStringRef error = NULL;
+    for (int typed = 0; typed <= 1; typed++) {
+        cJSON *json = OCIndexDictionaryCopyAsJSON(dict, typed, &error);
+        success &= (json && !error);
+        OCIndexDictionaryRef decoded = OCIndexDictionaryCreateFromJSON(json, &error);
+        success &= (decoded && !error && OCIndexDictionaryGetCount(decoded) == 3);
+        success &= OCTypeEqual(OCIndexDictionaryGetValue(decoded, -3), STR("minus three"));
+        success &= OCTypeEqual(OCIndexDictionaryGetValue(decoded, LONG_MIN), STR("lowest"));
+        if (typed) success &= OCTypeEqual(decoded, dict);
+        OCRelease(decoded);
+        cJSON_Delete(json);
+    }
+    // Member names must be integers
+    cJSON *bad = cJSON_Parse("{\"x\": 1}");
+    success &= (OCIndexDictionaryCreateFromJSON(bad, &error) == NULL && error);
+    cJSON_Delete(bad);
+    // ...that fit an OCIndex
+    error = NULL;
+    bad = cJSON_Parse("{\"99999999999999999999\": 1}");
+    success &= (OCIndexDictionaryCreateFromJSON(bad, &error) == NULL && error);
+    cJSON_Delete(bad);
+    OCRelease(n);
+    OCRelease(dict);
+    fprintf(stderr, " passed\n");
+    return success;
+}
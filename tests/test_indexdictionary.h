@@ -0,0 +1,13 @@
+#ifndef TEST_OCINDEXDICTIONARY_H
+#define TEST_OCINDEXDICTIONARY_H
+#include <stdbool.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool OCIndexDictionarySetGetRemove_test(void);
+bool OCIndexDictionaryCopy_test(void);
+bool OCIndexDictionaryJSONEncoding_test(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* TEST_OCINDEXDICTIONARY_H */
@@ -6,6 +6,7 @@
 #endif
 #include <complex.h>  // For double complex, creal, cimag, I
 #include <math.h>     // For mathematical constants and functions
+#include <string.h>   // For strcmp, memcpy
 // Fallback definitions for mathematical constants if not available
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -62,3 +63,114 @@ bool mathTest1(void) {
     fprintf(stderr, " passed\n");
     return true;
 }
+// Shortest round-trip formatting of doubles and floats
+bool mathTest_shortest_format(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    static const struct {
+        double value;
+        const char *text;
+    } doubles[] = {
+        {0.1, "0.1"}, {0.1 + 0.2, "0.30000000000000004"}, {0.04547, "0.04547"}, {-123.456, "-123.456"},
+        {100.0, "100"}, {1e20, "100000000000000000000"}, {1e21, "1e+21"}, {1.5e-7, "1.5e-7"},
+        {0.000001, "0.000001"}, {5e-324, "5e-324"}, {1.7976931348623157e308, "1.7976931348623157e+308"},
+        {0.0, "0"}, {-0.0, "-0"}, {9007199254740993.0, "9007199254740992"}};
+    char buf[kOCShortestFloatingPointStringSize];
+    for (size_t i = 0; i < sizeof doubles / sizeof *doubles; i++) {
+        int n = OCDoubleWriteShortestCString(doubles[i].value, buf, sizeof buf);
+        if (n != (int)strlen(doubles[i].text) || strcmp(buf, doubles[i].text) != 0) {
+            fprintf(stderr, "\n    got \"%s\", expected \"%s\"\n", buf, doubles[i].text);
+            PRINTERROR;
+        }
+    }
+    if (OCFloatWriteShortestCString(3.14f, buf, sizeof buf) < 0 || strcmp(buf, "3.14") != 0) PRINTERROR;
+    if (OCFloatWriteShortestCString(1e-45f, buf, sizeof buf) < 0 || strcmp(buf, "1e-45") != 0) PRINTERROR;
+    if (OCFloatWriteShortestCString(-INFINITY, buf, sizeof buf) < 0 || strcmp(buf, "-inf") != 0) PRINTERROR;
+    if (OCDoubleWriteShortestCString(NAN, buf, sizeof buf) < 0 || strcmp(buf, "nan") != 0) PRINTERROR;
+    // Too small a buffer is reported, not truncated
+    if (OCDoubleWriteShortestCString(0.1 + 0.2, buf, 8) != -1) PRINTERROR;
+    // Bit patterns across the whole range read back exactly
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 20000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double d;
+        memcpy(&d, &state, sizeof d);
+        if (isfinite(d)) {
+            OCDoubleWriteShortestCString(d, buf, sizeof buf);
+            if (strtod(buf, NULL) != d) PRINTERROR;
+        }
+        uint32_t bits = (uint32_t)(state >> 32);
+        float f;
+        memcpy(&f, &bits, sizeof f);
+        if (isfinite(f)) {
+            OCFloatWriteShortestCString(f, buf, sizeof buf);
+            if (strtof(buf, NULL) != f) PRINTERROR;
+        }
+    }
+    fprintf(stderr, " passed\n");
+    return true;
+}
+bool mathTest_from_chars(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    static const char *doubles[] = {"0", "-0", "1", "0.1", "3.14159", "1e23", "2.2250738585072011e-308", "5e-324",
+                                    "1e-400", "1.8e308", "123456789012345678901234567890", "9007199254740993",
+                                    "0.000001", "-7.5E+3"};
+    for (size_t i = 0; i < sizeof doubles / sizeof *doubles; i++) {
+        const char *s = doubles[i];
+        double got = -1.0;
+        size_t n = OCDoubleFromChars(s, s + strlen(s), &got);
+        double want = strtod(s, NULL);
+        if (n != strlen(s) || memcmp(&got, &want, sizeof got) != 0) {
+            fprintf(stderr, "\n    \"%s\": got %.17g (%zu), expected %.17g\n", s, got, n, want);
+            PRINTERROR;
+        }
+    }
+    // Parsing stops at the first character that cannot continue the number
+    double d = 0;
+    const char *partial = "2.5e+x";
+    if (OCDoubleFromChars(partial, partial + 6, &d) != 3 || d != 2.5) PRINTERROR;
+    if (OCDoubleFromChars("abc", "abc" + 3, &d) != 0) PRINTERROR;
+    // The range is honoured even without a terminator
+    if (OCDoubleFromChars("12345", "12345" + 2, &d) != 2 || d != 12.0) PRINTERROR;
+    float f = 0;
+    if (OCFloatFromChars("3.4028235e38", "3.4028235e38" + 12, &f) != 12 || f != 3.4028235e38f) PRINTERROR;
+    // Random bit patterns round-trip through the shortest formatter
+    char buf[kOCShortestFloatingPointStringSize];
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    for (int i = 0; i < 20000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double v;
+        memcpy(&v, &state, sizeof v);
+        if (!isfinite(v)) continue;
+        int len = OCDoubleWriteShortestCString(v, buf, sizeof buf);
+        double back = 0;
+        if (OCDoubleFromChars(buf, buf + len, &back) != (size_t)len || back != v) PRINTERROR;
+    }
+    // Integers
+    int64_t i64 = 0;
+    uint64_t u64 = 0;
+    if (OCInt64FromChars("-9223372036854775808", "-9223372036854775808" + 20, &i64) != 20 || i64 != INT64_MIN) PRINTERROR;
+    if (OCInt64FromChars("9223372036854775808", "9223372036854775808" + 19, &i64) != 0) PRINTERROR;
+    if (OCUInt64FromChars("18446744073709551615", "18446744073709551615" + 20, &u64) != 20 || u64 != UINT64_MAX) PRINTERROR;
+    if (OCUInt64FromChars("18446744073709551616", "18446744073709551616" + 20, &u64) != 0) PRINTERROR;
+    if (OCUInt64FromChars("-1", "-1" + 2, &u64) != 0) PRINTERROR;
+    // Complex literals
+    static const struct {
+        const char *text;
+        double re, im;
+    } complexes[] = {{"2.5", 2.5, 0}, {"3*I", 0, 3}, {"1.5+I*2.5", 1.5, 2.5}, {"2-3•I", 2, -3}, {"-4 + 0.5*I", -4, 0.5}};
+    for (size_t i = 0; i < sizeof complexes / sizeof *complexes; i++) {
+        const char *s = complexes[i].text;
+        double complex z = 0;
+        if (OCComplexFromChars(s, s + strlen(s), &z) != strlen(s) || creal(z) != complexes[i].re ||
+            cimag(z) != complexes[i].im) {
+            fprintf(stderr, "\n    \"%s\": got %g%+gi\n", s, creal(z), cimag(z));
+            PRINTERROR;
+        }
+    }
+    fprintf(stderr, " passed\n");
+    return true;
+}
@@ -5,6 +5,10 @@
 bool mathTest0(void);
 // New: tests for additional math functions
 bool mathTest1(void);
+// Shortest round-trip double/float formatting
+bool mathTest_shortest_format(void);
+// Exact, locale-independent number parsing
+bool mathTest_from_chars(void);
 // If raise_to_integer_power isn't in OCMath.h, declare it (though it should be)
 // This declaration might be specific to how tests were originally structured.
 // It's better if OCMath.h provides all necessary declarations.
@@ -256,15 +256,17 @@ bool numberTest0(void) {
                 PRINTERROR;
             }
         } else {
-            // build expected with the same format
-            char expected_buf[64];
+            // build expected from the shortest round-trip parts
+            char re_buf[kOCShortestFloatingPointStringSize], im_buf[kOCShortestFloatingPointStringSize];
+            char expected_buf[2 * kOCShortestFloatingPointStringSize + 4];
             if (t == kOCNumberComplex64Type) {
-                snprintf(expected_buf, sizeof expected_buf,
-                         "%.9g+I*%.9g", real, imag);
+                OCFloatWriteShortestCString((float)real, re_buf, sizeof re_buf);
+                OCFloatWriteShortestCString((float)imag, im_buf, sizeof im_buf);
             } else {
-                snprintf(expected_buf, sizeof expected_buf,
-                         "%.17g+I*%.17g", real, imag);
+                OCDoubleWriteShortestCString(real, re_buf, sizeof re_buf);
+                OCDoubleWriteShortestCString(imag, im_buf, sizeof im_buf);
             }
+            snprintf(expected_buf, sizeof expected_buf, "%s+I*%s", re_buf, im_buf);
             if (strcmp(got_c, expected_buf) != 0) {
                 fprintf(stderr,
                         "DEBUG: complex → got \"%s\", expected \"%s\"\n",
@@ -1071,6 +1073,63 @@ bool test_ocnumber_json_backward_compatibility(void) {
     OCRelease(from_old_untyped);
     return allPassed;
 }
+bool numberTest_parsing(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    double d = 0;
+    int64_t i64 = 0;
+    // String constructors skip leading blanks, are exact, and reject out-of-range integers
+    OCNumberRef n = OCNumberCreateWithStringValue(kOCNumberFloat64Type, "  0.1");
+    if (!n || !OCNumberTryGetFloat64(n, &d) || d != 0.1) PRINTERROR;
+    OCRelease(n);
+    n = OCNumberCreateWithStringValue(kOCNumberFloat64Type, "-inf");
+    if (!n || !OCNumberTryGetFloat64(n, &d) || d != -INFINITY) PRINTERROR;
+    OCRelease(n);
+    n = OCNumberCreateWithStringValue(kOCNumberSInt64Type, "-9223372036854775808");
+    if (!n || !OCNumberTryGetSInt64(n, &i64) || i64 != INT64_MIN) PRINTERROR;
+    OCRelease(n);
+    if (OCNumberCreateWithStringValue(kOCNumberSInt8Type, "300")) PRINTERROR;
+    if (OCNumberCreateWithStringValue(kOCNumberFloat64Type, "abc")) PRINTERROR;
+    // Complex literals take the fast path; expressions still go through the full parser
+    double complex z = 0;
+    n = OCNumberCreateWithStringValue(kOCNumberComplex128Type, "1.5+I*2.5");
+    if (!n || !OCNumberTryGetComplex128(n, &z) || creal(z) != 1.5 || cimag(z) != 2.5) PRINTERROR;
+    OCRelease(n);
+    n = OCNumberCreateWithStringValue(kOCNumberComplex128Type, "sqrt(4)+I");
+    if (!n || !OCNumberTryGetComplex128(n, &z) || creal(z) != 2.0 || cimag(z) != 1.0) PRINTERROR;
+    OCRelease(n);
+    z = OCStringGetDoubleComplexValue(STR("2-3•I"));
+    if (creal(z) != 2.0 || cimag(z) != -3.0) PRINTERROR;
+    // JSON numbers are read in place
+    cJSON *json = cJSON_Parse("[0.30000000000000004, -1e-7, 12]");
+    if (!json || cJSON_GetArrayItem(json, 0)->valuedouble != 0.1 + 0.2 ||
+        cJSON_GetArrayItem(json, 1)->valuedouble != -1e-7 || cJSON_GetArrayItem(json, 2)->valueint != 12)
+        PRINTERROR;
+    cJSON_Delete(json);
+    // Bulk parsing into a typed buffer
+    const char *text = " 1.5, 2\t3e2\n-4 ";
+    double values[8];
+    size_t consumed = 0;
+    OCStringRef err = NULL;
+    OCIndex count = OCNumberParseValuesFromCString(kOCNumberFloat64Type, text, strlen(text), values, 8, &consumed, &err);
+    if (count != 4 || err || consumed != strlen(text)) PRINTERROR;
+    if (values[0] != 1.5 || values[1] != 2.0 || values[2] != 300.0 || values[3] != -4.0) PRINTERROR;
+    // Capacity bounds the output
+    count = OCNumberParseValuesFromCString(kOCNumberFloat64Type, text, strlen(text), values, 2, NULL, NULL);
+    if (count != 2) PRINTERROR;
+    int16_t shorts[4];
+    const char *ints = "7,-8,9";
+    count = OCNumberParseValuesFromCString(kOCNumberSInt16Type, ints, strlen(ints), shorts, 4, NULL, NULL);
+    if (count != 3 || shorts[0] != 7 || shorts[1] != -8 || shorts[2] != 9) PRINTERROR;
+    // Errors report the offset of the offending value
+    const char *bad = "1, 2, x3";
+    count = OCNumberParseValuesFromCString(kOCNumberFloat64Type, bad, strlen(bad), values, 8, &consumed, &err);
+    if (count != -1 || !err || consumed != 6) PRINTERROR;
+    const char *empty = "1,,2";
+    count = OCNumberParseValuesFromCString(kOCNumberFloat64Type, empty, strlen(empty), values, 8, &consumed, &err);
+    if (count != -1 || !err) PRINTERROR;
+    fprintf(stderr, " passed\n");
+    return true;
+}
 bool test_number_comprehensive(void) {
     const char *test_name = "test_number_comprehensive";
     bool allPassed = true;
@@ -1082,6 +1141,7 @@ bool test_number_comprehensive(void) {
     allPassed &= test_ocnumber_json_untyped_real();
     allPassed &= test_ocnumber_json_typed_real();
     allPassed &= test_ocnumber_json_backward_compatibility();
+    allPassed &= numberTest_parsing();
     if (allPassed) {
     } else {
         fprintf(stderr, "[%s] SOME TESTS FAILED\n", test_name);
@@ -13,6 +13,8 @@ bool test_ocnumber_json_untyped_real(void);
 bool test_ocnumber_json_typed_real(void);
 /// Test backward compatibility with old JSON formats
 bool test_ocnumber_json_backward_compatibility(void);
+/// Test string constructors, in-place JSON numbers and bulk parsing
+bool numberTest_parsing(void);
 /// Run all OCNumber tests (basic + JSON). Returns true on success.
 bool test_number_comprehensive(void);
 #endif /* TEST_NUMBER_H */
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/OCTypes.h"
+#include "test_utils.h"
+#define kKeyRange 4000
+static OCComparisonResult compareNumbers(const void *a, const void *b, void *context) {
+    (void)context;
+    int64_t x = 0, y = 0;
+    OCNumberTryGetSInt64((OCNumberRef)a, &x);
+    OCNumberTryGetSInt64((OCNumberRef)b, &y);
+    return x < y ? kOCCompareLessThan : x > y ? kOCCompareGreaterThan : kOCCompareEqualTo;
+}
+static OCComparisonResult compareStrings(const void *a, const void *b, void *context) {
+    (void)context;
+    return OCStringCompare((OCStringRef)a, (OCStringRef)b, 0);
+}
+static int64_t numberValue(const void *n) {
+    int64_t v = 0;
+    OCNumberTryGetSInt64((OCNumberRef)n, &v);
+    return v;
+}
+// Checks count, order and every value against a reference of present keys
+static bool matchesReference(OCSortedDictionaryRef dict, const bool *present) {
+    uint64_t expected = 0;
+    for (int64_t k = 0; k < kKeyRange; k++)
+        expected += present[k];
+    if (OCSortedDictionaryGetCount(dict) != expected) return false;
+    OCSortedDictionaryCursor cursor;
+    const void *key, *value;
+    int64_t previous = -1;
+    uint64_t seen = 0;
+    OCSortedDictionaryCursorInit(&cursor, dict, NULL, NULL);
+    while (OCSortedDictionaryCursorNext(&cursor, &key, &value)) {
+        int64_t k = numberValue(key);
+        if (k <= previous || !present[k] || numberValue(value) != -k) return false;
+        previous = k;
+        seen++;
+    }
+    return seen == expected;
+}
+bool OCSortedDictionarySetGetRemove_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    bool *present = calloc(kKeyRange, sizeof(bool));
+    OCMutableSortedDictionaryRef dict = OCSortedDictionaryCreateMutable(compareNumbers, NULL);
+    success &= (dict && OCSortedDictionaryGetCount(dict) == 0);
+    success &= (OCSortedDictionaryCreateMutable(NULL, NULL) == NULL);
+    // Random inserts and removals split, borrow and merge nodes at every level
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    for (int step = 0; step < 40000 && success; step++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        int64_t k = (int64_t)(rng % kKeyRange);
+        OCNumberRef key = OCNumberCreateWithSInt64(k);
+        // Grow for the first half, then shrink
+        if ((rng >> 32) % 4 < (step < 20000 ? 3u : 1u)) {
+            OCNumberRef value = OCNumberCreateWithSInt64(-k);
+            success &= OCSortedDictionarySetValue(dict, key, value);
+            OCRelease(value);
+            present[k] = true;
+        } else {
+            success &= (OCSortedDictionaryRemoveValue(dict, key) == present[k]);
+            present[k] = false;
+        }
+        success &= (OCSortedDictionaryContainsKey(dict, key) == present[k]);
+        OCRelease(key);
+        if (step % 2000 == 0) success &= matchesReference(dict, present);
+    }
+    success &= matchesReference(dict, present);
+    for (int64_t k = 0; k < kKeyRange && success; k++) {
+        OCNumberRef key = OCNumberCreateWithSInt64(k);
+        const void *value = OCSortedDictionaryGetValue(dict, key);
+        success &= present[k] ? (value && numberValue(value) == -k) : value == NULL;
+        OCRelease(key);
+    }
+    // Replacing keeps the count
+    OCNumberRef seven = OCNumberCreateWithSInt64(7);
+    uint64_t count = OCSortedDictionaryGetCount(dict);
+    success &= OCSortedDictionarySetValue(dict, seven, STR("seven"));
+    success &= (OCSortedDictionaryGetCount(dict) == count + !present[7]);
+    success &= (OCSortedDictionaryGetValue(dict, seven) == STR("seven"));
+    OCRelease(seven);
+    // Drain to empty and refill
+    for (int64_t k = 0; k < kKeyRange; k++) {
+        OCNumberRef key = OCNumberCreateWithSInt64(k);
+        OCSortedDictionaryRemoveValue(dict, key);
+        OCRelease(key);
+    }
+    success &= (OCSortedDictionaryGetCount(dict) == 0);
+    OCSortedDictionaryCursor cursor;
+    OCSortedDictionaryCursorInit(&cursor, dict, NULL, NULL);
+    success &= !OCSortedDictionaryCursorNext(&cursor, NULL, NULL);
+    OCRelease(dict);
+    free(present);
+    if (!success) PRINTERROR;
+    fprintf(stderr, " passed\n");
+    return success;
+}
+typedef struct {
+    int64_t sum;
+    int64_t count;
+} RangeTotals;
+static void addEntry(const void *key, const void *value, void *context) {
+    (void)value;
+    RangeTotals *totals = context;
+    totals->sum += numberValue(key);
+    totals->count++;
+}
+bool OCSortedDictionaryRangeQuery_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    // Even keys 0, 2, ..., 1998, then remove the multiples of 6 so that some
+    // separators no longer name a stored key
+    OCMutableSortedDictionaryRef dict = OCSortedDictionaryCreateMutable(compareNumbers, NULL);
+    for (int64_t k = 0; k < 2000; k += 2) {
+        OCNumberRef key = OCNumberCreateWithSInt64(k);
+        OCNumberRef value = OCNumberCreateWithSInt64(-k);
+        OCSortedDictionarySetValue(dict, key, value);
+        OCRelease(value);
+        OCRelease(key);
+    }
+    for (int64_t k = 0; k < 2000; k += 6) {
+        OCNumberRef key = OCNumberCreateWithSInt64(k);
+        success &= OCSortedDictionaryRemoveValue(dict, key);
+        OCRelease(key);
+    }
+    // Floor and ceiling of every probe against the expected neighbours
+    for (int64_t probe = -3; probe < 2003 && success; probe++) {
+        int64_t floor = probe < 1998 ? probe : 1998, ceiling = probe > 0 ? probe : 0;
+        while (floor >= 0 && (floor % 2 || floor % 6 == 0)) floor--;
+        while (ceiling < 2000 && (ceiling % 2 || ceiling % 6 == 0)) ceiling++;
+        OCNumberRef key = OCNumberCreateWithSInt64(probe);
+        const void *found = NULL, *value = NULL;
+        bool hasFloor = OCSortedDictionaryGetFloor(dict, key, &found, &value);
+        success &= (hasFloor == (floor >= 0));
+        if (hasFloor) success &= (numberValue(found) == floor && numberValue(value) == -floor);
+        bool hasCeiling = OCSortedDictionaryGetCeiling(dict, key, &found, NULL);
+        success &= (hasCeiling == (ceiling < 2000));
+        if (hasCeiling) success &= (numberValue(found) == ceiling);
+        OCRelease(key);
+    }
+    // Half-open ranges, including bounds that fall between stored keys
+    OCNumberRef low = OCNumberCreateWithSInt64(101);
+    OCNumberRef high = OCNumberCreateWithSInt64(500);
+    RangeTotals totals = {0, 0};
+    OCSortedDictionaryApplyFunction(dict, low, high, addEntry, &totals);
+    int64_t sum = 0, count = 0;
+    for (int64_t k = 102; k < 500; k += 2)
+        if (k % 6) sum += k, count++;
+    success &= (totals.sum == sum && totals.count == count);
+    totals = (RangeTotals){0, 0};
+    OCSortedDictionaryApplyFunction(dict, high, low, addEntry, &totals);
+    success &= (totals.count == 0);
+    totals = (RangeTotals){0, 0};
+    OCSortedDictionaryApplyFunction(dict, NULL, NULL, addEntry, &totals);
+    success &= ((uint64_t)totals.count == OCSortedDictionaryGetCount(dict));
+    OCSortedDictionaryCursor cursor;
+    const void *key;
+    OCSortedDictionaryCursorInit(&cursor, dict, high, NULL);
+    success &= (OCSortedDictionaryCursorNext(&cursor, &key, NULL) && numberValue(key) == 500);
+    OCRelease(high);
+    OCRelease(low);
+    OCRelease(dict);
+    if (!success) PRINTERROR;
+    fprintf(stderr, " passed\n");
+    return success;
+}
+bool OCSortedDictionaryBulkLoad_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    // Sizes around the leaf and internal node capacities
+    const uint64_t sizes[] = {0, 1, 31, 32, 33, 992, 993, 5000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && success; s++) {
+        uint64_t n = sizes[s];
+        const void **keys = malloc((n + 1) * sizeof(void *));
+        const void **values = malloc((n + 1) * sizeof(void *));
+        for (uint64_t i = 0; i < n; i++) {
+            keys[i] = OCNumberCreateWithSInt64((int64_t)i * 3);
+            values[i] = OCNumberCreateWithSInt64(-(int64_t)i * 3);
+        }
+        OCSortedDictionaryRef dict = OCSortedDictionaryCreate(keys, values, n, compareNumbers, NULL);
+        success &= (dict && OCSortedDictionaryGetCount(dict) == n);
+        for (uint64_t i = 0; i < n; i++) {
+            const void *value = OCSortedDictionaryGetValue(dict, keys[i]);
+            success &= (value && numberValue(value) == -(int64_t)i * 3);
+        }
+        // Immutable, so copies are the same object and writes are refused
+        OCSortedDictionaryRef copy = OCSortedDictionaryCreateCopy(dict);
+        success &= (copy == dict);
+        OCRelease(copy);
+        success &= !OCSortedDictionarySetValue((OCMutableSortedDictionaryRef)dict, STR("key"), STR("value"));
+        // A mutable copy of a bulk-loaded tree takes inserts and removals
+        OCMutableSortedDictionaryRef mutableCopy = OCSortedDictionaryCreateMutableCopy(dict);
+        success &= (mutableCopy && OCTypeEqual(mutableCopy, dict));
+        for (uint64_t i = 0; i < n; i += 2)
+            success &= OCSortedDictionaryRemoveValue(mutableCopy, keys[i]);
+        success &= (OCSortedDictionaryGetCount(mutableCopy) == n / 2);
+        success &= (n < 2 || !OCTypeEqual(mutableCopy, dict));
+        OCSortedDictionaryRef deep = OCTypeDeepCopy(mutableCopy);
+        success &= (deep && OCTypeEqual(deep, mutableCopy));
+        OCRelease(deep);
+        OCRelease(mutableCopy);
+        OCRelease(dict);
+        // Keys out of order or repeated are rejected
+        if (n >= 2) {
+            const void *swap = keys[0];
+            keys[0] = keys[1];
+            keys[1] = swap;
+            success &= (OCSortedDictionaryCreate(keys, values, n, compareNumbers, NULL) == NULL);
+            keys[1] = keys[0];
+            keys[0] = swap;
+            const void *second = keys[1];
+            keys[1] = keys[0];
+            success &= (OCSortedDictionaryCreate(keys, values, n, compareNumbers, NULL) == NULL);
+            keys[1] = second;
+        }
+        for (uint64_t i = 0; i < n; i++) {
+            OCRelease(keys[i]);
+            OCRelease(values[i]);
+        }
+        free(keys);
+        free(values);
+    }
+    // JSON output is [key, value] pairs in key order
+    const void *keys[] = {STR("a"), STR("b")};
+    const void *values[] = {kOCBooleanTrue, kOCBooleanFalse};
+    OCSortedDictionaryRef dict = OCSortedDictionaryCreate(keys, values, 2, compareStrings, NULL);
+    cJSON *json = OCTypeCopyJSON((OCTypeRef)dict, false, NULL);
+    char *text = json ? cJSON_PrintUnformatted(json) : NULL;
+    success &= (text && strcmp(text, "[[\"a\",true],[\"b\",false]]") == 0);
+    free(text);
+    cJSON_Delete(json);
+    OCRelease(dict);
+    if (!success) PRINTERROR;
+    fprintf(stderr, " passed\n");
+    return success;
+}
@@ -0,0 +1,13 @@
+#ifndef TEST_OCSORTEDDICTIONARY_H
+#define TEST_OCSORTEDDICTIONARY_H
+#include <stdbool.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool OCSortedDictionarySetGetRemove_test(void);
+bool OCSortedDictionaryRangeQuery_test(void);
+bool OCSortedDictionaryBulkLoad_test(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* TEST_OCSORTEDDICTIONARY_H */
@@ -3,10 +3,13 @@
 #include <complex.h>   // creal, cimag, conj
 #include <inttypes.h>  // Provides PRIu64 and related macros
 #include <math.h>      // exp, log, acos, asin, cos, sin
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>          // Added for strcmp
 #include "../src/OCArray.h"  // for OCArrayGetCount, OCArrayGetValueAtIndex
+#include "../src/OCData.h"   // for OCDataCreate
+#include "../src/OCIndexPairSet.h"
 #include "../src/OCMath.h"   // for OCComplexFromCString, OCCompareDoubleValues
 #include "../src/OCString.h"
 // ————————— existing tests —————————
@@ -1006,3 +1009,459 @@ bool stringTest_deepcopy(void) {
     fprintf(stderr, " passed\n");
     return ok;
 }
+// Reads every character of a shared immutable copy of the 'mixed' string
+// below; returns non-NULL on a mismatch
+static void *indexingWorker(void *arg) {
+    OCStringRef shared = (OCStringRef)arg;
+    uint64_t length = OCStringGetLength(shared);
+    for (uint64_t i = length; i-- > 0;) {
+        uint32_t c = OCStringGetCharacterAtIndex(shared, i);
+        if (c != 'x' && c != 0x00E9 && c != 'a' && c != 'b') return arg;
+    }
+    return NULL;
+}
+bool stringTest_indexing(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCMutableStringRef ascii = NULL;
+    OCMutableStringRef mixed = NULL;
+    OCStringRef sub = NULL;
+    // ASCII string: direct byte indexing
+    ascii = OCStringCreateMutable(0);
+    for (int i = 0; i < 300; i++) {
+        char c[2] = {(char)('a' + i % 26), '\0'};
+        OCStringAppendCString(ascii, c);
+    }
+    if (OCStringGetLength(ascii) != 300) goto cleanup;
+    if (OCStringGetCharacterAtIndex(ascii, 299) != (uint32_t)('a' + 299 % 26)) goto cleanup;
+    if (OCStringGetCharacterAtIndex(ascii, 300) != 0) goto cleanup;
+    // Appending a non-ASCII character switches to the indexed path
+    OCStringAppendCString(ascii, "µ");
+    if (OCStringGetCharacterAtIndex(ascii, 300) != 0x00B5) goto cleanup;
+    if (OCStringGetCharacterAtIndex(ascii, 150) != (uint32_t)('a' + 150 % 26)) goto cleanup;
+    // Non-ASCII string longer than several index strides
+    mixed = OCStringCreateMutable(0);
+    for (int i = 0; i < 200; i++) {
+        OCStringAppendCString(mixed, (i % 2) ? "x" : "é");
+    }
+    for (uint64_t i = 0; i < 200; i++) {
+        uint32_t expected = (i % 2) ? 'x' : 0x00E9;
+        if (OCStringGetCharacterAtIndex(mixed, i) != expected) goto cleanup;
+    }
+    // Edits before cached offsets must invalidate them
+    OCStringDelete(mixed, OCRangeMake(10, 1));  // drop an 'é' at an even index
+    if (OCStringGetCharacterAtIndex(mixed, 10) != 'x') goto cleanup;
+    if (OCStringGetCharacterAtIndex(mixed, 150) != 'x') goto cleanup;
+    if (OCStringGetCharacterAtIndex(mixed, 151) != 0x00E9) goto cleanup;
+    OCStringInsert(mixed, 5, STR("€€€"));
+    if (OCStringGetCharacterAtIndex(mixed, 6) != 0x20AC) goto cleanup;
+    if (OCStringGetCharacterAtIndex(mixed, 153) != 'x') goto cleanup;
+    if (OCStringGetCharacterAtIndex(mixed, 154) != 0x00E9) goto cleanup;
+    OCStringReplace(mixed, OCRangeMake(0, 8), STR("ab"));
+    if (OCStringGetCharacterAtIndex(mixed, 1) != 'b') goto cleanup;
+    if (OCStringGetCharacterAtIndex(mixed, 147) != 'x') goto cleanup;
+    sub = OCStringCreateWithSubstring(mixed, OCRangeMake(146, 3));
+    if (!sub || OCStringCompare(sub, STR("éxé"), 0) != kOCCompareEqualTo) goto cleanup;
+    // Lookups on a shared immutable string may all build its index at once
+    OCRelease(sub);
+    sub = OCStringCreateCopy(mixed);
+    if (!sub) goto cleanup;
+    pthread_t threads[4];
+    int started = 0;
+    bool clean = true;
+    for (; started < 4; started++)
+        if (pthread_create(&threads[started], NULL, indexingWorker, (void *)sub) != 0) break;
+    for (int t = 0; t < started; t++) {
+        void *failed = NULL;
+        pthread_join(threads[t], &failed);
+        if (failed) clean = false;
+    }
+    if (started < 4 || !clean) goto cleanup;
+    ok = true;
+cleanup:
+    if (sub) OCRelease(sub);
+    if (mixed) OCRelease(mixed);
+    if (ascii) OCRelease(ascii);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_utf8_validation(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCStringRef s = NULL;
+    OCIndex bad = 0;
+    char buf[200];
+    // Valid input spanning several 32-byte ASCII blocks plus multi-byte sequences
+    memset(buf, 'a', 100);
+    memcpy(buf + 100, "é€😀", 9);
+    memset(buf + 109, 'z', 40);
+    s = OCStringCreateWithUTF8Bytes(buf, 149, &bad);
+    if (!s || bad != kOCNotFound) goto cleanup;
+    if (OCStringGetLength(s) != 143) goto cleanup;
+    if (OCStringGetCharacterAtIndex(s, 102) != 0x1F600) goto cleanup;
+    OCRelease(s);
+    s = NULL;
+    // Invalid byte placed after a long ASCII run is located exactly
+    buf[70] = (char)0xFF;
+    s = OCStringCreateWithUTF8Bytes(buf, 149, &bad);
+    if (s || bad != 70) goto cleanup;
+    // Truncated, overlong, surrogate and out-of-range sequences
+    if (OCStringCreateWithUTF8Bytes("ab\xC3", 3, &bad) || bad != 2) goto cleanup;
+    if (OCStringCreateWithUTF8Bytes("\xC0\xAF", 2, &bad) || bad != 0) goto cleanup;
+    if (OCStringCreateWithUTF8Bytes("x\xE0\x80\xAF", 4, &bad) || bad != 1) goto cleanup;
+    if (OCStringCreateWithUTF8Bytes("\xED\xA0\x80", 3, &bad) || bad != 0) goto cleanup;
+    if (OCStringCreateWithUTF8Bytes("\xF4\x90\x80\x80", 4, &bad) || bad != 0) goto cleanup;
+    if (OCStringCreateWithUTF8Bytes("a\0b", 3, &bad) || bad != 1) goto cleanup;
+    // Grapheme rules still apply to the non-ASCII parts
+    s = OCStringCreateWithUTF8Bytes("abc🇺🇸def", 14, &bad);
+    if (!s || OCStringGetLength(s) != 7) goto cleanup;
+    ok = true;
+cleanup:
+    if (s) OCRelease(s);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_substring_views(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCStringRef line = OCStringCreateWithCString("alpha,β-gamma,delta,,epsilon");
+    OCMutableStringRef m = OCMutableStringCreateWithCString("mutable source");
+    OCStringRef word = NULL, copy = NULL, fromMutable = NULL, inner = NULL;
+    OCArrayRef parts = NULL;
+    OCMutableStringRef joined = NULL;
+    if (!line || !m) goto cleanup;
+    // A substring of an immutable string shares (and retains) the parent
+    word = OCStringCreateWithSubstring(line, OCRangeMake(6, 7));
+    if (!word || OCTypeGetRetainCount(line) != 2) goto cleanup;
+    if (OCStringGetLength(word) != 7) goto cleanup;
+    if (OCStringGetCharacterAtIndex(word, 0) != 0x03B2) goto cleanup;
+    if (!OCStringEqual(word, STR("β-gamma"))) goto cleanup;
+    if (OCStringCompare(word, STR("β-gam"), 0) != kOCCompareGreaterThan) goto cleanup;
+    // Views of views still point at the owning string; a view, being
+    // immutable, is its own copy
+    inner = OCStringCreateWithSubstring(word, OCRangeMake(2, 5));
+    copy = OCStringCreateCopy(word);
+    if (!inner || copy != word || OCTypeGetRetainCount(line) != 3) goto cleanup;
+    if (!OCStringEqual(inner, STR("gamma")) || !OCStringEqual(copy, word)) goto cleanup;
+    // Asking for a C string copies the bytes aside; the view keeps its parent
+    if (strcmp(OCStringGetCString(inner), "gamma") != 0) goto cleanup;
+    if (OCTypeGetRetainCount(line) != 3 || !OCStringEqual(inner, STR("gamma"))) goto cleanup;
+    // A view used as a format is compiled from its own bytes, up to its end
+    OCStringRef pattern = OCStringCreateWithCString("n=%d%%;%s");
+    OCStringRef fmtView = pattern ? OCStringCreateWithSubstring(pattern, OCRangeMake(0, 6)) : NULL;
+    OCStringRef formatted = fmtView ? OCStringCreateWithFormat(fmtView, 5) : NULL;
+    bool formattedOK = formatted && OCStringEqual(formatted, STR("n=5%")) && OCTypeGetRetainCount(pattern) == 2;
+    if (formatted) OCRelease(formatted);
+    if (fmtView) OCRelease(fmtView);
+    if (pattern) OCRelease(pattern);
+    if (!formattedOK) goto cleanup;
+    // Splitting yields views, including empty tokens
+    parts = OCStringCreateArrayBySeparatingStrings(line, STR(","));
+    if (!parts || OCArrayGetCount(parts) != 5) goto cleanup;
+    if (!OCStringEqual(OCArrayGetValueAtIndex(parts, 3), STR(""))) goto cleanup;
+    if (!OCStringEqual(OCArrayGetValueAtIndex(parts, 4), STR("epsilon"))) goto cleanup;
+    // Views outlive the caller's reference to the parent
+    OCRelease(line);
+    line = NULL;
+    joined = OCStringCreateMutable(0);
+    OCStringAppend(joined, word);
+    OCStringAppend(joined, OCArrayGetValueAtIndex(parts, 0));
+    if (strcmp(OCStringGetCString(joined), "β-gammaalpha") != 0) goto cleanup;
+    // Substrings of mutable strings are independent copies
+    fromMutable = OCStringCreateWithSubstring(m, OCRangeMake(0, 7));
+    OCStringUppercase(m);
+    if (!fromMutable || !OCStringEqual(fromMutable, STR("mutable"))) goto cleanup;
+    ok = true;
+cleanup:
+    if (joined) OCRelease(joined);
+    if (parts) OCRelease(parts);
+    if (fromMutable) OCRelease(fromMutable);
+    if (copy) OCRelease(copy);
+    if (inner) OCRelease(inner);
+    if (word) OCRelease(word);
+    if (line) OCRelease(line);
+    if (m) OCRelease(m);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_search_engine(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCMutableStringRef text = NULL;
+    OCIndexPairSetRef hits = NULL;
+    OCRange r;
+    // Long (Boyer-Moore-Horspool) and short (memchr) needles after non-ASCII text
+    text = OCMutableStringCreateWithCString("µµ the Quick brown fox; THE QUICK BROWN FOX; the quick brown fox");
+    if (!text) goto cleanup;
+    r = OCStringFind(text, STR("quick brown"), 0);
+    if (r.location != 49 || r.length != 11) goto cleanup;
+    r = OCStringFind(text, STR("quick brown"), kOCCompareCaseInsensitive);
+    if (r.location != 7) goto cleanup;
+    r = OCStringFind(text, STR("fox"), 0);
+    if (r.location != 19) goto cleanup;
+    r = OCStringFind(text, STR("FOX"), kOCCompareCaseInsensitive);
+    if (r.location != 19) goto cleanup;
+    if (OCStringFind(text, STR("quick brownie"), kOCCompareCaseInsensitive).location != kOCNotFound) goto cleanup;
+    // Compact match results
+    hits = OCStringCreateIndexPairSetWithFindResults(text, STR("the quick"),
+                                                     OCRangeMake(0, OCStringGetLength(text)),
+                                                     kOCCompareCaseInsensitive);
+    if (!hits || OCIndexPairSetGetCount(hits) != 3) goto cleanup;
+    OCIndexPair* pairs = OCIndexPairSetGetBytesPtr(hits);
+    if (pairs[0].index != 3 || pairs[1].index != 24 || pairs[2].index != 45 || pairs[2].value != 9) goto cleanup;
+    // Single-pass replace restricted to a range, then across the whole string
+    if (OCStringFindAndReplace(text, STR("fox"), STR("cat"), OCRangeMake(0, 44), kOCCompareCaseInsensitive) != 2)
+        goto cleanup;
+    if (OCStringCompare(text, STR("µµ the Quick brown cat; THE QUICK BROWN cat; the quick brown fox"), 0) != kOCCompareEqualTo)
+        goto cleanup;
+    if (OCStringFindAndReplace2(text, STR("µ"), STR("mu")) != 2) goto cleanup;
+    if (OCStringGetLength(text) != 66 || OCStringGetCharacterAtIndex(text, 65) != 'x') goto cleanup;
+    ok = true;
+cleanup:
+    if (hits) OCRelease(hits);
+    if (text) OCRelease(text);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_format_cache(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCStringRef s = NULL;
+    OCMutableStringRef m = NULL;
+    OCMutableStringRef fmt = NULL;
+    char longText[301];
+    memset(longText, 'a', 300);
+    longText[300] = '\0';
+    // The same constant format reused with different arguments
+    for (int i = 0; i < 3; i++) {
+        s = OCStringCreateWithFormat(STR("item %03d of %s: %.2f%% µ"), i, "three", 12.5 * i);
+        char expected[64];
+        snprintf(expected, sizeof(expected), "item %03d of %s: %.2f%% µ", i, "three", 12.5 * i);
+        if (!s || strcmp(OCStringGetCString(s), expected) != 0) goto cleanup;
+        if (OCStringGetLength(s) != strlen(expected) - 1) goto cleanup;
+        OCRelease(s);
+        s = NULL;
+    }
+    // Conversions longer than any fixed scratch buffer, length modifiers and %@
+    s = OCStringCreateWithFormat(STR("[%s|%@|%zu|%lld|%hhu|%-6x]"), longText, STR("obj"),
+                                 (size_t)300, -5000000000LL, 258, 255u);
+    if (!s || OCStringGetLength(s) != 300 + 31) goto cleanup;
+    if (strcmp(OCStringGetCString(s) + 301, "|obj|300|-5000000000|2|ff    ]") != 0) goto cleanup;
+    OCRelease(s);
+    s = NULL;
+    // Appending, including a mutable format edited between uses
+    m = OCStringCreateMutable(0);
+    fmt = OCMutableStringCreateWithCString("<%d>");
+    if (!m || !fmt) goto cleanup;
+    OCStringAppendFormat(m, fmt, 1);
+    OCStringAppendCString(fmt, "%@");
+    OCStringAppendFormat(m, fmt, 2, STR("x"));
+    OCStringAppendFormat(m, STR("%@%"), m);
+    if (strcmp(OCStringGetCString(m), "<1><2>x<1><2>x%") != 0) goto cleanup;
+    ok = true;
+cleanup:
+    if (s) OCRelease(s);
+    if (m) OCRelease(m);
+    if (fmt) OCRelease(fmt);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+static int noCopyDeallocations = 0;
+static void noCopyDeallocate(void *bytes, uint64_t length, void *context) {
+    (void)length;
+    if (context == &noCopyDeallocations) noCopyDeallocations++;
+    free(bytes);
+}
+bool stringTest_no_copy(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCStringRef s = NULL, word = NULL, fromData = NULL, copied = NULL;
+    OCDataRef data = NULL;
+    noCopyDeallocations = 0;
+    // Not NUL-terminated: the string ends at the given length
+    char *bytes = malloc(16);
+    if (!bytes) goto cleanup;
+    memcpy(bytes, "héllo, world!XYZ", 16);
+    s = OCStringCreateWithBytesNoCopy(bytes, 14, noCopyDeallocate, &noCopyDeallocations);
+    if (!s || OCStringGetLength(s) != 13 || !OCStringEqual(s, STR("héllo, world!"))) goto cleanup;
+    if (OCStringGetCharacterAtIndex(s, 1) != 0x00E9) goto cleanup;
+    // Views share the caller's bytes and keep them alive
+    word = OCStringCreateWithSubstring(s, OCRangeMake(7, 5));
+    if (!word || !OCStringEqual(word, STR("world"))) goto cleanup;
+    OCRelease(s);
+    s = NULL;
+    if (noCopyDeallocations != 0) goto cleanup;
+    // Reading a view gives it a terminated copy but leaves it a view, so the
+    // same pointer comes back and the caller's bytes stay in use
+    const char *cWord = OCStringGetCString(word);
+    if (!cWord || strcmp(cWord, "world") != 0 || OCStringGetCString(word) != cWord) goto cleanup;
+    if (noCopyDeallocations != 0) goto cleanup;
+    // Releasing the last view hands the bytes back exactly once
+    OCRelease(word);
+    word = NULL;
+    if (noCopyDeallocations != 1) goto cleanup;
+    // Data-backed strings retain the data and stop at an embedded NUL
+    data = OCDataCreate((const uint8_t *)"abc\0def", 7);
+    fromData = OCStringCreateWithDataNoCopy(data);
+    if (!fromData || OCTypeGetRetainCount(data) != 2 || !OCStringEqual(fromData, STR("abc"))) goto cleanup;
+    copied = OCStringCreateWithExternalRepresentation(data);
+    if (!copied || !OCStringEqual(copied, fromData)) goto cleanup;
+    // A NULL deallocator leaves ownership with the caller
+    static const char literal[] = "static text";
+    OCRelease(fromData);
+    fromData = OCStringCreateWithBytesNoCopy(literal, sizeof literal - 1, NULL, NULL);
+    if (!fromData || !OCStringEqual(fromData, STR("static text"))) goto cleanup;
+    // A buffer ending inside a multi-byte sequence is rejected without
+    // reading past its end, and the caller keeps the bytes
+    char *truncated = malloc(4);
+    if (!truncated) goto cleanup;
+    memcpy(truncated, "ab\xE2\x82", 4);
+    OCStringRef rejected = OCStringCreateWithBytesNoCopy(truncated, 4, noCopyDeallocate, &noCopyDeallocations);
+    free(truncated);
+    if (rejected || noCopyDeallocations != 1) goto cleanup;
+    // Writes to mutable data after the fact do not reach the string
+    OCMutableDataRef scratch = OCDataCreateMutable(0);
+    OCDataAppendBytes(scratch, (const uint8_t *)"mutable", 7);
+    OCRelease(fromData);
+    fromData = OCStringCreateWithDataNoCopy(scratch);
+    OCDataGetMutableBytes(scratch)[0] = 'M';
+    OCRelease(scratch);
+    if (!fromData || !OCStringEqual(fromData, STR("mutable"))) goto cleanup;
+    ok = true;
+cleanup:
+    if (copied) OCRelease(copied);
+    if (fromData) OCRelease(fromData);
+    if (data) OCRelease(data);
+    if (word) OCRelease(word);
+    if (s) OCRelease(s);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_rope_builder(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCMutableStringRef rope = OCStringCreateMutableRope();
+    OCMutableStringRef flat = OCStringCreateMutable(0);
+    OCMutableStringRef copy = NULL;
+    OCStringRef tail = NULL;
+    FILE *f = NULL;
+    char *streamed = NULL;
+    if (!rope || !flat) goto cleanup;
+    // Mirror random edits on a rope builder and a flat string
+    static const char *pieces[] = {"alpha ", "β-γ ", "", "x", "µµµ ", "long piece of plain ASCII text "};
+    uint32_t state = 12345;
+    for (int i = 0; i < 3000; i++) {
+        state = state * 1103515245u + 12345u;
+        uint32_t r = state >> 8;
+        OCStringRef piece = OCStringCreateWithCString(pieces[r % 6]);
+        uint64_t len = OCStringGetLength(flat);
+        switch ((r >> 4) % 5) {
+            case 0:
+            case 1:
+                OCStringAppend(rope, piece);
+                OCStringAppend(flat, piece);
+                break;
+            case 2: {
+                int64_t at = len ? (int64_t)((r >> 8) % (len + 1)) : 0;
+                OCStringInsert(rope, at, piece);
+                OCStringInsert(flat, at, piece);
+                break;
+            }
+            case 3:
+                if (len) {
+                    uint64_t at = (r >> 8) % len;
+                    OCRange range = OCRangeMake(at, (r >> 16) % (len - at + 1) % 40);
+                    OCStringDelete(rope, range);
+                    OCStringDelete(flat, range);
+                }
+                break;
+            case 4:
+                OCStringAppendFormat(rope, STR("[%d]"), i);
+                OCStringAppendFormat(flat, STR("[%d]"), i);
+                break;
+        }
+        OCRelease(piece);
+        if (OCStringGetLength(rope) != OCStringGetLength(flat)) goto cleanup;
+        // Reading flattens; the next edit goes back into the rope
+        if (i % 500 == 0 && !OCStringEqual(rope, flat)) goto cleanup;
+    }
+    // Streaming writes the chunks without flattening
+    f = tmpfile();
+    if (!f || !OCStringWriteToStream(rope, f)) goto cleanup;
+    long size = ftell(f);
+    if (size < 0 || (size_t)size != strlen(OCStringGetCString(flat))) goto cleanup;
+    streamed = malloc((size_t)size + 1);
+    rewind(f);
+    if (!streamed || fread(streamed, 1, (size_t)size, f) != (size_t)size) goto cleanup;
+    streamed[size] = '\0';
+    if (strcmp(streamed, OCStringGetCString(flat)) != 0) goto cleanup;
+    if (strcmp(OCStringGetCString(rope), OCStringGetCString(flat)) != 0) goto cleanup;
+    // Flattened builders behave like ordinary strings
+    copy = OCStringCreateMutableCopy(rope);
+    OCStringUppercase(copy);
+    OCStringAppendCString(rope, " END");
+    tail = OCStringCreateWithSubstring(rope, OCRangeMake(OCStringGetLength(rope) - 4, 4));
+    if (!tail || !OCStringEqual(tail, STR(" END"))) goto cleanup;
+    // An unflattened builder formats through %@ like any other string
+    OCRelease(tail);
+    tail = NULL;
+    OCMutableStringRef pending = OCStringCreateMutableRope();
+    OCStringAppendCString(pending, "rope ");
+    OCStringAppendCString(pending, "text");
+    tail = OCStringCreateWithFormat(STR("[%@]"), pending);
+    OCRelease(pending);
+    if (!tail || !OCStringEqual(tail, STR("[rope text]"))) goto cleanup;
+    ok = true;
+cleanup:
+    if (tail) OCRelease(tail);
+    free(streamed);
+    if (f) fclose(f);
+    if (copy) OCRelease(copy);
+    if (flat) OCRelease(flat);
+    if (rope) OCRelease(rope);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
+bool stringTest_copy_on_write(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool ok = false;
+    OCMutableStringRef source = OCMutableStringCreateWithCString("copy on write");
+    OCStringRef snapshot = NULL, again = NULL, literal = NULL;
+    OCMutableStringRef edit = NULL, tail = NULL;
+    if (!source) goto cleanup;
+    // Copies read the source's buffer until one of them changes
+    snapshot = OCStringCreateCopy(source);
+    edit = OCStringCreateMutableCopy(source);
+    if (!snapshot || !edit) goto cleanup;
+    if (OCStringGetCString(snapshot) != OCStringGetCString(source)) goto cleanup;
+    if (OCStringGetCString(edit) != OCStringGetCString(source)) goto cleanup;
+    again = OCStringCreateCopy(snapshot);
+    if (again != snapshot) goto cleanup;
+    // Edits on either side stay on that side
+    OCStringAppendCString(source, "!");
+    OCStringUppercase(edit);
+    if (strcmp(OCStringGetCString(source), "copy on write!") != 0) goto cleanup;
+    if (strcmp(OCStringGetCString(edit), "COPY ON WRITE") != 0) goto cleanup;
+    if (strcmp(OCStringGetCString(snapshot), "copy on write") != 0) goto cleanup;
+    // A mutable copy of a substring view edits its own bytes
+    OCStringRef word = OCStringCreateWithSubstring(snapshot, OCRangeMake(8, 5));
+    tail = word ? OCStringCreateMutableCopy(word) : NULL;
+    if (word) OCRelease(word);
+    if (!tail) goto cleanup;
+    OCStringInsert(tail, 0, STR("re"));
+    if (strcmp(OCStringGetCString(tail), "rewrite") != 0) goto cleanup;
+    if (strcmp(OCStringGetCString(snapshot), "copy on write") != 0) goto cleanup;
+    // Interned constants still get a private copy
+    literal = OCStringCreateCopy(STR("constant"));
+    if (!literal || literal == STR("constant") || !OCStringEqual(literal, STR("constant"))) goto cleanup;
+    ok = true;
+cleanup:
+    if (literal) OCRelease(literal);
+    if (tail) OCRelease(tail);
+    if (again) OCRelease(again);
+    if (edit) OCRelease(edit);
+    if (snapshot) OCRelease(snapshot);
+    if (source) OCRelease(source);
+    fprintf(stderr, ok ? " passed\n" : " FAILED\n");
+    return ok;
+}
@@ -17,4 +17,12 @@ bool stringTest9(void);
 bool stringTest10(void);
 bool stringTest11(void);
 bool stringTest_deepcopy(void);
+bool stringTest_indexing(void);
+bool stringTest_utf8_validation(void);
+bool stringTest_substring_views(void);
+bool stringTest_search_engine(void);
+bool stringTest_format_cache(void);
+bool stringTest_no_copy(void);
+bool stringTest_rope_builder(void);
+bool stringTest_copy_on_write(void);
 #endif  // TEST_STRING_H
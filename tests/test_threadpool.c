@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/OCTypes.h"
+#include "test_utils.h"
+static void OCThreadPoolTest_increment(void *context) {
+    __atomic_add_fetch((int64_t *)context, 1, __ATOMIC_RELAXED);
+}
+// Forks ten increments into a nested group and waits for them from inside a task
+static void OCThreadPoolTest_fork(void *context) {
+    OCTaskGroupRef inner = OCTaskGroupCreate();
+    for (int i = 0; i < 10; i++) {
+        if (!OCTaskGroupSubmit(inner, OCThreadPoolTest_increment, context)) OCThreadPoolTest_increment(context);
+    }
+    OCTaskGroupRelease(inner);
+}
+bool OCThreadPoolTaskGroup_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    int64_t count = 0;
+    OCTaskGroupRef group = OCTaskGroupCreate();
+    success &= (group != NULL);
+    for (int i = 0; i < 100; i++)
+        success &= OCTaskGroupSubmit(group, OCThreadPoolTest_increment, &count);
+    OCTaskGroupWait(group);
+    success &= (count == 100);
+    // Nested fork-join must not deadlock, even with more forks than threads
+    count = 0;
+    for (int i = 0; i < 50; i++)
+        OCTaskGroupSubmit(group, OCThreadPoolTest_fork, &count);
+    OCTaskGroupWait(group);
+    success &= (count == 500);
+    OCTaskGroupRelease(group);
+    count = 0;
+    for (int i = 0; i < 20; i++)
+        success &= OCThreadPoolSubmit(OCThreadPoolTest_increment, &count);
+    OCThreadPoolWait();
+    success &= (count == 20);
+    success &= !OCTaskGroupSubmit(NULL, OCThreadPoolTest_increment, &count);
+    success &= !OCThreadPoolSubmit(NULL, NULL);
+    fprintf(stderr, success ? " passed\n" : " FAILED\n");
+    return success;
+}
+typedef struct {
+    unsigned char *visits;
+    int64_t slices;
+} OCThreadPoolTestCoverage;
+static void OCThreadPoolTest_visit(OCRange range, void *context) {
+    OCThreadPoolTestCoverage *coverage = (OCThreadPoolTestCoverage *)context;
+    for (OCIndex i = range.location; i < range.location + range.length; i++)
+        coverage->visits[i]++;
+    __atomic_add_fetch(&coverage->slices, 1, __ATOMIC_RELAXED);
+}
+bool OCThreadPoolApplyRange_test(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    bool success = true;
+    const OCIndex length = 100000;
+    OCThreadPoolTestCoverage coverage = {calloc((size_t)length, 1), 0};
+    if (coverage.visits == NULL) PRINTERROR;
+    // Resizing restarts the pool with the new count
+    success &= OCThreadPoolSetThreadCount(3);
+    success &= (OCThreadPoolGetThreadCount() == 3);
+    OCThreadPoolApplyRange(OCRangeMake(10, length - 20), 1000, OCThreadPoolTest_visit, &coverage);
+    for (OCIndex i = 0; i < length; i++)
+        success &= (coverage.visits[i] == (i >= 10 && i < length - 10 ? 1 : 0));
+    success &= (coverage.slices > 1 && coverage.slices <= 12);
+    // A grain larger than the range runs it as one slice
+    coverage.slices = 0;
+    OCThreadPoolApplyRange(OCRangeMake(0, 10), 1000, OCThreadPoolTest_visit, &coverage);
+    success &= (coverage.slices == 1 && coverage.visits[0] == 1);
+    OCThreadPoolApplyRange(OCRangeMake(0, 0), 1, OCThreadPoolTest_visit, &coverage);
+    success &= (coverage.slices == 1);
+    success &= OCThreadPoolSetThreadCount(0);
+    free(coverage.visits);
+    fprintf(stderr, success ? " passed\n" : " FAILED\n");
+    return success;
+}
@@ -0,0 +1,12 @@
+#ifndef TEST_OCTHREADPOOL_H
+#define TEST_OCTHREADPOOL_H
+#include <stdbool.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool OCThreadPoolTaskGroup_test(void);
+bool OCThreadPoolApplyRange_test(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* TEST_OCTHREADPOOL_H */
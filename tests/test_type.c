@@ -57,3 +57,68 @@ bool typeTest2(void) {
     fprintf(stderr, " passed\n");
     return success;
 }
+bool typeTest3_deep_copy_shared(void) {
+    fprintf(stderr, "%s begin...", __func__);
+    // root = {config: frozen {n, name}, list: [s, s, fixed], blob: immutable [data], self: root}
+    OCNumberRef n = OCNumberCreateWithInt(42);
+    OCStringRef name = OCStringCreateWithCString("name");
+    const void *configKeys[] = {STR("n"), STR("name")};
+    const void *configValues[] = {n, name};
+    OCDictionaryRef config = OCDictionaryCreate(configKeys, configValues, 2);
+    OCMutableStringRef s = OCStringCreateMutableCopy(STR("shared"));
+    const void *fixedValues[] = {n};
+    OCArrayRef fixed = OCArrayCreate(fixedValues, 1, &kOCTypeArrayCallBacks);
+    OCMutableArrayRef list = OCArrayCreateMutable(0, &kOCTypeArrayCallBacks);
+    OCArrayAppendValue(list, s);
+    OCArrayAppendValue(list, s);
+    OCArrayAppendValue(list, fixed);
+    OCMutableDataRef data = OCDataCreateMutable(0);
+    OCDataAppendBytes(data, (const uint8_t *)"abc", 3);
+    const void *blobValues[] = {data};
+    OCArrayRef blob = OCArrayCreate(blobValues, 1, &kOCTypeArrayCallBacks);
+    OCMutableDictionaryRef root = OCDictionaryCreateMutable(0);
+    OCDictionarySetValue(root, STR("config"), config);
+    OCDictionarySetValue(root, STR("list"), list);
+    OCDictionarySetValue(root, STR("blob"), blob);
+    OCDictionarySetValue(root, STR("self"), root);
+    OCMutableDictionaryRef copy = (OCMutableDictionaryRef)OCTypeDeepCopyShared(root);
+    ASSERT_NOT_NULL(copy, "OCTypeDeepCopyShared should not return NULL");
+    ASSERT_TRUE(copy != root, "A mutable root is copied");
+    ASSERT_TRUE(OCDictionaryGetValue(copy, STR("self")) == copy, "The cycle closes on the copy");
+    ASSERT_TRUE(OCDictionaryGetValue(copy, STR("config")) == config, "An immutable subtree is shared");
+    OCMutableArrayRef listCopy = (OCMutableArrayRef)OCDictionaryGetValue(copy, STR("list"));
+    ASSERT_TRUE(listCopy != list && OCArrayGetCount(listCopy) == 3, "A mutable array is copied");
+    OCMutableStringRef sCopy = (OCMutableStringRef)OCArrayGetValueAtIndex(listCopy, 0);
+    ASSERT_TRUE(sCopy != s && OCTypeEqual(sCopy, s), "A mutable string is copied");
+    ASSERT_TRUE(OCArrayGetValueAtIndex(listCopy, 1) == sCopy, "Repeated references share one copy");
+    ASSERT_TRUE(OCArrayGetValueAtIndex(listCopy, 2) == fixed, "An immutable array of numbers is shared");
+    OCArrayRef blobCopy = OCDictionaryGetValue(copy, STR("blob"));
+    ASSERT_TRUE(blobCopy != blob, "An immutable array holding mutable data is rebuilt");
+    OCDataRef dataCopy = OCArrayGetValueAtIndex(blobCopy, 0);
+    ASSERT_TRUE(dataCopy != data && OCTypeEqual(dataCopy, data), "Mutable data is copied");
+    // Changes on either side stay on that side
+    OCStringAppendCString(sCopy, "!");
+    OCDataAppendBytes(data, (const uint8_t *)"d", 1);
+    OCArrayAppendValue(list, n);
+    ASSERT_TRUE(OCStringCompare(s, STR("shared"), 0) == kOCCompareEqualTo, "The original string is unchanged");
+    ASSERT_TRUE(OCDataGetLength(dataCopy) == 3, "The copied data is unchanged");
+    ASSERT_TRUE(OCArrayGetCount(listCopy) == 3, "The copied array is unchanged");
+    // Immutable leaves come back as themselves
+    OCStringRef nameCopy = OCTypeDeepCopyShared(name);
+    ASSERT_TRUE(nameCopy == name, "An immutable string is retained");
+    OCRelease(nameCopy);
+    OCDictionaryRemoveValue(copy, STR("self"));
+    OCDictionaryRemoveValue(root, STR("self"));
+    OCRelease(copy);
+    OCRelease(root);
+    OCRelease(blob);
+    OCRelease(data);
+    OCRelease(list);
+    OCRelease(fixed);
+    OCRelease(s);
+    OCRelease(config);
+    OCRelease(name);
+    OCRelease(n);
+    fprintf(stderr, " passed\n");
+    return true;
+}
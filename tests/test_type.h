@@ -6,4 +6,5 @@ bool typeTest0(void);
 // New: tests for type descriptions and OCGetTypeID
 bool typeTest1(void);
 bool typeTest2(void);
+bool typeTest3_deep_copy_shared(void);
 #endif /* TEST_TYPE_H */